@@ -346,6 +346,7 @@ private:
     void initializeAllIKConstraints();
     void saveTransformState();
     void clearTransformState();
+    void setIncrementalUpdateEnable(bool value);
 
     ProjectProxy *m_parentProjectRef;
     MotionProxy *m_childMotionRef;
@@ -137,6 +137,7 @@ public:
     bool canPaste() const;
     bool isDirty() const;
     void setDirty(bool value);
+    void setPlaying(bool value);
     const BoneMotionTrackBundle &boneMotionTrackBundle() const;
     const MorphMotionTrackBundle &morphMotionTrackBundle() const;
 
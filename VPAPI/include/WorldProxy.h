@@ -48,6 +48,7 @@ namespace vpvl2 {
 namespace VPVL2_VERSION_NS {
 namespace extensions {
 class World;
+class XMLProject;
 }
 }
 using namespace VPVL2_VERSION_NS;
@@ -69,6 +70,7 @@ class WorldProxy : public QObject
     Q_PROPERTY(int randSeed READ randSeed WRITE setRandSeed NOTIFY randSeedChanged FINAL)
     Q_PROPERTY(bool enableDebug READ isDebugEnabled WRITE setDebugEnabled NOTIFY enableDebugChanged FINAL)
     Q_PROPERTY(bool enableFloor READ isFloorEnabled WRITE setFloorEnabled NOTIFY enableFloorChanged FINAL)
+    Q_PROPERTY(bool enableIsland READ isIslandEnabled WRITE setIslandEnabled NOTIFY enableIslandChanged FINAL)
 
 public:
     enum SimulationType {
@@ -82,9 +84,11 @@ public:
 
     BoneRefObject *ray(const vpvl2::Vector3 &from, const vpvl2::Vector3 &to);
     void joinWorld(ModelProxy *value);
+    void addModel(ModelProxy *value);
     void leaveWorld(ModelProxy *value);
     void resetProjectInstance(ProjectProxy *value);
     void stepSimulation(qreal timeIndex);
+    void clearCheckpoints();
     void rewind();
     void setDebugDrawer(btIDebugDraw *value);
     void debugDraw();
@@ -104,6 +108,8 @@ public:
     void setDebugEnabled(bool value);
     bool isFloorEnabled() const;
     void setFloorEnabled(bool value);
+    bool isIslandEnabled() const;
+    void setIslandEnabled(bool value);
 
 signals:
     void simulationTypeChanged();
@@ -113,9 +119,12 @@ signals:
     void randSeedChanged();
     void enableDebugChanged();
     void enableFloorChanged();
+    void enableIslandChanged();
 
 private:
     void applyAllModels(bool value);
+    void seekCheckpoint(qreal timeIndex);
+    void attachProject(vpvl2::extensions::XMLProject *project, bool value);
 
     QScopedPointer<vpvl2::extensions::World> m_sceneWorld;
     QScopedPointer<vpvl2::extensions::World> m_modelWorld;
@@ -124,8 +133,10 @@ private:
     SimulationType m_simulationType;
     QVector3D m_lastGravity;
     qreal m_lastTimeIndex;
+    qreal m_lastCheckpointTimeIndex;
     bool m_enableDebug;
     bool m_playing;
+    bool m_attached;
 };
 
 #endif // WORLDPROXY_H
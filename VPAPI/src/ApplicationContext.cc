@@ -272,10 +272,17 @@ bool ApplicationContext::extractModelNameFromFileName(const std::string &path, s
 
 ITexture *ApplicationContext::uploadTextureOpaque(const uint8 *data, vsize size, const std::string &key, int flags, ModelContext *context)
 {
-    QImage image;
-    image.loadFromData(data, size);
-    ITexture *texturePtr = uploadTextureQt(image, key, flags, context);
+    /* identical images are decoded and uploaded only once and shared between models */
+    ITexture *texturePtr = findSharedTexture(data, size, context->flipVertically(), flags);
     if (!texturePtr) {
+        QImage image;
+        image.loadFromData(data, size);
+        texturePtr = shareTexture(data, size, context->flipVertically(), flags, uploadTextureQt(image, key, flags, context));
+    }
+    if (texturePtr) {
+        context->storeTexture(key, flags, texturePtr);
+    }
+    else {
         texturePtr = context->createTextureFromMemory(data, size, key, flags);
     }
     return texturePtr;
@@ -283,13 +290,14 @@ ITexture *ApplicationContext::uploadTextureOpaque(const uint8 *data, vsize size,
 
 ITexture *ApplicationContext::uploadTextureOpaque(const std::string &path, int flags, ModelContext *context)
 {
-    QImage image;
-    image.load(QString::fromStdString(path));
-    ITexture *texturePtr = uploadTextureQt(image, path, flags, context);
-    if (!texturePtr) {
-        texturePtr = context->createTextureFromFile(path, flags);
+    QFile file(QString::fromStdString(path));
+    if (file.open(QFile::ReadOnly)) {
+        const QByteArray &bytes = file.readAll();
+        if (!bytes.isEmpty()) {
+            return uploadTextureOpaque(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size(), path, flags, context);
+        }
     }
-    return texturePtr;
+    return context->createTextureFromFile(path, flags);
 }
 
 IApplicationContext::FunctionResolver *ApplicationContext::sharedFunctionResolverInstance() const
@@ -314,7 +322,6 @@ ITexture *ApplicationContext::uploadTextureQt(const QImage &image, const std::st
         const QImage &normalizedImage = image.convertToFormat(QImage::Format_ARGB32).rgbSwapped();
         texturePtr = uploadTexture((context->flipVertically() ? normalizedImage.mirrored() : normalizedImage).constBits(), defaultTextureFormat(), size);
         VPVL2_VLOG(2, "Created a texture: texture=" << texturePtr);
-        context->storeTexture(key, flags, texturePtr);
     }
     else {
         VPVL2_LOG(WARNING, "Cannot load an image texture with QImage: " << key);
@@ -533,11 +540,13 @@ void ApplicationContext::deleteModelProxy(ModelProxy *modelProxy, ProjectProxy *
             m_fileSystemWatcher.removePath(filePath);
         }
         removeTextureWatch(modelRef);
+        removeModelFilePath(modelRef);
         projectRef->removeModel(modelRef);
         engine->release();
         delete engine;
     }
     else {
+        removeModelFilePath(modelRef);
         projectRef->removeModel(modelRef);
     }
 }
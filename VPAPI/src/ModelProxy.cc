@@ -37,6 +37,7 @@
 
 #include <vpvl2/vpvl2.h>
 #include <vpvl2/extensions/XMLProject.h>
+#include <vpvl2/pmx/Model.h>
 #include <vpvl2/extensions/qt/String.h>
 
 #include <QtCore>
@@ -312,6 +313,7 @@ void ModelProxy::beginTransform(qreal startY)
 {
     Q_ASSERT(!m_moving);
     saveTransformState();
+    setIncrementalUpdateEnable(true);
     m_baseY = startY;
     m_moving = true;
     emit transformDidBegin();
@@ -454,6 +456,7 @@ void ModelProxy::discardTransform()
 {
     Q_ASSERT(m_moving);
     clearTransformState();
+    setIncrementalUpdateEnable(false);
     m_baseY = 0;
     m_moving = false;
     emit transformDidDiscard();
@@ -463,6 +466,7 @@ void ModelProxy::commitTransform()
 {
     Q_ASSERT(m_moving);
     clearTransformState();
+    setIncrementalUpdateEnable(false);
     m_baseY = 0;
     m_moving = false;
     emit transformDidCommit();
@@ -1544,3 +1548,12 @@ void ModelProxy::clearTransformState()
 {
     m_transformState.clear();
 }
+
+void ModelProxy::setIncrementalUpdateEnable(bool value)
+{
+    /* only the dragged bones and their descendants are changed while transforming */
+    if (m_model->type() == IModel::kPMXModel) {
+        pmx::Model *model = static_cast<pmx::Model *>(m_model.data());
+        model->setIncrementalUpdateEnable(value);
+    }
+}
@@ -59,6 +59,8 @@
 
 #include <vpvl2/vpvl2.h>
 #include <vpvl2/extensions/qt/String.h>
+#include <vpvl2/vmd/BoneAnimation.h>
+#include <vpvl2/vmd/Motion.h>
 
 using namespace vpvl2;
 using namespace vpvl2::extensions::qt;
@@ -1336,6 +1338,15 @@ void MotionProxy::setDirty(bool value)
     }
 }
 
+void MotionProxy::setPlaying(bool value)
+{
+    /* keyframes are edited in place only while stopped, so the compiled seek is used for playback */
+    if (m_motion->type() == IMotion::kVMDFormat) {
+        vmd::Motion *motion = static_cast<vmd::Motion *>(m_motion.data());
+        motion->mutableBoneAnimation()->setCompileEnable(value);
+    }
+}
+
 const MotionProxy::BoneMotionTrackBundle &MotionProxy::boneMotionTrackBundle() const
 {
     return m_boneMotionTrackBundle;
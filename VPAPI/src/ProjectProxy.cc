@@ -127,9 +127,16 @@ public:
         QFile file(m_fileUrl.toLocalFile());
         bool ok = false;
         if (file.open(QFile::ReadOnly)) {
-            const QByteArray &bytes = file.readAll();
-            const uint8_t *ptr = reinterpret_cast<const uint8_t *>(bytes.constData());
-            model.reset(m_factoryRef->createModel(ptr, file.size(), ok));
+            /* parse from the mapped file directly to avoid copying whole of the file to the heap */
+            const qint64 size = file.size();
+            if (const uchar *ptr = file.map(0, size)) {
+                model.reset(m_factoryRef->createModel(ptr, size, ok));
+                file.unmap(const_cast<uchar *>(ptr));
+            }
+            else {
+                const QByteArray &bytes = file.readAll();
+                model.reset(m_factoryRef->createModel(reinterpret_cast<const uint8_t *>(bytes.constData()), bytes.size(), ok));
+            }
             if (ok) {
                 /* set filename of the model if the name of the model is null such as asset */
                 if (!model->name(IEncoding::kDefaultLanguage)) {
@@ -195,10 +202,16 @@ private:
         QString errorString;
         bool ok = false;
         if (file.open(QFile::ReadOnly)) {
-            const QByteArray &bytes = file.readAll();
-            const uint8_t *ptr = reinterpret_cast<const uint8_t *>(bytes.constData());
             IModel *modelRef = m_parentModel ? m_parentModel->data() : 0;
-            motion.reset(m_factoryRef->createMotion(ptr, file.size(), modelRef, ok));
+            const qint64 size = file.size();
+            if (const uchar *ptr = file.map(0, size)) {
+                motion.reset(m_factoryRef->createMotion(ptr, size, modelRef, ok));
+                file.unmap(const_cast<uchar *>(ptr));
+            }
+            else {
+                const QByteArray &bytes = file.readAll();
+                motion.reset(m_factoryRef->createMotion(reinterpret_cast<const uint8_t *>(bytes.constData()), bytes.size(), modelRef, ok));
+            }
             if (!ok) {
                 errorString = QStringLiteral("errno=%1").arg(motion->error());
                 motion.reset();
@@ -287,6 +300,8 @@ ProjectProxy::ProjectProxy(QObject *parent)
         const QVariant &value = settings.value("constants." + it.key());
         m_dictionary.insert(it.value(), String::create(value.toString().toStdString()));
     }
+    /* models of both ModelLoader and XMLProject (through ProjectDelegate) are created by this factory */
+    m_factory->setParallelLoadEnable(m_accelerationType != NoAcceleration);
     connect(this, &ProjectProxy::currentModelChanged, this, &ProjectProxy::updateParentBindingModel);
     connect(this, &ProjectProxy::parentBindingDidUpdate, this, &ProjectProxy::availableParentBindingBonesChanged);
     connect(this, &ProjectProxy::parentBindingDidUpdate, this, &ProjectProxy::availableParentBindingModelsChanged);
@@ -305,6 +320,7 @@ ProjectProxy::ProjectProxy(QObject *parent)
     connect(this, &ProjectProxy::motionWillDelete, this, &ProjectProxy::availableMotionsChanged);
     connect(m_undoGroup.data(), &QUndoGroup::canUndoChanged, this, &ProjectProxy::canUndoChanged);
     connect(m_undoGroup.data(), &QUndoGroup::canRedoChanged, this, &ProjectProxy::canRedoChanged);
+    connect(m_undoGroup.data(), &QUndoGroup::indexChanged, m_worldProxy.data(), &WorldProxy::clearCheckpoints);
 }
 
 ProjectProxy::~ProjectProxy()
@@ -359,7 +375,13 @@ bool ProjectProxy::save(const QUrl &fileUrl)
     }
     QTemporaryFile temp;
     if (temp.open()) {
-        saved = m_project->save(temp.fileName().toUtf8().constData());
+        const QByteArray &path = temp.fileName().toUtf8();
+        if (QFileInfo(fileUrl.toLocalFile()).suffix() == QStringLiteral("vpvb")) {
+            saved = m_project->saveBinary(path.constData());
+        }
+        else {
+            saved = m_project->save(path.constData());
+        }
         QSaveFile saveFile(fileUrl.toLocalFile());
         if (saveFile.open(QFile::WriteOnly | QFile::Unbuffered)) {
             saveFile.write(temp.readAll());
@@ -553,6 +575,7 @@ void ProjectProxy::internalAddModel(ModelProxy *value, bool selected, bool isPro
     m_modelProxies.append(value);
     m_instance2ModelProxyRefs.insert(value->data(), value);
     m_uuid2ModelProxyRefs.insert(value->uuid(), value);
+    m_worldProxy->addModel(value);
     if (selected) {
         setCurrentModel(value);
     }
@@ -779,6 +802,7 @@ void ProjectProxy::setAccelerationType(AccelerationType value)
             }
             break;
         }
+        m_factory->setParallelLoadEnable(value != NoAcceleration);
         m_accelerationType = value;
         emit accelerationTypeChanged();
     }
@@ -1456,6 +1480,7 @@ void ProjectProxy::release(bool fromDestructor)
     if (!fromDestructor) {
         connect(m_undoGroup.data(), &QUndoGroup::canUndoChanged, this, &ProjectProxy::canUndoChanged);
         connect(m_undoGroup.data(), &QUndoGroup::canRedoChanged, this, &ProjectProxy::canRedoChanged);
+        connect(m_undoGroup.data(), &QUndoGroup::indexChanged, m_worldProxy.data(), &WorldProxy::clearCheckpoints);
     }
     emit projectDidRelease();
 }
@@ -58,6 +58,8 @@ using namespace vpvl2::extensions;
 
 namespace {
 
+static const qreal kCheckpointInterval = 30;
+
 class SynchronizedBoneMotionState : public btMotionState {
 public:
     SynchronizedBoneMotionState(const IBone *boneRef)
@@ -88,8 +90,10 @@ WorldProxy::WorldProxy(ProjectProxy *parent)
       m_simulationType(DisableSimulation),
       m_lastGravity(gravity()),
       m_lastTimeIndex(0.0),
+      m_lastCheckpointTimeIndex(0.0),
       m_enableDebug(false),
-      m_playing(false)
+      m_playing(false),
+      m_attached(false)
 {
 }
 
@@ -134,19 +138,33 @@ void WorldProxy::joinWorld(ModelProxy *value)
     }
 }
 
+void WorldProxy::addModel(ModelProxy *value)
+{
+    Q_ASSERT(m_sceneWorld);
+    Q_ASSERT(value);
+    clearCheckpoints();
+    /* models join the shared world through the project unless islands are enabled */
+    if (m_attached && m_sceneWorld->isIslandEnabled()) {
+        m_sceneWorld->addModel(value->data(), false);
+    }
+}
+
 void WorldProxy::leaveWorld(ModelProxy *value)
 {
     Q_ASSERT(m_sceneWorld);
     Q_ASSERT(value);
     IModel *modelRef = value->data();
-    modelRef->leaveWorld(m_sceneWorld->dynamicWorldRef());
+    clearCheckpoints();
+    if (!m_sceneWorld->removeModel(modelRef)) {
+        modelRef->leaveWorld(m_sceneWorld->dynamicWorldRef());
+    }
 }
 
 void WorldProxy::resetProjectInstance(ProjectProxy *value)
 {
     Q_ASSERT(m_sceneWorld);
     Q_ASSERT(value);
-    value->projectInstanceRef()->setWorldRef(m_sceneWorld->dynamicWorldRef());
+    attachProject(value->projectInstanceRef(), true);
 }
 
 void WorldProxy::stepSimulation(qreal timeIndex)
@@ -155,24 +173,34 @@ void WorldProxy::stepSimulation(qreal timeIndex)
     Q_ASSERT(timeIndex >= 0);
     SimulationType type = simulationType();
     if (type == EnableSimulationAnytime || (type == EnableSimulationPlayOnly && m_playing)) {
+        seekCheckpoint(timeIndex);
         int delta = qRound(timeIndex - m_lastTimeIndex);
         if (delta > 0) {
             m_sceneWorld->stepSimulation(delta, Scene::defaultFPS());
         }
         m_lastTimeIndex = timeIndex;
+        /* only playback advances contiguously, so only its state is worth saving */
+        if (m_playing && timeIndex - m_lastCheckpointTimeIndex >= kCheckpointInterval) {
+            m_sceneWorld->saveCheckpoint(timeIndex);
+            m_lastCheckpointTimeIndex = timeIndex;
+        }
     }
 }
 
+void WorldProxy::clearCheckpoints()
+{
+    Q_ASSERT(m_sceneWorld);
+    m_sceneWorld->clearCheckpoints();
+    m_lastCheckpointTimeIndex = 0;
+}
+
 void WorldProxy::rewind()
 {
     Q_ASSERT(m_sceneWorld);
     stepSimulation(0);
     XMLProject *project = m_parentProjectProxyRef->projectInstanceRef();
     Q_ASSERT(project);
-    project->setWorldRef(0);
-    if (simulationType() != DisableSimulation) {
-        project->setWorldRef(m_sceneWorld->dynamicWorldRef());
-    }
+    attachProject(project, simulationType() != DisableSimulation);
 }
 
 void WorldProxy::setDebugDrawer(btIDebugDraw *value)
@@ -208,9 +236,8 @@ void WorldProxy::setSimulationType(SimulationType value)
         XMLProject *project = m_parentProjectProxyRef->projectInstanceRef();
         Q_ASSERT(project);
         bool enabled = (value == EnableSimulationAnytime);
-        project->setWorldRef(0);
+        attachProject(project, enabled);
         if (enabled) {
-            project->setWorldRef(m_sceneWorld->dynamicWorldRef());
             setGravity(m_lastGravity);
         }
         else {
@@ -308,6 +335,68 @@ void WorldProxy::setFloorEnabled(bool value)
     }
 }
 
+bool WorldProxy::isIslandEnabled() const
+{
+    Q_ASSERT(m_sceneWorld);
+    return m_sceneWorld->isIslandEnabled();
+}
+
+void WorldProxy::setIslandEnabled(bool value)
+{
+    Q_ASSERT(m_sceneWorld);
+    if (isIslandEnabled() != value) {
+        m_sceneWorld->setIslandEnabled(value);
+        if (m_attached) {
+            attachProject(m_parentProjectProxyRef->projectInstanceRef(), true);
+        }
+        emit enableIslandChanged();
+    }
+}
+
+void WorldProxy::seekCheckpoint(qreal timeIndex)
+{
+    bool rewinding = timeIndex < m_lastTimeIndex;
+    if (rewinding || timeIndex - m_lastTimeIndex > kCheckpointInterval) {
+        Scalar checkpointTimeIndex = 0;
+        /* forward seek restores only if it skips more than simulating from the last frame */
+        if (m_sceneWorld->findCheckpoint(timeIndex, checkpointTimeIndex)
+                && (rewinding || checkpointTimeIndex > m_lastTimeIndex)) {
+            m_sceneWorld->restoreCheckpoint(timeIndex);
+            m_lastTimeIndex = checkpointTimeIndex;
+            m_lastCheckpointTimeIndex = checkpointTimeIndex;
+        }
+    }
+}
+
+void WorldProxy::attachProject(XMLProject *project, bool value)
+{
+    Q_ASSERT(m_sceneWorld);
+    Q_ASSERT(project);
+    clearCheckpoints();
+    project->setWorldRef(0);
+    m_sceneWorld->removeAllModels();
+    if (value) {
+        if (m_sceneWorld->isIslandEnabled()) {
+            /* each model is simulated in its own island stepped concurrently */
+            foreach (ModelProxy *modelProxy, m_parentProjectProxyRef->modelProxies()) {
+                m_sceneWorld->addModel(modelProxy->data(), false);
+            }
+            /* Scene cannot reset models in islands because the project has no world */
+            m_sceneWorld->resetMotionState();
+        }
+        else {
+            btDiscreteDynamicsWorld *worldRef = m_sceneWorld->dynamicWorldRef();
+            project->setWorldRef(worldRef);
+            foreach (ModelProxy *modelProxy, m_parentProjectProxyRef->modelProxies()) {
+                modelProxy->data()->resetMotionState(worldRef);
+            }
+        }
+        /* motion states are reset now, so seeking back to the beginning restores this */
+        m_sceneWorld->saveCheckpoint(0);
+    }
+    m_attached = value;
+}
+
 void WorldProxy::applyAllModels(bool value)
 {
     foreach (ModelProxy *modelProxy, m_parentProjectProxyRef->modelProxies()) {
@@ -39,11 +39,13 @@
 #ifndef ENCODINGTASK_H_
 #define ENCODINGTASK_H_
 
+#include <QAtomicInt>
 #include <QDir>
 #include <QObject>
 #include <QProcess>
 #include <QSize>
 
+class QOpenGLBuffer;
 class QOpenGLFramebufferObject;
 class QQuickWindow;
 class QTemporaryDir;
@@ -57,6 +59,8 @@ public:
     ~EncodingTask();
 
     bool isRunning() const;
+    bool isStreaming() const;
+    bool canCaptureFrame() const;
     void setSize(const QSize &value);
     void setTitle(const QString &value);
     void setInputImageFormat(const QString &value);
@@ -67,6 +71,8 @@ public:
     void reset();
     QOpenGLFramebufferObject *generateFramebufferObject(QQuickWindow *win);
     QString generateFilename(const qreal &timeIndex);
+    void captureFrame(QOpenGLFramebufferObject *fbo);
+    void flushCapturedFrames();
 
     void stop();
     void release();
@@ -76,18 +82,31 @@ public slots:
     void handleReadyRead();
     void handleStateChanged();
     void handleError(QProcess::ProcessError error);
+    void handleBytesWritten(qint64 bytes);
+    void writeFrame(const QByteArray &bytes);
+    void finishWritingFrames();
     void launch();
 
 signals:
+    void frameDidCapture(const QByteArray &bytes);
+    void captureDidFinish();
     void encodeDidBegin();
     void encodeDidProceed(quint64 proceed, quint64 estimated);
     void encodeDidFinish(bool isNormalExit);
 
 private:
+    static const int kNumPixelBuffers = 3;
+    static const int kMaxQueuedFrames = 8;
+
+    int frameSize() const;
+    void readPixelBuffer(int index);
+    void releasePixelBuffers();
     void getArguments(QStringList &arguments);
 
     QScopedPointer<QProcess> m_process;
     QScopedPointer<QOpenGLFramebufferObject> m_fbo;
+    QScopedPointer<QOpenGLFramebufferObject> m_resolveFbo;
+    QScopedPointer<QOpenGLBuffer> m_pixelBuffers[kNumPixelBuffers];
     QScopedPointer<QTemporaryDir> m_workerDir;
     QProcess::ProcessState m_lastState;
     QDir m_workerDirPath;
@@ -101,6 +120,9 @@ private:
     QString m_outputFormat;
     QString m_pixelFormat;
     quint64 m_estimatedFrameCount;
+    QAtomicInt m_queuedBytes;
+    int m_numCapturedFrames;
+    int m_numReadFrames;
 };
 
 #endif
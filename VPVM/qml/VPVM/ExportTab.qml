@@ -47,7 +47,7 @@ Tab {
     property size size
     property size range : Qt.size(0, 0)
     property string videoType
-    property string frameImageType
+    property string frameImageType: "rawvideo"
     RowLayout {
         GroupBox {
             Layout.fillHeight: true
@@ -132,6 +132,7 @@ Tab {
                             }
                             ListModel {
                                 id: frameImageTypeModel
+                                ListElement { text: "Raw (Streaming)"; value: "rawvideo" }
                                 ListElement { text: "BMP"; value: "bmp" }
                                 ListElement { text: "PNG"; value: "png" }
                             }
@@ -213,7 +213,11 @@ ApplicationWindow {
     }
     FileDialog {
         id: loadProjectDialog
-        nameFilters: [ qsTr("Project File (*.xml)") ]
+        nameFilters: [
+            qsTr("Project File (*.xml *.vpvb)"),
+            qsTr("XML Project File (*.xml)"),
+            qsTr("Binary Project File (*.vpvb)")
+        ]
         selectExisting: true
         onAccepted: {
             var fileUrlString = fileUrl.toString(),
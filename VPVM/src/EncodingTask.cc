@@ -39,6 +39,10 @@
 #include "EncodingTask.h"
 
 #include <QtCore>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
 #include <QQuickWindow>
 #include <vpvl2/vpvl2.h>
 
@@ -47,8 +51,14 @@ using namespace vpvl2;
 EncodingTask::EncodingTask(QObject *parent)
     : QObject(parent),
       m_lastState(QProcess::NotRunning),
-      m_estimatedFrameCount(0)
+      m_estimatedFrameCount(0),
+      m_queuedBytes(0),
+      m_numCapturedFrames(0),
+      m_numReadFrames(0)
 {
+    /* frames are captured on the render thread but QProcess must be written from the thread owning it */
+    connect(this, &EncodingTask::frameDidCapture, this, &EncodingTask::writeFrame, Qt::QueuedConnection);
+    connect(this, &EncodingTask::captureDidFinish, this, &EncodingTask::finishWritingFrames, Qt::QueuedConnection);
 }
 
 EncodingTask::~EncodingTask()
@@ -61,6 +71,17 @@ bool EncodingTask::isRunning() const
     return m_process && m_process->state() == QProcess::Running;
 }
 
+bool EncodingTask::isStreaming() const
+{
+    return m_inputImageFormat == QStringLiteral("rawvideo");
+}
+
+bool EncodingTask::canCaptureFrame() const
+{
+    /* throttle rendering when the encoder cannot consume frames as fast as they are produced */
+    return m_queuedBytes.load() < frameSize() * kMaxQueuedFrames;
+}
+
 void EncodingTask::setSize(const QSize &value)
 {
     m_size = value;
@@ -100,12 +121,13 @@ void EncodingTask::setEstimatedFrameCount(const qint64 value)
 void EncodingTask::reset()
 {
     m_workerId = QUuid::createUuid().toByteArray().toHex();
-    m_workerDir.reset(new QTemporaryDir());
-    m_workerDirPath = m_workerDir->path();
+    m_workerDir.reset();
     m_inputImageFormat = "bmp";
     m_outputFormat = "png";
     m_pixelFormat = "rgb24";
     m_fbo.reset();
+    releasePixelBuffers();
+    m_queuedBytes.store(0);
 }
 
 QOpenGLFramebufferObject *EncodingTask::generateFramebufferObject(QQuickWindow *win)
@@ -120,6 +142,11 @@ QOpenGLFramebufferObject *EncodingTask::generateFramebufferObject(QQuickWindow *
 
 QString EncodingTask::generateFilename(const qreal &timeIndex)
 {
+    if (!m_workerDir) {
+        /* the temporary directory is only needed for image sequence inputs */
+        m_workerDir.reset(new QTemporaryDir());
+        m_workerDirPath = m_workerDir->path();
+    }
     const QString &filename = QStringLiteral("%1-%2.%3")
             .arg(m_workerId)
             .arg(qRound64(timeIndex), 9, 10, QLatin1Char('0'))
@@ -128,6 +155,50 @@ QString EncodingTask::generateFilename(const qreal &timeIndex)
     return path;
 }
 
+void EncodingTask::captureFrame(QOpenGLFramebufferObject *fbo)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    Q_ASSERT(context);
+    QOpenGLFramebufferObject *source = fbo;
+    if (fbo->format().samples() > 0) {
+        /* multisampled framebuffer cannot be read directly so resolve it first */
+        if (!m_resolveFbo) {
+            m_resolveFbo.reset(new QOpenGLFramebufferObject(m_size));
+        }
+        QOpenGLFramebufferObject::blitFramebuffer(m_resolveFbo.data(), fbo);
+        source = m_resolveFbo.data();
+    }
+    const int index = m_numCapturedFrames % kNumPixelBuffers;
+    if (m_numCapturedFrames - m_numReadFrames >= kNumPixelBuffers) {
+        /* the oldest readback has been in flight for kNumPixelBuffers frames and should be done without stall */
+        readPixelBuffer(index);
+    }
+    QScopedPointer<QOpenGLBuffer> &buffer = m_pixelBuffers[index];
+    if (!buffer) {
+        buffer.reset(new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer));
+        buffer->setUsagePattern(QOpenGLBuffer::StreamRead);
+        buffer->create();
+        buffer->bind();
+        buffer->allocate(frameSize());
+        buffer->release();
+    }
+    source->bind();
+    buffer->bind();
+    context->functions()->glReadPixels(0, 0, m_size.width(), m_size.height(), GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    buffer->release();
+    source->release();
+    m_numCapturedFrames++;
+}
+
+void EncodingTask::flushCapturedFrames()
+{
+    while (m_numReadFrames < m_numCapturedFrames) {
+        readPixelBuffer(m_numReadFrames % kNumPixelBuffers);
+    }
+    releasePixelBuffers();
+    emit captureDidFinish();
+}
+
 void EncodingTask::stop()
 {
     if (isRunning()) {
@@ -151,9 +222,34 @@ void EncodingTask::release()
     m_process.reset();
     m_workerDir.reset();
     m_fbo.reset();
+    releasePixelBuffers();
+    m_queuedBytes.store(0);
     m_estimatedFrameCount = 0;
 }
 
+void EncodingTask::handleBytesWritten(qint64 bytes)
+{
+    m_queuedBytes.fetchAndAddOrdered(-int(bytes));
+}
+
+void EncodingTask::writeFrame(const QByteArray &bytes)
+{
+    if (isRunning() || (m_process && m_process->state() == QProcess::Starting)) {
+        m_process->write(bytes);
+    }
+    else {
+        m_queuedBytes.fetchAndAddOrdered(-bytes.size());
+    }
+}
+
+void EncodingTask::finishWritingFrames()
+{
+    if (m_process) {
+        /* closing standard input lets the encoder finish the stream */
+        m_process->closeWriteChannel();
+    }
+}
+
 void EncodingTask::handleStarted()
 {
     emit encodeDidBegin();
@@ -212,13 +308,16 @@ void EncodingTask::launch()
         m_process->setArguments(arguments);
         m_process->setProgram(m_encoderFilePath);
         m_process->setProcessChannelMode(QProcess::MergedChannels);
-        m_process->setWorkingDirectory(m_workerDir->path());
+        if (m_workerDir) {
+            m_process->setWorkingDirectory(m_workerDir->path());
+        }
         /* disable color output from standard output */
         QStringList environments = m_process->environment();
         environments << "AV_LOG_FORCE_NOCOLOR" << "1";
         m_process->setEnvironment(environments);
         connect(m_process.data(), &QProcess::started, this, &EncodingTask::handleStarted);
         connect(m_process.data(), &QProcess::readyRead, this, &EncodingTask::handleReadyRead);
+        connect(m_process.data(), &QProcess::bytesWritten, this, &EncodingTask::handleBytesWritten);
         connect(m_process.data(), &QProcess::stateChanged, this, &EncodingTask::handleStateChanged);
         connect(m_process.data(), SIGNAL(error(QProcess::ProcessError)), this, SLOT(handleError(QProcess::ProcessError)));
         m_process->start();
@@ -231,6 +330,38 @@ void EncodingTask::launch()
     }
 }
 
+int EncodingTask::frameSize() const
+{
+    return m_size.width() * m_size.height() * 4;
+}
+
+void EncodingTask::readPixelBuffer(int index)
+{
+    QOpenGLBuffer *buffer = m_pixelBuffers[index].data();
+    Q_ASSERT(buffer);
+    buffer->bind();
+    if (const char *ptr = static_cast<const char *>(buffer->map(QOpenGLBuffer::ReadOnly))) {
+        const QByteArray bytes(ptr, frameSize());
+        buffer->unmap();
+        m_queuedBytes.fetchAndAddOrdered(bytes.size());
+        emit frameDidCapture(bytes);
+    }
+    else {
+        VPVL2_LOG(WARNING, "Cannot map pixel buffer of the frame: index=" << m_numReadFrames);
+    }
+    buffer->release();
+    m_numReadFrames++;
+}
+
+void EncodingTask::releasePixelBuffers()
+{
+    for (int i = 0; i < kNumPixelBuffers; i++) {
+        m_pixelBuffers[i].reset();
+    }
+    m_resolveFbo.reset();
+    m_numCapturedFrames = m_numReadFrames = 0;
+}
+
 void EncodingTask::getArguments(QStringList &arguments)
 {
 #ifndef QT_NO_DEBUG
@@ -241,14 +372,29 @@ void EncodingTask::getArguments(QStringList &arguments)
     arguments.append(QStringLiteral("%1").arg(30));
     arguments.append("-s");
     arguments.append(QStringLiteral("%1x%2").arg(m_size.width()).arg(m_size.height()));
-    arguments.append("-qscale");
-    arguments.append("1");
-    arguments.append("-vcodec");
-    arguments.append(m_inputImageFormat);
-    arguments.append("-metadata");
-    arguments.append(QStringLiteral("title=\"%1\"").arg(m_title));
-    arguments.append("-i");
-    arguments.append(m_workerDirPath.absoluteFilePath(QStringLiteral("%1-%09d.%2").arg(m_workerId).arg(m_inputImageFormat)));
+    if (isStreaming()) {
+        /* raw RGBA frames read back from OpenGL are written to standard input bottom-up */
+        arguments.append("-f");
+        arguments.append("rawvideo");
+        arguments.append("-pix_fmt");
+        arguments.append("rgba");
+        arguments.append("-metadata");
+        arguments.append(QStringLiteral("title=\"%1\"").arg(m_title));
+        arguments.append("-i");
+        arguments.append("-");
+        arguments.append("-vf");
+        arguments.append("vflip");
+    }
+    else {
+        arguments.append("-qscale");
+        arguments.append("1");
+        arguments.append("-vcodec");
+        arguments.append(m_inputImageFormat);
+        arguments.append("-metadata");
+        arguments.append(QStringLiteral("title=\"%1\"").arg(m_title));
+        arguments.append("-i");
+        arguments.append(m_workerDirPath.absoluteFilePath(QStringLiteral("%1-%09d.%2").arg(m_workerId).arg(m_inputImageFormat)));
+    }
     arguments.append("-map");
     arguments.append("0");
     arguments.append("-c:v");
@@ -557,6 +557,9 @@ void RenderTarget::setPlaying(bool value)
     Q_ASSERT(m_projectProxyRef);
     if (m_playing != value) {
         m_projectProxyRef->world()->setPlaying(value);
+        foreach (MotionProxy *motionProxy, m_projectProxyRef->motionProxies()) {
+            motionProxy->setPlaying(value);
+        }
         m_playing = value;
         emit playingChanged();
     }
@@ -807,6 +810,11 @@ void RenderTarget::exportVideo(const QUrl &fileUrl, const QSize &size, const QSt
     encodingTaskRef->setInputImageFormat(frameImageType);
     encodingTaskRef->setOutputFormat(videoType);
     encodingTaskRef->setOutputPath(fileUrl.toLocalFile());
+    if (encodingTaskRef->isStreaming()) {
+        /* launch the encoder first to pipe frames to it while rendering */
+        encodingTaskRef->setEstimatedFrameCount(qRound64(m_projectProxyRef->durationTimeIndex()));
+        encodingTaskRef->launch();
+    }
     setPlaying(true);
     connect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::drawOffscreenForVideo, Qt::DirectConnection);
 }
@@ -1082,20 +1090,37 @@ void RenderTarget::drawOffscreenForVideo()
     Q_ASSERT(window());
     Q_ASSERT(window()->thread() == thread());
     EncodingTask *encodingTaskRef = encodingTask();
+    const bool streaming = encodingTaskRef->isStreaming();
+    if (streaming && !encodingTaskRef->canCaptureFrame()) {
+        /* wait for the encoder to consume queued frames */
+        window()->update();
+        return;
+    }
     QOpenGLFramebufferObject *fbo = encodingTaskRef->generateFramebufferObject(window());
     drawOffscreen(fbo);
     if (qFuzzyIsNull(m_projectProxyRef->differenceTimeIndex(m_currentTimeIndex))) {
         encodingTaskRef->setEstimatedFrameCount(m_currentTimeIndex);
         setPlaying(false);
         disconnect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::drawOffscreenForVideo);
-        connect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::launchEncodingTask);
+        if (streaming) {
+            encodingTaskRef->flushCapturedFrames();
+            m_exportSize = QSize();
+        }
+        else {
+            connect(window(), &QQuickWindow::frameSwapped, this, &RenderTarget::launchEncodingTask);
+        }
     }
     else {
         const qreal &currentTimeIndex = m_currentTimeIndex;
-        const QString &path = encodingTaskRef->generateFilename(currentTimeIndex);
+        const QString &path = streaming ? QString() : encodingTaskRef->generateFilename(currentTimeIndex);
         setCurrentTimeIndex(currentTimeIndex + 1);
         m_projectProxyRef->update(Scene::kUpdateAll);
-        fbo->toImage().save(path);
+        if (streaming) {
+            encodingTaskRef->captureFrame(fbo);
+        }
+        else {
+            fbo->toImage().save(path);
+        }
         emit videoFrameDidSave(currentTimeIndex, m_projectProxyRef->durationTimeIndex());
     }
 }
@@ -1193,7 +1218,7 @@ void RenderTarget::synchronizeImplicitly()
     Q_ASSERT(window());
     Q_ASSERT(window()->thread() == thread());
     if (m_projectProxyRef) {
-        int flags = m_playing ? Scene::kUpdateAll : (Scene::kUpdateCamera | Scene::kUpdateRenderEngines);
+        int flags = m_playing ? (Scene::kUpdateAll | Scene::kParallelUpdateModels) : (Scene::kUpdateCamera | Scene::kUpdateRenderEngines);
         m_projectProxyRef->update(flags);
     }
 }
@@ -85,6 +85,25 @@ public:
      */
     IModel *newModel(IModel::Type type) const;
 
+    /**
+     * PMX モデルの読み込みを並列で行うかを返します.
+     *
+     * @return bool
+     * @sa setParallelLoadEnable
+     */
+    bool isParallelLoadEnabled() const;
+
+    /**
+     * PMX モデルの読み込みを並列で行うかを設定します.
+     *
+     * newModel/createModel/createModelFromFile で作成される PMX モデルに適用されます。
+     * 初期値は false です。
+     *
+     * @param value
+     * @sa pmx::Model::setParallelLoadEnable
+     */
+    void setParallelLoadEnable(bool value);
+
     /**
      * オンメモリ上にあるデータとその長さを元に読み込み済みの Model インスタンスを作成します.
      *
@@ -98,6 +117,19 @@ public:
      */
     IModel *createModel(const uint8 *data, vsize size, bool &ok) const;
 
+    /**
+     * ファイルをメモリマップして読み込み済みの Model インスタンスを作成します.
+     *
+     * ファイル全体をバッファに読み込まずにマップした領域から直接解析するため、
+     * 大きなファイルを読み込む時のピークメモリ使用量を抑えることが出来ます。
+     * ファイルが開けなかった場合は null を返し、ok は false にセットされます。
+     *
+     * @param path
+     * @param ok
+     * @return IModel
+     */
+    IModel *createModelFromFile(const char *path, bool &ok) const;
+
     /**
      * 空の Motion インスタンスを返します.
      *
@@ -124,6 +156,18 @@ public:
      */
     IMotion *createMotion(const uint8 *data, vsize size, IModel *model, bool &ok) const;
 
+    /**
+     * ファイルをメモリマップして読み込み済みの Motion インスタンスを作成します.
+     *
+     * 引数の扱いは createMotion と createModelFromFile に準じます。
+     *
+     * @param path
+     * @param model
+     * @param ok
+     * @return IMotion
+     */
+    IMotion *createMotionFromFile(const char *path, IModel *model, bool &ok) const;
+
     /**
      * IBoneKeyframe (ボーンのキーフレーム) のインスタンスを返します.
      *
@@ -96,6 +96,28 @@ public:
         virtual void performTransform(void *address, const Vector3 &cameraPosition) const = 0;
         virtual void computeAabb(const void *address, Array<Vector3> &values) const = 0;
         virtual void setParallelUpdateEnable(bool value) = 0;
+        /**
+         * lastUpdateCount の時点から頂点モーフによって変化した頂点の範囲 [from, to) を返します.
+         *
+         * lastUpdateCount は呼び出し側が頂点バッファごとに保持し、呼び出し後に現在の値に更新されます。
+         * 初回または頂点バッファを作り直した場合は -1 を渡してください。
+         * 変化した頂点がない場合は from と to が同じ値になります。変化を追跡できない場合は全ての頂点の範囲を返します。
+         *
+         * @param lastUpdateCount
+         * @param from
+         * @param to
+         */
+        virtual void getDirtyVertexRange(int &lastUpdateCount, int &from, int &to) const = 0;
+        /**
+         * DynamicVertexBuffer#update と同じ処理を頂点の範囲 [from, to) に対してのみ行います.
+         *
+         * address は頂点 from の位置を指すものとして扱います。
+         *
+         * @param address
+         * @param from
+         * @param to
+         */
+        virtual void updateRange(void *address, int from, int to) const = 0;
     };
     struct StaticVertexBuffer : Buffer {
         virtual void update(void *address) const = 0;
@@ -82,7 +82,8 @@ public:
         kUpdateAll            = kUpdateModels | kUpdateRenderEngines | kUpdateCamera | kUpdateLight,
         kResetMotionState     = 0x10,
         kForceUpdateAllMorphs = 0x20,
-        kMaxUpdateTypeFlags   = 0x40
+        kParallelUpdateModels = 0x40,
+        kMaxUpdateTypeFlags   = 0x80
     };
     struct Deleter {
         void operator()(IModel *model) const {
@@ -387,6 +388,11 @@ public:
      * :kUpdateRenderEngine|レンダリングエンジン
      * :kUpdateAll|上記すべて
      *
+     * kUpdateModels と kParallelUpdateModels を同時に指定した場合は、他のモデルに依存しないモデル
+     * (親モデルまたは親ボーンを持たないモデル) の更新を並列に行います。依存するモデルはその後に
+     * 登録順で逐次更新されます。いずれの場合も kResetMotionState と kUpdateRenderEngines の処理は
+     * 全てのモデルの更新が完了してから呼び出し元のスレッドで行われます。
+     *
      * @brief update
      * @param flags
      */
@@ -519,6 +525,17 @@ public:
      */
     IKeyframe::TimeIndex currentTimeIndex() const VPVL2_DECL_NOEXCEPT;
 
+    /**
+     * モデルの状態が更新された回数 (世代) を返します.
+     *
+     * Scene#update または Scene#updateModel を呼び出すたびに値が増えます。レンダリングエンジンは
+     * この値が変わらない間は IRenderEngine#update が複数回呼ばれてもスキニング済みの頂点を再計算せずに再利用します。
+     *
+     * @brief updateGeneration
+     * @return
+     */
+    int updateGeneration() const VPVL2_DECL_NOEXCEPT;
+
     /**
      * Scene が管理する照明のインスタンスの参照を返します.
      *
@@ -42,6 +42,7 @@
 /* libvpvl2 */
 #include <vpvl2/IApplicationContext.h>
 #include <vpvl2/IEffect.h>
+#include <vpvl2/IProgressReporter.h>
 #include <vpvl2/Scene.h>
 #include <vpvl2/extensions/StringMap.h>
 #include <vpvl2/gl/FrameBufferObject.h>
@@ -172,6 +173,33 @@ public:
         bool m_flipVertically;
     };
 
+    struct TextureCacheStatistics {
+        TextureCacheStatistics()
+            : nhits(0),
+              nmisses(0),
+              ntextures(0),
+              residentBytes(0),
+              savedBytes(0)
+        {
+        }
+        uint64 nhits;
+        uint64 nmisses;
+        int ntextures;
+        uint64 residentBytes;
+        uint64 savedBytes;
+    };
+    struct MatrixCacheStatistics {
+        MatrixCacheStatistics()
+            : nhits(0),
+              nmisses(0),
+              ninvalidations(0)
+        {
+        }
+        uint64 nhits;
+        uint64 nmisses;
+        uint64 ninvalidations;
+    };
+
     static bool initializeOnce(const char *argv0, const char *logdir, int vlog);
     static void terminate();
 
@@ -181,9 +209,10 @@ public:
     void initializeOpenGLContext(bool enableDebug);
     void release();
 
-    ITexture *uploadTextureFromFile(const IString *path, bool flipVertically);
+    ITexture *uploadTextureFromFile(const IString *path, bool flipVertically, int flags);
     ITexture *uploadEffectTexture(const IString *name, const IEffect *effectRef);
     ITexture *uploadModelTexture(const IString *name, int flags, void *userData);
+    void prefetchModelTextures(const IModel *model, ModelContext *context);
     void getMatrix(float32 value[], const IModel *model, int flags) const;
     IString *loadShaderSource(ShaderType type, const IModel *model, void *userData);
     IString *loadShaderSource(ShaderType type, const IString *path);
@@ -216,6 +245,8 @@ public:
         }
         const IEffect::OffscreenRenderTarget renderTarget;
         const EffectAttachmentRuleList attachmentRules;
+        /* model to the matched rule (or NULL if no rules are matched) resolved at the first lookup */
+        Hash<HashPtr, const EffectAttachmentRule *> resolvedRuleRefs;
         ITexture *colorTextureRef;
         gl::FrameBufferObject::StandardRenderBuffer depthStencilBuffer;
     private:
@@ -234,6 +265,7 @@ public:
     IModel *findEffectModelRef(const IEffect *effect) const;
     void setEffectModelRef(const IEffect *effectRef, IModel *model);
     void addModelFilePath(IModel *model, const std::string &path);
+    void removeModelFilePath(const IModel *model);
     std::string findEffectOwnerName(const IEffect *effect) const;
     gl::FrameBufferObject *viewportFrameBufferObjectRef() const;
     gl::FrameBufferObject *createFrameBufferObject();
@@ -274,12 +306,23 @@ public:
     void renderShadowMap();
 
     ITexture *uploadTexture(const void *ptr, const gl::BaseSurface::Format &format, const Vector3 &size) const;
-    ITexture *uploadTextureFromMemory(const uint8 *data, vsize size, bool flipVertically);
+    ITexture *uploadTextureFromMemory(const uint8 *data, vsize size, bool flipVertically, int flags);
+    ITexture *findSharedTexture(const uint8 *data, vsize size, bool flipVertically, int flags);
+    ITexture *shareTexture(const uint8 *data, vsize size, bool flipVertically, int flags, ITexture *texturePtr);
+    void getTextureCacheStatistics(TextureCacheStatistics &value) const;
+    void getMatrixCacheStatistics(MatrixCacheStatistics &value) const;
+    void uploadDecodedTextures();
+    void waitForDecodingTextures();
+    int countDecodingTextures() const;
+    IProgressReporter *textureProgressReporterRef() const;
+    void setTextureProgressReporterRef(IProgressReporter *value);
     void optimizeTexture(ITexture *texture);
 
 #ifdef VPVL2_ENABLE_NVIDIA_CG
     void bindOffscreenRenderTarget(OffscreenTexture *textureRef, bool enableAA);
     void releaseOffscreenRenderTarget(const OffscreenTexture *textureRef, bool enableAA);
+    const EffectAttachmentRule *resolveAttachmentRuleRef(OffscreenTexture *textureRef, const IModel *modelRef) const;
+    void invalidateAttachmentRules();
 #endif
 
     virtual bool mapFile(const std::string &path, MapBuffer *bufferRef) const = 0;
@@ -342,6 +385,41 @@ protected:
     typedef Hash<HashString, IModel *> Name2ModelRefMap;
     typedef std::pair<const IEffect::Parameter *, const char *> SharedTextureParameterKey;
     typedef std::map<SharedTextureParameterKey, SharedTextureParameter> SharedTextureParameterMap;
+    struct SharedTextureKey {
+        SharedTextureKey(const uint8 *data, vsize size, bool flipVertically, int flags);
+        bool operator<(const SharedTextureKey &other) const {
+            if (hash != other.hash) {
+                return hash < other.hash;
+            }
+            else if (size != other.size) {
+                return size < other.size;
+            }
+            return flags < other.flags;
+        }
+        uint64 hash;
+        vsize size;
+        int flags;
+    };
+    struct SharedTexture;
+    class SharedTextureRef;
+    class TextureDecoder;
+    /* keys of different contents may collide so entries are verified by comparing contents */
+    typedef std::multimap<SharedTextureKey, SharedTexture *> SharedTextureMap;
+    /* an entry per combination of matrix flags, the model is verified when the entry depends on it */
+    struct MatrixCacheValue {
+        MatrixCacheValue()
+            : modelRef(0),
+              scaleFactor(1),
+              generation(0)
+        {
+        }
+        glm::mat4 value;
+        const IModel *modelRef;
+        Transform worldTransform;
+        Vector3 lightDirection;
+        Scalar scaleFactor;
+        uint32 generation;
+    };
     glm::vec4 m_mouseCursorPosition;
     glm::vec4 m_mouseLeftPressPosition;
     glm::vec4 m_mouseMiddlePressPosition;
@@ -356,9 +434,17 @@ protected:
     EffectRef2ParameterUIRefMap m_effectRef2ParameterUIs;
     RenderTargetMap m_renderTargets;
     SharedTextureParameterMap m_sharedParameters;
+    SharedTextureMap m_sharedTextures;
+    TextureCacheStatistics m_textureCacheStatistics;
+    mutable MatrixCacheValue m_matrixCache[IApplicationContext::kMaxMatrixTypeFlags];
+    mutable MatrixCacheStatistics m_matrixCacheStatistics;
+    mutable int m_matrixCacheSceneGeneration;
+    mutable uint32 m_matrixCacheGeneration;
+    TextureDecoder *m_textureDecoderPtr;
+    IProgressReporter *m_textureProgressReporterRef;
     Array<IEffect::Technique *> m_offscreenTechniques;
     Array<IEffect *> m_dirtyEffects;
-#ifdef VPVl2_ENABLE_NVIDIA_CG
+#ifdef VPVL2_ENABLE_NVIDIA_CG
     typedef PointerArray<OffscreenTexture> OffscreenTextureList;
     OffscreenTextureList m_offscreenTextures;
 #endif
@@ -374,6 +460,14 @@ private:
     static void debugMessageCallback(gl::GLenum source, gl::GLenum type, gl::GLuint id, gl::GLenum severity,
                                      gl::GLsizei length, const gl::GLchar *message, gl::GLvoid *userData);
     void addGlobalEffect(const std::string &alias, const std::string &filename, StringMap &includeBuffers);
+    void detachSharedTextures();
+    void invalidateMatrixCache() const;
+    void computeMatrix(const IModel *model, int flags, glm::mat4 &m) const;
+    static void getModelWorldTransform(const IModel *model, Transform &value);
+    SharedTexture *findSharedTextureEntry(const SharedTextureKey &key, const uint8 *data) const;
+    SharedTexture *registerSharedTexture(const SharedTextureKey &key, const uint8 *data, ITexture *texturePtr);
+    ITexture *decodeTextureAsync(const uint8 *data, vsize size, bool flipVertically, int flags);
+    void prefetchTexture(const uint8 *data, vsize size, bool flipVertically);
 
     VPVL2_DISABLE_COPY_AND_ASSIGN(BaseApplicationContext)
 };
@@ -57,6 +57,7 @@ namespace extensions
 class VPVL2_API World VPVL2_DECL_FINAL {
 public:
     static const int kDefaultMaxSubSteps;
+    static const vsize kDefaultCheckpointMemoryBudget;
 
     World();
     ~World();
@@ -66,6 +67,42 @@ public:
     void deleteAll();
     void stepSimulation(const Scalar &deltaTimeIndex, const Scalar &motionFPS);
 
+    /*
+     * Models added by addModel get their own simulation island stepped concurrently
+     * when islands are enabled, unless sharedCollision is set (collides with other models)
+     * or islands are disabled, then they join the shared world of dynamicWorldRef().
+     * Don't set the shared world to Scene::setWorldRef for models added here, and reset
+     * their motion states by resetMotionState instead of Scene::resetMotionState.
+     * Models must be removed before they are destroyed; remaining ones leave on destruction.
+     */
+    void addModel(IModel *value, bool sharedCollision);
+    bool removeModel(IModel *value);
+    void removeAllModels();
+    void resetMotionState();
+    bool isIslandEnabled() const;
+    void setIslandEnabled(bool value);
+
+    /*
+     * A checkpoint is a snapshot of transforms and velocities of all dynamic rigid bodies
+     * at the time index. Seeking restores the nearest earlier checkpoint and simulates only
+     * the remainder. Rigid bodies of models are matched by the model and the rigid body index,
+     * so the user pointer of other dynamic bodies in the world must be null. Checkpoints are
+     * thinned out when they exceed the memory budget and cleared when models are added or
+     * removed; clear them when motions are changed too.
+     *
+     * stepSimulation runs at most maxSubSteps (kDefaultMaxSubSteps by default) fixed steps
+     * per call, so seeking far without a checkpoint doesn't stall.
+     */
+    void saveCheckpoint(const Scalar &timeIndex);
+    bool findCheckpoint(const Scalar &timeIndex, Scalar &checkpointTimeIndex) const;
+    bool restoreCheckpoint(const Scalar &timeIndex);
+    void clearCheckpoints();
+    int countCheckpoints() const;
+    vsize checkpointMemoryBudget() const;
+    void setCheckpointMemoryBudget(vsize value);
+    int maxSubSteps() const;
+    void setMaxSubSteps(int value);
+
     const Vector3 gravity() const;
     btDiscreteDynamicsWorld *dynamicWorldRef() const;
     void setGravity(const Vector3 &value);
@@ -65,6 +65,12 @@ namespace extensions
  * @section DESCRIPTION
  *
  * Project class represents a project file (*.vpvx)
+ *
+ * The same content can be also stored as a compact binary container (*.vpvb). It consists
+ * of a header, an index of chunks (settings, models, assets and motions) and the chunks.
+ * Keyframes of a motion are stored as raw little-endian arrays, and motion chunks can be
+ * decoded lazily through the index. Loading either form and saving as the other converts
+ * the project without losing content.
  */
 
 class VPVL2_API XMLProject VPVL2_DECL_FINAL : public Scene
@@ -89,6 +95,7 @@ public:
     static const std::string kSettingOrderKey;
 
     static float32 formatVersion();
+    static bool isBinaryFormat(const uint8 *data, vsize size);
     static bool isReservedSettingKey(const std::string &key);
     static std::string toStringFromFloat32(float32 value);
     static std::string toStringFromVector3(const Vector3 &value);
@@ -106,8 +113,14 @@ public:
     bool load(const char *path);
     bool load(const uint8 *data, vsize size);
     bool save(const char *path);
+    bool saveBinary(const char *path);
     void clear();
 
+    bool loadMotion(const UUID &uuid);
+    const UUIDList pendingMotionUUIDs() const;
+    bool isMotionLazyLoadEnabled() const;
+    void setMotionLazyLoadEnable(bool value);
+
     std::string version() const;
     std::string globalSetting(const std::string &key) const;
     std::string modelSetting(const IModel *model, const std::string &key) const;
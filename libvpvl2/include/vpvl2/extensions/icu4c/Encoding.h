@@ -56,6 +56,11 @@ namespace icu4c
 class VPVL2_API Encoding VPVL2_DECL_FINAL : public IEncoding {
 public:
     typedef Hash<HashInt, const IString *> Dictionary;
+    /**
+     * Strings converted by toString up to this length (names) are interned to the symbol table
+     * and decoded lazily. Interned strings must not outlive the encoding object.
+     */
+    static const vsize kMaxSymbolLength = 128;
 
     static const char *commonDataPath();
     static bool initializeOnce();
@@ -72,11 +77,13 @@ public:
     IString::Codec detectCodec(const char *data, vsize length) const;
 
     IString *createString(const UnicodeString &value) const;
+    const String::SymbolTable *symbolTable() const;
 
 private:
     const Dictionary *m_dictionaryRef;
     const String m_null;
     String::Converter m_converter;
+    mutable String::SymbolTable m_symbolTable;
     UCharsetDetector *m_detector;
 
     VPVL2_DISABLE_COPY_AND_ASSIGN(Encoding)
@@ -95,6 +95,30 @@ public:
         UConverter *utf8;
         UConverter *utf16;
     };
+    struct Symbol;
+
+    /**
+     * Interns raw encoded names (bone, morph, material and so on) and decodes each of them only once
+     * on the first access. Decoded names share a canonical UTF-8 buffer with a stable integer ID, so
+     * HashString keys made from the same name have the same pointer. Symbols and IDs are removed
+     * when the last string referring them is deleted.
+     */
+    class SymbolTable {
+    public:
+        SymbolTable();
+        ~SymbolTable();
+
+        String *newString(const uint8 *value, vsize size, IString::Codec codec, const Converter *converterRef);
+        int countSymbols() const;
+        int countIdentifiers() const;
+
+    private:
+        struct PrivateContext;
+        friend struct Symbol;
+        PrivateContext *m_context;
+
+        VPVL2_DISABLE_COPY_AND_ASSIGN(SymbolTable)
+    };
     struct Less {
         /* use custom std::less alternative to prevent warning on MSVC */
         bool operator()(const UnicodeString &left, const UnicodeString &right) const {
@@ -106,6 +130,7 @@ public:
     static std::string toStdString(const UnicodeString &value);
 
     explicit String(const UnicodeString &value, IString::Codec codec = IString::kUTF8, const Converter *converterRef = 0);
+    String(Symbol *symbolRef, IString::Codec codec, const Converter *converterRef);
     ~String();
 
     bool startsWith(const IString *value) const;
@@ -120,8 +145,13 @@ public:
     std::string toStdString() const;
     const uint8 *toByteArray() const;
     vsize size() const;
+    int symbolId() const;
 
 private:
+    const UnicodeString &unicode() const;
+    const std::string &utf8() const;
+
+    Symbol *m_symbolRef;
     const Converter *m_converterRef;
     const UnicodeString m_value;
     const IString::Codec m_codec;
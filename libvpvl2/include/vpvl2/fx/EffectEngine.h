@@ -697,6 +697,13 @@ private:
     class RectangleRenderEngine;
 
     static bool containsSubset(const IEffect::Annotation *annotation, int subset, int nmaterials);
+    IEffect::Technique *findTechniqueUncached(const char *pass,
+                                              int offset,
+                                              int nmaterials,
+                                              bool hasTexture,
+                                              bool hasSphereMap,
+                                              bool useToon,
+                                              bool enabled) const;
     static bool testTechnique(const IEffect::Technique *technique,
                               const char *pass,
                               int offset,
@@ -760,6 +767,8 @@ private:
     Hash<HashInt, const RenderDepthStencilTargetSemantic::Buffer *> m_target2BufferRefs;
     btHashMap<btHashPtr, Script> m_techniqueScripts;
     btHashMap<btHashPtr, Script> m_passScripts;
+    mutable Hash<HashInt, IEffect::Technique *> m_techniqueTable;
+    mutable int m_techniqueTableMaterials;
 
     VPVL2_DISABLE_COPY_AND_ASSIGN(EffectEngine)
 };
@@ -163,6 +163,7 @@ private:
     bool releaseUserData0(void *userData);
     void initializeEffectParameters(int extraCameraFlags);
     void refreshEffect();
+    void bindBoneTransformTexture();
     void createVertexBundle(gl::VertexBundleLayout *layout, IModel::Buffer::StrideType strideType, gl::GLuint dvbo);
     void unbindVertexBundle();
     void bindDynamicVertexAttributePointers(IModel::Buffer::StrideType type);
@@ -209,6 +210,10 @@ private:
     gl::GLenum m_indexType;
     Vector3 m_aabbMin;
     Vector3 m_aabbMax;
+    int m_lastDirtyVertexFrom;
+    int m_lastDirtyVertexTo;
+    int m_lastUpdateCount;
+    int m_updatedGeneration;
     bool m_cullFaceState;
     bool m_updateEvenBuffer;
 
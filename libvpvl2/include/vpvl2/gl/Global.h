@@ -70,6 +70,8 @@ typedef unsigned int GLuint;
 typedef unsigned int GLbitfield;
 typedef ptrdiff_t GLintptr;
 typedef ptrdiff_t GLsizeiptr;
+typedef uint64 GLuint64;
+typedef struct __GLsync *GLsync;
 
 static const GLenum kGL_FALSE = 0;
 static const GLenum kGL_TRUE = 1;
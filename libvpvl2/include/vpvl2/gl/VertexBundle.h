@@ -57,6 +57,14 @@ public:
     static const GLenum kGL_ELEMENT_ARRAY_BUFFER = 0x8893;
     static const GLenum kGL_WRITE_ONLY = 0x88B9;
     static const GLenum kGL_MAP_WRITE_BIT = 0x0002;
+    static const GLenum kGL_MAP_INVALIDATE_BUFFER_BIT = 0x0008;
+    static const GLenum kGL_MAP_UNSYNCHRONIZED_BIT = 0x0020;
+    static const GLenum kGL_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+    static const GLenum kGL_SYNC_FLUSH_COMMANDS_BIT = 0x00000001;
+    static const GLenum kGL_ALREADY_SIGNALED = 0x911A;
+    static const GLenum kGL_TIMEOUT_EXPIRED = 0x911B;
+    static const GLenum kGL_CONDITION_SATISFIED = 0x911C;
+    static const GLenum kGL_WAIT_FAILED = 0x911D;
     static const GLenum kGL_TRANSFORM_FEEDBACK_BUFFER = 0x8C8E;
     static const GLenum kGL_RASTERIZER_DISCARD = 0x8C89;
     static const GLenum kGL_INTERLEAVED_ATTRIBS = 0x8C8C;
@@ -88,12 +96,24 @@ public:
           mapBuffer(reinterpret_cast<PFNGLMAPBUFFERPROC>(resolver->resolveSymbol("glMapBuffer"))),
           unmapBuffer(reinterpret_cast<PFNGLUNMAPBUFFERPROC>(resolver->resolveSymbol("glUnmapBuffer"))),
           mapBufferRange(0),
+          fenceSync(0),
+          clientWaitSync(0),
+          deleteSync(0),
           m_indexBuffer(0),
           m_query(0)
+#ifdef VPVL2_ENABLE_GLES2
+        , m_mappedOffset(0)
+#endif
     {
         if (resolver->hasExtension("ARB_map_buffer_range")) {
             mapBufferRange = reinterpret_cast<PFNGLMAPBUFFERRANGEPROC>(resolver->resolveSymbol("glMapBufferRange"));
         }
+        if (resolver->query(IApplicationContext::FunctionResolver::kQueryVersion) >= gl::makeVersion(3, 2) ||
+                resolver->hasExtension("ARB_sync")) {
+            fenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(resolver->resolveSymbol("glFenceSync"));
+            clientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(resolver->resolveSymbol("glClientWaitSync"));
+            deleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(resolver->resolveSymbol("glDeleteSync"));
+        }
         if (resolver->query(IApplicationContext::FunctionResolver::kQueryVersion) >= gl::makeVersion(3, 0)) {
             bindBufferBase = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>(resolver->resolveSymbol("glBindBufferBase"));
             transformFeedbackVaryings = reinterpret_cast<PFNGLTRANSFORMFEEDBACKVARYINGSPROC>(resolver->resolveSymbol("glTransformFeedbackVaryings"));
@@ -115,6 +135,10 @@ public:
             const GLuint *value = m_vertexBuffers.value(i);
             deleteBuffers(1, value);
         }
+        const int numFences = m_fences.count();
+        for (int i = 0; i < numFences; i++) {
+            deleteSync(*m_fences.value(i));
+        }
         if (m_query) {
             deleteQueries(1, &m_query);
         }
@@ -145,6 +169,10 @@ public:
                 deleteBuffers(1, buffer);
                 m_vertexBuffers.remove(key);
             }
+            if (const GLsync *fence = m_fences.find(key)) {
+                deleteSync(*fence);
+                m_fences.remove(key);
+            }
             break;
         }
         case kIndexBuffer: {
@@ -223,16 +251,18 @@ public:
         return glMapBufferSubDataCHROMIUM(target, offset, size, GL_WRITE_ONLY);
 #elif defined(VPVL2_ENABLE_GLES2)
         (void) target;
-        (void) offset;
         m_bytes.resize(int(size));
+        m_mappedOffset = offset;
         return &m_bytes[0];
 #else /* GL_CHROMIUM_map_sub */
         if (mapBufferRange) {
             return mapBufferRange(target, offset, size, kGL_MAP_WRITE_BIT);
         }
-        else {
-            return mapBuffer(target, kGL_WRITE_ONLY);
+        else if (uint8_t *address = static_cast<uint8_t *>(mapBuffer(target, kGL_WRITE_ONLY))) {
+            /* glMapBuffer always maps whole buffer */
+            return address + offset;
         }
+        return 0;
 #endif /* GL_CHROMIUM_map_sub */
     }
     void unmap(Type type, void *address) {
@@ -242,13 +272,54 @@ public:
 #elif defined(VPVL2_ENABLE_GLES2)
         (void) address;
         GLuint target = type2target(type);
-        bufferSubData(target, 0, m_bytes.count(), &m_bytes[0]);
+        bufferSubData(target, m_mappedOffset, m_bytes.count(), &m_bytes[0]);
 #else /* GL_CHROMIUM_map_sub */
         (void) address;
         GLuint target = type2target(type);
         unmapBuffer(target);
 #endif /* GL_CHROMIUM_map_sub */
     }
+    bool isSyncAvailable() const {
+#if defined(GL_CHROMIUM_map_sub) || defined(VPVL2_ENABLE_GLES2)
+        return false;
+#else
+        return mapBufferRange && fenceSync && clientWaitSync && deleteSync;
+#endif
+    }
+    void *mapUnsynchronized(Type type, vsize offset, vsize size) {
+#if defined(GL_CHROMIUM_map_sub) || defined(VPVL2_ENABLE_GLES2)
+        return map(type, offset, size);
+#else
+        if (mapBufferRange) {
+            /* caller must wait the fence of the buffer before writing (see waitFence) */
+            GLuint target = type2target(type);
+            return mapBufferRange(target, offset, size, kGL_MAP_WRITE_BIT | kGL_MAP_INVALIDATE_BUFFER_BIT | kGL_MAP_UNSYNCHRONIZED_BIT);
+        }
+        return map(type, offset, size);
+#endif
+    }
+    void insertFence(GLuint key) {
+        if (fenceSync && m_vertexBuffers.find(key)) {
+            if (const GLsync *fence = m_fences.find(key)) {
+                deleteSync(*fence);
+            }
+            m_fences.insert(key, fenceSync(kGL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        }
+    }
+    /* returns kGL_CONDITION_SATISFIED if it had to wait, the buffer must not be mapped unsynchronized unless signaled */
+    GLenum waitFence(GLuint key, GLuint64 timeout) {
+        GLenum result = kGL_ALREADY_SIGNALED;
+        if (const GLsync *fencePtr = m_fences.find(key)) {
+            GLsync fence = *fencePtr;
+            result = clientWaitSync(fence, 0, 0);
+            while (result == kGL_TIMEOUT_EXPIRED) {
+                result = clientWaitSync(fence, kGL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+            }
+            deleteSync(fence);
+            m_fences.remove(key);
+        }
+        return result;
+    }
     GLuint findName(GLuint key) const {
         if (const GLuint *value = m_vertexBuffers.find(key)) {
             return *value;
@@ -306,6 +377,9 @@ private:
     typedef GLvoid* (GLAPIENTRY * PFNGLMAPBUFFERPROC) (GLenum target, GLenum access);
     typedef GLboolean (GLAPIENTRY * PFNGLUNMAPBUFFERPROC) (GLenum target);
     typedef GLvoid * (GLAPIENTRY * PFNGLMAPBUFFERRANGEPROC) (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    typedef GLsync (GLAPIENTRY * PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
+    typedef GLenum (GLAPIENTRY * PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+    typedef void (GLAPIENTRY * PFNGLDELETESYNCPROC) (GLsync sync);
     PFNGLGENBUFFERSPROC genBuffers;
     PFNGLBINDBUFFERPROC bindBuffer;
     PFNGLBUFFERDATAPROC bufferData;
@@ -324,12 +398,17 @@ private:
     PFNGLMAPBUFFERPROC mapBuffer;
     PFNGLUNMAPBUFFERPROC unmapBuffer;
     PFNGLMAPBUFFERRANGEPROC mapBufferRange;
+    PFNGLFENCESYNCPROC fenceSync;
+    PFNGLCLIENTWAITSYNCPROC clientWaitSync;
+    PFNGLDELETESYNCPROC deleteSync;
 
     Hash<HashInt, GLuint> m_vertexBuffers;
+    Hash<HashInt, GLsync> m_fences;
     GLuint m_indexBuffer;
     GLuint m_query;
 #ifdef VPVL2_ENABLE_GLES2
     Array<uint8_t> m_bytes;
+    vsize m_mappedOffset;
 #endif
 
     VPVL2_DISABLE_COPY_AND_ASSIGN(VertexBundle)
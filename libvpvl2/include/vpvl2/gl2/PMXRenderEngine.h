@@ -67,6 +67,18 @@ class BaseShaderProgram;
 class VPVL2_API PMXRenderEngine : public IRenderEngine
 {
 public:
+    struct UploadStatistics {
+        UploadStatistics()
+            : nbytes(0),
+              nwaits(0),
+              elapsed(0)
+        {
+        }
+        vsize nbytes;
+        int nwaits;
+        float64 elapsed;
+    };
+
     PMXRenderEngine(IApplicationContext *applicationContextRef,
                     Scene *scene,
                     cl::PMXAccelerator *accelerator,
@@ -92,6 +104,13 @@ public:
     void setOverridePass(IEffect::Pass *pass);
     bool testVisible();
 
+    /**
+     * Get bytes, count of fence waits and elapsed seconds of the dynamic vertex upload in the last update.
+     *
+     * elapsed is always zero unless linking Intel TBB.
+     */
+    void getUploadStatistics(UploadStatistics &value) const;
+
 private:
     typedef void (GLAPIENTRY * PFNGLCULLFACEPROC) (gl::GLenum mode);
     typedef void (GLAPIENTRY * PFNGLENABLEPROC) (gl::GLenum cap);
@@ -0,0 +1,136 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_INTERNAL_ARENA_H_
+#define VPVL2_INTERNAL_ARENA_H_
+
+#include "vpvl2/Common.h"
+
+#include <new>
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+/**
+ * Arena allocates objects of a model from large blocks and frees all of them at once.
+ *
+ * Each allocation is prefixed with a header pointing the owner pool of blocks, so objects
+ * allocated from the heap (without arena) and from an arena can be released by the same
+ * operator delete. Releasing an object allocated from an arena only destructs it; the blocks
+ * are freed when the arena is destroyed or reset and all objects allocated from them are
+ * released, so an object removed from the model (and added to another) stays valid after
+ * the model is destroyed. Arena is not thread safe including releasing objects.
+ */
+class VPVL2_API Arena VPVL2_DECL_FINAL {
+public:
+    struct Statistics {
+        Statistics()
+            : nblocks(0),
+              nobjects(0),
+              nliveObjects(0),
+              reservedBytes(0),
+              usedBytes(0),
+              releasedBytes(0)
+        {
+        }
+        void add(const Statistics &value) {
+            nblocks += value.nblocks;
+            nobjects += value.nobjects;
+            nliveObjects += value.nliveObjects;
+            reservedBytes += value.reservedBytes;
+            usedBytes += value.usedBytes;
+            releasedBytes += value.releasedBytes;
+        }
+        int nblocks;
+        int nobjects;
+        int nliveObjects;
+        vsize reservedBytes;
+        vsize usedBytes;
+        vsize releasedBytes;
+    };
+    static const vsize kDefaultBlockSize = 64 * 1024;
+
+    Arena();
+    ~Arena();
+
+    static void *allocate(vsize size, Arena *arena);
+    static void release(void *ptr) VPVL2_DECL_NOEXCEPT;
+
+    void reset();
+    void getStatistics(Statistics &value) const;
+
+private:
+    struct Header;
+    struct Pool;
+    void *allocateFromBlock(vsize size);
+    void addBlock(vsize size);
+    void detachPool();
+
+    Pool *m_pool;
+    uint8 *m_currentBlock;
+    vsize m_offset;
+    vsize m_capacity;
+    Statistics m_statistics;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(Arena)
+};
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+/* declares class specific operator new/delete to be able to allocate the object from the arena */
+#define VPVL2_DECLARE_ARENA_ALLOCATABLE() \
+    static void *operator new(std::size_t size) { \
+        return vpvl2::VPVL2_VERSION_NS::internal::Arena::allocate(size, 0); \
+    } \
+    static void *operator new(std::size_t size, vpvl2::VPVL2_VERSION_NS::internal::Arena *arena) { \
+        return vpvl2::VPVL2_VERSION_NS::internal::Arena::allocate(size, arena); \
+    } \
+    static void operator delete(void *ptr) { \
+        vpvl2::VPVL2_VERSION_NS::internal::Arena::release(ptr); \
+    } \
+    static void operator delete(void *ptr, vpvl2::VPVL2_VERSION_NS::internal::Arena * /* arena */) { \
+        vpvl2::VPVL2_VERSION_NS::internal::Arena::release(ptr); \
+    }
+
+#endif
@@ -63,19 +63,52 @@ struct InterpolationPair VPVL2_DECL_FINAL {
 
 #pragma pack(pop)
 
+/**
+ * Process-wide registry of immutable interpolation curve tables.
+ *
+ * Curve tables are keyed by four control points and the table size. Keyframes
+ * share the table returned by findOrCreate and must not free it, but must call
+ * release when they drop or rebind it.
+ */
+class VPVL2_API InterpolationCurveRegistry VPVL2_DECL_FINAL {
+public:
+    struct Statistics {
+        Statistics()
+            : ncurves(0),
+              nlookups(0),
+              bytes(0)
+        {
+        }
+        int ncurves;
+        /* count of tables currently bound by keyframes; tables themselves are never freed */
+        int nlookups;
+        vsize bytes;
+    };
+
+    static const IKeyframe::SmoothPrecision *findOrCreate(const QuadWord &value, int size);
+    static void release(const IKeyframe::SmoothPrecision *table);
+    static void getStatistics(Statistics &value);
+
+private:
+    VPVL2_MAKE_STATIC_CLASS(InterpolationCurveRegistry)
+};
+
 struct InterpolationTable VPVL2_DECL_FINAL {
-    typedef Array<IKeyframe::SmoothPrecision> Value;
+    typedef const IKeyframe::SmoothPrecision *Value;
     Value table;
     QuadWord parameter;
     bool linear;
     int size;
     InterpolationTable()
-        : parameter(defaultParameter()),
+        : table(0),
+          parameter(defaultParameter()),
           linear(true),
           size(0)
     {
     }
     ~InterpolationTable() {
+        InterpolationCurveRegistry::release(table);
+        table = 0;
         parameter = defaultParameter();
         linear = true;
         size = 0;
@@ -87,23 +120,21 @@ struct InterpolationTable VPVL2_DECL_FINAL {
         pair.second.y = uint8(parameter.w());
     }
     void build(const QuadWord &value, int s) {
+        InterpolationCurveRegistry::release(table);
         if (!btFuzzyZero(value.x() - value.y()) || !btFuzzyZero(value.z() - value.w())) {
-            table.resize(s + 1);
-            const IKeyframe::SmoothPrecision &x1 = value.x() / 127.0f, &x2 = value.z() / 127.0f;
-            const IKeyframe::SmoothPrecision &y1 = value.y() / 127.0f, &y2 = value.w() / 127.0f;
-            IKeyframe::SmoothPrecision *ptr = &table[0];
-            build(x1, x2, y1, y2, s, ptr);
+            table = InterpolationCurveRegistry::findOrCreate(value, s);
             linear = false;
         }
         else {
-            table.clear();
+            table = 0;
             linear = true;
         }
         parameter = value;
         size = s;
     }
     void reset() {
-        table.clear();
+        InterpolationCurveRegistry::release(table);
+        table = 0;
         linear = true;
         parameter = defaultParameter();
     }
@@ -152,6 +183,9 @@ struct InterpolationTable VPVL2_DECL_FINAL {
         }
         table[size] = 1;
     }
+
+private:
+    VPVL2_DISABLE_COPY_AND_ASSIGN(InterpolationTable)
 };
 
 } /* namespace internal */
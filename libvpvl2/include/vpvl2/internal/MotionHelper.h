@@ -66,40 +66,91 @@ public:
     };
 
     template<typename T>
+    static inline IKeyframe::TimeIndex keyframeTimeIndexAt(const Array<T *> &keyframes, int index) VPVL2_DECL_NOEXCEPT
+    {
+        return keyframes[index]->timeIndex();
+    }
+    static inline IKeyframe::TimeIndex keyframeTimeIndexAt(const IKeyframe::TimeIndex *timeIndices, int index) VPVL2_DECL_NOEXCEPT
+    {
+        return timeIndices[index];
+    }
+    /**
+     * Finds the first keyframe index in [first, last) that has time index equal or greater than value
+     * and returns last if not found. keyframes must be sorted by time index.
+     */
+    template<typename TKeyframes>
+    static int lowerBoundKeyframeIndex(const IKeyframe::TimeIndex &value,
+                                       int first,
+                                       int last,
+                                       const TKeyframes &keyframes) VPVL2_DECL_NOEXCEPT
+    {
+        int count = last - first;
+        while (count > 0) {
+            const int step = count / 2, middle = first + step;
+            if (keyframeTimeIndexAt(keyframes, middle) < value) {
+                first = middle + 1;
+                count -= step + 1;
+            }
+            else {
+                count = step;
+            }
+        }
+        return first;
+    }
+    /**
+     * Finds a pair of keyframe indices to interpolate at seekIndex.
+     *
+     * lastIndex is a cursor of the previous call. Sequential playback finds the keyframe within
+     * a few steps from the cursor (O(1)) and any other seeks fall back to binary search (O(log n)).
+     * keyframes is either an array of keyframes or an array of time indices of the keyframes.
+     */
+    template<typename TKeyframes>
     static void findKeyframeIndices(const IKeyframe::TimeIndex &seekIndex,
                                     IKeyframe::TimeIndex &currentKeyframe,
                                     int &lastIndex,
                                     int &fromIndex,
                                     int &toIndex,
-                                    const Array<T *> &keyframes) VPVL2_DECL_NOEXCEPT
+                                    const TKeyframes &keyframes,
+                                    int nframes) VPVL2_DECL_NOEXCEPT
     {
-        const int nframes = keyframes.count();
-        IKeyframe *lastKeyFrame = keyframes[nframes - 1];
-        currentKeyframe = btMin(seekIndex, lastKeyFrame->timeIndex());
+        static const int kMaxLinearSearchSteps = 4;
+        currentKeyframe = btMin(seekIndex, keyframeTimeIndexAt(keyframes, nframes - 1));
+        if (!internal::checkBound(lastIndex, 0, nframes)) {
+            lastIndex = 0;
+        }
         // Find the next frame index bigger than the frame index of last key frame
-        fromIndex = toIndex = 0;
-        if (currentKeyframe >= keyframes[lastIndex]->timeIndex()) {
-            for (int i = lastIndex; i < nframes; i++) {
-                if (currentKeyframe <= keyframes[i]->timeIndex()) {
-                    toIndex = i;
-                    break;
-                }
+        int index = nframes;
+        if (currentKeyframe >= keyframeTimeIndexAt(keyframes, lastIndex)) {
+            const int end = btMin(lastIndex + kMaxLinearSearchSteps, nframes);
+            index = lastIndex;
+            while (index < end && keyframeTimeIndexAt(keyframes, index) < currentKeyframe) {
+                index++;
+            }
+            if (index == end) {
+                index = lowerBoundKeyframeIndex(currentKeyframe, end, nframes, keyframes);
             }
         }
         else {
-            for (int i = 0; i <= lastIndex && i < nframes; i++) {
-                if (currentKeyframe <= keyframes[i]->timeIndex()) {
-                    toIndex = i;
-                    break;
-                }
+            const int end = lastIndex + 1;
+            index = lowerBoundKeyframeIndex(currentKeyframe, 0, end, keyframes);
+            if (index == end) {
+                index = nframes;
             }
         }
-        if (toIndex >= nframes) {
-            toIndex = nframes - 1;
-        }
+        toIndex = index < nframes ? index : 0;
         fromIndex = toIndex <= 1 ? 0 : toIndex - 1;
         lastIndex = fromIndex;
     }
+    template<typename T>
+    static void findKeyframeIndices(const IKeyframe::TimeIndex &seekIndex,
+                                    IKeyframe::TimeIndex &currentKeyframe,
+                                    int &lastIndex,
+                                    int &fromIndex,
+                                    int &toIndex,
+                                    const Array<T *> &keyframes) VPVL2_DECL_NOEXCEPT
+    {
+        findKeyframeIndices(seekIndex, currentKeyframe, lastIndex, fromIndex, toIndex, keyframes, keyframes.count());
+    }
     template<typename TMotion>
     static inline bool isReachedToDuration(const TMotion &motion, const IKeyframe::TimeIndex &atEnd) VPVL2_DECL_NOEXCEPT
     {
@@ -66,6 +66,10 @@ static inline bool LessOMP(const Vector3 &left, const Vector3 &right) VPVL2_DECL
     return left.x() > right.x() ||  left.y() > right.y() || left.z() > right.z();
 }
 
+/*
+ * processors below must not keep a static tbb::affinity_partitioner
+ * because a processor may be executed by multiple models concurrently
+ */
 template<typename TModel, typename TVertex, typename TUnit>
 class ParallelSkinningVertexProcessor VPVL2_DECL_FINAL {
 public:
@@ -102,8 +106,7 @@ public:
         const int nvertices = m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
         if (enableParallel) {
-            static tbb::affinity_partitioner affinityPartitioner;
-            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this);
         }
         else {
 #else
@@ -156,8 +159,7 @@ public:
         const int nvertices = m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
         if (enableParallel) {
-            static tbb::affinity_partitioner affinityPartitioner;
-            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this);
         }
         else {
 #else
@@ -184,16 +186,31 @@ public:
     ParallelVertexMorphProcessor(const Array<TVertex *> *verticesRef,
                                  void *address)
         : m_verticesRef(verticesRef),
-          m_bufferPtr(static_cast<TUnit *>(address))
+          m_bufferPtr(static_cast<TUnit *>(address)),
+          m_offset(0),
+          m_count(verticesRef->count())
+    {
+    }
+    /* address points the unit of the vertex at "from" */
+    ParallelVertexMorphProcessor(const Array<TVertex *> *verticesRef,
+                                 void *address,
+                                 int from,
+                                 int to)
+        : m_verticesRef(verticesRef),
+          m_bufferPtr(static_cast<TUnit *>(address)),
+          m_offset(from),
+          m_count(to - from)
     {
     }
     ~ParallelVertexMorphProcessor() {
         m_verticesRef = 0;
         m_bufferPtr = 0;
+        m_offset = 0;
+        m_count = 0;
     }
 
     inline void performTransform(int index) const VPVL2_DECL_NOEXCEPT {
-        const TVertex *vertex = m_verticesRef->at(index);
+        const TVertex *vertex = m_verticesRef->at(m_offset + index);
         TUnit &v = m_bufferPtr[index];
         v.setPosition(vertex);
     }
@@ -205,11 +222,10 @@ public:
     }
 #endif /* VPVL2_LINK_INTEL_TBB */
     void execute(bool enableParallel) {
-        const int nvertices = m_verticesRef->count();
+        const int nvertices = m_count;
 #if defined(VPVL2_LINK_INTEL_TBB)
         if (enableParallel) {
-            static tbb::affinity_partitioner affinityPartitioner;
-            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+            tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this);
         }
         else {
 #else
@@ -228,6 +244,8 @@ public:
 private:
     const Array<TVertex *> *m_verticesRef;
     TUnit *m_bufferPtr;
+    int m_offset;
+    int m_count;
 };
 
 template<typename TVertex>
@@ -256,8 +274,7 @@ public:
     void execute() {
         const int nvertices = m_verticesRef->count();
 #if defined(VPVL2_LINK_INTEL_TBB)
-        static tbb::affinity_partitioner affinityPartitioner;
-        tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this, affinityPartitioner);
+        tbb::parallel_for(tbb::blocked_range<int>(0, nvertices), *this);
 #else
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
@@ -272,6 +289,56 @@ private:
     const Array<TVertex *> *m_verticesRef;
 };
 
+template<typename TElement, typename TDataInfo>
+class ParallelReadElementProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelReadElementProcessor(const Array<TElement *> *elementsRef,
+                                 const Array<uint8 *> *ptrsRef,
+                                 const TDataInfo *infoRef)
+        : m_elementsRef(elementsRef),
+          m_ptrsRef(ptrsRef),
+          m_infoRef(infoRef)
+    {
+    }
+    ~ParallelReadElementProcessor() {
+        m_elementsRef = 0;
+        m_ptrsRef = 0;
+        m_infoRef = 0;
+    }
+
+    inline void performTransform(int index) const {
+        TElement *element = m_elementsRef->at(index);
+        vsize size = 0;
+        element->read(m_ptrsRef->at(index), *m_infoRef, size);
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        for (int i = range.begin(), end = range.end(); i != end; ++i) {
+            performTransform(i);
+        }
+    }
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute() {
+        const int nelements = m_elementsRef->count();
+#if defined(VPVL2_LINK_INTEL_TBB)
+        tbb::parallel_for(tbb::blocked_range<int>(0, nelements), *this);
+#else
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < nelements; ++i) {
+            performTransform(i);
+        }
+#endif
+    }
+
+private:
+    const Array<TElement *> *m_elementsRef;
+    const Array<uint8 *> *m_ptrsRef;
+    const TDataInfo *m_infoRef;
+};
+
 template<typename TBone>
 class ParallelUpdateLocalTransformProcessor VPVL2_DECL_FINAL {
 public:
@@ -298,8 +365,7 @@ public:
     void execute() const {
         const int nbones = m_boneRefs->count();
 #ifdef VPVL2_LINK_INTEL_TBB
-        static tbb::affinity_partitioner partitioner;
-        tbb::parallel_for(tbb::blocked_range<int>(0, nbones), *this, partitioner);
+        tbb::parallel_for(tbb::blocked_range<int>(0, nbones), *this);
 #else
 #ifdef VPVL2_ENABLE_OPENMP
 #pragma omp parallel for
@@ -354,6 +420,47 @@ private:
     mutable Array<TRigidBody *> *m_rigidBodyRefs;
 };
 
+template<typename TModel>
+class ParallelUpdateModelProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelUpdateModelProcessor(const Array<TModel *> *modelRefs)
+        : m_modelRefs(modelRefs)
+    {
+    }
+    ~ParallelUpdateModelProcessor() {
+        m_modelRefs = 0;
+    }
+
+    inline void performTransform(int index) const {
+        TModel *model = m_modelRefs->at(index);
+        model->performUpdate();
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        for (int i = range.begin(), end = range.end(); i != end; ++i) {
+            performTransform(i);
+        }
+    }
+#endif
+    void execute() const {
+        const int nmodels = m_modelRefs->count();
+#ifdef VPVL2_LINK_INTEL_TBB
+        /* a model is a coarse grained task so split the range into each model to be stolen by idle workers */
+        tbb::parallel_for(tbb::blocked_range<int>(0, nmodels, 1), *this, tbb::simple_partitioner());
+#else /* VPVL2_LINK_INTEL_TBB */
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+        for (int i = 0; i < nmodels; i++) {
+            performTransform(i);
+        }
+#endif /* VPVL2_LINK_INTEL_TBB */
+    }
+
+private:
+    const Array<TModel *> *m_modelRefs;
+};
+
 template<typename TMaterial, typename TUnit>
 class ParallelComputeAabbProcessor VPVL2_DECL_FINAL {
 public:
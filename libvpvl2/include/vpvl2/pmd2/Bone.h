@@ -74,8 +74,11 @@ public:
     static const int kCategoryNameSize;
 
     Bone(Model *parentModelRef, IEncoding *encodingRef);
+    Bone(Model *parentModelRef, IEncoding *encodingRef, internal::Arena *arenaRef);
     ~Bone();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     const IString *name(IEncoding::LanguageType type) const;
     void setName(const IString *value, IEncoding::LanguageType type);
     int index() const;
@@ -55,8 +55,11 @@ public:
     static const int kNameSize;
 
     Material(Model *parentModelRef, IEncoding *encodingRef);
+    Material(Model *parentModelRef, IEncoding *encodingRef, internal::Arena *arenaRef);
     ~Material();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     IModel *parentModelRef() const;
     const IString *name(IEncoding::LanguageType type) const;
     const IString *userDataArea() const;
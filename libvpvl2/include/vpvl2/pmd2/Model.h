@@ -40,6 +40,7 @@
 
 #include "vpvl2/Common.h"
 #include "vpvl2/IModel.h"
+#include "vpvl2/internal/Arena.h"
 
 class btDiscreteDynamicsWorld;
 
@@ -225,6 +226,7 @@ public:
     void getMatrixBuffer(MatrixBuffer *&matrixBuffer,
                          DynamicVertexBuffer *dynamicBuffer,
                          const IndexBuffer *indexBuffer) const;
+    void getArenaStatistics(internal::Arena::Statistics &value) const;
 
 private:
     struct PrivateContext;
@@ -61,8 +61,11 @@ public:
     static const int kNameSize;
 
     Morph(Model *parentModelRef, IEncoding *encodingRef);
+    Morph(Model *parentModelRef, IEncoding *encodingRef, internal::Arena *arenaRef);
     ~Morph();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     void resetTransform();
     Label *internalParentLabelRef() const;
     IModel *parentModelRef() const;
@@ -62,8 +62,11 @@ public:
     static const int kMaxBones;
 
     Vertex(Model *parentModelRef);
+    Vertex(Model *parentModelRef, internal::Arena *arenaRef);
     ~Vertex();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     IModel *parentModelRef() const;
     Vector3 origin() const;
     Vector3 normal() const;
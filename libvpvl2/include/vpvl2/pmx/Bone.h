@@ -81,13 +81,18 @@ public:
      * Constructor
      */
     Bone(Model *modelRef);
+    Bone(Model *modelRef, internal::Arena *arenaRef);
     ~Bone();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     static bool preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info);
     static bool loadBones(const Array<Bone *> &bones);
     static void sortBones(const Array<Bone *> &bones, Array<Bone *> &bpsBones, Array<Bone *> &apsBones);
     static void writeBones(const Array<Bone *> &bones, const Model::DataInfo &info, uint8 *&data);
     static vsize estimateTotalSize(const Array<Bone *> &bones, const Model::DataInfo &info);
+    static void performTransform(Model::PoseBuffer &buffer, int slot);
+    static void resetPoses(Model::PoseBuffer &buffer, int from, int to);
 
     void read(const uint8 *data, const Model::DataInfo &info, vsize &size);
     void write(uint8 *&data, const Model::DataInfo &info) const;
@@ -110,6 +115,11 @@ public:
     void getLocalAxes(Matrix3x3 &value) const;
     void setLocalTransform(const Transform &value);
     void setSimulated(bool value);
+    void bindPoseBuffer(Model::PoseBuffer *buffer, int slot);
+    int poseSlot() const;
+    bool isPoseInputChanged() const;
+    void savePoseInput();
+    void invalidatePoseInput();
 
     Label *internalParentLabelRef() const;
     IModel *parentModelRef() const;
@@ -66,8 +66,11 @@ public:
      * Constructor
      */
     Material(Model *modelRef);
+    Material(Model *modelRef, internal::Arena *arenaRef);
     ~Material();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     static bool preparse(uint8 *&data, vsize &rest, Model::DataInfo &info);
     static bool loadMaterials(const Array<Material *> &materials,
                               const Array<IString *> &textures,
@@ -46,6 +46,7 @@
 #include "vpvl2/IMorph.h"
 #include "vpvl2/ISoftBody.h"
 #include "vpvl2/IString.h"
+#include "vpvl2/internal/Arena.h"
 
 namespace vpvl2
 {
@@ -137,6 +138,42 @@ public:
         uint8 *endPtr;
     };
 
+    /**
+     * PoseBuffer holds transforms of all bones in the model as structure of arrays.
+     *
+     * Each array is indexed by "slot" of the bone. Slots are assigned in the evaluation order
+     * (bones transformed before physics simulation first, then bones transformed after physics
+     * simulation, each sorted by layer index and bone index), so a skeleton update becomes
+     * a linear sweep over contiguous memory. Use boneIndex2Slot to find a slot from the bone index.
+     *
+     * changedFlags has non zero value at the slot whose world transform is changed by the last update.
+     *
+     * offsets, coefficients, flags (inherence and IK bits only), parentSlots and parentInherentSlots
+     * are copied from the bone so the transform and IK passes never follow bone pointers.
+     * Parent slots are -1 if the bone has no parent in the buffer.
+     */
+    struct PoseBuffer
+    {
+        btAlignedObjectArray<Vector3> localTranslations;
+        btAlignedObjectArray<Quaternion> localOrientations;
+        btAlignedObjectArray<Transform> worldTransforms;
+        btAlignedObjectArray<Transform> skinningTransforms;
+        btAlignedObjectArray<Vector3> origins;
+        btAlignedObjectArray<Vector3> morphTranslations;
+        btAlignedObjectArray<Quaternion> morphOrientations;
+        btAlignedObjectArray<Quaternion> jointOrientations;
+        btAlignedObjectArray<Vector3> inherentTranslations;
+        btAlignedObjectArray<Quaternion> inherentOrientations;
+        btAlignedObjectArray<Vector3> offsets;
+        btAlignedObjectArray<Scalar> coefficients;
+        btAlignedObjectArray<uint16> flags;
+        btAlignedObjectArray<int> parentSlots;
+        btAlignedObjectArray<int> parentInherentSlots;
+        btAlignedObjectArray<int> boneIndex2Slot;
+        btAlignedObjectArray<uint8> changedFlags;
+        int numBonesBeforePhysics;
+    };
+
     /**
      * Constructor
      */
@@ -214,6 +251,14 @@ public:
     void setPhysicsEnable(bool value);
 
     static void updateLocalTransform(Array<Bone *> &bones);
+    static void updateSkinningTransforms(PoseBuffer &buffer, int from, int to);
+    const PoseBuffer &poseBuffer() const;
+    PoseBuffer *mutablePoseBuffer();
+    void markVertexMorphed(Vertex *vertex);
+    void markSkinningChanged();
+    int skinningRevision() const;
+    void getDirtyVertexRange(int &from, int &to) const;
+    int updateCount() const;
     void getIndexBuffer(IndexBuffer *&indexBuffer) const;
     void getStaticVertexBuffer(StaticVertexBuffer *&staticBuffer) const;
     void getDynamicVertexBuffer(DynamicVertexBuffer *&dynamicBuffer,
@@ -272,6 +317,35 @@ public:
     int findTextureIndex(const IString *value, int defaultIfNotFound) const;
     IString *addTexture(const IString *value);
     void removeTexture(IString *&value);
+    void getArenaStatistics(internal::Arena::Statistics &value) const;
+
+    /**
+     * Parse vertices, indices and morphs concurrently with the other sections in load().
+     *
+     * String conversions are serialized and elements are linked in the file order,
+     * so the loaded model is identical to the sequential load. Disabled by default.
+     */
+    bool isParallelLoadEnabled() const;
+    void setParallelLoadEnable(bool value);
+
+    /**
+     * Transform only bones whose inputs (local transform, morph, IK, inherent parent) are changed
+     * since the last update and their descendants in performUpdate().
+     *
+     * All bones are transformed while physics simulation is enabled, and at the next update after
+     * the bones are rebuilt or requestFullUpdate() is called. Disabled by default.
+     */
+    bool isIncrementalUpdateEnabled() const;
+    void setIncrementalUpdateEnable(bool value);
+    void requestFullUpdate();
+
+    /**
+     * Solve IK chains of two joints (a hinge joint rotating around X axis such as knees and a joint
+     * without angle limits) analytically, and stop iterations of the other IK chains when the effector
+     * reaches to the target. Disabled by default because the result differs slightly from CCD.
+     */
+    bool isFastInverseKinematicsEnabled() const;
+    void setFastInverseKinematicsEnable(bool value);
 
 private:
     struct PrivateContext;
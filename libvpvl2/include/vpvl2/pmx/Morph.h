@@ -62,9 +62,13 @@ class VPVL2_API Morph VPVL2_DECL_FINAL : public IMorph
 {
 public:
     Morph(Model *modelRef);
+    Morph(Model *modelRef, internal::Arena *arenaRef);
     ~Morph();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     static bool preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info);
+    static void locateMorphs(const Model::DataInfo &info, Array<uint8 *> &ptrs);
     static bool loadMorphs(const Array<Morph *> &morphs,
                            const Array<pmx::Bone *> &bones,
                            const Array<pmx::Material *> &materials,
@@ -0,0 +1,108 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#pragma once
+#ifndef VPVL2_PMX_SKINNINGENGINE_H_
+#define VPVL2_PMX_SKINNINGENGINE_H_
+
+#include "vpvl2/IVertex.h"
+#include "vpvl2/pmx/Model.h"
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace pmx
+{
+
+/**
+ * @file
+ * @author hkrn
+ *
+ * @section DESCRIPTION
+ *
+ * SkinningEngine class performs CPU skinning of all vertices of a Polygon Model Extended object.
+ *
+ * Bone indices, weights, rest positions, morph deltas and UVA of vertices are packed into aligned
+ * structure of arrays streams grouped by deformation type (BDEF1, BDEF2/SDEF and BDEF4/QDEF), then
+ * vertices are skinned 8 (AVX), 4 (SSE) or 1 (scalar fallback) at a time against a matrix palette
+ * built from Model::PoseBuffer and written straight into the mapped dynamic vertex buffer.
+ *
+ * Streams are repacked when Model#skinningRevision is changed by editing vertices, bones or materials,
+ * and only morph deltas and UVA of vertices in the dirty vertex range are refreshed at each update.
+ */
+
+class VPVL2_API SkinningEngine VPVL2_DECL_FINAL
+{
+public:
+    /**
+     * Returns number of vertices to be skinned at a time in this build.
+     */
+    static int packWidth();
+
+    SkinningEngine(const Model *modelRef, const IModel::DynamicVertexBuffer *dynamicBufferRef);
+    ~SkinningEngine();
+
+    /**
+     * Discards packed streams and repacks them at next execute call.
+     *
+     * Edits through setters of vertices, bones and materials are detected by Model#skinningRevision,
+     * so this is only required when the dynamic vertex buffer is rebound.
+     */
+    void invalidate();
+
+    /**
+     * Skins all vertices and writes position, normal, edge position and UVA to the buffer.
+     *
+     * @param address The mapped address of the dynamic vertex buffer
+     * @param edgeScaleFactor The value of Model#edgeScaleFactor
+     * @param enableParallel Set true to skin vertices in parallel
+     */
+    void execute(void *address, const IVertex::EdgeSizePrecision &edgeScaleFactor, bool enableParallel);
+
+private:
+    struct PrivateContext;
+    PrivateContext *m_context;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(SkinningEngine)
+};
+
+} /* namespace pmx */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
+
+#endif
@@ -72,9 +72,13 @@ public:
      * Constructor
      */
     Vertex(IModel *modelRef);
+    Vertex(IModel *modelRef, internal::Arena *arenaRef);
     ~Vertex();
 
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     static bool preparse(uint8 *&data, vsize &rest, Model::DataInfo &info);
+    static void locateVertices(const Model::DataInfo &info, Array<uint8 *> &ptrs);
     static bool loadVertices(const Array<Vertex *> &vertices, const Array<Bone *> &bones);
     static void writeVertices(const Array<Vertex *> &vertices, const Model::DataInfo &info, uint8 *&data);
     static vsize estimateTotalSize(const Array<Vertex *> &vertices, const Model::DataInfo &info);
@@ -83,8 +83,23 @@ public:
     bool isNullFrameEnabled() const { return m_enableNullFrame; }
     void setNullFrameEnable(bool value) { m_enableNullFrame = value; }
 
+    /**
+     * Enables the compiled form of the animation.
+     *
+     * The compiled form flattens all keyframes of the bound model into contiguous arrays
+     * (time indices, translations, orientations and interpolation tables shared through
+     * internal::InterpolationCurveRegistry) and seek samples all tracks in one pass, writing
+     * the result into the pose buffer of pmx::Model (other models through IBone).
+     * Keyframes are copied at compile, so call Motion#update (or setParentModelRef)
+     * after modifying keyframes to reflect them. It is disabled by default because editors
+     * modify keyframes in place; enable it while playing back.
+     */
+    bool isCompileEnabled() const { return m_enableCompile; }
+    void setCompileEnable(bool value);
+
 private:
     struct PrivateContext;
+    struct CompiledContext;
     static IKeyframe::SmoothPrecision weightValue(const BoneKeyframe *keyFrame,
                                                   const IKeyframe::SmoothPrecision &w,
                                                   int at);
@@ -96,11 +111,15 @@ private:
                             IKeyframe::SmoothPrecision &value);
     void createPrivateContexts(IModel *model);
     void calculateKeyframes(const IKeyframe::TimeIndex &timeIndexAt, PrivateContext *context);
+    void compile();
+    void seekCompiled(const IKeyframe::TimeIndex &timeIndexAt);
 
     IEncoding *m_encodingRef;
     PointerHash<HashString, PrivateContext> m_name2contexts;
+    CompiledContext *m_compiledContextPtr;
     IModel *m_modelRef;
     bool m_enableNullFrame;
+    bool m_enableCompile;
 
     VPVL2_DISABLE_COPY_AND_ASSIGN(BoneAnimation)
 };
@@ -99,7 +99,7 @@ private:
     Quaternion m_rotation;
     bool m_linear[4];
     bool m_enableIK;
-    SmoothPrecision *m_interpolationTable[4];
+    const SmoothPrecision *m_interpolationTable[4];
     int8 m_rawInterpolationTable[kTableSize];
     InterpolationParameter m_parameter;
 
@@ -198,6 +198,7 @@ public:
                 }
             }
         }
+        m_applicationContext->uploadDecodedTextures();
         m_applicationContext->renderShadowMap();
         m_applicationContext->renderOffscreen();
         m_applicationContext->updateCameraMatrices(glm::vec2(m_width, m_height));
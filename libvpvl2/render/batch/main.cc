@@ -0,0 +1,440 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+/*
+ * Headless batch renderer renders a project file (*.vpvx) at fixed frame rate
+ * without window system by EGL pbuffer surface.
+ *
+ * usage: vpvl2_batch [options] /path/to/project.vpvx
+ *
+ *   --width N / --height N   size of output frames (default is 1280x720)
+ *   --fps N                  frame rate of output frames (default is 30)
+ *   --from N / --to N        range of output frames (inclusive, default is whole the project)
+ *   --jobs N --job-index K   split the frame range into N and render K-th part of it (K starts from 0)
+ *   --output PATH            "-" writes raw RGBA frames to standard output (default), otherwise
+ *                            PATH is a printf pattern of binary PPM files such as "out/%06d.ppm"
+ *   --config PATH            config.ini to read (default is config.ini)
+ *   --no-warmup              do not simulate physics before the first frame of the range
+ *
+ * raw RGBA frames can be piped to the encoder directly, for example:
+ *
+ *   vpvl2_batch --fps 60 project.vpvx | avconv -f rawvideo -pix_fmt rgba -s 1280x720 -r 60 -i - out.mkv
+ *
+ * each job writes frame files by absolute frame number so outputs of several processes
+ * rendering other ranges of the same project can be mixed in the same directory.
+ */
+
+#include "../helper.h"
+#include <vpvl2/extensions/XMLProject.h>
+#include <vpvl2/extensions/egl/ApplicationContext.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace vpvl2::extensions::egl;
+using namespace vpvl2::extensions::icu4c;
+
+namespace {
+
+struct Options {
+    Options()
+        : configPath("config.ini"),
+          outputPath("-"),
+          width(1280),
+          height(720),
+          fps(30),
+          from(0),
+          to(-1),
+          njobs(1),
+          jobIndex(0),
+          enableWarmup(true)
+    {
+    }
+    std::string projectPath;
+    std::string configPath;
+    std::string outputPath;
+    int width;
+    int height;
+    int fps;
+    int from;
+    int to;
+    int njobs;
+    int jobIndex;
+    bool enableWarmup;
+};
+
+class ProjectDelegate : public XMLProject::IDelegate {
+public:
+    ProjectDelegate(Factory *factoryRef, IEncoding *encodingRef, const StringMap *settingsRef)
+        : m_applicationContextRef(0),
+          m_sceneRef(0),
+          m_factoryRef(factoryRef),
+          m_encodingRef(encodingRef),
+          m_settingsRef(settingsRef)
+    {
+    }
+    ~ProjectDelegate() {
+        m_applicationContextRef = 0;
+        m_sceneRef = 0;
+        m_factoryRef = 0;
+        m_encodingRef = 0;
+        m_settingsRef = 0;
+    }
+
+    void setApplicationContextRef(BaseApplicationContext *applicationContextRef, Scene *sceneRef) {
+        m_applicationContextRef = applicationContextRef;
+        m_sceneRef = sceneRef;
+    }
+    std::string toStdFromString(const IString *value) const {
+        return value ? static_cast<const String *>(value)->toStdString() : std::string();
+    }
+    IString *toStringFromStd(const std::string &value) const {
+        return String::create(value);
+    }
+    bool loadModel(const XMLProject::UUID &uuid, const StringMap &settings, IModel::Type /* type */, IModel *&model, IRenderEngine *&engine, int &priority) {
+        const std::string &uri = settings.value(XMLProject::kSettingURIKey, std::string());
+        const UnicodeString &modelPath = UnicodeString::fromUTF8(uri);
+        const int flags = m_settingsRef->value("enable.effects", true) ? Scene::kEffectCapable : 0;
+        String dir(modelPath.tempSubString(0, modelPath.lastIndexOf("/")));
+        ArchiveSmartPtr archive;
+        IModelSmartPtr modelPtr;
+        model = 0;
+        engine = 0;
+        if (!::ui::loadModel(modelPath, m_applicationContextRef, m_factoryRef, m_encodingRef, archive, modelPtr)) {
+            VPVL2_LOG(WARNING, "Cannot load the model: uuid=" << uuid << " uri=" << uri);
+            return false;
+        }
+        BaseApplicationContext::ModelContext modelContext(m_applicationContextRef, archive.get(), &dir, modelPtr->type() == IModel::kAssetModel);
+        m_applicationContextRef->prefetchModelTextures(modelPtr.get(), &modelContext);
+        IRenderEngineSmartPtr enginePtr(m_sceneRef->createRenderEngine(m_applicationContextRef, modelPtr.get(), flags));
+        m_applicationContextRef->addModelFilePath(modelPtr.get(), uri);
+        if ((flags & Scene::kEffectCapable) != 0) {
+            if (IEffect *effectRef = m_applicationContextRef->createEffectRef(modelPtr.get(), &dir)) {
+                enginePtr->setEffect(effectRef, IEffect::kAutoDetection, &modelContext);
+            }
+        }
+        if (!enginePtr->upload(&modelContext)) {
+            VPVL2_LOG(WARNING, "Cannot upload the model: uuid=" << uuid << " uri=" << uri);
+            return false;
+        }
+        enginePtr->setUpdateOptions(IRenderEngine::kParallelUpdate);
+        priority = XMLProject::toIntFromString(settings.value(XMLProject::kSettingOrderKey, std::string("0")));
+        model = modelPtr.release();
+        engine = enginePtr.release();
+        return true;
+    }
+
+private:
+    BaseApplicationContext *m_applicationContextRef;
+    Scene *m_sceneRef;
+    Factory *m_factoryRef;
+    IEncoding *m_encodingRef;
+    const StringMap *m_settingsRef;
+};
+
+static void UIPrintUsage(const char *argv0)
+{
+    std::cerr << "usage: " << argv0 << " [--width N] [--height N] [--fps N] [--from N] [--to N]"
+                 " [--jobs N --job-index K] [--output PATH] [--config PATH] [--no-warmup] project.vpvx" << std::endl;
+}
+
+static bool UIParseArguments(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--width") == 0 && hasValue) {
+            options.width = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--height") == 0 && hasValue) {
+            options.height = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--fps") == 0 && hasValue) {
+            options.fps = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--from") == 0 && hasValue) {
+            options.from = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--to") == 0 && hasValue) {
+            options.to = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--jobs") == 0 && hasValue) {
+            options.njobs = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--job-index") == 0 && hasValue) {
+            options.jobIndex = atoi(argv[++i]);
+        }
+        else if (strcmp(arg, "--output") == 0 && hasValue) {
+            options.outputPath = argv[++i];
+        }
+        else if (strcmp(arg, "--config") == 0 && hasValue) {
+            options.configPath = argv[++i];
+        }
+        else if (strcmp(arg, "--no-warmup") == 0) {
+            options.enableWarmup = false;
+        }
+        else if (arg[0] != '-' && options.projectPath.empty()) {
+            options.projectPath = arg;
+        }
+        else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.projectPath.empty() || options.width <= 0 || options.height <= 0 || options.fps <= 0) {
+        return false;
+    }
+    if (options.njobs <= 0 || options.jobIndex < 0 || options.jobIndex >= options.njobs) {
+        std::cerr << "--job-index must be in range of 0 to --jobs - 1" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void UISplitFrameRange(const Options &options, int nframes, int &from, int &to)
+{
+    const int first = btMax(options.from, 0);
+    const int last = options.to >= 0 ? btMin(options.to, nframes - 1) : nframes - 1;
+    const int total = btMax(last - first + 1, 0);
+    const int chunk = (total + options.njobs - 1) / options.njobs;
+    from = first + chunk * options.jobIndex;
+    to = btMin(from + chunk - 1, last);
+}
+
+static void UIAdvanceFrame(Scene &scene, World &world, int frame, int fps)
+{
+    scene.seekSeconds(frame / float64(fps), Scene::kUpdateAll);
+    world.stepSimulation(Scene::defaultFPS() / fps, Scene::defaultFPS());
+    scene.update(Scene::kUpdateAll);
+}
+
+static bool UIWriteFrame(const Options &options, int frame, std::vector<uint8> &pixels, std::vector<uint8> &row)
+{
+    const int width = options.width, height = options.height, stride = width * 4;
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+    /* OpenGL returns pixels bottom-up so flip them to be top-down */
+    for (int y = 0, half = height / 2; y < half; y++) {
+        uint8 *top = &pixels[y * stride], *bottom = &pixels[(height - y - 1) * stride];
+        memcpy(&row[0], top, stride);
+        memcpy(top, bottom, stride);
+        memcpy(bottom, &row[0], stride);
+    }
+    if (options.outputPath == "-") {
+        return fwrite(&pixels[0], 1, pixels.size(), stdout) == pixels.size();
+    }
+    char path[1024];
+    snprintf(path, sizeof(path), options.outputPath.c_str(), frame);
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        std::cerr << "Cannot open the output file: " << path << std::endl;
+        return false;
+    }
+    fprintf(fp, "P6\n%d %d\n255\n", width, height);
+    for (int i = 0, npixels = width * height; i < npixels; i++) {
+        fwrite(&pixels[i * 4], 1, 3, fp);
+    }
+    const bool ok = ferror(fp) == 0;
+    fclose(fp);
+    return ok;
+}
+
+static void UITerminateEGLSession(EGLDisplay display, EGLSurface surface, EGLContext context)
+{
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT) {
+        eglDestroyContext(display, context);
+    }
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    eglTerminate(display);
+}
+
+} /* namespace anonymous */
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!UIParseArguments(argc, argv, options)) {
+        UIPrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    tbb::task_scheduler_init initializer; (void) initializer;
+    BaseApplicationContext::initializeOnce(argv[0], 0, 0);
+
+    StringMap settings;
+    ::ui::loadSettings(options.configPath, settings);
+    int samplesSize = settings.value("opengl.size.samples", 0);
+    bool enableGLES = settings.value("opengl.enable.gles", false);
+    eglBindAPI(enableGLES ? EGL_OPENGL_ES_API : EGL_OPENGL_API);
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor)) {
+        std::cerr << "Cannot initialize EGL session: " << eglGetError() << std::endl;
+        return EXIT_FAILURE;
+    }
+    Array<EGLint> attrs;
+    attrs.append(EGL_RED_SIZE);
+    attrs.append(8);
+    attrs.append(EGL_GREEN_SIZE);
+    attrs.append(8);
+    attrs.append(EGL_BLUE_SIZE);
+    attrs.append(8);
+    attrs.append(EGL_ALPHA_SIZE);
+    attrs.append(8);
+    attrs.append(EGL_DEPTH_SIZE);
+    attrs.append(24);
+    attrs.append(EGL_STENCIL_SIZE);
+    attrs.append(8);
+    /* no window system is required to render into pbuffer surface */
+    attrs.append(EGL_SURFACE_TYPE);
+    attrs.append(EGL_PBUFFER_BIT);
+    attrs.append(EGL_RENDERABLE_TYPE);
+    attrs.append(enableGLES ? EGL_OPENGL_ES_BIT : EGL_OPENGL_BIT);
+    if (samplesSize > 0) {
+        attrs.append(EGL_SAMPLE_BUFFERS);
+        attrs.append(1);
+        attrs.append(EGL_SAMPLES);
+        attrs.append(samplesSize);
+    }
+    attrs.append(EGL_NONE);
+    EGLConfig config;
+    EGLint nconfigs;
+    if (!eglChooseConfig(display, &attrs[0], &config, 1, &nconfigs) || nconfigs == 0) {
+        std::cerr << "Cannot choose EGL configuration: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return EXIT_FAILURE;
+    }
+    const EGLint surfaceAttribs[] = {
+        EGL_WIDTH, options.width,
+        EGL_HEIGHT, options.height,
+        EGL_NONE
+    };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        std::cerr << "Cannot create EGL pbuffer surface: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, surface, EGL_NO_CONTEXT);
+        return EXIT_FAILURE;
+    }
+    Array<EGLint> contextAttribs;
+    if (enableGLES) {
+        contextAttribs.append(EGL_CONTEXT_CLIENT_VERSION);
+        contextAttribs.append(3);
+    }
+    contextAttribs.append(EGL_NONE);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, &contextAttribs[0]);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Cannot create EGL context: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, surface, context);
+        return EXIT_FAILURE;
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        std::cerr << "Cannot make OpenGL context current: " << eglGetError() << std::endl;
+        UITerminateEGLSession(display, surface, context);
+        return EXIT_FAILURE;
+    }
+    if (!Scene::initialize(ApplicationContext::staticSharedFunctionResolverInstance())) {
+        std::cerr << "Cannot initialize the scene" << std::endl;
+        UITerminateEGLSession(display, surface, context);
+        return EXIT_FAILURE;
+    }
+
+    int exitCode = EXIT_SUCCESS;
+    {
+        Encoding::Dictionary dictionary;
+        Encoding encoding(&dictionary);
+        Factory factory(&encoding);
+        ProjectDelegate delegate(&factory, &encoding, &settings);
+        XMLProject project(&delegate, &factory, true);
+        ApplicationContext applicationContext(&project, &encoding, &settings, enableGLES);
+        World world;
+        delegate.setApplicationContextRef(&applicationContext, &project);
+        applicationContext.initializeOpenGLContext(false);
+        applicationContext.setViewportRegion(glm::ivec4(0, 0, options.width, options.height));
+        ::ui::initializeDictionary(settings, dictionary);
+        project.setWorldRef(world.dynamicWorldRef());
+        if (project.load(options.projectPath.c_str())) {
+            /* textures decoded asynchronously must be resident before the first frame */
+            applicationContext.waitForDecodingTextures();
+            const float64 seconds = project.durationTimeIndex() / float64(Scene::defaultFPS());
+            const int nframes = int(seconds * options.fps) + 1;
+            int from = 0, to = -1;
+            UISplitFrameRange(options, nframes, from, to);
+            std::cerr << "Rendering frames from " << from << " to " << to << " of " << nframes
+                      << " at " << options.width << "x" << options.height << "@" << options.fps << "fps" << std::endl;
+            project.seekTimeIndex(0, Scene::kUpdateAll);
+            project.update(Scene::kUpdateAll | Scene::kResetMotionState);
+            if (options.enableWarmup) {
+                /* physics simulation depends on previous frames so run it without rendering */
+                for (int frame = 1; frame < from; frame++) {
+                    UIAdvanceFrame(project, world, frame, options.fps);
+                }
+            }
+            std::vector<uint8> pixels(options.width * options.height * 4), row(options.width * 4);
+            glViewport(0, 0, options.width, options.height);
+            for (int frame = from; frame <= to; frame++) {
+                if (frame > 0) {
+                    UIAdvanceFrame(project, world, frame, options.fps);
+                }
+                applicationContext.updateCameraMatrices();
+                applicationContext.renderShadowMap();
+                applicationContext.renderOffscreen();
+                glViewport(0, 0, options.width, options.height);
+                glClearColor(1, 1, 1, 1);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+                ::ui::drawScreen(project);
+                if (!UIWriteFrame(options, frame, pixels, row)) {
+                    std::cerr << "Cannot write the frame " << frame << std::endl;
+                    exitCode = EXIT_FAILURE;
+                    break;
+                }
+            }
+            fflush(stdout);
+        }
+        else {
+            std::cerr << "Cannot load the project: " << options.projectPath << std::endl;
+            exitCode = EXIT_FAILURE;
+        }
+        project.setWorldRef(0);
+        applicationContext.release();
+    }
+    UITerminateEGLSession(display, surface, context);
+    return exitCode;
+}
@@ -322,6 +322,7 @@ public:
         return !glfwWindowShouldClose(m_window);
     }
     void handleFrame(double base, double &last, uint64 &oldTimeIndex) {
+        m_applicationContext->uploadDecodedTextures();
         m_applicationContext->renderShadowMap();
         m_applicationContext->renderOffscreen();
         ::ui::drawScreen(*m_scene.get());
@@ -207,6 +207,8 @@ static void loadAllModels(const StringMap &settings,
         icu4c::String dir(modelPath.tempSubString(0, indexOf));
         if (loadModel(modelPath, applicationContextRef, factoryRef, encodingRef, archive, model)) {
             BaseApplicationContext::ModelContext modelContext(applicationContextRef, archive.get(), &dir, model->type() == IModel::kAssetModel);
+            /* textures are decoded while the render engine and the effect are being created */
+            applicationContextRef->prefetchModelTextures(model.get(), &modelContext);
             IRenderEngineSmartPtr engine(sceneRef->createRenderEngine(applicationContextRef, model.get(), flags));
             IEffect *effectRef = 0;
             /*
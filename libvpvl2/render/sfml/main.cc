@@ -174,6 +174,7 @@ public:
                 break;
             }
         }
+        m_applicationContext->uploadDecodedTextures();
         m_applicationContext->renderShadowMap();
         m_applicationContext->renderOffscreen();
         ::ui::drawScreen(*m_scene.get());
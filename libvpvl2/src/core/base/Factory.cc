@@ -37,6 +37,7 @@
 
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/internal/util.h"
+#include "vpvl2/internal/MappedFile.h"
 
 #include "vpvl2/asset/Model.h"
 #include "vpvl2/mvd/Motion.h"
@@ -229,7 +230,8 @@ struct Factory::PrivateContext
           vmdBoneKeyframe(0),
           vmdCameraKeyframe(0),
           vmdLightKeyframe(0),
-          vmdMorphKeyframe(0)
+          vmdMorphKeyframe(0),
+          enableParallelLoad(false)
     {
     }
     ~PrivateContext() {
@@ -419,6 +421,7 @@ struct Factory::PrivateContext
     mutable vmd::CameraKeyframe *vmdCameraKeyframe;
     mutable vmd::LightKeyframe *vmdLightKeyframe;
     mutable vmd::MorphKeyframe *vmdMorphKeyframe;
+    bool enableParallelLoad;
 };
 
 IModel::Type Factory::findModelType(const uint8 *data, vsize size)
@@ -483,9 +486,12 @@ IModel *Factory::newModel(IModel::Type type) const
         modelRef = new pmd2::Model(m_context->encodingRef);
 #endif
         break;
-    case IModel::kPMXModel:
-        modelRef = new pmx::Model(m_context->encodingRef);
+    case IModel::kPMXModel: {
+        pmx::Model *model = new pmx::Model(m_context->encodingRef);
+        model->setParallelLoadEnable(m_context->enableParallelLoad);
+        modelRef = model;
         break;
+    }
     default:
         break;
     }
@@ -495,6 +501,16 @@ IModel *Factory::newModel(IModel::Type type) const
     return modelRef;
 }
 
+bool Factory::isParallelLoadEnabled() const
+{
+    return m_context->enableParallelLoad;
+}
+
+void Factory::setParallelLoadEnable(bool value)
+{
+    m_context->enableParallelLoad = value;
+}
+
 IModel *Factory::createModel(const uint8 *data, vsize size, bool &ok) const
 {
     IModel *model = newModel(findModelType(data, size));
@@ -502,6 +518,18 @@ IModel *Factory::createModel(const uint8 *data, vsize size, bool &ok) const
     return model;
 }
 
+IModel *Factory::createModelFromFile(const char *path, bool &ok) const
+{
+    internal::MappedFile file;
+    ok = false;
+    if (path && file.open(path)) {
+        /* the mapping is released after parsing as a loaded model doesn't refer the data */
+        return createModel(file.address(), file.size(), ok);
+    }
+    VPVL2_LOG(WARNING, "Cannot map the model file: " << (path ? path : "(null)"));
+    return 0;
+}
+
 IMotion *Factory::newMotion(IMotion::FormatType type, IModel *modelRef) const
 {
     switch (type) {
@@ -521,6 +549,17 @@ IMotion *Factory::createMotion(const uint8 *data, vsize size, IModel *model, boo
     return motion;
 }
 
+IMotion *Factory::createMotionFromFile(const char *path, IModel *model, bool &ok) const
+{
+    internal::MappedFile file;
+    ok = false;
+    if (path && file.open(path)) {
+        return createMotion(file.address(), file.size(), model, ok);
+    }
+    VPVL2_LOG(WARNING, "Cannot map the motion file: " << (path ? path : "(null)"));
+    return 0;
+}
+
 IBoneKeyframe *Factory::createBoneKeyframe(IMotion *motion) const
 {
     return motion ? motion->createBoneKeyframe() : 0;
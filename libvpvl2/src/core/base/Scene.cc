@@ -38,6 +38,7 @@
 #include "vpvl2/vpvl2.h"
 #include "vpvl2/IApplicationContext.h"
 #include "vpvl2/internal/util.h"
+#include "vpvl2/internal/ParallelProcessors.h"
 
 #include "vpvl2/asset/Model.h"
 #include "vpvl2/mvd/Motion.h"
@@ -319,6 +320,11 @@ namespace VPVL2_VERSION_NS
 
 struct Scene::PrivateContext VPVL2_DECL_FINAL
 {
+    enum DependentModelState {
+        kDependentModelUnvisited,
+        kDependentModelVisiting,
+        kDependentModelVisited
+    };
     struct ModelPtr VPVL2_DECL_FINAL {
         ModelPtr(IModel *v, int p, bool o)
             : value(v),
@@ -389,6 +395,7 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
           currentTimeIndex(0),
           currentSeconds(0),
           preferredFPS(Scene::defaultFPS()),
+          updateGeneration(0),
           ownMemory(ownMemory)
     {
     }
@@ -518,6 +525,60 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
             model->performUpdate();
         }
     }
+    void updateModelsInParallel() {
+        Array<IModel *> independentModelRefs, dependentModelRefs;
+        const int nmodels = models.count();
+        independentModelRefs.reserve(nmodels);
+        for (int i = 0; i < nmodels; i++) {
+            IModel *model = models[i]->value;
+            /* a model attached to other model refers its parent bone's world transform */
+            if (model->parentModelRef() || model->parentBoneRef()) {
+                dependentModelRefs.append(model);
+            }
+            else {
+                independentModelRefs.append(model);
+            }
+        }
+        internal::ParallelUpdateModelProcessor<IModel> processor(&independentModelRefs);
+        processor.execute();
+        Array<IModel *> sortedModelRefs;
+        sortDependentModels(dependentModelRefs, sortedModelRefs);
+        const int ndependents = sortedModelRefs.count();
+        for (int i = 0; i < ndependents; i++) {
+            IModel *model = sortedModelRefs[i];
+            model->performUpdate();
+        }
+    }
+    static void sortDependentModels(const Array<IModel *> &modelRefs, Array<IModel *> &sortedModelRefs) {
+        /* orders models topologically so that a parent model is always updated before its children */
+        Hash<HashPtr, int> states;
+        const int nmodels = modelRefs.count();
+        sortedModelRefs.reserve(nmodels);
+        for (int i = 0; i < nmodels; i++) {
+            states.insert(modelRefs[i], kDependentModelUnvisited);
+        }
+        for (int i = 0; i < nmodels; i++) {
+            visitDependentModel(modelRefs[i], states, sortedModelRefs);
+        }
+    }
+    static void visitDependentModel(IModel *model, Hash<HashPtr, int> &states, Array<IModel *> &sortedModelRefs) {
+        int *state = states[model];
+        /* models not attached to other model were already updated and cyclic links are ignored */
+        if (!state || *state != kDependentModelUnvisited) {
+            return;
+        }
+        *state = kDependentModelVisiting;
+        if (IModel *parentModelRef = model->parentModelRef()) {
+            visitDependentModel(parentModelRef, states, sortedModelRefs);
+        }
+        if (const IBone *parentBoneRef = model->parentBoneRef()) {
+            if (IModel *parentModelRef = parentBoneRef->parentModelRef()) {
+                visitDependentModel(parentModelRef, states, sortedModelRefs);
+            }
+        }
+        *states[model] = kDependentModelVisited;
+        sortedModelRefs.append(model);
+    }
     void markAllMorphsDirty() {
         Array<IMorph *> morphs;
         const int nmodels = models.count();
@@ -632,6 +693,7 @@ struct Scene::PrivateContext VPVL2_DECL_FINAL
     IKeyframe::TimeIndex currentTimeIndex;
     float64 currentSeconds;
     Scalar preferredFPS;
+    int updateGeneration;
     bool ownMemory;
 };
 
@@ -967,6 +1029,7 @@ void Scene::updateModel(IModel *model) const
 {
     if (model) {
         model->performUpdate();
+        m_context->updateGeneration++;
         if (IRenderEngine *engine = findRenderEngine(model)) {
             engine->update();
         }
@@ -975,6 +1038,8 @@ void Scene::updateModel(IModel *model) const
 
 void Scene::update(int flags)
 {
+    /* render engines reuse skinned vertices until the generation is changed */
+    m_context->updateGeneration++;
     if (internal::hasFlagBits(flags, kUpdateCamera)) {
         m_context->updateCamera();
     }
@@ -982,7 +1047,12 @@ void Scene::update(int flags)
         m_context->markAllMorphsDirty();
     }
     if (internal::hasFlagBits(flags, kUpdateModels)) {
-        m_context->updateModels();
+        if (internal::hasFlagBits(flags, kParallelUpdateModels)) {
+            m_context->updateModelsInParallel();
+        }
+        else {
+            m_context->updateModels();
+        }
     }
     /*
      * Call updateMotionAfter after #updateModels() to resolve dependency
@@ -1128,6 +1198,11 @@ IKeyframe::TimeIndex Scene::currentTimeIndex() const VPVL2_DECL_NOEXCEPT
     return m_context->currentTimeIndex;
 }
 
+int Scene::updateGeneration() const VPVL2_DECL_NOEXCEPT
+{
+    return m_context->updateGeneration;
+}
+
 ILight *Scene::lightRef() const VPVL2_DECL_NOEXCEPT
 {
     return &m_context->light;
@@ -0,0 +1,196 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/internal/Arena.h"
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+/* keeps 16 bytes alignment of SIMD types in allocated objects */
+static const vsize kArenaAlignment = 16;
+
+static inline vsize AlignArenaSize(vsize size) VPVL2_DECL_NOEXCEPT
+{
+    return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+struct Arena::Header {
+    Pool *pool;
+    vsize size;
+};
+
+/* blocks outlive the arena while objects allocated from them are alive */
+struct Arena::Pool {
+    Pool(Arena *arena)
+        : arenaRef(arena),
+          nliveObjects(0)
+    {
+    }
+    ~Pool() {
+        const int nblocks = blocks.count();
+        for (int i = 0; i < nblocks; i++) {
+            ::operator delete(blocks[i]);
+        }
+        blocks.clear();
+        arenaRef = 0;
+    }
+
+    Arena *arenaRef;
+    Array<uint8 *> blocks;
+    int nliveObjects;
+};
+
+static const vsize kArenaHeaderSize = 16;
+
+const vsize Arena::kDefaultBlockSize;
+
+Arena::Arena()
+    : m_pool(0),
+      m_currentBlock(0),
+      m_offset(0),
+      m_capacity(0)
+{
+    VPVL2_DCHECK(sizeof(Header) <= kArenaHeaderSize);
+}
+
+Arena::~Arena()
+{
+    VPVL2_VLOG(2, "Arena: blocks=" << m_statistics.nblocks << " objects=" << m_statistics.nobjects
+               << " live=" << m_statistics.nliveObjects << " reserved=" << m_statistics.reservedBytes
+               << " used=" << m_statistics.usedBytes);
+    detachPool();
+}
+
+void *Arena::allocate(vsize size, Arena *arena)
+{
+    const vsize allocationSize = kArenaHeaderSize + AlignArenaSize(size);
+    uint8 *ptr = arena ? static_cast<uint8 *>(arena->allocateFromBlock(allocationSize))
+                       : static_cast<uint8 *>(::operator new(allocationSize));
+    Header *header = reinterpret_cast<Header *>(ptr);
+    header->pool = arena ? arena->m_pool : 0;
+    header->size = allocationSize;
+    return ptr + kArenaHeaderSize;
+}
+
+void Arena::release(void *ptr) VPVL2_DECL_NOEXCEPT
+{
+    if (ptr) {
+        uint8 *base = static_cast<uint8 *>(ptr) - kArenaHeaderSize;
+        const Header *header = reinterpret_cast<const Header *>(base);
+        if (Pool *pool = header->pool) {
+            pool->nliveObjects--;
+            if (Arena *arena = pool->arenaRef) {
+                /* memory of the object is reclaimed when the arena is destroyed or reset */
+                arena->m_statistics.nliveObjects--;
+                arena->m_statistics.releasedBytes += header->size;
+            }
+            else if (pool->nliveObjects == 0) {
+                /* the last object of the detached pool */
+                delete pool;
+            }
+        }
+        else {
+            ::operator delete(base);
+        }
+    }
+}
+
+void Arena::reset()
+{
+    detachPool();
+    m_statistics = Statistics();
+}
+
+void Arena::getStatistics(Statistics &value) const
+{
+    value = m_statistics;
+}
+
+void *Arena::allocateFromBlock(vsize size)
+{
+    if (size > m_capacity - m_offset) {
+        /* grows block size with allocated bytes to keep the number of blocks small */
+        addBlock(btMax(size, btMax(m_statistics.usedBytes, kDefaultBlockSize)));
+    }
+    uint8 *ptr = m_currentBlock + m_offset;
+    m_offset += size;
+    m_pool->nliveObjects++;
+    m_statistics.nobjects++;
+    m_statistics.nliveObjects++;
+    m_statistics.usedBytes += size;
+    return ptr;
+}
+
+void Arena::addBlock(vsize size)
+{
+    const vsize blockSize = AlignArenaSize(size);
+    if (!m_pool) {
+        m_pool = new Pool(this);
+    }
+    m_currentBlock = static_cast<uint8 *>(::operator new(blockSize));
+    m_pool->blocks.append(m_currentBlock);
+    m_offset = 0;
+    m_capacity = blockSize;
+    m_statistics.nblocks++;
+    m_statistics.reservedBytes += blockSize;
+}
+
+void Arena::detachPool()
+{
+    if (m_pool) {
+        if (m_pool->nliveObjects > 0) {
+            /* objects taken out of the model still live, the last one deletes the pool */
+            m_pool->arenaRef = 0;
+        }
+        else {
+            delete m_pool;
+        }
+        m_pool = 0;
+    }
+    m_currentBlock = 0;
+    m_offset = 0;
+    m_capacity = 0;
+}
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
@@ -0,0 +1,139 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/internal/Keyframe.h"
+
+#include <map>
+
+#ifdef VPVL2_LINK_INTEL_TBB
+#include <tbb/spin_mutex.h>
+#endif
+
+namespace
+{
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+class Registry {
+public:
+    typedef std::pair<uint32, int> Key;
+    typedef std::map<Key, IKeyframe::SmoothPrecision *> CurveMap;
+
+    Registry() {}
+    ~Registry() {
+        for (CurveMap::const_iterator it = m_curves.begin(); it != m_curves.end(); it++) {
+            delete[] it->second;
+        }
+        m_curves.clear();
+    }
+
+    const IKeyframe::SmoothPrecision *findOrCreate(const QuadWord &value, int size) {
+        const uint8 x1 = uint8(value.x()), y1 = uint8(value.y()), x2 = uint8(value.z()), y2 = uint8(value.w());
+        const Key key(uint32(x1) | (uint32(y1) << 8) | (uint32(x2) << 16) | (uint32(y2) << 24), size);
+#ifdef VPVL2_LINK_INTEL_TBB
+        tbb::spin_mutex::scoped_lock lock(m_mutex);
+#endif
+        m_statistics.nlookups++;
+        CurveMap::const_iterator it = m_curves.find(key);
+        if (it != m_curves.end()) {
+            return it->second;
+        }
+        IKeyframe::SmoothPrecision *table = new IKeyframe::SmoothPrecision[size + 1];
+        internal::InterpolationTable::build(x1 / 127.0f, x2 / 127.0f, y1 / 127.0f, y2 / 127.0f, size, table);
+        m_curves.insert(std::make_pair(key, table));
+        m_statistics.ncurves++;
+        m_statistics.bytes += sizeof(*table) * (size + 1);
+        return table;
+    }
+    void release(const IKeyframe::SmoothPrecision *table) {
+        if (table) {
+#ifdef VPVL2_LINK_INTEL_TBB
+            tbb::spin_mutex::scoped_lock lock(m_mutex);
+#endif
+            m_statistics.nlookups--;
+        }
+    }
+    void getStatistics(internal::InterpolationCurveRegistry::Statistics &value) {
+#ifdef VPVL2_LINK_INTEL_TBB
+        tbb::spin_mutex::scoped_lock lock(m_mutex);
+#endif
+        value = m_statistics;
+    }
+
+private:
+    CurveMap m_curves;
+    internal::InterpolationCurveRegistry::Statistics m_statistics;
+#ifdef VPVL2_LINK_INTEL_TBB
+    tbb::spin_mutex m_mutex;
+#endif
+};
+
+static Registry &SharedRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+} /* namespace anonymous */
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+const IKeyframe::SmoothPrecision *InterpolationCurveRegistry::findOrCreate(const QuadWord &value, int size)
+{
+    VPVL2_DCHECK_GT(size, int(0));
+    return SharedRegistry().findOrCreate(value, size);
+}
+
+void InterpolationCurveRegistry::release(const IKeyframe::SmoothPrecision *table)
+{
+    SharedRegistry().release(table);
+}
+
+void InterpolationCurveRegistry::getStatistics(Statistics &value)
+{
+    SharedRegistry().getStatistics(value);
+}
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
@@ -0,0 +1,156 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/internal/MappedFile.h"
+
+#ifdef VPVL2_OS_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace internal
+{
+
+#ifdef VPVL2_OS_WINDOWS
+static const intptr_t kInvalidFileHandle = reinterpret_cast<intptr_t>(INVALID_HANDLE_VALUE);
+#else
+static const intptr_t kInvalidFileHandle = -1;
+#endif
+
+MappedFile::MappedFile()
+    : m_address(0),
+      m_size(0),
+      m_fileHandle(kInvalidFileHandle),
+      m_mappingHandle(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const char *path)
+{
+    close();
+#ifdef VPVL2_OS_WINDOWS
+    HANDLE file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    m_fileHandle = reinterpret_cast<intptr_t>(file);
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        close();
+        return false;
+    }
+    HANDLE mapping = ::CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    m_mappingHandle = reinterpret_cast<intptr_t>(mapping);
+    void *address = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!address) {
+        close();
+        return false;
+    }
+    m_address = static_cast<uint8 *>(address);
+    m_size = vsize(size.QuadPart);
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    m_fileHandle = fd;
+    struct stat sb;
+    if (::fstat(fd, &sb) == -1 || sb.st_size == 0) {
+        close();
+        return false;
+    }
+    void *address = ::mmap(0, vsize(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        close();
+        return false;
+    }
+    /* parsers read sections from the beginning to the end */
+    ::madvise(address, vsize(sb.st_size), MADV_SEQUENTIAL);
+    m_address = static_cast<uint8 *>(address);
+    m_size = vsize(sb.st_size);
+#endif
+    VPVL2_VLOG(2, "Mapped the file: path=" << path << " size=" << m_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef VPVL2_OS_WINDOWS
+    if (m_address) {
+        ::UnmapViewOfFile(m_address);
+    }
+    if (m_mappingHandle) {
+        ::CloseHandle(reinterpret_cast<HANDLE>(m_mappingHandle));
+    }
+    if (m_fileHandle != kInvalidFileHandle) {
+        ::CloseHandle(reinterpret_cast<HANDLE>(m_fileHandle));
+    }
+#else
+    if (m_address) {
+        ::munmap(m_address, m_size);
+    }
+    if (m_fileHandle != kInvalidFileHandle) {
+        ::close(int(m_fileHandle));
+    }
+#endif
+    m_address = 0;
+    m_size = 0;
+    m_fileHandle = kInvalidFileHandle;
+    m_mappingHandle = 0;
+}
+
+} /* namespace internal */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
@@ -217,6 +217,27 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
             processor.execute(enableParallelUpdate);
         }
     }
+    void update(void *address) const {
+        const Array<IVertex *> &vertices = modelRef->vertices();
+        Unit *bufferPtr = static_cast<Unit *>(address);
+        const int nvertices = vertices.count();
+        for (int i = 0; i < nvertices; i++) {
+            bufferPtr[i].update(vertices[i], i);
+        }
+    }
+    void updateRange(void *address, int from, int to) const {
+        /* the dirty range is always whole vertices (see getDirtyVertexRange) */
+        VPVL2_DCHECK(from == 0 && to == modelRef->vertices().count());
+        (void) from;
+        (void) to;
+        update(address);
+    }
+    void getDirtyVertexRange(int &lastUpdateCount, int &from, int &to) const {
+        /* changes of morphed vertices are not tracked in libvpvl */
+        lastUpdateCount = -1;
+        from = 0;
+        to = modelRef->vertices().count();
+    }
     void setSkinningEnable(bool value) {
         enableSkinning = value;
     }
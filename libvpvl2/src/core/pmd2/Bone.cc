@@ -71,6 +71,8 @@ namespace pmd2
 {
 
 struct Bone::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *parentModelRef, IEncoding *encodingRef)
         : parentModelRef(parentModelRef),
           parentLabelRef(0),
@@ -148,6 +150,11 @@ Bone::Bone(Model *parentModelRef, IEncoding *encodingRef)
 {
 }
 
+Bone::Bone(Model *parentModelRef, IEncoding *encodingRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(parentModelRef, encodingRef))
+{
+}
+
 Bone::~Bone()
 {
     if (Label *parentLabelRef = m_context->parentLabelRef) {
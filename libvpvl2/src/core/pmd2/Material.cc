@@ -74,6 +74,8 @@ static const Color kWhiteColor = Color(1, 1, 1, 1);
 const int Material::kNameSize = internal::kPMDMaterialNameSize;
 
 struct Material::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *parentModelRef, IEncoding *encodingRef)
         : parentModelRef(parentModelRef),
           encodingRef(encodingRef),
@@ -129,6 +131,11 @@ Material::Material(Model *parentModelRef, IEncoding *encodingRef)
 {
 }
 
+Material::Material(Model *parentModelRef, IEncoding *encodingRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(parentModelRef, encodingRef))
+{
+}
+
 Material::~Material()
 {
     internal::deleteObject(m_context);
@@ -340,6 +340,17 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
         internal::ParallelVertexMorphProcessor<pmd2::Model, pmd2::Vertex, Unit> processor(&vertices, address);
         processor.execute(enableParallelUpdate);
     }
+    void updateRange(void *address, int from, int to) const {
+        const PointerArray<Vertex> &vertices = modelRef->vertices();
+        internal::ParallelVertexMorphProcessor<pmd2::Model, pmd2::Vertex, Unit> processor(&vertices, address, from, to);
+        processor.execute(enableParallelUpdate);
+    }
+    void getDirtyVertexRange(int &lastUpdateCount, int &from, int &to) const {
+        /* changes of morphed vertices are not tracked in PMD */
+        lastUpdateCount = -1;
+        from = 0;
+        to = modelRef->vertices().count();
+    }
     void performTransform(void *address, const Vector3 &cameraPosition) const {
         const PointerArray<Vertex> &vertices = modelRef->vertices();
         Unit *bufferPtr = static_cast<Unit *>(address);
@@ -638,6 +649,13 @@ struct Model::PrivateContext {
         rigidBodies.releaseAll();
         constraints.releaseAll();
         bones.releaseAll();
+        name2boneRefs.clear();
+        name2morphRefs.clear();
+        /* blocks still used by elements removed from this model are freed when they are deleted */
+        vertexArena.reset();
+        materialArena.reset();
+        boneArena.reset();
+        morphArena.reset();
         internal::deleteObject(namePtr);
         internal::deleteObject(englishNamePtr);
         internal::deleteObject(commentPtr);
@@ -664,7 +682,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.verticesPtr;
         vsize size;
         for (int i = 0; i < nvertices; i++) {
-            Vertex *vertex = vertices.append(new Vertex(selfRef));
+            Vertex *vertex = vertices.append(new (&vertexArena) Vertex(selfRef, &vertexArena));
             vertex->read(ptr, info, size);
             ptr += size;
         }
@@ -683,7 +701,7 @@ struct Model::PrivateContext {
         vsize size;
         int indexOffset = 0;
         for (int i = 0; i < nmaterials; i++) {
-            Material *material = materials.append(new Material(selfRef, encodingRef));
+            Material *material = materials.append(new (&materialArena) Material(selfRef, encodingRef, &materialArena));
             material->read(ptr, info, size);
             IMaterial::IndexRange range = material->indexRange();
             int indexOffsetTo = indexOffset + range.count;
@@ -712,7 +730,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.bonesPtr;
         vsize size;
         for (int i = 0; i < nbones; i++) {
-            Bone *bone = bones.append(new Bone(selfRef, encodingRef));
+            Bone *bone = bones.append(new (&boneArena) Bone(selfRef, encodingRef, &boneArena));
             bone->readBone(ptr, info, size);
             sortedBoneRefs.append(bone);
             name2boneRefs.insert(bone->name(IEncoding::kJapanese)->toHashString(), bone);
@@ -750,7 +768,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.morphsPtr;
         vsize size;
         for (int i = 0; i < nmorphs; i++) {
-            Morph *morph = morphs.append(new Morph(selfRef, encodingRef));
+            Morph *morph = morphs.append(new (&morphArena) Morph(selfRef, encodingRef, &morphArena));
             morph->read(ptr, size);
             name2morphRefs.insert(morph->name(IEncoding::kJapanese)->toHashString(), morph);
             if (hasEnglish && morph->category() != IMorph::kBase) {
@@ -867,6 +885,11 @@ struct Model::PrivateContext {
     IString *englishNamePtr;
     IString *commentPtr;
     IString *englishCommentPtr;
+    /* arenas must be declared before arrays of the elements allocated from them */
+    internal::Arena vertexArena;
+    internal::Arena materialArena;
+    internal::Arena boneArena;
+    internal::Arena morphArena;
     PointerArray<Vertex> vertices;
     Array<int> indices;
     PointerHash<HashString, IString> textures;
@@ -1998,6 +2021,20 @@ void Model::getMatrixBuffer(MatrixBuffer *&matrixBuffer,
     }
 }
 
+void Model::getArenaStatistics(internal::Arena::Statistics &value) const
+{
+    internal::Arena::Statistics statistics;
+    value = internal::Arena::Statistics();
+    m_context->vertexArena.getStatistics(statistics);
+    value.add(statistics);
+    m_context->materialArena.getStatistics(statistics);
+    value.add(statistics);
+    m_context->boneArena.getStatistics(statistics);
+    value.add(statistics);
+    m_context->morphArena.getStatistics(statistics);
+    value.add(statistics);
+}
+
 } /* namespace pmd2 */
 } /* namespace VPVL2_VERSION_NS */
 } /* namespace vpvl2 */
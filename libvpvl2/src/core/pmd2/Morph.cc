@@ -72,6 +72,8 @@ namespace pmd2
 {
 
 struct Morph::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *parentModelRef, IEncoding *encodingRef)
         : parentModelRef(parentModelRef),
           parentLabelRef(0),
@@ -113,6 +115,11 @@ Morph::Morph(Model *parentModelRef, IEncoding *encodingRef)
     m_context = new PrivateContext(parentModelRef, encodingRef);
 }
 
+Morph::Morph(Model *parentModelRef, IEncoding *encodingRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(parentModelRef, encodingRef))
+{
+}
+
 Morph::~Morph()
 {
     if (Label *parentLabelRef = m_context->parentLabelRef) {
@@ -69,6 +69,8 @@ namespace pmd2
 {
 
 struct Vertex::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *parentModelRef)
         : parentModelRef(parentModelRef),
           origin(kZeroV3),
@@ -120,6 +122,11 @@ Vertex::Vertex(Model *parentModelRef)
 {
 }
 
+Vertex::Vertex(Model *parentModelRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(parentModelRef))
+{
+}
+
 Vertex::~Vertex()
 {
     internal::deleteObject(m_context);
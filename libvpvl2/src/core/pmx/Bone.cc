@@ -69,6 +69,9 @@ struct IKUnit {
 using namespace vpvl2::VPVL2_VERSION_NS;
 using namespace vpvl2::VPVL2_VERSION_NS::pmx;
 
+/* distance between the effector and the target to stop iterations on the fast path of IK */
+static const Scalar kInverseKinematicsTolerance = 1e-4f;
+
 struct DefaultIKJoint : vpvl2::IBone::IKJoint {
     static void clampAngle(const Scalar &min, const Scalar &max, const Scalar &result, Scalar &output) {
         if (btFuzzyZero(min) && btFuzzyZero(max)) {
@@ -150,9 +153,11 @@ struct DefaultIKJoint : vpvl2::IBone::IKJoint {
         m_upperLimit = value;
     }
 
-    bool calculateAxisAngle(const Vector3 &rootBonePosition, Vector3 &localAxis, Scalar &angle) const {
-        const Vector3 &currentEffectorPosition = m_parentBoneRef->effectorBoneRef()->worldTransform().getOrigin();
-        const Transform &jointBoneTransform = m_targetBoneRef->worldTransform();
+    bool calculateAxisAngle(const Vector3 &rootBonePosition,
+                            const Vector3 &currentEffectorPosition,
+                            const Transform &jointBoneTransform,
+                            Vector3 &localAxis,
+                            Scalar &angle) const {
         const Transform &inversedJointBoneTransform = jointBoneTransform.inverse();
         Vector3 localRootBonePosition = inversedJointBoneTransform * rootBonePosition;
         Vector3 localEffectorPosition = inversedJointBoneTransform * currentEffectorPosition;
@@ -169,17 +174,21 @@ struct DefaultIKJoint : vpvl2::IBone::IKJoint {
             return false;
         }
     }
-    void transformLocalAxis(bool performConstraint, Vector3 &localAxis) const {
+    void transformLocalAxis(bool performConstraint,
+                            const Transform &worldTransform,
+                            const Transform &localTransform,
+                            Vector3 &localAxis) const {
 #ifdef VPVL2_NEW_IK
         if (hasAngleLimit() && performConstraint) {
-            const Matrix3x3 &matrix = m_targetBoneRef->worldTransform().getBasis();
-            constrainLocalAxis(matrix, localAxis);
+            constrainLocalAxis(worldTransform.getBasis(), localAxis);
         }
         else {
-            localAxis = m_targetBoneRef->localTransform() * localAxis;
+            localAxis = localTransform * localAxis;
         }
 #else
         (void) performConstraint;
+        (void) worldTransform;
+        (void) localTransform;
         (void) localAxis;
 #endif
     }
@@ -201,13 +210,13 @@ struct DefaultIKJoint : vpvl2::IBone::IKJoint {
             localAxis.setValue(0.0, 0.0, axisZ);
         }
     }
-    void constrainRotation(Quaternion &jointRotation, bool performConstrain) const {
+    void constrainRotation(const Quaternion &localOrientation, bool performConstrain, Quaternion &jointRotation) const {
 #ifndef VPVL2_NEW_IK
         (void) performConstrain;
         Scalar x1, y1, z1, x2, y2, z2, x3, y3, z3;
         Matrix3x3 matrix(jointRotation);
         matrix.getEulerZYX(z1, y1, x1);
-        matrix.setRotation(m_targetBoneRef->localOrientation());
+        matrix.setRotation(localOrientation);
         matrix.getEulerZYX(z2, y2, x2);
         x3 = x1 + x2; y3 = y1 + y2; z3 = z1 + z2;
         clampAngle(m_lowerLimit.x(), m_upperLimit.x(), x3, x1);
@@ -219,6 +228,7 @@ struct DefaultIKJoint : vpvl2::IBone::IKJoint {
         // extraction order in 2.1 and 2.4 and 2.5 from
         // http://www.geometrictools.com/Documentation/EulerAngles.pdf
         //
+        (void) localOrientation;
         static const Scalar &kEulerAngleLimit = btRadians(90), &kEulerAngleLimit2 = btRadians(88);
         Scalar x, y, z;
         Quaternion rx, ry, rz, result;
@@ -280,6 +290,8 @@ namespace pmx
 {
 
 struct Bone::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *modelRef)
         : parentModelRef(modelRef),
           parentLabelRef(0),
@@ -289,17 +301,13 @@ struct Bone::PrivateContext {
           destinationOriginBoneRef(0),
           namePtr(0),
           englishNamePtr(0),
-          localOrientation(Quaternion::getIdentity()),
-          localInherentOrientation(Quaternion::getIdentity()),
-          localMorphOrientation(Quaternion::getIdentity()),
-          jointOrientation(Quaternion::getIdentity()),
-          worldTransform(Transform::getIdentity()),
-          localTransform(Transform::getIdentity()),
+          poseBufferRef(0),
           origin(kZeroV3),
           offsetFromParent(kZeroV3),
-          localTranslation(kZeroV3),
-          localInherentTranslation(kZeroV3),
-          localMorphTranslation(kZeroV3),
+          lastLocalTranslation(kZeroV3),
+          lastLocalMorphTranslation(kZeroV3),
+          lastLocalOrientation(Quaternion::getIdentity()),
+          lastLocalMorphOrientation(Quaternion::getIdentity()),
           destinationOrigin(kZeroV3),
           fixedAxis(kZeroV3),
           axisX(kZeroV3),
@@ -307,6 +315,7 @@ struct Bone::PrivateContext {
           angleLimit(0.0),
           coefficient(1.0),
           index(-1),
+          poseSlot(-1),
           parentBoneIndex(-1),
           layerIndex(0),
           destinationOriginBoneIndex(-1),
@@ -315,7 +324,8 @@ struct Bone::PrivateContext {
           parentInherentBoneIndex(-1),
           globalID(0),
           flags(0),
-          enableInverseKinematics(true)
+          enableInverseKinematics(true),
+          poseInputInvalidated(true)
     {
     }
     ~PrivateContext() {
@@ -327,18 +337,16 @@ struct Bone::PrivateContext {
         parentBoneRef = 0;
         effectorBoneRef = 0;
         parentInherentBoneRef = 0;
+        poseBufferRef = 0;
         origin.setZero();
         offsetFromParent.setZero();
-        localTranslation.setZero();
-        localMorphTranslation.setZero();
-        worldTransform.setIdentity();
-        localTransform.setIdentity();
         destinationOrigin.setZero();
         fixedAxis.setZero();
         axisX.setZero();
         axisZ.setZero();
         coefficient = 0;
         index = -1;
+        poseSlot = -1;
         parentBoneIndex = -1;
         layerIndex = 0;
         destinationOriginBoneIndex = -1;
@@ -383,37 +391,226 @@ struct Bone::PrivateContext {
 #endif
     }
 
-    void updateWorldTransform() {
-        updateWorldTransform(localTranslation, localOrientation);
+    struct Pose {
+        Pose()
+            : localTranslation(kZeroV3),
+              localOrientation(Quaternion::getIdentity()),
+              worldTransform(Transform::getIdentity()),
+              skinningTransform(Transform::getIdentity()),
+              morphTranslation(kZeroV3),
+              morphOrientation(Quaternion::getIdentity()),
+              jointOrientation(Quaternion::getIdentity()),
+              inherentTranslation(kZeroV3),
+              inherentOrientation(Quaternion::getIdentity())
+        {
+        }
+        Vector3 localTranslation;
+        Quaternion localOrientation;
+        Transform worldTransform;
+        Transform skinningTransform;
+        Vector3 morphTranslation;
+        Quaternion morphOrientation;
+        Quaternion jointOrientation;
+        Vector3 inherentTranslation;
+        Quaternion inherentOrientation;
+    };
+
+    static void updateWorldTransform(Model::PoseBuffer &buffer, int slot, const Vector3 &translation, const Quaternion &orientation) {
+        Transform &worldTransform = buffer.worldTransforms[slot];
+        worldTransform.setRotation(orientation);
+        worldTransform.setOrigin(buffer.offsets[slot] + translation);
+        const int parentSlot = buffer.parentSlots[slot];
+        if (parentSlot >= 0) {
+            worldTransform = buffer.worldTransforms[parentSlot] * worldTransform;
+        }
+    }
+    static void updateWorldTransform(Model::PoseBuffer &buffer, int slot) {
+        updateWorldTransform(buffer, slot, buffer.localTranslations[slot], buffer.localOrientations[slot]);
+    }
+
+    /* pose of the bone lives in the pose buffer of the model while the bone belongs to it */
+    Vector3 &localTranslation() {
+        return poseBufferRef ? poseBufferRef->localTranslations[poseSlot] : detachedPose.localTranslation;
+    }
+    Quaternion &localOrientation() {
+        return poseBufferRef ? poseBufferRef->localOrientations[poseSlot] : detachedPose.localOrientation;
+    }
+    Transform &worldTransform() {
+        return poseBufferRef ? poseBufferRef->worldTransforms[poseSlot] : detachedPose.worldTransform;
+    }
+    Transform &skinningTransform() {
+        return poseBufferRef ? poseBufferRef->skinningTransforms[poseSlot] : detachedPose.skinningTransform;
+    }
+    Vector3 &morphTranslation() {
+        return poseBufferRef ? poseBufferRef->morphTranslations[poseSlot] : detachedPose.morphTranslation;
+    }
+    Quaternion &morphOrientation() {
+        return poseBufferRef ? poseBufferRef->morphOrientations[poseSlot] : detachedPose.morphOrientation;
+    }
+    Quaternion &jointOrientation() {
+        return poseBufferRef ? poseBufferRef->jointOrientations[poseSlot] : detachedPose.jointOrientation;
+    }
+    Vector3 &inherentTranslation() {
+        return poseBufferRef ? poseBufferRef->inherentTranslations[poseSlot] : detachedPose.inherentTranslation;
+    }
+    Quaternion &inherentOrientation() {
+        return poseBufferRef ? poseBufferRef->inherentOrientations[poseSlot] : detachedPose.inherentOrientation;
+    }
+    void storePose(Pose &value) {
+        value.localTranslation = localTranslation();
+        value.localOrientation = localOrientation();
+        value.worldTransform = worldTransform();
+        value.skinningTransform = skinningTransform();
+        value.morphTranslation = morphTranslation();
+        value.morphOrientation = morphOrientation();
+        value.jointOrientation = jointOrientation();
+        value.inherentTranslation = inherentTranslation();
+        value.inherentOrientation = inherentOrientation();
+    }
+    void restorePose(const Pose &value) {
+        localTranslation() = value.localTranslation;
+        localOrientation() = value.localOrientation;
+        worldTransform() = value.worldTransform;
+        skinningTransform() = value.skinningTransform;
+        morphTranslation() = value.morphTranslation;
+        morphOrientation() = value.morphOrientation;
+        jointOrientation() = value.jointOrientation;
+        inherentTranslation() = value.inherentTranslation;
+        inherentOrientation() = value.inherentOrientation;
+    }
+    void bindPoseBuffer(Model::PoseBuffer *buffer, int slot) {
+        if (poseBufferRef) {
+            /* copy current pose to own storage before the buffer is resized or released */
+            storePose(detachedPose);
+            poseBufferRef = 0;
+            poseSlot = -1;
+        }
+        if (buffer && slot >= 0) {
+            poseBufferRef = buffer;
+            poseSlot = slot;
+            restorePose(detachedPose);
+            syncPoseLayout();
+        }
+    }
+    void syncPoseLayout() {
+        if (Model::PoseBuffer *buffer = poseBufferRef) {
+            static const uint16 kPoseFlagsMask = kHasInverseKinematics | kHasInherentRotation | kHasInherentTranslation;
+            buffer->offsets[poseSlot] = offsetFromParent;
+            buffer->coefficients[poseSlot] = coefficient;
+            buffer->flags[poseSlot] = flags & kPoseFlagsMask;
+            buffer->parentSlots[poseSlot] = parentBoneRef ? parentBoneRef->m_context->poseSlot : -1;
+            buffer->parentInherentSlots[poseSlot] = parentInherentBoneRef ? parentInherentBoneRef->m_context->poseSlot : -1;
+        }
+    }
+    bool resolveJointSlots(int &effectorSlot) {
+        const int njoints = joints.count();
+        effectorSlot = effectorBoneRef ? effectorBoneRef->m_context->poseSlot : -1;
+        jointSlots.resize(njoints);
+        for (int i = 0; i < njoints; i++) {
+            const Bone *jointBoneRef = joints[i]->m_targetBoneRef;
+            const int jointSlot = jointBoneRef ? jointBoneRef->m_context->poseSlot : -1;
+            if (jointSlot < 0) {
+                return false;
+            }
+            jointSlots[i] = jointSlot;
+        }
+        return effectorSlot >= 0;
+    }
+    bool hasTwoJointsChain(const Model::PoseBuffer &buffer, int effectorSlot) const {
+        if (joints.count() != 2) {
+            return false;
+        }
+        const DefaultIKJoint *hingeJoint = joints[0], *baseJoint = joints[1];
+        if (!hingeJoint->hasAngleLimit() || baseJoint->hasAngleLimit()) {
+            return false;
+        }
+        /* the hinge joint (knee or elbow) must rotate around X axis only */
+        const Vector3 &lower = hingeJoint->m_lowerLimit, &upper = hingeJoint->m_upperLimit;
+        if (!btFuzzyZero(lower.y()) || !btFuzzyZero(upper.y()) || !btFuzzyZero(lower.z()) || !btFuzzyZero(upper.z())) {
+            return false;
+        }
+        const int hingeSlot = jointSlots[0], baseSlot = jointSlots[1];
+        return buffer.parentSlots[effectorSlot] == hingeSlot && buffer.parentSlots[hingeSlot] == baseSlot;
+    }
+    void solveTwoJointsChain(Model::PoseBuffer &buffer, int effectorSlot, const Vector3 &targetPosition) {
+        const DefaultIKJoint *hingeJoint = joints[0];
+        const int hingeSlot = jointSlots[0], baseSlot = jointSlots[1];
+        const Vector3 basePosition = buffer.worldTransforms[baseSlot].getOrigin();
+        /*
+         * the hinge orientation is split into the twist around X axis and the rest of it (swing), and only the
+         * twist is solved so Y/Z rotation of the current pose is kept. positions of the base joint (h) and the
+         * swung effector (q) in the hinge joint space without its twist. distance between them after rotating q
+         * around X axis by angle t is |q|^2 + |h|^2 - 2 * q.x * h.x - 2 * (a * cos(t) + b * sin(t)), so the angle
+         * to reach the target is solved from the law of cosines
+         */
+        Quaternion &hingeLocalOrientation = buffer.localOrientations[hingeSlot];
+        Quaternion hingeTwist(hingeLocalOrientation.x(), 0, 0, hingeLocalOrientation.w());
+        hingeTwist = btFuzzyZero(hingeTwist.length2()) ? Quaternion::getIdentity() : hingeTwist.normalized();
+        const Quaternion &hingeSwing = hingeTwist.inverse() * hingeLocalOrientation;
+        const Transform &hingeFrame = buffer.worldTransforms[baseSlot]
+                * Transform(Matrix3x3::getIdentity(), buffer.offsets[hingeSlot] + buffer.localTranslations[hingeSlot]);
+        const Vector3 &h = hingeFrame.invXform(basePosition);
+        const Vector3 &q = quatRotate(hingeSwing, buffer.offsets[effectorSlot] + buffer.localTranslations[effectorSlot]);
+        const Scalar a = h.y() * q.y() + h.z() * q.z(), b = h.z() * q.y() - h.y() * q.z();
+        const Scalar c = q.length2() + h.length2() - 2 * q.x() * h.x(), d = basePosition.distance2(targetPosition);
+        const Scalar r = btSqrt(a * a + b * b);
+        if (r > SIMD_EPSILON) {
+            const Scalar phi = btAtan2(b, a), delta = btAcos(btClamped((c - d) / (2 * r), Scalar(-1), Scalar(1)));
+            const Scalar lowerAngle = hingeJoint->m_lowerLimit.x(), upperAngle = hingeJoint->m_upperLimit.x();
+            const Scalar angle1 = btClamped(btNormalizeAngle(phi + delta), lowerAngle, upperAngle);
+            const Scalar angle2 = btClamped(btNormalizeAngle(phi - delta), lowerAngle, upperAngle);
+            const Scalar error1 = btFabs(c - 2 * (a * btCos(angle1) + b * btSin(angle1)) - d);
+            const Scalar error2 = btFabs(c - 2 * (a * btCos(angle2) + b * btSin(angle2)) - d);
+            const Quaternion &hingeOrientation = Quaternion(kUnitX, error1 <= error2 ? angle1 : angle2) * hingeSwing;
+            buffer.jointOrientations[hingeSlot] = hingeOrientation * hingeLocalOrientation.inverse();
+            hingeLocalOrientation = hingeOrientation;
+            updateWorldTransform(buffer, hingeSlot);
+            updateWorldTransform(buffer, effectorSlot);
+        }
+        /* then rotates the base joint to point the effector to the target */
+        Vector3 from = buffer.worldTransforms[effectorSlot].getOrigin() - basePosition, to = targetPosition - basePosition;
+        if (!btFuzzyZero(from.length2()) && !btFuzzyZero(to.length2())) {
+            const Quaternion &rotation = shortestArcQuat(from.normalize(), to.normalize());
+            const int parentSlot = buffer.parentSlots[baseSlot];
+            const Quaternion &parentOrientation = parentSlot >= 0
+                    ? buffer.worldTransforms[parentSlot].getRotation() : Quaternion::getIdentity();
+            const Quaternion &jointRotation = parentOrientation.inverse() * rotation * parentOrientation;
+            Quaternion &baseLocalOrientation = buffer.localOrientations[baseSlot];
+            baseLocalOrientation = (jointRotation * baseLocalOrientation).normalized();
+            buffer.jointOrientations[baseSlot] = jointRotation;
+            updateWorldTransform(buffer, baseSlot);
+            updateWorldTransform(buffer, hingeSlot);
+            updateWorldTransform(buffer, effectorSlot);
+        }
     }
     void updateWorldTransform(const Vector3 &translation, const Quaternion &orientation) {
-        worldTransform.setRotation(orientation);
-        worldTransform.setOrigin(offsetFromParent + translation);
+        Transform &value = worldTransform();
+        value.setRotation(orientation);
+        value.setOrigin(offsetFromParent + translation);
         if (parentBoneRef) {
-            worldTransform = parentBoneRef->worldTransform() * worldTransform;
+            value = parentBoneRef->worldTransform() * value;
         }
     }
 
     Model *parentModelRef;
     Label *parentLabelRef;
     PointerArray<DefaultIKJoint> joints;
+    Array<int> jointSlots;
     Bone *parentBoneRef;
     Bone *effectorBoneRef;
     Bone *parentInherentBoneRef;
     Bone *destinationOriginBoneRef;
     IString *namePtr;
     IString *englishNamePtr;
-    Quaternion localOrientation;
-    Quaternion localInherentOrientation;
-    Quaternion localMorphOrientation;
-    Quaternion jointOrientation;
-    Transform worldTransform;
-    Transform localTransform;
+    Model::PoseBuffer *poseBufferRef;
+    Pose detachedPose;
     Vector3 origin;
     Vector3 offsetFromParent;
-    Vector3 localTranslation;
-    Vector3 localInherentTranslation;
-    Vector3 localMorphTranslation;
+    /* inputs of performTransform at the last update to find bones to be transformed incrementally */
+    Vector3 lastLocalTranslation;
+    Vector3 lastLocalMorphTranslation;
+    Quaternion lastLocalOrientation;
+    Quaternion lastLocalMorphOrientation;
     Vector3 destinationOrigin;
     Vector3 fixedAxis;
     Vector3 axisX;
@@ -421,6 +618,7 @@ struct Bone::PrivateContext {
     float32 angleLimit;
     float32 coefficient;
     int index;
+    int poseSlot;
     int parentBoneIndex;
     int layerIndex;
     int destinationOriginBoneIndex;
@@ -430,6 +628,7 @@ struct Bone::PrivateContext {
     int globalID;
     uint16 flags;
     bool enableInverseKinematics;
+    bool poseInputInvalidated;
 };
 
 Bone::Bone(Model *modelRef)
@@ -437,6 +636,11 @@ Bone::Bone(Model *modelRef)
 {
 }
 
+Bone::Bone(Model *modelRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(modelRef))
+{
+}
+
 Bone::~Bone()
 {
     if (Label *parentLabelRef = m_context->parentLabelRef) {
@@ -666,7 +870,7 @@ void Bone::read(const uint8 *data, const Model::DataInfo &info, vsize &size)
     internal::setPosition(unit.vector3, m_context->origin);
     VPVL2_VLOG(3, "PMXBone: origin=" << m_context->origin.x() << "," << m_context->origin.y() << "," << m_context->origin.z());
     m_context->offsetFromParent = m_context->origin;
-    m_context->worldTransform.setOrigin(m_context->origin);
+    m_context->worldTransform().setOrigin(m_context->origin);
     ptr += sizeof(unit);
     m_context->parentBoneIndex = internal::readSignedIndex(ptr, boneIndexSize);
     VPVL2_VLOG(3, "PMXBone: parentBoneIndex=" << m_context->parentBoneIndex);
@@ -852,13 +1056,13 @@ vsize Bone::estimateSize(const Model::DataInfo &info) const
 void Bone::mergeMorph(const Morph::Bone *morph, const IMorph::WeightPrecision &weight)
 {
     const Scalar &w = Scalar(weight);
-    m_context->localMorphTranslation += morph->position * w;
-    m_context->localMorphOrientation *= Quaternion::getIdentity().slerp(morph->rotation, w);
+    m_context->morphTranslation() += morph->position * w;
+    m_context->morphOrientation() *= Quaternion::getIdentity().slerp(morph->rotation, w);
 }
 
 void Bone::getLocalTransform(Transform &output) const
 {
-    getLocalTransform(m_context->worldTransform, output);
+    getLocalTransform(m_context->worldTransform(), output);
 }
 
 void Bone::getLocalTransform(const Transform &worldTransform, Transform &output) const
@@ -866,115 +1070,148 @@ void Bone::getLocalTransform(const Transform &worldTransform, Transform &output)
     output = worldTransform * Transform(Matrix3x3::getIdentity(), -m_context->origin);
 }
 
-void Bone::performTransform()
+void Bone::performTransform(Model::PoseBuffer &buffer, int slot)
 {
+    const uint16 flags = buffer.flags[slot];
+    const Scalar &coefficient = buffer.coefficients[slot];
+    const int parentSlot = buffer.parentInherentSlots[slot];
     Quaternion orientation(Quaternion::getIdentity());
-    if (isInherentOrientationEnabled()) {
-        Bone *parentBoneRef = m_context->parentInherentBoneRef;
-        if (parentBoneRef) {
-            if (parentBoneRef->isInherentOrientationEnabled()) {
-                orientation *= parentBoneRef->m_context->localInherentOrientation;
+    if (internal::hasFlagBits(flags, kHasInherentRotation)) {
+        if (parentSlot >= 0) {
+            if (internal::hasFlagBits(buffer.flags[parentSlot], kHasInherentRotation)) {
+                orientation *= buffer.inherentOrientations[parentSlot];
             }
             else {
-                orientation *= parentBoneRef->localOrientation() * parentBoneRef->m_context->localMorphOrientation;
+                orientation *= buffer.localOrientations[parentSlot] * buffer.morphOrientations[parentSlot];
             }
         }
-        if (!btFuzzyZero(m_context->coefficient - 1.0f)) {
-            orientation = Quaternion::getIdentity().slerp(orientation, m_context->coefficient);
+        if (!btFuzzyZero(coefficient - 1.0f)) {
+            orientation = Quaternion::getIdentity().slerp(orientation, coefficient);
         }
-        if (parentBoneRef && parentBoneRef->hasInverseKinematics()) {
-            orientation *= parentBoneRef->m_context->jointOrientation;
+        if (parentSlot >= 0 && internal::hasFlagBits(buffer.flags[parentSlot], kHasInverseKinematics)) {
+            orientation *= buffer.jointOrientations[parentSlot];
         }
-        m_context->localInherentOrientation = orientation * m_context->localOrientation * m_context->localMorphOrientation;
-        m_context->localInherentOrientation.normalize();
+        buffer.inherentOrientations[slot] = (orientation * buffer.localOrientations[slot] * buffer.morphOrientations[slot]).normalized();
     }
-    orientation *= m_context->localOrientation * m_context->localMorphOrientation * m_context->jointOrientation;
+    orientation *= buffer.localOrientations[slot] * buffer.morphOrientations[slot] * buffer.jointOrientations[slot];
     orientation.normalize();
     Vector3 translation(kZeroV3);
-    if (isInherentTranslationEnabled()) {
-        Bone *parentBone = m_context->parentInherentBoneRef;
-        if (parentBone) {
-            if (parentBone->isInherentTranslationEnabled()) {
-                translation += parentBone->m_context->localInherentTranslation;
+    if (internal::hasFlagBits(flags, kHasInherentTranslation)) {
+        if (parentSlot >= 0) {
+            if (internal::hasFlagBits(buffer.flags[parentSlot], kHasInherentTranslation)) {
+                translation += buffer.inherentTranslations[parentSlot];
             }
             else {
-                translation += parentBone->localTranslation() + parentBone->m_context->localMorphTranslation;
+                translation += buffer.localTranslations[parentSlot] + buffer.morphTranslations[parentSlot];
             }
         }
-        if (!btFuzzyZero(m_context->coefficient - 1.0f)) {
-            translation *= m_context->coefficient;
+        if (!btFuzzyZero(coefficient - 1.0f)) {
+            translation *= coefficient;
         }
-        m_context->localInherentTranslation = translation;
+        buffer.inherentTranslations[slot] = translation;
+    }
+    translation += buffer.localTranslations[slot] + buffer.morphTranslations[slot];
+    PrivateContext::updateWorldTransform(buffer, slot, translation, orientation);
+}
+
+void Bone::resetPoses(Model::PoseBuffer &buffer, int from, int to)
+{
+    for (int i = from; i < to; i++) {
+        buffer.morphTranslations[i].setZero();
+        buffer.morphOrientations[i] = Quaternion::getIdentity();
+        buffer.jointOrientations[i] = Quaternion::getIdentity();
+    }
+}
+
+void Bone::performTransform()
+{
+    if (Model::PoseBuffer *buffer = m_context->poseBufferRef) {
+        performTransform(*buffer, m_context->poseSlot);
+    }
+    else {
+        /* inherence is resolved by pose slots, so a bone not belonging to a model uses its own pose only */
+        const Quaternion &orientation = m_context->localOrientation() * m_context->morphOrientation() * m_context->jointOrientation();
+        m_context->updateWorldTransform(m_context->localTranslation() + m_context->morphTranslation(), orientation.normalized());
     }
-    translation += m_context->localTranslation + m_context->localMorphTranslation;
-    m_context->updateWorldTransform(translation, orientation);
 }
 
 void Bone::solveInverseKinematics()
 {
-    if (!hasInverseKinematics() || !m_context->enableInverseKinematics) {
+    Model::PoseBuffer *buffer = m_context->poseBufferRef;
+    int effectorSlot = -1;
+    if (!hasInverseKinematics() || !m_context->enableInverseKinematics || !buffer || !m_context->resolveJointSlots(effectorSlot)) {
         return;
     }
+    btAlignedObjectArray<Transform> &worldTransforms = buffer->worldTransforms;
+    btAlignedObjectArray<Quaternion> &localOrientations = buffer->localOrientations;
     const Array<DefaultIKJoint *> &constraints = m_context->joints;
-    const Vector3 &rootBonePosition = m_context->worldTransform.getOrigin();
+    const Array<int> &jointSlots = m_context->jointSlots;
+    const Vector3 &rootBonePosition = worldTransforms[m_context->poseSlot].getOrigin();
     const int nconstraints = constraints.count();
     const int numIterations = m_context->numIterations;
     const int numHalfOfIteration = numIterations / 2;
-    Bone *effectorBoneRef = m_context->effectorBoneRef;
-    const Quaternion originalTargetRotation = effectorBoneRef->localOrientation();
-    Quaternion jointRotation(Quaternion::getIdentity()), newJointLocalRotation;
+    const bool enableFastPath = m_context->parentModelRef && m_context->parentModelRef->isFastInverseKinematicsEnabled();
+    if (enableFastPath && m_context->hasTwoJointsChain(*buffer, effectorSlot)) {
+        m_context->solveTwoJointsChain(*buffer, effectorSlot, rootBonePosition);
+        return;
+    }
+    const Quaternion originalTargetRotation = localOrientations[effectorSlot];
+    Quaternion jointRotation(Quaternion::getIdentity());
     Vector3 localAxis(kZeroV3);
     Scalar angle = 0;
     for (int i = 0; i < numIterations; i++) {
+        if (enableFastPath && worldTransforms[effectorSlot].getOrigin().distance2(rootBonePosition)
+                < kInverseKinematicsTolerance * kInverseKinematicsTolerance) {
+            break;
+        }
         const bool performConstraint = i < numHalfOfIteration;
         for (int j = 0; j < nconstraints; j++) {
             const DefaultIKJoint *joint = constraints[j];
-            if (!joint->calculateAxisAngle(rootBonePosition, localAxis, angle)) {
+            const int jointSlot = jointSlots[j];
+            const Transform &jointTransform = worldTransforms[jointSlot];
+            if (!joint->calculateAxisAngle(rootBonePosition, worldTransforms[effectorSlot].getOrigin(), jointTransform, localAxis, angle)) {
                 break;
             }
-            joint->transformLocalAxis(performConstraint, localAxis);
+            joint->transformLocalAxis(performConstraint, jointTransform, buffer->skinningTransforms[jointSlot], localAxis);
             const Scalar &angleLimit = m_context->angleLimit * (j + 1) * 2;
             jointRotation.setRotation(localAxis, btClamped(angle, -angleLimit, angleLimit));
-            Bone *jointBoneRef = joint->m_targetBoneRef;
+            Quaternion &jointLocalOrientation = localOrientations[jointSlot];
             if (joint->hasAngleLimit() && performConstraint) {
                 if (VPVL2_IK_COND(performConstraint, i == 0)) {
                     joint->constrainLocalAxis(Matrix3x3(jointRotation), localAxis);
                     jointRotation.setRotation(localAxis, angle);
                 }
                 else {
-                    joint->constrainRotation(jointRotation, performConstraint);
+                    joint->constrainRotation(jointLocalOrientation, performConstraint, jointRotation);
                 }
-                newJointLocalRotation = jointRotation * jointBoneRef->localOrientation();
+                jointLocalOrientation = jointRotation * jointLocalOrientation;
             }
             else if (i == 0) {
-                newJointLocalRotation = jointRotation * jointBoneRef->localOrientation();
+                jointLocalOrientation = jointRotation * jointLocalOrientation;
             }
             else {
-                newJointLocalRotation = jointBoneRef->localOrientation() * jointRotation;
+                jointLocalOrientation = jointLocalOrientation * jointRotation;
             }
-            jointBoneRef->setLocalOrientation(newJointLocalRotation);
-            jointBoneRef->m_context->jointOrientation = jointRotation;
+            buffer->jointOrientations[jointSlot] = jointRotation;
             for (int k = j; k >= 0; k--) {
-                DefaultIKJoint *joint = constraints[k];
-                jointBoneRef = joint->m_targetBoneRef;
-                jointBoneRef->m_context->updateWorldTransform();
+                PrivateContext::updateWorldTransform(*buffer, jointSlots[k]);
             }
-            effectorBoneRef->m_context->updateWorldTransform();
+            PrivateContext::updateWorldTransform(*buffer, effectorSlot);
         }
     }
-    effectorBoneRef->setLocalOrientation(originalTargetRotation);
+    localOrientations[effectorSlot] = originalTargetRotation;
 }
 
 void Bone::updateLocalTransform()
 {
-    getLocalTransform(m_context->localTransform);
+    getLocalTransform(m_context->skinningTransform());
 }
 
 void Bone::reset()
 {
-    m_context->localMorphTranslation.setZero();
-    m_context->localMorphOrientation = Quaternion::getIdentity();
-    m_context->jointOrientation = Quaternion::getIdentity();
+    m_context->morphTranslation().setZero();
+    m_context->morphOrientation() = Quaternion::getIdentity();
+    m_context->jointOrientation() = Quaternion::getIdentity();
 }
 
 Vector3 Bone::offset() const
@@ -984,12 +1221,12 @@ Vector3 Bone::offset() const
 
 Transform Bone::worldTransform() const
 {
-    return m_context->worldTransform;
+    return m_context->worldTransform();
 }
 
 Transform Bone::localTransform() const
 {
-    return m_context->localTransform;
+    return m_context->skinningTransform();
 }
 
 void Bone::getEffectorBones(Array<IBone *> &value) const
@@ -1005,12 +1242,12 @@ void Bone::getEffectorBones(Array<IBone *> &value) const
 
 void Bone::setLocalTranslation(const Vector3 &value)
 {
-    m_context->localTranslation = value;
+    m_context->localTranslation() = value;
 }
 
 void Bone::setLocalOrientation(const Quaternion &value)
 {
-    m_context->localOrientation = value;
+    m_context->localOrientation() = value;
 }
 
 Label *Bone::internalParentLabelRef() const
@@ -1053,7 +1290,7 @@ const IString *Bone::name(IEncoding::LanguageType type) const
 
 Quaternion Bone::localOrientation() const
 {
-    return m_context->localOrientation;
+    return m_context->localOrientation();
 }
 
 Vector3 Bone::origin() const
@@ -1067,13 +1304,14 @@ Vector3 Bone::destinationOrigin() const
         return boneRef->worldTransform().getOrigin();
     }
     else {
-        return m_context->worldTransform.getOrigin() + m_context->worldTransform.getBasis() * m_context->destinationOrigin;
+        const Transform &worldTransform = m_context->worldTransform();
+        return worldTransform.getOrigin() + worldTransform.getBasis() * m_context->destinationOrigin;
     }
 }
 
 Vector3 Bone::localTranslation() const
 {
-    return m_context->localTranslation;
+    return m_context->localTranslation();
 }
 
 Vector3 Bone::axis() const
@@ -1197,7 +1435,41 @@ bool Bone::isInverseKinematicsEnabled() const
 
 void Bone::setLocalTransform(const Transform &value)
 {
-    m_context->localTransform = value;
+    m_context->skinningTransform() = value;
+    m_context->poseInputInvalidated = true;
+}
+
+void Bone::bindPoseBuffer(Model::PoseBuffer *buffer, int slot)
+{
+    m_context->bindPoseBuffer(buffer, slot);
+}
+
+int Bone::poseSlot() const
+{
+    return m_context->poseSlot;
+}
+
+bool Bone::isPoseInputChanged() const
+{
+    return m_context->poseInputInvalidated
+            || m_context->lastLocalTranslation != m_context->localTranslation()
+            || m_context->lastLocalOrientation != m_context->localOrientation()
+            || m_context->lastLocalMorphTranslation != m_context->morphTranslation()
+            || m_context->lastLocalMorphOrientation != m_context->morphOrientation();
+}
+
+void Bone::savePoseInput()
+{
+    m_context->lastLocalTranslation = m_context->localTranslation();
+    m_context->lastLocalOrientation = m_context->localOrientation();
+    m_context->lastLocalMorphTranslation = m_context->morphTranslation();
+    m_context->lastLocalMorphOrientation = m_context->morphOrientation();
+    m_context->poseInputInvalidated = false;
+}
+
+void Bone::invalidatePoseInput()
+{
+    m_context->poseInputInvalidated = true;
 }
 
 void Bone::setInternalParentLabelRef(Label *value)
@@ -1210,6 +1482,8 @@ void Bone::setParentBoneRef(IBone *value)
     if (!value || (value && value->parentModelRef() == m_context->parentModelRef)) {
         m_context->parentBoneRef = static_cast<Bone *>(value);
         m_context->parentBoneIndex = value ? value->index() : -1;
+        m_context->poseInputInvalidated = true;
+        m_context->syncPoseLayout();
     }
 }
 
@@ -1218,6 +1492,8 @@ void Bone::setParentInherentBoneRef(IBone *value)
     if (!value || (value && value->parentModelRef() == m_context->parentModelRef)) {
         m_context->parentInherentBoneRef = static_cast<Bone *>(value);
         m_context->parentInherentBoneIndex = value ? value->index() : -1;
+        m_context->poseInputInvalidated = true;
+        m_context->syncPoseLayout();
     }
 }
 
@@ -1225,6 +1501,8 @@ void Bone::setInherentCoefficient(float32 value)
 {
     if (!btFuzzyZero(m_context->coefficient - value)) {
         m_context->coefficient = value;
+        m_context->poseInputInvalidated = true;
+        m_context->syncPoseLayout();
     }
 }
 
@@ -1247,6 +1525,10 @@ void Bone::setName(const IString *value, IEncoding::LanguageType type)
 void Bone::setOrigin(const Vector3 &value)
 {
     m_context->origin = value;
+    m_context->poseInputInvalidated = true;
+    if (Model::PoseBuffer *buffer = m_context->poseBufferRef) {
+        buffer->origins[m_context->poseSlot] = value;
+    }
 }
 
 void Bone::setDestinationOrigin(const Vector3 &value)
@@ -1273,6 +1555,9 @@ void Bone::setAxisZ(const Vector3 &value)
 void Bone::setIndex(int value)
 {
     m_context->index = value;
+    if (m_context->parentModelRef) {
+        m_context->parentModelRef->markSkinningChanged();
+    }
 }
 
 void Bone::setLayerIndex(int value)
@@ -1308,16 +1593,22 @@ void Bone::setInteractive(bool value)
 void Bone::setHasInverseKinematics(bool value)
 {
     internal::toggleFlag(kHasInverseKinematics, value, m_context->flags);
+    m_context->poseInputInvalidated = true;
+    m_context->syncPoseLayout();
 }
 
 void Bone::setInherentOrientationEnable(bool value)
 {
     internal::toggleFlag(kHasInherentTranslation, value, m_context->flags);
+    m_context->poseInputInvalidated = true;
+    m_context->syncPoseLayout();
 }
 
 void Bone::setInherentTranslationEnable(bool value)
 {
     internal::toggleFlag(kHasInherentRotation, value, m_context->flags);
+    m_context->poseInputInvalidated = true;
+    m_context->syncPoseLayout();
 }
 
 void Bone::setFixedAxisEnable(bool value)
@@ -1343,6 +1634,7 @@ void Bone::setTransformedByExternalParentEnable(bool value)
 void Bone::setInverseKinematicsEnable(bool value)
 {
     m_context->enableInverseKinematics = value;
+    m_context->poseInputInvalidated = true;
 }
 
 IBone *Bone::rootBoneRef() const
@@ -1365,6 +1657,7 @@ void Bone::setEffectorBoneRef(IBone *effector)
     if (!effector || (effector && effector->parentModelRef() == m_context->parentModelRef)) {
         m_context->effectorBoneRef = static_cast<Bone *>(effector);
         m_context->effectorBoneIndex = effector ? effector->index() : -1;
+        m_context->poseInputInvalidated = true;
     }
 }
 
@@ -1376,6 +1669,7 @@ int Bone::numIterations() const
 void Bone::setNumIterations(int value)
 {
     m_context->numIterations = value;
+    m_context->poseInputInvalidated = true;
 }
 
 float32 Bone::angleLimit() const
@@ -1386,6 +1680,7 @@ float32 Bone::angleLimit() const
 void Bone::setAngleLimit(float32 value)
 {
     m_context->angleLimit = value;
+    m_context->poseInputInvalidated = true;
 }
 
 void Bone::getJointRefs(Array<IKJoint *> &value) const
@@ -131,6 +131,8 @@ struct RGBA3 {
 };
 
 struct Material::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *modelRef)
         : modelRef(modelRef),
           name(0),
@@ -213,6 +215,11 @@ Material::Material(Model *modelRef)
 {
 }
 
+Material::Material(Model *modelRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(modelRef))
+{
+}
+
 Material::~Material()
 {
     internal::deleteObject(m_context);
@@ -819,6 +826,9 @@ void Material::setFlags(int value)
 void Material::setIndex(int value)
 {
     m_context->index = value;
+    if (m_context->modelRef) {
+        m_context->modelRef->markSkinningChanged();
+    }
 }
 
 void Material::setSharedToonTextureUsed(bool value)
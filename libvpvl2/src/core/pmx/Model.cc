@@ -45,6 +45,7 @@
 #include "vpvl2/pmx/Model.h"
 #include "vpvl2/pmx/Morph.h"
 #include "vpvl2/pmx/RigidBody.h"
+#include "vpvl2/pmx/SkinningEngine.h"
 #include "vpvl2/pmx/SoftBody.h"
 #include "vpvl2/pmx/Vertex.h"
 #include "vpvl2/internal/ParallelProcessors.h"
@@ -52,6 +53,11 @@
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
 
+#ifdef VPVL2_LINK_INTEL_TBB
+#include <tbb/spin_mutex.h>
+#include <tbb/task_group.h>
+#endif
+
 namespace {
 
 using namespace vpvl2::VPVL2_VERSION_NS;
@@ -109,6 +115,65 @@ struct Flags
 
 #pragma pack(pop)
 
+class SynchronizedEncoding VPVL2_DECL_FINAL : public IEncoding {
+public:
+    /* IEncoding implementations may share converters, so parsing sections concurrently serializes conversions */
+    SynchronizedEncoding(IEncoding *encodingRef)
+        : m_encodingRef(encodingRef)
+    {
+    }
+    ~SynchronizedEncoding() {
+        m_encodingRef = 0;
+    }
+
+    IString *toString(const uint8 *value, vsize size, IString::Codec codec) const {
+        IString *s = 0;
+#if defined(VPVL2_LINK_INTEL_TBB)
+        tbb::spin_mutex::scoped_lock lock(m_mutex);
+        s = m_encodingRef->toString(value, size, codec);
+#else
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp critical (vpvl2_pmx_synchronized_encoding)
+#endif
+        s = m_encodingRef->toString(value, size, codec);
+#endif
+        return s;
+    }
+    IString *toString(const uint8 *value, IString::Codec codec, vsize maxlen) const {
+        IString *s = 0;
+#if defined(VPVL2_LINK_INTEL_TBB)
+        tbb::spin_mutex::scoped_lock lock(m_mutex);
+        s = m_encodingRef->toString(value, codec, maxlen);
+#else
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp critical (vpvl2_pmx_synchronized_encoding)
+#endif
+        s = m_encodingRef->toString(value, codec, maxlen);
+#endif
+        return s;
+    }
+    vsize estimateSize(const IString *value, IString::Codec codec) const {
+        return m_encodingRef->estimateSize(value, codec);
+    }
+    uint8 *toByteArray(const IString *value, IString::Codec codec, int &size) const {
+        return m_encodingRef->toByteArray(value, codec, size);
+    }
+    void disposeByteArray(uint8 *&value) const {
+        m_encodingRef->disposeByteArray(value);
+    }
+    const IString *stringConstant(ConstantType value) const {
+        return m_encodingRef->stringConstant(value);
+    }
+
+private:
+    IEncoding *m_encodingRef;
+#ifdef VPVL2_LINK_INTEL_TBB
+    mutable tbb::spin_mutex m_mutex;
+#endif
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(SynchronizedEncoding)
+};
+
 struct DefaultStaticVertexBuffer : public IModel::StaticVertexBuffer {
     typedef btAlignedObjectArray<int32> BoneIndices;
     typedef Array<BoneIndices> MeshBoneIndices;
@@ -289,15 +354,6 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
             position = edge = vertex->origin() + vertex->delta();
             position[3] = edge[3] = Scalar(vertex->type());
         }
-        void performTransform(const IVertex *vertex, const IVertex::EdgeSizePrecision &materialEdgeSize, Vector3 &p) {
-            Vector3 n;
-            const IVertex::EdgeSizePrecision &edgeSize = vertex->edgeSize() * materialEdgeSize;
-            vertex->performSkinning(p, n);
-            position = p;
-            normal = n;
-            edge = p + n * Scalar(edgeSize);
-            setUVA(vertex);
-        }
         inline void setUVA(const IVertex *vertex) {
             uva1 = vertex->uv(0);
             uva2 = vertex->uv(1);
@@ -317,10 +373,13 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
     DefaultDynamicVertexBuffer(const pmx::Model *model, const IModel::IndexBuffer *indexBuffer)
         : modelRef(model),
           indexBufferRef(indexBuffer),
+          skinningEnginePtr(0),
           enableParallelUpdate(false)
     {
+        skinningEnginePtr = new pmx::SkinningEngine(model, this);
     }
     ~DefaultDynamicVertexBuffer() {
+        internal::deleteObject(skinningEnginePtr);
         modelRef = 0;
         indexBufferRef = 0;
         enableParallelUpdate = false;
@@ -368,18 +427,37 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
         const Array<pmx::Vertex *> &verticeRefs = modelRef->vertices();
         internal::ParallelBindPoseVertexProcessor<pmx::Model, pmx::Vertex, Unit> processor(&verticeRefs, address);
         processor.execute(enableParallelUpdate);
+        skinningEnginePtr->invalidate();
     }
     void update(void *address) const {
         const Array<pmx::Vertex *> &vertices = modelRef->vertices();
         internal::ParallelVertexMorphProcessor<pmx::Model, pmx::Vertex, Unit> processor(&vertices, address);
         processor.execute(enableParallelUpdate);
     }
-    void performTransform(void *address, const Vector3 &cameraPosition) const {
-        const Array<pmx::Vertex *> &verticeRefs = modelRef->vertices();
-        Unit *bufferPtr = static_cast<Unit *>(address);
-        internal::ParallelSkinningVertexProcessor<pmx::Model, pmx::Vertex, Unit> processor(modelRef, &verticeRefs, cameraPosition, bufferPtr);
+    void updateRange(void *address, int from, int to) const {
+        const Array<pmx::Vertex *> &vertices = modelRef->vertices();
+        internal::ParallelVertexMorphProcessor<pmx::Model, pmx::Vertex, Unit> processor(&vertices, address, from, to);
         processor.execute(enableParallelUpdate);
     }
+    void getDirtyVertexRange(int &lastUpdateCount, int &from, int &to) const {
+        const int updateCount = modelRef->updateCount();
+        if (lastUpdateCount >= 0 && updateCount == lastUpdateCount + 1) {
+            modelRef->getDirtyVertexRange(from, to);
+        }
+        else if (lastUpdateCount >= 0 && updateCount == lastUpdateCount) {
+            /* model is not updated since the last call */
+            from = to = 0;
+        }
+        else {
+            /* no way to track changes of skipped updates */
+            from = 0;
+            to = modelRef->vertices().count();
+        }
+        lastUpdateCount = updateCount;
+    }
+    void performTransform(void *address, const Vector3 &cameraPosition) const {
+        skinningEnginePtr->execute(address, modelRef->edgeScaleFactor(cameraPosition), enableParallelUpdate);
+    }
     void computeAabb(const void *address, Array<Vector3> &values) const {
         const Array<pmx::Material *> &materials = modelRef->materials();
         internal::ParallelComputeAabbProcessor<pmx::Material, Unit> processor(&materials, &values, address);
@@ -391,6 +469,7 @@ struct DefaultDynamicVertexBuffer : public IModel::DynamicVertexBuffer {
 
     const pmx::Model *modelRef;
     const IModel::IndexBuffer *indexBufferRef;
+    pmx::SkinningEngine *skinningEnginePtr;
     bool enableParallelUpdate;
 };
 const DefaultDynamicVertexBuffer::Unit DefaultDynamicVertexBuffer::kIdent = DefaultDynamicVertexBuffer::Unit();
@@ -559,7 +638,9 @@ struct DefaultMatrixBuffer : public IModel::MatrixBuffer {
     }
 
     void updateBoneLocalTransforms() {
-        const Array<pmx::Bone *> &boneRefs = modelRef->bones();
+        const pmx::Model::PoseBuffer &poseBuffer = modelRef->poseBuffer();
+        const btAlignedObjectArray<Transform> &skinningTransforms = poseBuffer.skinningTransforms;
+        const btAlignedObjectArray<int> &boneIndex2Slot = poseBuffer.boneIndex2Slot;
         const Array<pmx::Material *> &materialRefs = modelRef->materials();
         const Transform &staticBoneLocalTransform = Factory::sharedNullBoneRef()->localTransform();
         const int nmaterials = materialRefs.count();
@@ -570,7 +651,7 @@ struct DefaultMatrixBuffer : public IModel::MatrixBuffer {
             staticBoneLocalTransform.getOpenGLMatrix(matrices);
             for (int j = 1; j < numBoneIndices; j++) {
                 const int boneIndex = boneIndices[j];
-                const Transform &localBoneTransform = boneRefs[boneIndex]->localTransform();
+                const Transform &localBoneTransform = skinningTransforms[boneIndex2Slot[boneIndex]];
                 localBoneTransform.getOpenGLMatrix(&matrices[j * 16]);
             }
         }
@@ -630,6 +711,8 @@ namespace VPVL2_VERSION_NS
 namespace pmx
 {
 
+#define VPVL2_CALCULATE_PROGRESS_PERCENTAGE(value) (value / 15.0)
+
 struct Model::PrivateContext {
     PrivateContext(IEncoding *encoding, Model *self)
         : encodingRef(encoding),
@@ -651,12 +734,23 @@ struct Model::PrivateContext {
           opacity(1),
           scaleFactor(1),
           edgeWidth(0),
+          morphedVertexFrom(0),
+          morphedVertexTo(0),
+          dirtyVertexFrom(0),
+          dirtyVertexTo(0),
+          updateCount(0),
+          skinningRevision(0),
           visible(false),
-          enablePhysics(false)
+          enablePhysics(false),
+          enableParallelLoad(false),
+          enableIncrementalUpdate(false),
+          enableFastInverseKinematics(false),
+          requiresFullUpdate(true)
     {
         internal::zerofill(&dataInfo, sizeof(dataInfo));
         dataInfo.encoding = encodingRef;
         dataInfo.version = 2.0f;
+        poseBuffer.numBonesBeforePhysics = 0;
     }
     ~PrivateContext() {
     }
@@ -671,6 +765,20 @@ struct Model::PrivateContext {
         joints.releaseAll();
         rigidBodies.releaseAll();
         bones.releaseAll();
+        bonesBeforePhysics.clear();
+        bonesAfterPhysics.clear();
+        name2boneRefs.clear();
+        name2morphRefs.clear();
+        /* blocks still used by elements removed from this model are freed when they are deleted */
+        vertexArena.reset();
+        materialArena.reset();
+        boneArena.reset();
+        morphArena.reset();
+        releasePoseBuffer();
+        morphedVertexRefs.clear();
+        vertexMorphedFlags.clear();
+        morphedVertexFrom = morphedVertexTo = 0;
+        dirtyVertexFrom = dirtyVertexTo = 0;
         internal::zerofill(&dataInfo, sizeof(dataInfo));
         dataInfo.encoding = encodingRef;
         dataInfo.version = 2.0f;
@@ -702,7 +810,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.verticesPtr;
         vsize size;
         for (int i = 0; i < nvertices; i++) {
-            Vertex *vertex = vertices.append(new Vertex(selfRef));
+            Vertex *vertex = vertices.append(new (&vertexArena) Vertex(selfRef, &vertexArena));
             vertex->read(ptr, info, size);
             ptr += size;
         }
@@ -741,7 +849,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.materialsPtr;
         vsize size;
         for (int i = 0; i < nmaterials; i++) {
-            Material *material = materials.append(new Material(selfRef));
+            Material *material = materials.append(new (&materialArena) Material(selfRef, &materialArena));
             material->read(ptr, info, size);
             ptr += size;
             IMaterial::IndexRange range = material->indexRange();
@@ -769,7 +877,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.bonesPtr;
         vsize size;
         for (int i = 0; i < nbones; i++) {
-            Bone *bone = bones.append(new Bone(selfRef));
+            Bone *bone = bones.append(new (&boneArena) Bone(selfRef, &boneArena));
             bone->read(ptr, info, size);
             name2boneRefs.insert(bone->name(IEncoding::kJapanese)->toHashString(), bone);
             name2boneRefs.insert(bone->name(IEncoding::kEnglish)->toHashString(), bone);
@@ -781,7 +889,7 @@ struct Model::PrivateContext {
         uint8 *ptr = info.morphsPtr;
         vsize size;
         for(int i = 0; i < nmorphs; i++) {
-            Morph *morph = morphs.append(new Morph(selfRef));
+            Morph *morph = morphs.append(new (&morphArena) Morph(selfRef, &morphArena));
             morph->read(ptr, info, size);
             name2morphRefs.insert(morph->name(IEncoding::kJapanese)->toHashString(), morph);
             name2morphRefs.insert(morph->name(IEncoding::kEnglish)->toHashString(), morph);
@@ -830,6 +938,118 @@ struct Model::PrivateContext {
             }
         }
     }
+    void parseSequentially(const Model::DataInfo &info) {
+        parseVertices(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(3));
+        parseIndices(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(4));
+        parseTextures(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(5));
+        parseMaterials(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(6));
+        parseBones(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(7));
+        parseMorphs(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(8));
+        parseLabels(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(9));
+        parseRigidBodies(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(10));
+        parseJoints(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(11));
+        parseSoftBodies(info);
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    template<typename TElement>
+    struct ReadElementsTask {
+        ReadElementsTask(const Array<TElement *> *elements, const Array<uint8 *> *ptrs, const Model::DataInfo *info)
+            : elementsRef(elements),
+              ptrsRef(ptrs),
+              infoRef(info)
+        {
+        }
+        void operator()() const {
+            internal::ParallelReadElementProcessor<TElement, Model::DataInfo> processor(elementsRef, ptrsRef, infoRef);
+            processor.execute();
+        }
+        const Array<TElement *> *elementsRef;
+        const Array<uint8 *> *ptrsRef;
+        const Model::DataInfo *infoRef;
+    };
+    struct ParseIndicesTask {
+        ParseIndicesTask(PrivateContext *context, const Model::DataInfo *info)
+            : contextRef(context),
+              infoRef(info)
+        {
+        }
+        void operator()() const {
+            contextRef->parseIndices(*infoRef);
+        }
+        PrivateContext *contextRef;
+        const Model::DataInfo *infoRef;
+    };
+#endif /* VPVL2_LINK_INTEL_TBB */
+    void parseSectionsConcurrently(const Model::DataInfo &info) {
+        SynchronizedEncoding encoding(info.encoding);
+        Model::DataInfo newInfo = info;
+        newInfo.encoding = &encoding;
+        Array<uint8 *> vertexPtrs, morphPtrs;
+        Vertex::locateVertices(info, vertexPtrs);
+        Morph::locateMorphs(info, morphPtrs);
+        /* arenas are not thread safe so elements are allocated up front in the file order */
+        const int nvertices = vertexPtrs.count(), nmorphs = morphPtrs.count();
+        vertices.reserve(nvertices);
+        for (int i = 0; i < nvertices; i++) {
+            vertices.append(new (&vertexArena) Vertex(selfRef, &vertexArena));
+        }
+        morphs.reserve(nmorphs);
+        for (int i = 0; i < nmorphs; i++) {
+            morphs.append(new (&morphArena) Morph(selfRef, &morphArena));
+        }
+#ifdef VPVL2_LINK_INTEL_TBB
+        /*
+         * vertices (chunked), indices and morphs (chunked) are parsed on the worker threads
+         * while sections registering names to hashes are parsed in order on the calling thread
+         * that also reports progress
+         */
+        tbb::task_group group;
+        group.run(ReadElementsTask<Vertex>(&vertices, &vertexPtrs, &newInfo));
+        group.run(ParseIndicesTask(this, &newInfo));
+        group.run(ReadElementsTask<Morph>(&morphs, &morphPtrs, &newInfo));
+        parseNamedSections(newInfo);
+        group.wait();
+#else /* VPVL2_LINK_INTEL_TBB */
+        internal::ParallelReadElementProcessor<Vertex, Model::DataInfo> vertexProcessor(&vertices, &vertexPtrs, &newInfo);
+        vertexProcessor.execute();
+        parseIndices(newInfo);
+        internal::ParallelReadElementProcessor<Morph, Model::DataInfo> morphProcessor(&morphs, &morphPtrs, &newInfo);
+        morphProcessor.execute();
+        parseNamedSections(newInfo);
+#endif /* VPVL2_LINK_INTEL_TBB */
+        for (int i = 0; i < nmorphs; i++) {
+            Morph *morph = morphs[i];
+            name2morphRefs.insert(morph->name(IEncoding::kJapanese)->toHashString(), morph);
+            name2morphRefs.insert(morph->name(IEncoding::kEnglish)->toHashString(), morph);
+        }
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(10));
+        /* materials assign themselves to vertices referred by indices */
+        parseMaterials(newInfo);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(11));
+    }
+    void parseNamedSections(const Model::DataInfo &info) {
+        parseTextures(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(4));
+        parseBones(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(5));
+        parseLabels(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(6));
+        parseRigidBodies(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(7));
+        parseJoints(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(8));
+        parseSoftBodies(info);
+        reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(9));
+    }
     void assignIndexSize(Model::DataInfo &info) const {
         info.boneIndexSize = Flags::estimateSize(bones.count());
         info.materialIndexSize = Flags::estimateSize(materials.count());
@@ -846,6 +1066,245 @@ struct Model::PrivateContext {
         flags.textureIndexSize = Flags::estimateSize(name2textureRefs.count());
         flags.vertexIndexSize = Flags::estimateSize(vertices.count());
     }
+    void sortBones() {
+        Bone::sortBones(bones, bonesBeforePhysics, bonesAfterPhysics);
+        rebuildPoseBuffer();
+        /* pose slots referred by vertices may be reassigned */
+        skinningRevision++;
+    }
+    void rebuildPoseBuffer() {
+        /* bones keep their poses in own storage while the buffer is resized */
+        const int nbones = bones.count();
+        for (int i = 0; i < nbones; i++) {
+            bones[i]->bindPoseBuffer(0, -1);
+        }
+        const int numBonesBeforePhysics = bonesBeforePhysics.count();
+        const int nslots = numBonesBeforePhysics + bonesAfterPhysics.count();
+        poseBuffer.localTranslations.resize(nslots);
+        poseBuffer.localOrientations.resize(nslots);
+        poseBuffer.worldTransforms.resize(nslots);
+        poseBuffer.skinningTransforms.resize(nslots);
+        poseBuffer.origins.resize(nslots);
+        poseBuffer.morphTranslations.resize(nslots);
+        poseBuffer.morphOrientations.resize(nslots);
+        poseBuffer.jointOrientations.resize(nslots);
+        poseBuffer.inherentTranslations.resize(nslots);
+        poseBuffer.inherentOrientations.resize(nslots);
+        poseBuffer.offsets.resize(nslots);
+        poseBuffer.coefficients.resize(nslots);
+        poseBuffer.flags.resize(nslots);
+        poseBuffer.parentSlots.resize(nslots);
+        poseBuffer.parentInherentSlots.resize(nslots);
+        poseBuffer.changedFlags.resize(nslots);
+        poseBuffer.numBonesBeforePhysics = numBonesBeforePhysics;
+        for (int i = 0; i < nslots; i++) {
+            Bone *bone = boneAtSlot(i);
+            bone->bindPoseBuffer(&poseBuffer, i);
+            poseBuffer.origins[i] = bone->origin();
+            poseBuffer.changedFlags[i] = 1;
+        }
+        /* parent slots are resolved after all bones are bound */
+        for (int i = 0; i < nslots; i++) {
+            const Bone *bone = boneAtSlot(i);
+            const Bone *parentBoneRef = static_cast<const Bone *>(bone->parentBoneRef());
+            const Bone *parentInherentBoneRef = static_cast<const Bone *>(bone->parentInherentBoneRef());
+            poseBuffer.parentSlots[i] = parentBoneRef ? parentBoneRef->poseSlot() : -1;
+            poseBuffer.parentInherentSlots[i] = parentInherentBoneRef ? parentInherentBoneRef->poseSlot() : -1;
+        }
+        poseBuffer.boneIndex2Slot.resize(nbones);
+        for (int i = 0; i < nbones; i++) {
+            poseBuffer.boneIndex2Slot[i] = bones[i]->poseSlot();
+        }
+        requiresFullUpdate = true;
+    }
+    void releasePoseBuffer() {
+        poseBuffer.localTranslations.clear();
+        poseBuffer.localOrientations.clear();
+        poseBuffer.worldTransforms.clear();
+        poseBuffer.skinningTransforms.clear();
+        poseBuffer.origins.clear();
+        poseBuffer.morphTranslations.clear();
+        poseBuffer.morphOrientations.clear();
+        poseBuffer.jointOrientations.clear();
+        poseBuffer.inherentTranslations.clear();
+        poseBuffer.inherentOrientations.clear();
+        poseBuffer.offsets.clear();
+        poseBuffer.coefficients.clear();
+        poseBuffer.flags.clear();
+        poseBuffer.parentSlots.clear();
+        poseBuffer.parentInherentSlots.clear();
+        poseBuffer.boneIndex2Slot.clear();
+        poseBuffer.changedFlags.clear();
+        poseBuffer.numBonesBeforePhysics = 0;
+    }
+    Bone *boneAtSlot(int slot) const {
+        const int numBonesBeforePhysics = bonesBeforePhysics.count();
+        return slot < numBonesBeforePhysics ? bonesBeforePhysics[slot] : bonesAfterPhysics[slot - numBonesBeforePhysics];
+    }
+    void updatePose(int from, int to) {
+        for (int i = from; i < to; i++) {
+            Bone::performTransform(poseBuffer, i);
+            if (internal::hasFlagBits(poseBuffer.flags[i], Bone::kHasInverseKinematics)) {
+                boneAtSlot(i)->solveInverseKinematics();
+            }
+        }
+        Model::updateSkinningTransforms(poseBuffer, from, to);
+        for (int i = from; i < to; i++) {
+            poseBuffer.changedFlags[i] = 1;
+        }
+    }
+    bool isSlotChanged(const Bone *bone, int slot) const {
+        if (bone) {
+            const int target = bone->poseSlot();
+            /* a bone transformed later than the slot is referred with the value of the previous update */
+            return target < 0 || target >= slot || poseBuffer.changedFlags[target] != 0;
+        }
+        return false;
+    }
+    bool requiresTransform(const Bone *bone, int slot) const {
+        if (bone->isPoseInputChanged() || isSlotChanged(static_cast<const Bone *>(bone->parentBoneRef()), slot)) {
+            return true;
+        }
+        if (bone->isInherentOrientationEnabled() || bone->isInherentTranslationEnabled()) {
+            return isSlotChanged(static_cast<const Bone *>(bone->parentInherentBoneRef()), slot);
+        }
+        return false;
+    }
+    bool requiresSolvingInverseKinematics(const Bone *bone, int slot, Array<IBone *> &jointBoneRefs) const {
+        if (!bone->isInverseKinematicsEnabled()) {
+            return false;
+        }
+        if (poseBuffer.changedFlags[slot] || isSlotChanged(static_cast<const Bone *>(bone->effectorBoneRef()), slot)) {
+            return true;
+        }
+        const int njoints = jointBoneRefs.count();
+        for (int i = 0; i < njoints; i++) {
+            if (isSlotChanged(static_cast<const Bone *>(jointBoneRefs[i]), slot)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    void markSlotChanged(const IBone *bone) {
+        const int slot = bone ? static_cast<const Bone *>(bone)->poseSlot() : -1;
+        if (slot >= 0) {
+            poseBuffer.changedFlags[slot] = 1;
+        }
+    }
+    void updatePoseIncrementally(const Array<Bone *> &boneRefs, int from, int to) {
+        Array<IBone *> jointBoneRefs;
+        const int nbones = boneRefs.count();
+        for (int i = from; i < to; i++) {
+            poseBuffer.changedFlags[i] = 0;
+        }
+        for (int i = 0; i < nbones; i++) {
+            Bone *bone = boneRefs[i];
+            const int slot = from + i;
+            if (requiresTransform(bone, slot)) {
+                const Transform lastWorldTransform = poseBuffer.worldTransforms[slot];
+                Bone::performTransform(poseBuffer, slot);
+                /* descendants need not to be transformed if the result is same as the last update */
+                poseBuffer.changedFlags[slot] = lastWorldTransform == poseBuffer.worldTransforms[slot] ? 0 : 1;
+            }
+            if (bone->hasInverseKinematics()) {
+                jointBoneRefs.clear();
+                bone->getEffectorBones(jointBoneRefs);
+                if (requiresSolvingInverseKinematics(bone, slot, jointBoneRefs)) {
+                    bone->solveInverseKinematics();
+                    const int njoints = jointBoneRefs.count();
+                    for (int j = 0; j < njoints; j++) {
+                        markSlotChanged(jointBoneRefs[j]);
+                    }
+                    markSlotChanged(bone->effectorBoneRef());
+                }
+            }
+        }
+        for (int i = from; i < to; i++) {
+            if (poseBuffer.changedFlags[i]) {
+                Model::updateSkinningTransforms(poseBuffer, i, i + 1);
+            }
+        }
+    }
+    void updatePoseBeforePhysics() {
+        updatePose(0, poseBuffer.numBonesBeforePhysics);
+    }
+    void updatePoseAfterPhysics() {
+        updatePose(poseBuffer.numBonesBeforePhysics, poseBuffer.worldTransforms.size());
+    }
+    void updateAllPoses() {
+        updatePoseBeforePhysics();
+        if (enablePhysics) {
+            internal::ParallelUpdateRigidBodyProcessor<pmx::RigidBody> processor(&rigidBodies);
+            processor.execute();
+        }
+        updatePoseAfterPhysics();
+    }
+    void updatePosesIncrementally() {
+        const int numBonesBeforePhysics = poseBuffer.numBonesBeforePhysics;
+        updatePoseIncrementally(bonesBeforePhysics, 0, numBonesBeforePhysics);
+        updatePoseIncrementally(bonesAfterPhysics, numBonesBeforePhysics, poseBuffer.worldTransforms.size());
+    }
+    void savePoseInputs() {
+        const int nbones = bones.count();
+        for (int i = 0; i < nbones; i++) {
+            Bone *bone = bones[i];
+            bone->savePoseInput();
+        }
+    }
+    void resetMorphedVertices() {
+        const int nvertices = vertices.count();
+        if (vertexMorphedFlags.count() != nvertices) {
+            /* vertices are changed or a vertex cannot be tracked, so all vertices should be reset */
+            internal::ParallelResetVertexProcessor<pmx::Vertex> processor(&vertices);
+            processor.execute();
+            vertexMorphedFlags.resize(nvertices);
+            for (int i = 0; i < nvertices; i++) {
+                vertexMorphedFlags[i] = 0;
+            }
+            dirtyVertexFrom = 0;
+            dirtyVertexTo = nvertices;
+        }
+        else {
+            /* only vertices morphed at the previous update have non zero delta */
+            const int nmorphed = morphedVertexRefs.count();
+            for (int i = 0; i < nmorphed; i++) {
+                Vertex *vertex = morphedVertexRefs[i];
+                vertex->reset();
+                vertexMorphedFlags[vertex->index()] = 0;
+            }
+            dirtyVertexFrom = morphedVertexFrom;
+            dirtyVertexTo = morphedVertexTo;
+        }
+        morphedVertexRefs.clear();
+        morphedVertexFrom = morphedVertexTo = 0;
+    }
+    void markVertexMorphed(Vertex *vertex) {
+        const int index = vertex->index();
+        if (internal::checkBound(index, 0, vertexMorphedFlags.count()) && vertices[index] == vertex) {
+            if (!vertexMorphedFlags[index]) {
+                vertexMorphedFlags[index] = 1;
+                morphedVertexRefs.append(vertex);
+                extendVertexRange(index, morphedVertexFrom, morphedVertexTo);
+                extendVertexRange(index, dirtyVertexFrom, dirtyVertexTo);
+            }
+        }
+        else {
+            /* fallback to reset all vertices at the next update */
+            vertexMorphedFlags.clear();
+            dirtyVertexFrom = 0;
+            dirtyVertexTo = vertices.count();
+        }
+    }
+    static void extendVertexRange(int index, int &from, int &to) {
+        if (from < to) {
+            btSetMin(from, index);
+            btSetMax(to, index + 1);
+        }
+        else {
+            from = index;
+            to = index + 1;
+        }
+    }
     void reportProgress(float value) const {
         if (progressReporterRef) {
             progressReporterRef->reportProgress(value);
@@ -858,6 +1317,11 @@ struct Model::PrivateContext {
     IModel *parentModelRef;
     IBone *parentBoneRef;
     IProgressReporter *progressReporterRef;
+    /* arenas must be declared before arrays of the elements allocated from them */
+    internal::Arena vertexArena;
+    internal::Arena materialArena;
+    internal::Arena boneArena;
+    internal::Arena morphArena;
     PointerArray<Vertex> vertices;
     Array<int> indices;
     PointerArray<IString> textures;
@@ -866,6 +1330,9 @@ struct Model::PrivateContext {
     PointerArray<Bone> bones;
     Array<Bone *> bonesBeforePhysics;
     Array<Bone *> bonesAfterPhysics;
+    Model::PoseBuffer poseBuffer;
+    Array<Vertex *> morphedVertexRefs;
+    Array<uint8> vertexMorphedFlags;
     PointerArray<Morph> morphs;
     PointerArray<Label> labels;
     PointerArray<RigidBody> rigidBodies;
@@ -886,9 +1353,19 @@ struct Model::PrivateContext {
     Scalar opacity;
     Scalar scaleFactor;
     IVertex::EdgeSizePrecision edgeWidth;
+    int morphedVertexFrom;
+    int morphedVertexTo;
+    int dirtyVertexFrom;
+    int dirtyVertexTo;
+    int updateCount;
+    int skinningRevision;
     DataInfo dataInfo;
     bool visible;
     bool enablePhysics;
+    bool enableParallelLoad;
+    bool enableIncrementalUpdate;
+    bool enableFastInverseKinematics;
+    bool requiresFullUpdate;
 };
 
 Model::Model(IEncoding *encoding)
@@ -907,30 +1384,16 @@ bool Model::load(const uint8 *data, vsize size)
     DataInfo info;
     internal::zerofill(&info, sizeof(info));
     if (preparse(data, size, info)) {
-#define VPVL2_CALCULATE_PROGRESS_PERCENTAGE(value) (value / 15.0)
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(1));
         m_context->release();
         m_context->parseNamesAndComments(info);
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(2));
-        m_context->parseVertices(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(3));
-        m_context->parseIndices(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(4));
-        m_context->parseTextures(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(5));
-        m_context->parseMaterials(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(6));
-        m_context->parseBones(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(7));
-        m_context->parseMorphs(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(8));
-        m_context->parseLabels(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(9));
-        m_context->parseRigidBodies(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(10));
-        m_context->parseJoints(info);
-        m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(11));
-        m_context->parseSoftBodies(info);
+        if (m_context->enableParallelLoad) {
+            m_context->parseSectionsConcurrently(info);
+        }
+        else {
+            m_context->parseSequentially(info);
+        }
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(12));
         if (!Bone::loadBones(m_context->bones)
                 || !Material::loadMaterials(m_context->materials, m_context->textures, m_context->indices.count())
@@ -944,12 +1407,11 @@ bool Model::load(const uint8 *data, vsize size)
             return false;
         }
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(13));
-        Bone::sortBones(m_context->bones, m_context->bonesBeforePhysics, m_context->bonesAfterPhysics);
+        m_context->sortBones();
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(14));
         performUpdate();
         m_context->reportProgress(VPVL2_CALCULATE_PROGRESS_PERCENTAGE(15));
         m_context->dataInfo = info;
-#undef VPVL2_CALCULATE_PROGRESS_PERCENTAGE
         return true;
     }
     else {
@@ -958,6 +1420,8 @@ bool Model::load(const uint8 *data, vsize size)
     return false;
 }
 
+#undef VPVL2_CALCULATE_PROGRESS_PERCENTAGE
+
 void Model::save(uint8 *data, vsize &written) const
 {
     Header header;
@@ -1074,12 +1538,8 @@ void Model::resetMotionState(btDiscreteDynamicsWorld *worldRef)
 {
     if (worldRef) {
         /* update worldTransform first to use it at RigidBody#setKinematic */
-        const int nbones = m_context->bonesBeforePhysics.count();
-        for (int i = 0; i < nbones; i++) {
-            Bone *bone = m_context->bonesBeforePhysics[i];
-            bone->reset();
-        }
-        updateLocalTransform(m_context->bonesBeforePhysics);
+        Bone::resetPoses(m_context->poseBuffer, 0, m_context->poseBuffer.numBonesBeforePhysics);
+        m_context->updatePoseBeforePhysics();
         const int numRigidBodies = m_context->rigidBodies.count();
         for (int i = 0; i < numRigidBodies; i++) {
             RigidBody *rigidBody = m_context->rigidBodies[i];
@@ -1092,25 +1552,21 @@ void Model::resetMotionState(btDiscreteDynamicsWorld *worldRef)
             Joint *joint = m_context->joints[i];
             joint->updateTransform();
         }
-        updateLocalTransform(m_context->bonesAfterPhysics);
+        m_context->updatePoseAfterPhysics();
+        m_context->requiresFullUpdate = true;
     }
 }
 
 void Model::performUpdate()
 {
     // update local transform matrix
-    const int nbones = m_context->bones.count();
-    for (int i = 0; i < nbones; i++) {
-        Bone *bone = m_context->bones[i];
-        bone->reset();
-    }
+    Bone::resetPoses(m_context->poseBuffer, 0, m_context->poseBuffer.worldTransforms.size());
     const int nmaterials = m_context->materials.count();
     for (int i = 0; i < nmaterials; i++) {
         Material *material = m_context->materials[i];
         material->reset();
     }
-    internal::ParallelResetVertexProcessor<pmx::Vertex> processor(&m_context->vertices);
-    processor.execute();
+    m_context->resetMorphedVertices();
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
         Morph *morph = m_context->morphs[i];
@@ -1120,15 +1576,18 @@ void Model::performUpdate()
         Morph *morph = m_context->morphs[i];
         morph->update();
     }
-    // before physics simulation
-    updateLocalTransform(m_context->bonesBeforePhysics);
-    if (m_context->enablePhysics) {
-        // physics simulation
-        internal::ParallelUpdateRigidBodyProcessor<pmx::RigidBody> processor(&m_context->rigidBodies);
-        processor.execute();
+    m_context->updateCount++;
+    // rigid bodies move bones at every step so incremental update is not applicable on physics simulation
+    if (m_context->enableIncrementalUpdate && !m_context->requiresFullUpdate && !m_context->enablePhysics) {
+        m_context->updatePosesIncrementally();
+    }
+    else {
+        m_context->updateAllPoses();
+    }
+    if (m_context->enableIncrementalUpdate) {
+        m_context->savePoseInputs();
+        m_context->requiresFullUpdate = false;
     }
-    // after physics simulation
-    updateLocalTransform(m_context->bonesAfterPhysics);
 }
 
 IBone *Model::findBoneRef(const IString *value) const
@@ -1650,9 +2109,54 @@ void Model::setParentBoneRef(IBone *value)
 
 void Model::setPhysicsEnable(bool value)
 {
+    if (value != m_context->enablePhysics) {
+        /* bones moved by rigid bodies should be transformed again */
+        m_context->requiresFullUpdate = true;
+    }
     m_context->enablePhysics = value;
 }
 
+bool Model::isParallelLoadEnabled() const
+{
+    return m_context->enableParallelLoad;
+}
+
+void Model::setParallelLoadEnable(bool value)
+{
+    m_context->enableParallelLoad = value;
+}
+
+bool Model::isIncrementalUpdateEnabled() const
+{
+    return m_context->enableIncrementalUpdate;
+}
+
+void Model::setIncrementalUpdateEnable(bool value)
+{
+    if (value != m_context->enableIncrementalUpdate) {
+        m_context->enableIncrementalUpdate = value;
+        m_context->requiresFullUpdate = true;
+    }
+}
+
+void Model::requestFullUpdate()
+{
+    m_context->requiresFullUpdate = true;
+}
+
+bool Model::isFastInverseKinematicsEnabled() const
+{
+    return m_context->enableFastInverseKinematics;
+}
+
+void Model::setFastInverseKinematicsEnable(bool value)
+{
+    if (value != m_context->enableFastInverseKinematics) {
+        m_context->enableFastInverseKinematics = value;
+        m_context->requiresFullUpdate = true;
+    }
+}
+
 void Model::updateLocalTransform(Array<Bone *> &bones)
 {
     const int nbones = bones.count();
@@ -1665,6 +2169,56 @@ void Model::updateLocalTransform(Array<Bone *> &bones)
     processor.execute();
 }
 
+void Model::updateSkinningTransforms(PoseBuffer &buffer, int from, int to)
+{
+    /* same as Bone#getLocalTransform but sweeps contiguous arrays of the pose buffer */
+    for (int i = from; i < to; i++) {
+        const Transform &worldTransform = buffer.worldTransforms[i];
+        const Matrix3x3 &basis = worldTransform.getBasis();
+        Transform &skinningTransform = buffer.skinningTransforms[i];
+        skinningTransform.setBasis(basis);
+        skinningTransform.setOrigin(worldTransform.getOrigin() - basis * buffer.origins[i]);
+    }
+}
+
+const Model::PoseBuffer &Model::poseBuffer() const
+{
+    return m_context->poseBuffer;
+}
+
+Model::PoseBuffer *Model::mutablePoseBuffer()
+{
+    return &m_context->poseBuffer;
+}
+
+void Model::markVertexMorphed(Vertex *vertex)
+{
+    if (vertex) {
+        m_context->markVertexMorphed(vertex);
+    }
+}
+
+void Model::markSkinningChanged()
+{
+    m_context->skinningRevision++;
+}
+
+int Model::skinningRevision() const
+{
+    return m_context->skinningRevision;
+}
+
+void Model::getDirtyVertexRange(int &from, int &to) const
+{
+    from = m_context->dirtyVertexFrom;
+    to = m_context->dirtyVertexTo;
+}
+
+int Model::updateCount() const
+{
+    return m_context->updateCount;
+}
+
 void Model::getIndexBuffer(IndexBuffer *&indexBuffer) const
 {
     internal::deleteObject(indexBuffer);
@@ -1857,7 +2411,7 @@ void Model::addBone(IBone *value)
         if (const IString *name = value->name(IEncoding::kEnglish)) {
             m_context->name2boneRefs.insert(name->toHashString(), value);
         }
-        Bone::sortBones(m_context->bones, m_context->bonesBeforePhysics, m_context->bonesAfterPhysics);
+        m_context->sortBones();
     }
 }
 
@@ -1874,6 +2428,7 @@ void Model::addLabel(ILabel *value)
 void Model::addMaterial(IMaterial *value)
 {
     internal::ModelHelper::addObject(this, value, m_context->materials);
+    m_context->skinningRevision++;
 }
 
 void Model::addMorph(IMorph *value)
@@ -1902,10 +2457,17 @@ void Model::addSoftBody(ISoftBody *value)
 void Model::addVertex(IVertex *value)
 {
     internal::ModelHelper::addObject(this, value, m_context->vertices);
+    m_context->vertexMorphedFlags.clear();
+    m_context->skinningRevision++;
 }
 
 void Model::removeBone(IBone *value)
 {
+    if (Bone *bone = static_cast<Bone *>(value)) {
+        if (bone->poseSlot() >= 0 && bone->parentModelRef() == this) {
+            bone->bindPoseBuffer(0, -1);
+        }
+    }
     internal::ModelHelper::removeObject(this, value, m_context->bones);
     internal::ModelHelper::removeBoneReferenceInBones(value, m_context->bones);
     internal::ModelHelper::removeBoneReferenceInRigidBodies(value, m_context->rigidBodies);
@@ -1927,6 +2489,7 @@ void Model::removeBone(IBone *value)
             }
         }
     }
+    m_context->sortBones();
 }
 
 void Model::removeJoint(IJoint *value)
@@ -1943,6 +2506,7 @@ void Model::removeMaterial(IMaterial *value)
 {
     internal::ModelHelper::removeObject(this, value, m_context->materials);
     internal::ModelHelper::removeMaterialReferenceInVertices(value, m_context->vertices);
+    m_context->skinningRevision++;
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
         Morph *morph = m_context->morphs[i];
@@ -2028,6 +2592,8 @@ void Model::removeSoftBody(ISoftBody *value)
 void Model::removeVertex(IVertex *value)
 {
     internal::ModelHelper::removeObject(this, value, m_context->vertices);
+    m_context->vertexMorphedFlags.clear();
+    m_context->skinningRevision++;
     const int nmorphs = m_context->morphs.count();
     for (int i = 0; i < nmorphs; i++) {
         Morph *morph = m_context->morphs[i];
@@ -2155,6 +2721,20 @@ void Model::removeTexture(IString *&value)
     }
 }
 
+void Model::getArenaStatistics(internal::Arena::Statistics &value) const
+{
+    internal::Arena::Statistics statistics;
+    value = internal::Arena::Statistics();
+    m_context->vertexArena.getStatistics(statistics);
+    value.add(statistics);
+    m_context->materialArena.getStatistics(statistics);
+    value.add(statistics);
+    m_context->boneArena.getStatistics(statistics);
+    value.add(statistics);
+    m_context->morphArena.getStatistics(statistics);
+    value.add(statistics);
+}
+
 } /* namespace pmx */
 } /* namespace VPVL2_VERSION_NS */
 } /* namespace vpvl2 */
@@ -110,6 +110,8 @@ namespace pmx
 {
 
 struct Morph::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(Model *modelRef)
         : parentModelRef(modelRef),
           parentMorphRef(0),
@@ -145,6 +147,18 @@ struct Morph::PrivateContext {
         dirty = false;
     }
 
+    static bool isUVMorph(IMorph::Type type) {
+        switch (type) {
+        case kTexCoordMorph:
+        case kUVA1Morph:
+        case kUVA2Morph:
+        case kUVA3Morph:
+        case kUVA4Morph:
+            return true;
+        default:
+            return false;
+        }
+    }
     static bool loadBones(const Array<pmx::Bone *> &bones, Morph *morph) {
         const int nMorphBones = morph->m_context->bones.count();
         const int nbones = bones.count();
@@ -513,6 +527,11 @@ Morph::Morph(Model *modelRef)
 {
 }
 
+Morph::Morph(Model *modelRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(modelRef))
+{
+}
+
 Morph::~Morph()
 {
     if (Label *parentLabelRef = m_context->parentLabelRef) {
@@ -598,6 +617,55 @@ bool Morph::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info)
     return true;
 }
 
+void Morph::locateMorphs(const Model::DataInfo &info, Array<uint8 *> &ptrs)
+{
+    /* morph units must be validated by preparse before locating */
+    const int nmorphs = int(info.morphsCount);
+    uint8 *ptr = info.morphsPtr, *namePtr = 0;
+    vsize rest = SIZE_MAX;
+    int32 size = 0;
+    MorphUnit morph;
+    ptrs.resize(nmorphs);
+    for (int i = 0; i < nmorphs; i++) {
+        ptrs[i] = ptr;
+        internal::getText(ptr, rest, namePtr, size);
+        internal::getText(ptr, rest, namePtr, size);
+        internal::getData(ptr, morph);
+        ptr += sizeof(MorphUnit);
+        vsize extraSize = 0;
+        switch (static_cast<Type>(morph.type)) {
+        case kGroupMorph:
+            extraSize = info.morphIndexSize + sizeof(GroupMorph);
+            break;
+        case kVertexMorph:
+            extraSize = info.vertexIndexSize + sizeof(VertexMorph);
+            break;
+        case kBoneMorph:
+            extraSize = info.boneIndexSize + sizeof(BoneMorph);
+            break;
+        case kTexCoordMorph:
+        case kUVA1Morph:
+        case kUVA2Morph:
+        case kUVA3Morph:
+        case kUVA4Morph:
+            extraSize = info.vertexIndexSize + sizeof(UVMorph);
+            break;
+        case kMaterialMorph:
+            extraSize = info.materialIndexSize + sizeof(MaterialMorph);
+            break;
+        case kFlipMorph:
+            extraSize = info.morphIndexSize + sizeof(FlipMorph);
+            break;
+        case kImpulseMorph:
+            extraSize = info.rigidBodyIndexSize + sizeof(ImpulseMorph);
+            break;
+        default:
+            break;
+        }
+        ptr += extraSize * morph.size;
+    }
+}
+
 bool Morph::loadMorphs(const Array<Morph *> &morphs,
                        const Array<pmx::Bone *> &bones,
                        const Array<pmx::Material *> &materials,
@@ -853,9 +921,13 @@ void Morph::update()
 {
     Type type = m_context->type;
     if (type == kVertexMorph && !m_context->parentMorphRef) {
-        /* force updating vertex morph except in group morph because vertices alway will be reset by IModel#performUpdate */
+        /* force updating vertex morph except in group morph because morphed vertices will be reset by IModel#performUpdate */
         updateVertexMorphs(m_context->internalWeight);
     }
+    else if (PrivateContext::isUVMorph(type) && !m_context->parentMorphRef) {
+        /* same as vertex morph because UV morph is also stored into vertices */
+        updateUVMorphs(m_context->internalWeight);
+    }
     else if (type == kGroupMorph) {
         /* force updating group morph to update morph children correctly even weight is not changed (not dirty) */
         updateGroupMorphs(m_context->internalWeight, false);
@@ -926,11 +998,19 @@ void Morph::syncWeight()
 
 void Morph::updateVertexMorphs(const WeightPrecision &value)
 {
+    /* zero weight morph doesn't affect vertices and they are already reset */
+    if (btFuzzyZero(Scalar(value))) {
+        return;
+    }
+    Model *modelRef = m_context->parentModelRef;
     const int nmorphs = m_context->vertices.count();
     for (int i = 0; i < nmorphs; i++) {
         Vertex *v = m_context->vertices[i];
         if (pmx::Vertex *vertex = static_cast<pmx::Vertex *>(v->vertex)) {
             vertex->mergeMorph(v, value);
+            if (modelRef) {
+                modelRef->markVertexMorphed(vertex);
+            }
         }
     }
 }
@@ -948,11 +1028,18 @@ void Morph::updateBoneMorphs(const WeightPrecision &value)
 
 void Morph::updateUVMorphs(const WeightPrecision &value)
 {
+    if (btFuzzyZero(Scalar(value))) {
+        return;
+    }
+    Model *modelRef = m_context->parentModelRef;
     const int nmorphs = m_context->uvs.count();
     for (int i = 0; i < nmorphs; i++) {
         UV *v = m_context->uvs[i];
         if (pmx::Vertex *vertex = static_cast<pmx::Vertex *>(v->vertex)) {
             vertex->mergeMorph(v, value);
+            if (modelRef) {
+                modelRef->markVertexMorphed(vertex);
+            }
         }
     }
 }
@@ -0,0 +1,598 @@
+/**
+
+ Copyright (c) 2010-2014  hkrn
+
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or
+ without modification, are permitted provided that the following
+ conditions are met:
+
+ - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above
+   copyright notice, this list of conditions and the following
+   disclaimer in the documentation and/or other materials provided
+   with the distribution.
+ - Neither the name of the MMDAI project team nor the names of
+   its contributors may be used to endorse or promote products
+   derived from this software without specific prior written
+   permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "vpvl2/vpvl2.h"
+#include "vpvl2/internal/util.h"
+
+#include "vpvl2/pmx/Bone.h"
+#include "vpvl2/pmx/Material.h"
+#include "vpvl2/pmx/SkinningEngine.h"
+#include "vpvl2/pmx/Vertex.h"
+
+#ifdef VPVL2_LINK_INTEL_TBB
+#include <tbb/tbb.h>
+#endif
+
+#if !defined(BT_USE_DOUBLE_PRECISION)
+#if defined(__AVX__)
+#define VPVL2_SKINNING_AVX
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VPVL2_SKINNING_SSE
+#include <xmmintrin.h>
+#endif
+#endif
+
+namespace
+{
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+/* a bone matrix is stored as 3x4 row major (basis rows and translation) */
+static const int kPaletteStride = 12;
+static const int kMaxPackWidth = 8;
+static const int kMaxBonesPerVertex = 4;
+static const int kMaxUVA = 4;
+
+struct ScalarPack {
+    typedef Scalar Type;
+    static const int kWidth = 1;
+    static inline Type zero() { return 0; }
+    static inline Type load(const Scalar *ptr) { return *ptr; }
+    static inline void gather(const Scalar *palette, const int *indices, Type *values) {
+        const Scalar *matrix = &palette[indices[0] * kPaletteStride];
+        for (int i = 0; i < kPaletteStride; i++) {
+            values[i] = matrix[i];
+        }
+    }
+    static inline Type add(const Type &a, const Type &b) { return a + b; }
+    static inline Type madd(const Type &a, const Type &b, const Type &c) { return a * b + c; }
+    static inline void store(Scalar *ptr, const Type &value) { *ptr = value; }
+};
+
+#if defined(VPVL2_SKINNING_AVX)
+struct AVXPack {
+    typedef __m256 Type;
+    static const int kWidth = 8;
+    static inline Type zero() { return _mm256_setzero_ps(); }
+    static inline Type load(const Scalar *ptr) { return _mm256_loadu_ps(ptr); }
+    static inline void gather(const Scalar *palette, const int *indices, Type *values) {
+        __m128 lo[kPaletteStride], hi[kPaletteStride];
+        transposeRows(palette, indices, lo);
+        transposeRows(palette, indices + 4, hi);
+        for (int i = 0; i < kPaletteStride; i++) {
+            values[i] = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[i]), hi[i], 1);
+        }
+    }
+    static inline void transposeRows(const Scalar *palette, const int *indices, __m128 *values) {
+        const Scalar *m0 = &palette[indices[0] * kPaletteStride], *m1 = &palette[indices[1] * kPaletteStride],
+                *m2 = &palette[indices[2] * kPaletteStride], *m3 = &palette[indices[3] * kPaletteStride];
+        for (int i = 0; i < kPaletteStride; i += 4) {
+            __m128 r0 = _mm_load_ps(m0 + i), r1 = _mm_load_ps(m1 + i), r2 = _mm_load_ps(m2 + i), r3 = _mm_load_ps(m3 + i);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            values[i + 0] = r0;
+            values[i + 1] = r1;
+            values[i + 2] = r2;
+            values[i + 3] = r3;
+        }
+    }
+    static inline Type add(const Type &a, const Type &b) { return _mm256_add_ps(a, b); }
+    static inline Type madd(const Type &a, const Type &b, const Type &c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+    static inline void store(Scalar *ptr, const Type &value) { _mm256_storeu_ps(ptr, value); }
+};
+typedef AVXPack DefaultPack;
+#elif defined(VPVL2_SKINNING_SSE)
+struct SSEPack {
+    typedef __m128 Type;
+    static const int kWidth = 4;
+    static inline Type zero() { return _mm_setzero_ps(); }
+    static inline Type load(const Scalar *ptr) { return _mm_loadu_ps(ptr); }
+    static inline void gather(const Scalar *palette, const int *indices, Type *values) {
+        /* loads one row of four bone matrices at a time and transposes them into lanes */
+        const Scalar *m0 = &palette[indices[0] * kPaletteStride], *m1 = &palette[indices[1] * kPaletteStride],
+                *m2 = &palette[indices[2] * kPaletteStride], *m3 = &palette[indices[3] * kPaletteStride];
+        for (int i = 0; i < kPaletteStride; i += 4) {
+            __m128 r0 = _mm_load_ps(m0 + i), r1 = _mm_load_ps(m1 + i), r2 = _mm_load_ps(m2 + i), r3 = _mm_load_ps(m3 + i);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            values[i + 0] = r0;
+            values[i + 1] = r1;
+            values[i + 2] = r2;
+            values[i + 3] = r3;
+        }
+    }
+    static inline Type add(const Type &a, const Type &b) { return _mm_add_ps(a, b); }
+    static inline Type madd(const Type &a, const Type &b, const Type &c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static inline void store(Scalar *ptr, const Type &value) { _mm_storeu_ps(ptr, value); }
+};
+typedef SSEPack DefaultPack;
+#else
+typedef ScalarPack DefaultPack;
+#endif
+
+struct SkinningStream {
+    SkinningStream(int numBones)
+        : numBones(numBones)
+    {
+    }
+    ~SkinningStream() {
+        numBones = 0;
+    }
+
+    void clear() {
+        originX.clear();
+        originY.clear();
+        originZ.clear();
+        normalX.clear();
+        normalY.clear();
+        normalZ.clear();
+        deltaX.clear();
+        deltaY.clear();
+        deltaZ.clear();
+        edgeSizes.clear();
+        for (int i = 0; i < kMaxUVA; i++) {
+            uvs[i].clear();
+        }
+        for (int i = 0; i < kMaxBonesPerVertex; i++) {
+            weights[i].clear();
+            paletteIndices[i].clear();
+        }
+        vertexIndices.clear();
+        materialIndices.clear();
+    }
+    void append(const pmx::Vertex *vertex, int vertexIndex, int materialIndex, const int *indices, const Scalar *values) {
+        const Vector3 &origin = vertex->origin(), &normal = vertex->normal();
+        originX.push_back(origin.x());
+        originY.push_back(origin.y());
+        originZ.push_back(origin.z());
+        normalX.push_back(normal.x());
+        normalY.push_back(normal.y());
+        normalZ.push_back(normal.z());
+        deltaX.push_back(0);
+        deltaY.push_back(0);
+        deltaZ.push_back(0);
+        edgeSizes.push_back(Scalar(vertex->edgeSize()));
+        for (int i = 0; i < kMaxUVA; i++) {
+            uvs[i].push_back(kZeroV4);
+        }
+        for (int i = 0; i < numBones; i++) {
+            weights[i].push_back(values[i]);
+            paletteIndices[i].push_back(indices[i]);
+        }
+        vertexIndices.push_back(vertexIndex);
+        materialIndices.push_back(materialIndex);
+        updateMorph(vertex, vertexIndices.size() - 1);
+    }
+    void updateMorph(const pmx::Vertex *vertex, int slot) {
+        const Vector3 &delta = vertex->delta();
+        deltaX[slot] = delta.x();
+        deltaY[slot] = delta.y();
+        deltaZ[slot] = delta.z();
+        for (int i = 0; i < kMaxUVA; i++) {
+            uvs[i][slot] = vertex->uv(i);
+        }
+    }
+    void pad(int width, int identityIndex) {
+        /* padded lanes have zero weights and are never written back */
+        while (vertexIndices.size() % width != 0) {
+            originX.push_back(0);
+            originY.push_back(0);
+            originZ.push_back(0);
+            normalX.push_back(0);
+            normalY.push_back(0);
+            normalZ.push_back(0);
+            deltaX.push_back(0);
+            deltaY.push_back(0);
+            deltaZ.push_back(0);
+            edgeSizes.push_back(0);
+            for (int i = 0; i < kMaxUVA; i++) {
+                uvs[i].push_back(kZeroV4);
+            }
+            for (int i = 0; i < numBones; i++) {
+                weights[i].push_back(0);
+                paletteIndices[i].push_back(identityIndex);
+            }
+            vertexIndices.push_back(-1);
+            materialIndices.push_back(0);
+        }
+    }
+    int size() const {
+        return vertexIndices.size();
+    }
+
+    btAlignedObjectArray<Scalar> originX;
+    btAlignedObjectArray<Scalar> originY;
+    btAlignedObjectArray<Scalar> originZ;
+    btAlignedObjectArray<Scalar> normalX;
+    btAlignedObjectArray<Scalar> normalY;
+    btAlignedObjectArray<Scalar> normalZ;
+    btAlignedObjectArray<Scalar> deltaX;
+    btAlignedObjectArray<Scalar> deltaY;
+    btAlignedObjectArray<Scalar> deltaZ;
+    btAlignedObjectArray<Scalar> edgeSizes;
+    btAlignedObjectArray<Vector4> uvs[kMaxUVA];
+    btAlignedObjectArray<Scalar> weights[kMaxBonesPerVertex];
+    btAlignedObjectArray<int> paletteIndices[kMaxBonesPerVertex];
+    btAlignedObjectArray<int> vertexIndices;
+    btAlignedObjectArray<int> materialIndices;
+    int numBones;
+};
+
+} /* namespace anonymous */
+
+namespace vpvl2
+{
+namespace VPVL2_VERSION_NS
+{
+namespace pmx
+{
+
+struct SkinningEngine::PrivateContext {
+    enum StreamType {
+        kBdef1Stream,
+        kBdef2Stream,
+        kBdef4Stream,
+        kMaxStreamType
+    };
+
+    class BatchProcessor VPVL2_DECL_FINAL {
+    public:
+        BatchProcessor(const PrivateContext *contextRef, const SkinningStream *streamRef, uint8 *bufferPtr)
+            : m_contextRef(contextRef),
+              m_streamRef(streamRef),
+              m_bufferPtr(bufferPtr)
+        {
+        }
+        ~BatchProcessor() {
+            m_contextRef = 0;
+            m_streamRef = 0;
+            m_bufferPtr = 0;
+        }
+
+        inline void performTransform(int index) const {
+            m_contextRef->transformBatch<DefaultPack>(*m_streamRef, index * DefaultPack::kWidth, m_bufferPtr);
+        }
+#ifdef VPVL2_LINK_INTEL_TBB
+        void operator()(const tbb::blocked_range<int> &range) const {
+            for (int i = range.begin(), end = range.end(); i != end; ++i) {
+                performTransform(i);
+            }
+        }
+#endif /* VPVL2_LINK_INTEL_TBB */
+        void execute(bool enableParallel) const {
+            const int nbatches = m_streamRef->size() / DefaultPack::kWidth;
+#if defined(VPVL2_LINK_INTEL_TBB)
+            if (enableParallel) {
+                tbb::parallel_for(tbb::blocked_range<int>(0, nbatches), *this);
+            }
+            else {
+#else
+            {
+                (void) enableParallel;
+#endif
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for
+#endif
+                for (int i = 0; i < nbatches; ++i) {
+                    performTransform(i);
+                }
+            }
+        }
+
+    private:
+        const PrivateContext *m_contextRef;
+        const SkinningStream *m_streamRef;
+        uint8 *m_bufferPtr;
+    };
+
+    PrivateContext(const Model *modelRef, const IModel::DynamicVertexBuffer *dynamicBufferRef)
+        : modelRef(modelRef),
+          dynamicBufferRef(dynamicBufferRef),
+          bdef1Stream(1),
+          bdef2Stream(2),
+          bdef4Stream(4),
+          strideSize(0),
+          positionOffset(0),
+          normalOffset(0),
+          edgeOffset(0),
+          numPackedVertices(-1),
+          numPackedSlots(-1),
+          packedRevision(-1),
+          lastUpdateCount(-1)
+    {
+        internal::zerofill(uvaOffsets, sizeof(uvaOffsets));
+    }
+    ~PrivateContext() {
+        modelRef = 0;
+        dynamicBufferRef = 0;
+        numPackedVertices = -1;
+        numPackedSlots = -1;
+        packedRevision = -1;
+        lastUpdateCount = -1;
+    }
+
+    bool isPacked() const {
+        return numPackedVertices == modelRef->vertices().count()
+                && numPackedSlots == modelRef->poseBuffer().skinningTransforms.size()
+                && packedRevision == modelRef->skinningRevision();
+    }
+    int resolvePaletteIndex(const IBone *boneRef, int identityIndex) const {
+        if (boneRef && boneRef->parentModelRef() == modelRef) {
+            const btAlignedObjectArray<int> &boneIndex2Slot = modelRef->poseBuffer().boneIndex2Slot;
+            const int boneIndex = boneRef->index();
+            if (internal::checkBound(boneIndex, 0, boneIndex2Slot.size())) {
+                const int slot = boneIndex2Slot[boneIndex];
+                return slot >= 0 ? slot : identityIndex;
+            }
+        }
+        return identityIndex;
+    }
+    void pack() {
+        const Array<Vertex *> &vertices = modelRef->vertices();
+        const int nvertices = vertices.count();
+        const int nmaterials = modelRef->materials().count();
+        const int identityIndex = modelRef->poseBuffer().skinningTransforms.size();
+        bdef1Stream.clear();
+        bdef2Stream.clear();
+        bdef4Stream.clear();
+        vertexStreamTypes.resize(nvertices);
+        vertexStreamSlots.resize(nvertices);
+        int indices[kMaxBonesPerVertex];
+        Scalar weights[kMaxBonesPerVertex];
+        for (int i = 0; i < nvertices; i++) {
+            const Vertex *vertex = vertices[i];
+            int materialIndex = vertex->materialRef()->index();
+            if (!internal::checkBound(materialIndex, 0, nmaterials)) {
+                materialIndex = nmaterials;
+            }
+            vertexStreamTypes[i] = kMaxStreamType;
+            vertexStreamSlots[i] = -1;
+            switch (vertex->type()) {
+            case IVertex::kBdef1: {
+                indices[0] = resolvePaletteIndex(vertex->boneRef(0), identityIndex);
+                weights[0] = 1;
+                bdef1Stream.append(vertex, i, materialIndex, indices, weights);
+                vertexStreamTypes[i] = kBdef1Stream;
+                vertexStreamSlots[i] = bdef1Stream.size() - 1;
+                break;
+            }
+            case IVertex::kBdef2:
+            case IVertex::kSdef: {
+                const Scalar weight = Scalar(vertex->weight(0));
+                indices[0] = resolvePaletteIndex(vertex->boneRef(0), identityIndex);
+                indices[1] = resolvePaletteIndex(vertex->boneRef(1), identityIndex);
+                weights[0] = weight;
+                weights[1] = 1 - weight;
+                bdef2Stream.append(vertex, i, materialIndex, indices, weights);
+                vertexStreamTypes[i] = kBdef2Stream;
+                vertexStreamSlots[i] = bdef2Stream.size() - 1;
+                break;
+            }
+            case IVertex::kBdef4:
+            case IVertex::kQdef: {
+                Scalar sum = 0;
+                for (int j = 0; j < kMaxBonesPerVertex; j++) {
+                    indices[j] = resolvePaletteIndex(vertex->boneRef(j), identityIndex);
+                    weights[j] = Scalar(vertex->weight(j));
+                    sum += weights[j];
+                }
+                /* weights are normalized here instead of every frame */
+                for (int j = 0; j < kMaxBonesPerVertex; j++) {
+                    weights[j] = btFuzzyZero(sum) ? Scalar(j == 0) : weights[j] / sum;
+                }
+                bdef4Stream.append(vertex, i, materialIndex, indices, weights);
+                vertexStreamTypes[i] = kBdef4Stream;
+                vertexStreamSlots[i] = bdef4Stream.size() - 1;
+                break;
+            }
+            case IVertex::kMaxType:
+            default:
+                break;
+            }
+        }
+        bdef1Stream.pad(DefaultPack::kWidth, identityIndex);
+        bdef2Stream.pad(DefaultPack::kWidth, identityIndex);
+        bdef4Stream.pad(DefaultPack::kWidth, identityIndex);
+        strideSize = dynamicBufferRef->strideSize();
+        positionOffset = dynamicBufferRef->strideOffset(IModel::Buffer::kVertexStride);
+        normalOffset = dynamicBufferRef->strideOffset(IModel::Buffer::kNormalStride);
+        edgeOffset = dynamicBufferRef->strideOffset(IModel::Buffer::kEdgeVertexStride);
+        uvaOffsets[0] = dynamicBufferRef->strideOffset(IModel::Buffer::kUVA1Stride);
+        uvaOffsets[1] = dynamicBufferRef->strideOffset(IModel::Buffer::kUVA2Stride);
+        uvaOffsets[2] = dynamicBufferRef->strideOffset(IModel::Buffer::kUVA3Stride);
+        uvaOffsets[3] = dynamicBufferRef->strideOffset(IModel::Buffer::kUVA4Stride);
+        numPackedVertices = nvertices;
+        numPackedSlots = identityIndex;
+        packedRevision = modelRef->skinningRevision();
+        /* morph deltas are packed above so only vertices morphed after here are refreshed */
+        lastUpdateCount = modelRef->updateCount();
+        VPVL2_VLOG(2, "PMXSkinningEngine: width=" << DefaultPack::kWidth << " bdef1=" << bdef1Stream.size() << " bdef2=" << bdef2Stream.size() << " bdef4=" << bdef4Stream.size());
+    }
+    void updateMorphs() {
+        const Array<Vertex *> &vertices = modelRef->vertices();
+        SkinningStream *streams[kMaxStreamType] = { &bdef1Stream, &bdef2Stream, &bdef4Stream };
+        int from = 0, to = 0;
+        dynamicBufferRef->getDirtyVertexRange(lastUpdateCount, from, to);
+        for (int i = from; i < to; i++) {
+            const int type = vertexStreamTypes[i];
+            if (type != kMaxStreamType) {
+                streams[type]->updateMorph(vertices[i], vertexStreamSlots[i]);
+            }
+        }
+    }
+    static void setPaletteTransform(const Transform &transform, Scalar *ptr) {
+        const Matrix3x3 &basis = transform.getBasis();
+        const Vector3 &origin = transform.getOrigin();
+        for (int i = 0; i < 3; i++) {
+            const Vector3 &row = basis.getRow(i);
+            ptr[i * 4 + 0] = row.x();
+            ptr[i * 4 + 1] = row.y();
+            ptr[i * 4 + 2] = row.z();
+            ptr[i * 4 + 3] = origin[i];
+        }
+    }
+    void updatePalette() {
+        const btAlignedObjectArray<Transform> &skinningTransforms = modelRef->poseBuffer().skinningTransforms;
+        const int nslots = skinningTransforms.size();
+        palette.resize((nslots + 1) * kPaletteStride);
+        for (int i = 0; i < nslots; i++) {
+            setPaletteTransform(skinningTransforms[i], &palette[i * kPaletteStride]);
+        }
+        /* the last one is identity for vertices referring no bone */
+        setPaletteTransform(Transform::getIdentity(), &palette[nslots * kPaletteStride]);
+    }
+    void updateMaterialEdgeSizes(const IVertex::EdgeSizePrecision &edgeScaleFactor) {
+        const Array<Material *> &materials = modelRef->materials();
+        const int nmaterials = materials.count();
+        materialEdgeSizes.resize(nmaterials + 1);
+        for (int i = 0; i < nmaterials; i++) {
+            const Material *material = materials[i];
+            materialEdgeSizes[i] = Scalar(material->edgeSize() * edgeScaleFactor);
+        }
+        materialEdgeSizes[nmaterials] = 0;
+    }
+    template<typename TPack>
+    void transformBatch(const SkinningStream &stream, int offset, uint8 *bufferPtr) const {
+        typedef typename TPack::Type Pack;
+        const Scalar *paletteRef = &palette[0];
+        Pack m[kPaletteStride], b[kPaletteStride];
+        for (int i = 0; i < kPaletteStride; i++) {
+            m[i] = TPack::zero();
+        }
+        /* blend bone matrices by weights first, then transform once */
+        for (int i = 0; i < stream.numBones; i++) {
+            const Pack w = TPack::load(&stream.weights[i][offset]);
+            TPack::gather(paletteRef, &stream.paletteIndices[i][offset], b);
+            for (int j = 0; j < kPaletteStride; j++) {
+                m[j] = TPack::madd(w, b[j], m[j]);
+            }
+        }
+        const Pack x = TPack::add(TPack::load(&stream.originX[offset]), TPack::load(&stream.deltaX[offset]));
+        const Pack y = TPack::add(TPack::load(&stream.originY[offset]), TPack::load(&stream.deltaY[offset]));
+        const Pack z = TPack::add(TPack::load(&stream.originZ[offset]), TPack::load(&stream.deltaZ[offset]));
+        const Pack nx = TPack::load(&stream.normalX[offset]);
+        const Pack ny = TPack::load(&stream.normalY[offset]);
+        const Pack nz = TPack::load(&stream.normalZ[offset]);
+        const Pack zero = TPack::zero();
+        Scalar result[6][kMaxPackWidth];
+        for (int i = 0; i < 3; i++) {
+            const Pack *row = &m[i * 4];
+            TPack::store(result[i], TPack::madd(row[0], x, TPack::madd(row[1], y, TPack::madd(row[2], z, row[3]))));
+            TPack::store(result[i + 3], TPack::madd(row[0], nx, TPack::madd(row[1], ny, TPack::madd(row[2], nz, zero))));
+        }
+        for (int i = 0; i < TPack::kWidth; i++) {
+            const int vertexIndex = stream.vertexIndices[offset + i];
+            if (vertexIndex < 0) {
+                continue;
+            }
+            uint8 *ptr = bufferPtr + vertexIndex * strideSize;
+            const Vector3 position(result[0][i], result[1][i], result[2][i]);
+            const Vector3 normal(result[3][i], result[4][i], result[5][i]);
+            const Scalar edgeSize = stream.edgeSizes[offset + i] * materialEdgeSizes[stream.materialIndices[offset + i]];
+            *reinterpret_cast<Vector3 *>(ptr + positionOffset) = position;
+            *reinterpret_cast<Vector3 *>(ptr + normalOffset) = normal;
+            *reinterpret_cast<Vector3 *>(ptr + edgeOffset) = position + normal * edgeSize;
+            for (int j = 0; j < kMaxUVA; j++) {
+                *reinterpret_cast<Vector4 *>(ptr + uvaOffsets[j]) = stream.uvs[j][offset + i];
+            }
+        }
+    }
+    void execute(uint8 *bufferPtr, bool enableParallel) {
+        const SkinningStream *streams[kMaxStreamType] = { &bdef1Stream, &bdef2Stream, &bdef4Stream };
+        for (int i = 0; i < kMaxStreamType; i++) {
+            BatchProcessor processor(this, streams[i], bufferPtr);
+            processor.execute(enableParallel);
+        }
+    }
+
+    const Model *modelRef;
+    const IModel::DynamicVertexBuffer *dynamicBufferRef;
+    SkinningStream bdef1Stream;
+    SkinningStream bdef2Stream;
+    SkinningStream bdef4Stream;
+    btAlignedObjectArray<Scalar> palette;
+    btAlignedObjectArray<Scalar> materialEdgeSizes;
+    btAlignedObjectArray<int> vertexStreamTypes;
+    btAlignedObjectArray<int> vertexStreamSlots;
+    vsize strideSize;
+    vsize positionOffset;
+    vsize normalOffset;
+    vsize edgeOffset;
+    vsize uvaOffsets[kMaxUVA];
+    int numPackedVertices;
+    int numPackedSlots;
+    int packedRevision;
+    int lastUpdateCount;
+};
+
+int SkinningEngine::packWidth()
+{
+    return DefaultPack::kWidth;
+}
+
+SkinningEngine::SkinningEngine(const Model *modelRef, const IModel::DynamicVertexBuffer *dynamicBufferRef)
+    : m_context(new PrivateContext(modelRef, dynamicBufferRef))
+{
+}
+
+SkinningEngine::~SkinningEngine()
+{
+    internal::deleteObject(m_context);
+}
+
+void SkinningEngine::invalidate()
+{
+    m_context->numPackedVertices = -1;
+    m_context->numPackedSlots = -1;
+    m_context->packedRevision = -1;
+}
+
+void SkinningEngine::execute(void *address, const IVertex::EdgeSizePrecision &edgeScaleFactor, bool enableParallel)
+{
+    if (!m_context->isPacked()) {
+        m_context->pack();
+    }
+    else {
+        m_context->updateMorphs();
+    }
+    m_context->updatePalette();
+    m_context->updateMaterialEdgeSizes(edgeScaleFactor);
+    m_context->execute(static_cast<uint8 *>(address), enableParallel);
+}
+
+} /* namespace pmx */
+} /* namespace VPVL2_VERSION_NS */
+} /* namespace vpvl2 */
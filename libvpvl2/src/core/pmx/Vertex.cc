@@ -89,6 +89,8 @@ const int Vertex::kMaxBones = 4;
 const int Vertex::kMaxMorphs = 5;
 
 struct Vertex::PrivateContext {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+
     PrivateContext(IModel *modelRef)
         : modelRef(modelRef),
           materialRef(Factory::sharedNullMaterialRef()),
@@ -136,6 +138,11 @@ struct Vertex::PrivateContext {
             morphUVs[i].setZero();
         }
     }
+    void markSkinningChanged() {
+        if (modelRef && modelRef->type() == IModel::kPMXModel) {
+            static_cast<Model *>(modelRef)->markSkinningChanged();
+        }
+    }
     IModel *modelRef;
     IBone *boneRefs[kMaxBones];
     IMaterial *materialRef;
@@ -160,6 +167,11 @@ Vertex::Vertex(IModel *modelRef)
 {
 }
 
+Vertex::Vertex(IModel *modelRef, internal::Arena *arenaRef)
+    : m_context(new (arenaRef) PrivateContext(modelRef))
+{
+}
+
 Vertex::~Vertex()
 {
     internal::deleteObject(m_context);
@@ -222,6 +234,38 @@ bool Vertex::preparse(uint8 *&ptr, vsize &rest, Model::DataInfo &info)
     return rest > 0;
 }
 
+void Vertex::locateVertices(const Model::DataInfo &info, Array<uint8 *> &ptrs)
+{
+    /* vertex units must be validated by preparse before locating */
+    const int nvertices = int(info.verticesCount);
+    const vsize baseSize = sizeof(VertexUnit) + sizeof(AdditinalUVUnit) * info.additionalUVSize;
+    uint8 *ptr = info.verticesPtr;
+    ptrs.resize(nvertices);
+    for (int i = 0; i < nvertices; i++) {
+        ptrs[i] = ptr;
+        ptr += baseSize;
+        vsize boneSize = 0;
+        switch (*ptr) {
+        case kBdef1:
+            boneSize = info.boneIndexSize;
+            break;
+        case kBdef2:
+            boneSize = info.boneIndexSize * 2 + sizeof(Bdef2Unit);
+            break;
+        case kBdef4:
+        case kQdef:
+            boneSize = info.boneIndexSize * 4 + sizeof(Bdef4Unit);
+            break;
+        case kSdef:
+            boneSize = info.boneIndexSize * 2 + sizeof(SdefUnit);
+            break;
+        default:
+            break;
+        }
+        ptr += sizeof(uint8) + boneSize + sizeof(float);
+    }
+}
+
 bool Vertex::loadVertices(const Array<Vertex *> &vertices, const Array<Bone *> &bones)
 {
     const int nvertices = vertices.count();
@@ -664,11 +708,13 @@ IMaterial *Vertex::materialRef() const
 void Vertex::setOrigin(const Vector3 &value)
 {
     m_context->origin = value;
+    m_context->markSkinningChanged();
 }
 
 void Vertex::setNormal(const Vector3 &value)
 {
     m_context->normal = value;
+    m_context->markSkinningChanged();
 }
 
 void Vertex::setTextureCoord(const Vector3 &value)
@@ -680,6 +726,7 @@ void Vertex::setOriginUV(int index, const Vector4 &value)
 {
     if (internal::checkBound(index, 0, kMaxBones - 1)) {
         m_context->originUVs[index + 1] = value;
+        m_context->markSkinningChanged();
     }
 }
 
@@ -693,17 +740,20 @@ void Vertex::setMorphUV(int index, const Vector4 &value)
 void Vertex::setType(Type value)
 {
     m_context->type = value;
+    m_context->markSkinningChanged();
 }
 
 void Vertex::setEdgeSize(const EdgeSizePrecision &value)
 {
     m_context->edgeSize = value;
+    m_context->markSkinningChanged();
 }
 
 void Vertex::setWeight(int index, const WeightPrecision &weight)
 {
     if (internal::checkBound(index, 0, kMaxBones)) {
         m_context->weight[index] = weight;
+        m_context->markSkinningChanged();
     }
 }
 
@@ -718,12 +768,14 @@ void Vertex::setBoneRef(int index, IBone *value)
             m_context->boneRefs[index] = Factory::sharedNullBoneRef();
             m_context->boneIndices[index] = -1;
         }
+        m_context->markSkinningChanged();
     }
 }
 
 void Vertex::setMaterialRef(IMaterial *value)
 {
     m_context->materialRef = value ? value : Factory::sharedNullMaterialRef();
+    m_context->markSkinningChanged();
 }
 
 void Vertex::setSdefC(const Vector3 &value)
@@ -744,6 +796,7 @@ void Vertex::setSdefR1(const Vector3 &value)
 void Vertex::setIndex(int value)
 {
     m_context->index = value;
+    m_context->markSkinningChanged();
 }
 
 } /* namespace pmx */
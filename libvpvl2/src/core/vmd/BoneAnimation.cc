@@ -41,6 +41,8 @@
 #include "vpvl2/internal/MotionHelper.h"
 
 #include "vpvl2/IBoneKeyframe.h"
+#include "vpvl2/pmx/Bone.h"
+#include "vpvl2/pmx/Model.h"
 #include "vpvl2/vmd/BoneAnimation.h"
 #include "vpvl2/vmd/BoneKeyframe.h"
 
@@ -68,6 +70,93 @@ struct BoneAnimation::PrivateContext {
     }
 };
 
+struct BoneAnimation::CompiledContext {
+    CompiledContext(IModel *modelRef)
+        : poseBufferRef(0),
+          numPoseSlots(0)
+    {
+        if (modelRef->type() == IModel::kPMXModel) {
+            poseBufferRef = static_cast<pmx::Model *>(modelRef)->mutablePoseBuffer();
+            numPoseSlots = poseBufferRef->localTranslations.size();
+        }
+    }
+
+    void appendTrack(const Array<BoneKeyframe *> &keyframes, IBone *boneRef, bool isNull) {
+        const int nkeyframes = keyframes.count();
+        /* bones of pmx model are written to the pose buffer directly, others through IBone */
+        const int slot = poseBufferRef ? static_cast<const pmx::Bone *>(boneRef)->poseSlot() : -1;
+        trackBoneRefs.append(boneRef);
+        trackSlots.append(slot);
+        trackOffsets.append(timeIndices.count());
+        trackCounts.append(nkeyframes);
+        trackLastIndices.append(0);
+        trackNullFlags.append(isNull ? 1 : 0);
+        for (int i = 0; i < nkeyframes; i++) {
+            const BoneKeyframe *keyframe = keyframes[i];
+            const bool *linear = keyframe->linear();
+            const IKeyframe::SmoothPrecision *const *tables = keyframe->interpolationTable();
+            timeIndices.append(keyframe->timeIndex());
+            translations.push_back(keyframe->localTranslation());
+            orientations.push_back(keyframe->localOrientation());
+            for (int j = 0; j < 4; j++) {
+                /* tables are owned by InterpolationCurveRegistry and shared between keyframes */
+                tableRefs.append(linear[j] ? 0 : tables[j]);
+            }
+        }
+    }
+    static IKeyframe::SmoothPrecision weightValue(const IKeyframe::SmoothPrecision &w, const IKeyframe::SmoothPrecision *v) {
+        if (!v) {
+            return w;
+        }
+        const uint16 index = static_cast<int16>(w * BoneKeyframe::kTableSize);
+        return v[index] + (v[index + 1] - v[index]) * (w * BoneKeyframe::kTableSize - index);
+    }
+    void interpolate(const IKeyframe::TimeIndex &currentTimeIndex, int from, int to, Vector3 &position, Quaternion &rotation) const {
+        const IKeyframe::TimeIndex &timeIndexFrom = timeIndices[from], &timeIndexTo = timeIndices[to];
+        const Vector3 &positionFrom = translations[from], &positionTo = translations[to];
+        const Quaternion &rotationFrom = orientations[from], &rotationTo = orientations[to];
+        if (timeIndexFrom != timeIndexTo) {
+            if (currentTimeIndex <= timeIndexFrom) {
+                position = positionFrom;
+                rotation = rotationFrom;
+            }
+            else if (currentTimeIndex >= timeIndexTo) {
+                position = positionTo;
+                rotation = rotationTo;
+            }
+            else {
+                /* curve of the destination keyframe is used to interpolate */
+                const IKeyframe::SmoothPrecision &w = internal::MotionHelper::interpolateTimeIndex(currentTimeIndex, timeIndexFrom, timeIndexTo);
+                const IKeyframe::SmoothPrecision *const *tables = &tableRefs[to * 4];
+                const IKeyframe::SmoothPrecision &x = internal::MotionHelper::lerp(positionFrom.x(), positionTo.x(), weightValue(w, tables[0]));
+                const IKeyframe::SmoothPrecision &y = internal::MotionHelper::lerp(positionFrom.y(), positionTo.y(), weightValue(w, tables[1]));
+                const IKeyframe::SmoothPrecision &z = internal::MotionHelper::lerp(positionFrom.z(), positionTo.z(), weightValue(w, tables[2]));
+                position.setValue(Scalar(x), Scalar(y), Scalar(z));
+                rotation = rotationFrom.slerp(rotationTo, Scalar(weightValue(w, tables[3])));
+            }
+        }
+        else {
+            position = positionFrom;
+            rotation = rotationFrom;
+        }
+    }
+
+    /* per track arrays */
+    Array<IBone *> trackBoneRefs;
+    Array<int> trackSlots;
+    Array<int> trackOffsets;
+    Array<int> trackCounts;
+    Array<int> trackLastIndices;
+    Array<uint8> trackNullFlags;
+    /* per keyframe arrays */
+    Array<IKeyframe::TimeIndex> timeIndices;
+    btAlignedObjectArray<Vector3> translations;
+    btAlignedObjectArray<Quaternion> orientations;
+    Array<const IKeyframe::SmoothPrecision *> tableRefs; /* X, Y, Z and rotation of each keyframe, null means linear */
+    pmx::Model::PoseBuffer *poseBufferRef;
+    int numPoseSlots;
+};
+
 IKeyframe::SmoothPrecision BoneAnimation::weightValue(const BoneKeyframe *keyframe,
                                                       const IKeyframe::SmoothPrecision &w,
                                                       int at)
@@ -98,13 +187,16 @@ void BoneAnimation::lerpVector3(const BoneKeyframe *keyframe,
 BoneAnimation::BoneAnimation(IEncoding *encoding)
     : BaseAnimation(),
       m_encodingRef(encoding),
+      m_compiledContextPtr(0),
       m_modelRef(0),
-      m_enableNullFrame(false)
+      m_enableNullFrame(false),
+      m_enableCompile(false)
 {
 }
 
 BoneAnimation::~BoneAnimation()
 {
+    internal::deleteObject(m_compiledContextPtr);
     m_name2contexts.releaseAll();
     m_modelRef = 0;
 }
@@ -122,7 +214,10 @@ void BoneAnimation::read(const uint8 *data, int size)
 
 void BoneAnimation::seek(const IKeyframe::TimeIndex &timeIndexAt)
 {
-    if (m_modelRef) {
+    if (m_compiledContextPtr) {
+        seekCompiled(timeIndexAt);
+    }
+    else if (m_modelRef) {
         const int ncontexts = m_name2contexts.count();
         for (int i = 0; i < ncontexts; i++) {
             PrivateContext *keyframes = *m_name2contexts.value(i);
@@ -165,6 +260,15 @@ void BoneAnimation::setParentModelRef(IModel *model)
 {
     createPrivateContexts(model);
     m_modelRef = model;
+    compile();
+}
+
+void BoneAnimation::setCompileEnable(bool value)
+{
+    if (m_enableCompile != value) {
+        m_enableCompile = value;
+        compile();
+    }
 }
 
 BoneKeyframe *BoneAnimation::findKeyframeAt(int i) const
@@ -272,6 +376,56 @@ void BoneAnimation::calculateKeyframes(const IKeyframe::TimeIndex &timeIndexAt,
     }
 }
 
+void BoneAnimation::compile()
+{
+    internal::deleteObject(m_compiledContextPtr);
+    if (m_enableCompile && m_modelRef) {
+        CompiledContext *compiled = m_compiledContextPtr = new CompiledContext(m_modelRef);
+        const int ncontexts = m_name2contexts.count();
+        for (int i = 0; i < ncontexts; i++) {
+            const PrivateContext *context = *m_name2contexts.value(i);
+            compiled->appendTrack(context->keyframeRefs, context->bone, context->isNull());
+        }
+    }
+}
+
+void BoneAnimation::seekCompiled(const IKeyframe::TimeIndex &timeIndexAt)
+{
+    CompiledContext *compiled = m_compiledContextPtr;
+    const int ntracks = compiled->trackOffsets.count();
+    if (ntracks > 0) {
+        const IKeyframe::TimeIndex *timeIndices = &compiled->timeIndices[0];
+        const int *slots = &compiled->trackSlots[0], *offsets = &compiled->trackOffsets[0], *counts = &compiled->trackCounts[0];
+        const uint8 *nullFlags = &compiled->trackNullFlags[0];
+        int *lastIndices = &compiled->trackLastIndices[0];
+        pmx::Model::PoseBuffer *poseBuffer = compiled->poseBufferRef;
+        /* slots are reassigned when bones are added or removed, so they are used only while the layout is same */
+        const int nslots = poseBuffer && poseBuffer->localTranslations.size() == compiled->numPoseSlots ? compiled->numPoseSlots : 0;
+        Vector3 position;
+        Quaternion rotation;
+        for (int i = 0; i < ntracks; i++) {
+            if (m_enableNullFrame && nullFlags[i]) {
+                continue;
+            }
+            const int offset = offsets[i], slot = slots[i];
+            int fromIndex, toIndex;
+            internal::MotionHelper::findKeyframeIndices(timeIndexAt, m_currentTimeIndex, lastIndices[i], fromIndex, toIndex, timeIndices + offset, counts[i]);
+            compiled->interpolate(m_currentTimeIndex, offset + fromIndex, offset + toIndex, position, rotation);
+            if (slot >= 0 && slot < nslots) {
+                poseBuffer->localTranslations[slot] = position;
+                poseBuffer->localOrientations[slot] = rotation;
+            }
+            else {
+                IBone *boneRef = compiled->trackBoneRefs[i];
+                boneRef->setLocalTranslation(position);
+                boneRef->setLocalOrientation(rotation);
+            }
+        }
+    }
+    m_previousTimeIndex = m_currentTimeIndex;
+    m_currentTimeIndex = timeIndexAt;
+}
+
 void BoneAnimation::reset()
 {
     BaseAnimation::reset();
@@ -280,6 +434,13 @@ void BoneAnimation::reset()
         PrivateContext *context = *m_name2contexts.value(i);
         context->lastIndex = 0;
     }
+    if (m_compiledContextPtr) {
+        Array<int> &lastIndices = m_compiledContextPtr->trackLastIndices;
+        const int ntracks = lastIndices.count();
+        for (int i = 0; i < ntracks; i++) {
+            lastIndices[i] = 0;
+        }
+    }
 }
 
 } /* namespace vmd */
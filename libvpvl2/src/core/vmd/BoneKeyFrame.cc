@@ -101,7 +101,7 @@ BoneKeyframe::~BoneKeyframe()
     m_enableIK = false;
     internal::deleteObject(m_ptr);
     for (int i = 0; i < kMaxBoneInterpolationType; i++) {
-        internal::deleteObjectArray(m_interpolationTable[i]);
+        internal::InterpolationCurveRegistry::release(m_interpolationTable[i]);
     }
     internal::zerofill(m_linear, sizeof(m_linear));
     internal::zerofill(m_interpolationTable, sizeof(m_interpolationTable));
@@ -214,19 +214,14 @@ void BoneKeyframe::setInterpolationTable(const int8 *table)
     QuadWord v;
     for (int i = 0; i < kMaxBoneInterpolationType; i++) {
         getValueFromTable(table, i, v);
-        internal::deleteObjectArray(m_interpolationTable[i]);
+        internal::InterpolationCurveRegistry::release(m_interpolationTable[i]);
         if (m_linear[i]) {
             m_interpolationTable[i] = 0;
             setInterpolationParameterInternal(static_cast<InterpolationType>(i), v);
             continue;
         }
-        m_interpolationTable[i] = new SmoothPrecision[kTableSize + 1];
-        internal::InterpolationTable::build(v.x() / 127.0f, // x1
-                                            v.z() / 127.0f, // x2
-                                            v.y() / 127.0f, // y1
-                                            v.w() / 127.0f, // y2
-                                            kTableSize,
-                                            m_interpolationTable[i]);
+        /* curve tables are shared with other keyframes through the registry */
+        m_interpolationTable[i] = internal::InterpolationCurveRegistry::findOrCreate(v, kTableSize);
     }
 }
 
@@ -84,6 +84,19 @@ static const char kTransposeSemanticsSuffix[] = "TRANSPOSE";
 static const char kInverseSemanticsSuffix[] = "INVERSE";
 static const char kMultipleTechniquesPrefix[] = "Technique=Technique?";
 static const char kSingleTechniquePrefix[] = "Technique=";
+/* MMDPass values used to dispatch per material techniques, index is used as a part of the technique table key */
+static const char *const kTechniqueTablePasses[] = { "object", "object_ss", "edge", "shadow", "zplot" };
+static const int kMaxTechniqueTablePasses = int(sizeof(kTechniqueTablePasses) / sizeof(kTechniqueTablePasses[0]));
+
+static int findTechniqueTablePassIndex(const char *pass)
+{
+    for (int i = 0; i < kMaxTechniqueTablePasses; i++) {
+        if (std::strcmp(pass, kTechniqueTablePasses[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
 
 }
 
@@ -1408,7 +1421,8 @@ EffectEngine::EffectEngine(Scene *sceneRef, IApplicationContext *applicationCont
       m_rectangleRenderEngine(0),
       m_frameBufferObjectRef(0),
       m_scriptOutput(kColor),
-      m_scriptClass(kObject)
+      m_scriptClass(kObject),
+      m_techniqueTableMaterials(0)
 {
     /* prepare pre/post effect that uses rectangle (quad) rendering */
     m_rectangleRenderEngine = new RectangleRenderEngine(m_applicationContextRef->sharedFunctionResolverInstance());
@@ -1658,6 +1672,7 @@ void EffectEngine::clearEffect()
     m_techniquePasses.clear();
     m_techniques.clear();
     m_techniqueScripts.clear();
+    m_techniqueTable.clear();
     m_frameBufferObjectRef = 0;
     m_effectRef = 0;
 }
@@ -1669,7 +1684,35 @@ IEffect::Technique *EffectEngine::findTechnique(const char *pass,
                                                 bool hasSphereMap,
                                                 bool useToon) const
 {
-    if (m_effectRef->isEnabled()) {
+    const bool enabled = m_effectRef->isEnabled();
+    const int passIndex = findTechniqueTablePassIndex(pass);
+    if (passIndex < 0 || offset < 0) {
+        return findTechniqueUncached(pass, offset, nmaterials, hasTexture, hasSphereMap, useToon, enabled);
+    }
+    /* the result only depends on the arguments and the techniques, so memoizes it to skip testing annotations */
+    if (nmaterials != m_techniqueTableMaterials) {
+        m_techniqueTable.clear();
+        m_techniqueTableMaterials = nmaterials;
+    }
+    const int flags = (hasTexture ? 0x1 : 0) | (hasSphereMap ? 0x2 : 0) | (useToon ? 0x4 : 0) | (enabled ? 0x8 : 0);
+    const int key = ((offset * kMaxTechniqueTablePasses + passIndex) << 4) | flags;
+    if (IEffect::Technique *const *techniqueRef = m_techniqueTable.find(key)) {
+        return *techniqueRef;
+    }
+    IEffect::Technique *technique = findTechniqueUncached(pass, offset, nmaterials, hasTexture, hasSphereMap, useToon, enabled);
+    m_techniqueTable.insert(key, technique);
+    return technique;
+}
+
+IEffect::Technique *EffectEngine::findTechniqueUncached(const char *pass,
+                                                        int offset,
+                                                        int nmaterials,
+                                                        bool hasTexture,
+                                                        bool hasSphereMap,
+                                                        bool useToon,
+                                                        bool enabled) const
+{
+    if (enabled) {
         if (IEffect::Technique *technique = findTechniqueIn(m_techniques, pass, offset, nmaterials, hasTexture, hasSphereMap, useToon)) {
             return technique;
         }
@@ -1781,6 +1824,7 @@ void EffectEngine::setDefaultStandardEffectRef(IEffect *effectRef)
             }
             passes.clear();
         }
+        m_techniqueTable.clear();
         m_defaultStandardEffectRef = effectRef;
     }
 }
@@ -2157,6 +2201,7 @@ void EffectEngine::addTechniquePasses(IEffect::Technique *technique)
     if (parseTechniqueScript(technique, passes)) {
         m_techniquePasses.insert(technique, passes);
         m_techniques.append(technique);
+        m_techniqueTable.clear();
     }
 }
 
@@ -2197,6 +2242,7 @@ void EffectEngine::setStandardsGlobal(const IEffect::Parameter *parameterRef, bo
         const char *value = annotationRef->stringValue();
         const vsize len = std::strlen(value);
         m_techniques.clear();
+        m_techniqueTable.clear();
         if (VPVL2_FX_STREQ_SUFFIX(value, len, kMultipleTechniquesPrefix)) {
             const std::string &s = Util::trimLastSemicolon(VPVL2_FX_GET_SUFFIX(value, kMultipleTechniquesPrefix));
             std::istringstream stream(s);
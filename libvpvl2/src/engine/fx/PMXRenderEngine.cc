@@ -293,6 +293,10 @@ PMXRenderEngine::PMXRenderEngine(IApplicationContext *applicationContextRef,
       m_indexType(kGL_UNSIGNED_INT),
       m_aabbMin(SIMD_INFINITY, SIMD_INFINITY, SIMD_INFINITY),
       m_aabbMax(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY),
+      m_lastDirtyVertexFrom(0),
+      m_lastDirtyVertexTo(0),
+      m_lastUpdateCount(-1),
+      m_updatedGeneration(-1),
       m_cullFaceState(true),
       m_updateEvenBuffer(true)
 {
@@ -367,6 +371,8 @@ bool PMXRenderEngine::upload(void *userData)
         m_bundle->unmap(VertexBundle::kVertexBuffer, address);
     }
     m_bundle->unbind(VertexBundle::kVertexBuffer);
+    /* both dynamic vertex buffers are filled with the bind pose, changes since then are unknown */
+    m_lastUpdateCount = -1;
     m_bundle->create(VertexBundle::kIndexBuffer, kModelIndexBuffer, VertexBundle::kGL_STATIC_DRAW, m_indexBuffer->bytes(), m_indexBuffer->size());
     labelVertexBuffer(kModelIndexBuffer, "ModelIndexBuffer");
     VPVL2_VLOG(2, "Binding indices to the vertex buffer object: ptr=" << m_indexBuffer->bytes() << " size=" << m_indexBuffer->size());
@@ -444,6 +450,8 @@ void PMXRenderEngine::release()
     m_aabbMax.setZero();
     m_defaultEffectRef = 0;
     m_currentEffectEngineRef = 0;
+    m_updatedGeneration = -1;
+    m_lastUpdateCount = -1;
     m_cullFaceState = false;
     popAnnotationGroup(m_applicationContextRef);
 }
@@ -457,6 +465,14 @@ void PMXRenderEngine::update()
     if (!m_modelRef->isVisible()) {
         return;
     }
+    /* skinned vertices are computed once per generation and shared by all passes and offscreen targets */
+    const int generation = m_sceneRef->updateGeneration();
+    if (m_updatedGeneration == generation) {
+        if (m_transformFeedbackProgram) {
+            bindBoneTransformTexture();
+        }
+        return;
+    }
     pushAnnotationGroup(std::string("PMXRenderEngine#update name=").append(internal::cstr(m_modelRef->name(IEncoding::kDefaultLanguage), "")).c_str(), m_applicationContextRef);
     VertexBufferObjectType vbo = m_updateEvenBuffer ? kModelDynamicVertexBufferEven : kModelDynamicVertexBufferOdd;
     annotate("update: model=%s type=%d", m_modelRef->name(IEncoding::kDefaultLanguage)->toByteArray(), vbo);
@@ -486,15 +502,29 @@ void PMXRenderEngine::update()
 #else
             m_transformFeedbackProgram->updateBoneTransformTextureData(m_modelRef);
             m_transformFeedbackProgram->updateBoneTransformTexture();
-            m_currentEffectEngineRef->boneTransformTexture.setTexture(m_transformFeedbackProgram->textureRef());
-            m_currentEffectEngineRef->boneCount.setValue(m_modelRef->count(IModel::kBone));
-            m_currentEffectEngineRef->edgeScaleFactor.setValue(m_modelRef->edgeScaleFactor(m_sceneRef->cameraRef()->position()));
-            m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
-            if (void *address = m_bundle->map(VertexBundle::kVertexBuffer, 0, m_dynamicBuffer->size())) {
-                m_dynamicBuffer->update(address);
-                m_bundle->unmap(VertexBundle::kVertexBuffer, address);
+            bindBoneTransformTexture();
+            /*
+             * the buffer to be written now was last written two updates ago (double buffered),
+             * so uploads union of vertices changed at the previous update and at this update
+             */
+            int from = 0, to = 0;
+            m_dynamicBuffer->getDirtyVertexRange(m_lastUpdateCount, from, to);
+            int start = from, end = to;
+            if (m_lastDirtyVertexFrom < m_lastDirtyVertexTo) {
+                start = from < to ? btMin(from, m_lastDirtyVertexFrom) : m_lastDirtyVertexFrom;
+                end = from < to ? btMax(to, m_lastDirtyVertexTo) : m_lastDirtyVertexTo;
+            }
+            m_lastDirtyVertexFrom = from;
+            m_lastDirtyVertexTo = to;
+            if (start < end) {
+                const vsize strideSize = m_dynamicBuffer->strideSize();
+                m_bundle->bind(VertexBundle::kVertexBuffer, vbo);
+                if (void *address = m_bundle->map(VertexBundle::kVertexBuffer, start * strideSize, (end - start) * strideSize)) {
+                    m_dynamicBuffer->updateRange(address, start, end);
+                    m_bundle->unmap(VertexBundle::kVertexBuffer, address);
+                }
+                m_bundle->unbind(VertexBundle::kVertexBuffer);
             }
-            m_bundle->unbind(VertexBundle::kVertexBuffer);
 #endif
         }
         else {
@@ -512,6 +542,7 @@ void PMXRenderEngine::update()
     }
     m_modelRef->setAabb(m_aabbMin, m_aabbMax);
     m_updateEvenBuffer = m_updateEvenBuffer ? false :true;
+    m_updatedGeneration = generation;
     popAnnotationGroup(m_applicationContextRef);
 }
 
@@ -948,6 +979,13 @@ void PMXRenderEngine::refreshEffect()
     }
 }
 
+void PMXRenderEngine::bindBoneTransformTexture()
+{
+    m_currentEffectEngineRef->boneTransformTexture.setTexture(m_transformFeedbackProgram->textureRef());
+    m_currentEffectEngineRef->boneCount.setValue(m_modelRef->count(IModel::kBone));
+    m_currentEffectEngineRef->edgeScaleFactor.setValue(m_modelRef->edgeScaleFactor(m_sceneRef->cameraRef()->position()));
+}
+
 void PMXRenderEngine::createVertexBundle(VertexBundleLayout *layout, IModel::Buffer::StrideType strideType, GLuint dvbo)
 {
     pushAnnotationGroup("PMXRenderEngine#createVertexBundle", m_applicationContextRef);
@@ -46,16 +46,26 @@
 #include "vpvl2/gl2/PMXRenderEngine.h"
 #include "vpvl2/cl/PMXAccelerator.h"
 
+#include <string.h> /* memcpy */
+#if defined(VPVL2_LINK_INTEL_TBB)
+#include <tbb/tick_count.h>
+#endif
+
 using namespace vpvl2::VPVL2_VERSION_NS;
 using namespace vpvl2::VPVL2_VERSION_NS::gl;
 using namespace vpvl2::VPVL2_VERSION_NS::gl2;
 
 namespace {
 
+/* dynamic vertex buffers are used as ring, CPU writes one while GPU reads others */
+static const int kMaxDynamicVertexBuffers = 3;
+static const GLuint64 kFenceWaitTimeout = 1000000; /* 1ms */
+
 enum VertexBufferObjectType
 {
-    kModelDynamicVertexBufferEven,
-    kModelDynamicVertexBufferOdd,
+    kModelDynamicVertexBuffer0,
+    kModelDynamicVertexBuffer1,
+    kModelDynamicVertexBuffer2,
     kModelStaticVertexBuffer,
     kModelIndexBuffer,
     kMaxVertexBufferObjectType
@@ -63,10 +73,12 @@ enum VertexBufferObjectType
 
 enum VertexArrayObjectType
 {
-    kVertexArrayObjectEven,
-    kVertexArrayObjectOdd,
-    kEdgeVertexArrayObjectEven,
-    kEdgeVertexArrayObjectOdd,
+    kVertexArrayObject0,
+    kVertexArrayObject1,
+    kVertexArrayObject2,
+    kEdgeVertexArrayObject0,
+    kEdgeVertexArrayObject1,
+    kEdgeVertexArrayObject2,
     kMaxVertexArrayObjectType
 };
 
@@ -404,7 +416,8 @@ public:
           aabbMax(-SIMD_INFINITY, -SIMD_INFINITY, -SIMD_INFINITY),
           cullFaceState(true),
           isVertexShaderSkinning(isVertexShaderSkinning),
-          updateEven(true)
+          updateIndex(0),
+          renderIndex(kMaxDynamicVertexBuffers - 1)
     {
         model->getIndexBuffer(indexBuffer);
         model->getStaticVertexBuffer(staticBuffer);
@@ -450,24 +463,52 @@ public:
     }
 
     void getVertexBundleType(VertexArrayObjectType &vao, VertexBufferObjectType &vbo) {
-        if (updateEven) {
-            vao = kVertexArrayObjectOdd;
-            vbo = kModelDynamicVertexBufferOdd;
-        }
-        else {
-            vao = kVertexArrayObjectEven;
-            vbo = kModelDynamicVertexBufferEven;
-        }
+        vao = VertexArrayObjectType(kVertexArrayObject0 + renderIndex);
+        vbo = VertexBufferObjectType(kModelDynamicVertexBuffer0 + renderIndex);
     }
     void getEdgeBundleType(VertexArrayObjectType &vao, VertexBufferObjectType &vbo) {
-        if (updateEven) {
-            vao = kEdgeVertexArrayObjectOdd;
-            vbo = kModelDynamicVertexBufferOdd;
+        vao = VertexArrayObjectType(kEdgeVertexArrayObject0 + renderIndex);
+        vbo = VertexBufferObjectType(kModelDynamicVertexBuffer0 + renderIndex);
+    }
+    void uploadDynamicBuffer(const Vector3 &cameraPosition) {
+        const vsize size = dynamicBuffer->size();
+        const GLuint vbo = kModelDynamicVertexBuffer0 + updateIndex;
+        /* skin into the system memory first not to write uncached driver memory from several threads */
+        stagingBuffer.resize(int(size));
+        uint8 *bytes = &stagingBuffer[0];
+        dynamicBuffer->performTransform(bytes, cameraPosition);
+        if (isVertexShaderSkinning) {
+            matrixBuffer->update(bytes);
+        }
+#if defined(VPVL2_LINK_INTEL_TBB)
+        const tbb::tick_count start = tbb::tick_count::now();
+#endif
+        /* all draw calls reading the previous buffer have been issued at this point */
+        buffer.insertFence(kModelDynamicVertexBuffer0 + renderIndex);
+        buffer.bind(VertexBundle::kVertexBuffer, vbo);
+        uploadStatistics.nwaits = 0;
+        GLenum status = VertexBundle::kGL_WAIT_FAILED;
+        if (buffer.isSyncAvailable()) {
+            status = buffer.waitFence(vbo, kFenceWaitTimeout);
+            if (status == VertexBundle::kGL_CONDITION_SATISFIED) {
+                uploadStatistics.nwaits++;
+            }
+        }
+        if (status == VertexBundle::kGL_ALREADY_SIGNALED || status == VertexBundle::kGL_CONDITION_SATISFIED) {
+            if (void *address = buffer.mapUnsynchronized(VertexBundle::kVertexBuffer, 0, size)) {
+                memcpy(address, bytes, size);
+                buffer.unmap(VertexBundle::kVertexBuffer, address);
+            }
         }
         else {
-            vao = kEdgeVertexArrayObjectEven;
-            vbo = kModelDynamicVertexBufferEven;
+            /* the buffer may still be read by GPU, so let the driver synchronize it */
+            buffer.write(VertexBundle::kVertexBuffer, 0, size, bytes);
         }
+        buffer.unbind(VertexBundle::kVertexBuffer);
+        uploadStatistics.nbytes = size;
+#if defined(VPVL2_LINK_INTEL_TBB)
+        uploadStatistics.elapsed = (tbb::tick_count::now() - start).seconds();
+#endif
     }
 
     const IModel *modelRef;
@@ -481,6 +522,8 @@ public:
     ExtendedZPlotProgram *zplotProgram;
     VertexBundle buffer;
     VertexBundleLayout *bundles[kMaxVertexArrayObjectType];
+    Array<uint8> stagingBuffer;
+    PMXRenderEngine::UploadStatistics uploadStatistics;
     GLenum indexType;
     PointerHash<HashPtr, ITexture> allocatedTextures;
     Array<MaterialTextureRefs> materialTextureRefs;
@@ -491,7 +534,8 @@ public:
 #endif
     bool cullFaceState;
     bool isVertexShaderSkinning;
-    bool updateEven;
+    int updateIndex;
+    int renderIndex;
 };
 
 PMXRenderEngine::PMXRenderEngine(IApplicationContext *applicationContextRef,
@@ -580,8 +624,9 @@ bool PMXRenderEngine::upload(void *userData)
         return false;
     }
     VertexBundle &buffer = m_context->buffer;
-    buffer.create(VertexBundle::kVertexBuffer, kModelDynamicVertexBufferEven, VertexBundle::kGL_DYNAMIC_DRAW, 0, m_context->dynamicBuffer->size());
-    buffer.create(VertexBundle::kVertexBuffer, kModelDynamicVertexBufferOdd, VertexBundle::kGL_DYNAMIC_DRAW, 0, m_context->dynamicBuffer->size());
+    for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+        buffer.create(VertexBundle::kVertexBuffer, kModelDynamicVertexBuffer0 + i, VertexBundle::kGL_STREAM_DRAW, 0, m_context->dynamicBuffer->size());
+    }
     VPVL2_VLOG(2, "Binding model dynamic vertex buffer to the vertex buffer object: size=" << m_context->dynamicBuffer->size());
     const IModel::StaticVertexBuffer *staticBuffer = m_context->staticBuffer;
     buffer.create(VertexBundle::kVertexBuffer, kModelStaticVertexBuffer, VertexBundle::kGL_STATIC_DRAW, 0, staticBuffer->size());
@@ -594,30 +639,20 @@ bool PMXRenderEngine::upload(void *userData)
     const IModel::IndexBuffer *indexBuffer = m_context->indexBuffer;
     buffer.create(VertexBundle::kIndexBuffer, kModelIndexBuffer, VertexBundle::kGL_STATIC_DRAW, indexBuffer->bytes(), indexBuffer->size());
     VPVL2_VLOG(2, "Binding indices to the vertex buffer object: ptr=" << indexBuffer->bytes() << " size=" << indexBuffer->size());
-    VertexBundleLayout *bundleME = m_context->bundles[kVertexArrayObjectEven];
-    if (bundleME->create() && bundleME->bind()) {
-        VPVL2_VLOG(2, "Binding an vertex array object for even frame: " << bundleME->name());
-        createVertexBundle(kModelDynamicVertexBufferEven);
-    }
-    bundleME->unbind();
-    VertexBundleLayout *bundleMO = m_context->bundles[kVertexArrayObjectOdd];
-    if (bundleMO->create() && bundleMO->bind()) {
-        VPVL2_VLOG(2, "Binding an vertex array object for odd frame: " << bundleMO->name());
-        createVertexBundle(kModelDynamicVertexBufferOdd);
-    }
-    bundleMO->unbind();
-    VertexBundleLayout *bundleEE = m_context->bundles[kEdgeVertexArrayObjectEven];
-    if (bundleEE->create() && bundleEE->bind()) {
-        VPVL2_VLOG(2, "Binding an edge vertex array object for even frame: " << bundleEE->name());
-        createEdgeBundle(kModelDynamicVertexBufferEven);
-    }
-    bundleEE->unbind();
-    VertexBundleLayout *bundleEO = m_context->bundles[kEdgeVertexArrayObjectOdd];
-    if (bundleEO->create() && bundleEO->bind()) {
-        VPVL2_VLOG(2, "Binding an edge vertex array object for odd frame: " << bundleEO->name());
-        createEdgeBundle(kModelDynamicVertexBufferOdd);
-    }
-    bundleEO->unbind();
+    for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+        VertexBundleLayout *bundleM = m_context->bundles[kVertexArrayObject0 + i];
+        if (bundleM->create() && bundleM->bind()) {
+            VPVL2_VLOG(2, "Binding an vertex array object for frame " << i << ": " << bundleM->name());
+            createVertexBundle(kModelDynamicVertexBuffer0 + i);
+        }
+        bundleM->unbind();
+        VertexBundleLayout *bundleE = m_context->bundles[kEdgeVertexArrayObject0 + i];
+        if (bundleE->create() && bundleE->bind()) {
+            VPVL2_VLOG(2, "Binding an edge vertex array object for frame " << i << ": " << bundleE->name());
+            createEdgeBundle(kModelDynamicVertexBuffer0 + i);
+        }
+        bundleE->unbind();
+    }
     buffer.unbind(VertexBundle::kVertexBuffer);
     buffer.unbind(VertexBundle::kIndexBuffer);
 #ifdef VPVL2_ENABLE_OPENCL
@@ -625,14 +660,16 @@ bool PMXRenderEngine::upload(void *userData)
         const VertexBundle &buffer = m_context->buffer;
         cl::PMXAccelerator::VertexBufferBridgeArray &buffers = m_context->buffers;
         m_accelerator->release(buffers);
-        buffers.append(cl::PMXAccelerator::VertexBufferBridge(buffer.findName(kModelDynamicVertexBufferEven)));
-        buffers.append(cl::PMXAccelerator::VertexBufferBridge(buffer.findName(kModelDynamicVertexBufferOdd)));
+        for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+            buffers.append(cl::PMXAccelerator::VertexBufferBridge(buffer.findName(kModelDynamicVertexBuffer0 + i)));
+        }
         m_accelerator->upload(buffers, m_context->indexBuffer);
     }
 #endif
     m_modelRef->setVisible(true);
-    update(); // for updating even frame
-    update(); // for updating odd frame
+    for (int i = 0; i < kMaxDynamicVertexBuffers; i++) {
+        update(); // for filling all of the dynamic vertex buffers
+    }
     VPVL2_VLOG(2, "Created the model: jp=" << internal::cstr(m_modelRef->name(IEncoding::kJapanese), "(null)") << " en=" << internal::cstr(m_modelRef->name(IEncoding::kEnglish), "(null)"));
     return ret;
 }
@@ -654,27 +691,27 @@ void PMXRenderEngine::update()
 {
     if (!m_modelRef || !m_modelRef->isVisible() || !m_context)
         return;
-    VertexBufferObjectType vbo = m_context->updateEven
-            ? kModelDynamicVertexBufferEven : kModelDynamicVertexBufferOdd;
-    IModel::DynamicVertexBuffer *dynamicBuffer = m_context->dynamicBuffer;
-    m_context->buffer.bind(VertexBundle::kVertexBuffer, vbo);
-    if (void *address = m_context->buffer.map(VertexBundle::kVertexBuffer, 0, dynamicBuffer->size())) {
-        const ICamera *camera = m_sceneRef->cameraRef();
-        dynamicBuffer->performTransform(address, camera->position());
-        if (m_context->isVertexShaderSkinning) {
-            m_context->matrixBuffer->update(address);
-        }
-        m_context->buffer.unmap(VertexBundle::kVertexBuffer, address);
-    }
-    m_context->buffer.unbind(VertexBundle::kVertexBuffer);
+    const int index = m_context->updateIndex;
+    m_context->uploadDynamicBuffer(m_sceneRef->cameraRef()->position());
 #ifdef VPVL2_ENABLE_OPENCL
     if (m_accelerator && m_accelerator->isAvailable()) {
-        const cl::PMXAccelerator::VertexBufferBridge &buffer = m_context->buffers[m_context->updateEven ? 0 : 1];
-        m_accelerator->update(dynamicBuffer, buffer, m_context->aabbMin, m_context->aabbMax);
+        const cl::PMXAccelerator::VertexBufferBridge &buffer = m_context->buffers[index];
+        m_accelerator->update(m_context->dynamicBuffer, buffer, m_context->aabbMin, m_context->aabbMax);
     }
 #endif
     m_modelRef->setAabb(m_context->aabbMin, m_context->aabbMax);
-    m_context->updateEven = m_context->updateEven ? false :true;
+    m_context->renderIndex = index;
+    m_context->updateIndex = (index + 1) % kMaxDynamicVertexBuffers;
+}
+
+void PMXRenderEngine::getUploadStatistics(UploadStatistics &value) const
+{
+    if (m_context) {
+        value = m_context->uploadStatistics;
+    }
+    else {
+        value = UploadStatistics();
+    }
 }
 
 void PMXRenderEngine::setUpdateOptions(int options)
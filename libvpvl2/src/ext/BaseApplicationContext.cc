@@ -81,9 +81,11 @@ typedef unsigned int ETwMouseAction;
 #endif
 
 /* STL */
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <queue>
 #include <set>
 
 #ifdef VPVL2_LINK_ASSIMP3
@@ -115,6 +117,12 @@ struct DefaultLogger {
 /* Simple OpenGL Image Library */
 #include "stb_image_aug.h"
 
+/* Intel Threading Building Blocks */
+#ifdef VPVL2_LINK_INTEL_TBB
+#include <tbb/concurrent_queue.h>
+#include <tbb/task_group.h>
+#endif
+
 /* FreeImage */
 #ifdef VPVL2_LINK_FREEIMAGE
 #include <FreeImage.h>
@@ -358,6 +366,330 @@ namespace extensions
 {
 using namespace gl;
 
+struct BaseApplicationContext::SharedTexture {
+    SharedTexture(BaseApplicationContext *parentRef, const SharedTextureKey &key, const uint8 *data, ITexture *texturePtr)
+        : parentRef(parentRef),
+          texturePtr(texturePtr),
+          key(key),
+          content(reinterpret_cast<const char *>(data), key.size),
+          bytes(0),
+          nrefs(0)
+    {
+        const Vector3 &size = texturePtr->size();
+        bytes = vsize(size.x() * size.y() * size.z()) * 4;
+    }
+    ~SharedTexture() {
+        internal::deleteObject(texturePtr);
+        parentRef = 0;
+    }
+    void retain() {
+        nrefs++;
+    }
+    void replaceTexture(ITexture *value) {
+        const Vector3 &size = value->size();
+        const vsize newBytes = vsize(size.x() * size.y() * size.z()) * 4;
+        /* sampler parameters were applied to the placeholder texture */
+        value->bind();
+        for (std::map<unsigned int, int>::const_iterator it = intParameters.begin(); it != intParameters.end(); it++) {
+            value->setParameter(it->first, it->second);
+        }
+        for (std::map<unsigned int, float>::const_iterator it = floatParameters.begin(); it != floatParameters.end(); it++) {
+            value->setParameter(it->first, it->second);
+        }
+        value->unbind();
+        internal::deleteObject(texturePtr);
+        texturePtr = value;
+        if (parentRef) {
+            parentRef->m_textureCacheStatistics.residentBytes += newBytes - bytes;
+        }
+        bytes = newBytes;
+    }
+    void release() {
+        if (--nrefs == 0) {
+            if (parentRef) {
+                TextureCacheStatistics &statistics = parentRef->m_textureCacheStatistics;
+                statistics.ntextures--;
+                statistics.residentBytes -= bytes;
+                SharedTextureMap &textures = parentRef->m_sharedTextures;
+                std::pair<SharedTextureMap::iterator, SharedTextureMap::iterator> range = textures.equal_range(key);
+                for (SharedTextureMap::iterator it = range.first; it != range.second; it++) {
+                    if (it->second == this) {
+                        textures.erase(it);
+                        break;
+                    }
+                }
+            }
+            delete this;
+        }
+    }
+    BaseApplicationContext *parentRef;
+    ITexture *texturePtr;
+    SharedTextureKey key;
+    std::string content;
+    std::map<unsigned int, int> intParameters;
+    std::map<unsigned int, float> floatParameters;
+    vsize bytes;
+    int nrefs;
+};
+
+/* a reference of the texture shared by content, owned by each render engine */
+class BaseApplicationContext::SharedTextureRef VPVL2_DECL_FINAL : public ITexture {
+public:
+    SharedTextureRef(SharedTexture *sharedTextureRef)
+        : m_sharedTextureRef(sharedTextureRef)
+    {
+        m_sharedTextureRef->retain();
+    }
+    ~SharedTextureRef() {
+        m_sharedTextureRef->release();
+        m_sharedTextureRef = 0;
+    }
+
+    void create() { texture()->create(); }
+    void bind() { texture()->bind(); }
+    void fillPixels(const void *pixels) { texture()->fillPixels(pixels); }
+    void allocate(const void *pixels) { texture()->allocate(pixels); }
+    void write(const void *pixels) { texture()->write(pixels); }
+    void getParameters(unsigned int key, int *values) const { texture()->getParameters(key, values); }
+    void getParameters(unsigned int key, float *values) const { texture()->getParameters(key, values); }
+    void setParameter(unsigned int key, int value) {
+        m_sharedTextureRef->intParameters[key] = value;
+        texture()->setParameter(key, value);
+    }
+    void setParameter(unsigned int key, float value) {
+        m_sharedTextureRef->floatParameters[key] = value;
+        texture()->setParameter(key, value);
+    }
+    void generateMipmaps() { texture()->generateMipmaps(); }
+    void resize(const Vector3 &size) { texture()->resize(size); }
+    void unbind() { texture()->unbind(); }
+    /* the shared texture is released when the last reference is deleted */
+    void release() {}
+    Vector3 size() const { return texture()->size(); }
+    intptr_t data() const { return texture()->data(); }
+    intptr_t sampler() const { return texture()->sampler(); }
+    intptr_t format() const { return texture()->format(); }
+
+private:
+    ITexture *texture() const { return m_sharedTextureRef->texturePtr; }
+
+    SharedTexture *m_sharedTextureRef;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(SharedTextureRef)
+};
+
+static stbi_uc *DecodeImage(const uint8 *data, vsize size, bool flipVertically, int &x, int &y)
+{
+    /* Loading major image format (BMP/JPG/PNG/TGA/DDS) texture with stb_image.c */
+    static const int rc = 4;
+    int ncomponents = 0;
+    stbi_uc *ptr = stbi_load_from_memory(data, int(size), &x, &y, &ncomponents, rc);
+    if (ptr && flipVertically) {
+        for (int j = 0, height = y >> 1; j < height; ++j) {
+            stbi_uc *p1 = ptr + j * x * rc;
+            stbi_uc *p2 = ptr + (y - 1 - j) * x * rc;
+            for (int i = 0, width = x * rc; i < width; ++i) {
+                stbi_uc t = p1[i];
+                p1[i] = p2[i];
+                p2[i] = t;
+            }
+        }
+    }
+    return ptr;
+}
+
+/* decodes images on worker threads and hands decoded pixels back to the thread of OpenGL context */
+class BaseApplicationContext::TextureDecoder {
+public:
+    struct Task {
+        Task(SharedTexture *sharedTextureRef, const uint8 *data, vsize size, bool flipVertically)
+            : sharedTextureRef(sharedTextureRef),
+              bytes(reinterpret_cast<const char *>(data), size),
+              pixels(0),
+              width(0),
+              height(0),
+              flipVertically(flipVertically),
+              prefetched(!sharedTextureRef),
+              completed(false),
+              discarded(false)
+        {
+        }
+        ~Task() {
+            stbi_image_free(pixels);
+            pixels = 0;
+            sharedTextureRef = 0;
+        }
+        void decode() {
+            pixels = DecodeImage(reinterpret_cast<const uint8 *>(bytes.data()), bytes.size(), flipVertically, width, height);
+            /* encoded bytes are no longer needed unless compared to claim the prefetched task */
+            if (!prefetched) {
+                std::string().swap(bytes);
+            }
+        }
+        /* fields below are accessed only from the thread of OpenGL context except pixels, width and height */
+        SharedTexture *sharedTextureRef;
+        std::string bytes;
+        stbi_uc *pixels;
+        int width;
+        int height;
+        const bool flipVertically;
+        const bool prefetched;
+        bool completed;
+        bool discarded;
+    };
+
+    TextureDecoder()
+        : m_nscheduled(0),
+          m_nuploaded(0)
+    {
+    }
+    ~TextureDecoder() {
+        discardAll();
+    }
+
+    void schedule(Task *task) {
+        m_nscheduled++;
+#ifdef VPVL2_LINK_INTEL_TBB
+        m_group.run(Runner(task, &m_completedTasks));
+#else
+        task->decode();
+        m_completedTasks.push(task);
+#endif
+    }
+    void prefetch(const SharedTextureKey &key, Task *task) {
+        m_prefetchedTasks.insert(std::make_pair(key, task));
+        schedule(task);
+    }
+    Task *findPrefetched(const SharedTextureKey &key, const uint8 *data) {
+        PrefetchedTaskMap::iterator it = findPrefetchedEntry(key, data);
+        return it != m_prefetchedTasks.end() ? it->second : 0;
+    }
+    Task *claim(const SharedTextureKey &key, const uint8 *data) {
+        PrefetchedTaskMap::iterator it = findPrefetchedEntry(key, data);
+        if (it != m_prefetchedTasks.end()) {
+            Task *task = it->second;
+            m_prefetchedTasks.erase(it);
+            return task;
+        }
+        return 0;
+    }
+    bool tryPop(Task *&task) {
+#ifdef VPVL2_LINK_INTEL_TBB
+        return m_completedTasks.try_pop(task);
+#else
+        if (!m_completedTasks.empty()) {
+            task = m_completedTasks.front();
+            m_completedTasks.pop();
+            return true;
+        }
+        return false;
+#endif
+    }
+    void wait() {
+#ifdef VPVL2_LINK_INTEL_TBB
+        m_group.wait();
+#endif
+    }
+    void discardPrefetchedTasks() {
+        /* tasks still running are deleted when they are popped */
+        for (PrefetchedTaskMap::const_iterator it = m_prefetchedTasks.begin(); it != m_prefetchedTasks.end(); it++) {
+            Task *task = it->second;
+            if (task->completed) {
+                delete task;
+                markUploaded();
+            }
+            else {
+                task->discarded = true;
+            }
+        }
+        m_prefetchedTasks.clear();
+    }
+    void discardAll() {
+        /* pending tasks are completed first then references of the shared textures are released */
+        Task *task = 0;
+        wait();
+        discardPrefetchedTasks();
+        while (tryPop(task)) {
+            if (SharedTexture *sharedTextureRef = task->sharedTextureRef) {
+                sharedTextureRef->release();
+            }
+            delete task;
+        }
+        m_nscheduled = m_nuploaded = 0;
+    }
+    void markUploaded() {
+        if (++m_nuploaded == m_nscheduled) {
+            m_nscheduled = m_nuploaded = 0;
+        }
+    }
+    int countPendingTasks() const {
+        return m_nscheduled - m_nuploaded;
+    }
+    float progress() const {
+        return m_nscheduled > 0 ? m_nuploaded / float(m_nscheduled) : 1.0f;
+    }
+
+private:
+    /* prefetched pixels are shared by contents and flipping regardless of the texture flags */
+    typedef std::multimap<SharedTextureKey, Task *> PrefetchedTaskMap;
+    PrefetchedTaskMap::iterator findPrefetchedEntry(const SharedTextureKey &key, const uint8 *data) {
+        std::pair<PrefetchedTaskMap::iterator, PrefetchedTaskMap::iterator> range = m_prefetchedTasks.equal_range(key);
+        for (PrefetchedTaskMap::iterator it = range.first; it != range.second; it++) {
+            if (std::memcmp(it->second->bytes.data(), data, key.size) == 0) {
+                return it;
+            }
+        }
+        return m_prefetchedTasks.end();
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    typedef tbb::concurrent_queue<Task *> TaskQueue;
+    struct Runner {
+        Runner(Task *task, TaskQueue *queue)
+            : m_task(task),
+              m_queue(queue)
+        {
+        }
+        void operator()() const {
+            m_task->decode();
+            m_queue->push(m_task);
+        }
+        Task *m_task;
+        TaskQueue *m_queue;
+    };
+    tbb::task_group m_group;
+#else
+    typedef std::queue<Task *> TaskQueue;
+#endif
+    TaskQueue m_completedTasks;
+    PrefetchedTaskMap m_prefetchedTasks;
+    int m_nscheduled;
+    int m_nuploaded;
+
+    VPVL2_DISABLE_COPY_AND_ASSIGN(TextureDecoder)
+};
+
+static uint64 HashTextureContent(const uint8 *data, vsize size)
+{
+    /* FNV-1a */
+    uint64 hash = 0xcbf29ce484222325ull;
+    for (vsize i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/* flags deciding pixels and sampler parameters of the texture (flipping, mipmaps and wrapping of toon texture) */
+static const int kSharedTextureFlagsMask = ~IApplicationContext::kAsyncLoadingTexture & (IApplicationContext::kMaxTextureTypeFlags - 1);
+static const int kSharedTextureFlipVertically = IApplicationContext::kMaxTextureTypeFlags;
+
+BaseApplicationContext::SharedTextureKey::SharedTextureKey(const uint8 *data, vsize size, bool flipVertically, int flags)
+    : hash(HashTextureContent(data, size)),
+      size(size),
+      flags((flags & kSharedTextureFlagsMask) | (flipVertically ? kSharedTextureFlipVertically : 0))
+{
+}
+
 BaseApplicationContext::ModelContext::ModelContext(BaseApplicationContext *applicationContextRef, extensions::Archive *archiveRef, const IString *directory, bool flipVertically)
     : m_directoryRef(directory),
       m_archiveRef(archiveRef),
@@ -374,6 +706,8 @@ BaseApplicationContext::ModelContext::ModelContext(BaseApplicationContext *appli
 
 BaseApplicationContext::ModelContext::~ModelContext()
 {
+    /* prefetched textures not requested by the render engine are no longer needed */
+    m_applicationContextRef->m_textureDecoderPtr->discardPrefetchedTasks();
     m_archiveRef = 0;
     m_applicationContextRef = 0;
     m_directoryRef = 0;
@@ -455,7 +789,7 @@ ITexture *BaseApplicationContext::ModelContext::createTextureFromFile(const std:
     }
     else {
         IStringSmartPtr pathPtr(String::create(path));
-        textureRef = m_applicationContextRef->uploadTextureFromFile(pathPtr.get(), m_flipVertically);
+        textureRef = m_applicationContextRef->uploadTextureFromFile(pathPtr.get(), m_flipVertically, flags);
         storeTexture(path, flags, textureRef);
     }
     return textureRef;
@@ -469,7 +803,7 @@ ITexture *BaseApplicationContext::ModelContext::createTextureFromMemory(const ui
         VPVL2_VLOG(2, key << " is already cached, skipped.");
         return textureRef;
     }
-    textureRef = m_applicationContextRef->uploadTextureFromMemory(data, size, m_flipVertically);
+    textureRef = m_applicationContextRef->uploadTextureFromMemory(data, size, m_flipVertically, flags);
     if (!textureRef) {
         VPVL2_LOG(WARNING, "Cannot load texture with key " << key << ": " << stbi_failure_reason());
         return 0;
@@ -515,6 +849,10 @@ BaseApplicationContext::BaseApplicationContext(Scene *sceneRef, IEncoding *encod
       m_cameraViewMatrix(1),
       m_cameraProjectionMatrix(1),
       m_aspectRatio(1),
+      m_matrixCacheSceneGeneration(-1),
+      m_matrixCacheGeneration(1),
+      m_textureDecoderPtr(new TextureDecoder()),
+      m_textureProgressReporterRef(0),
       m_samplesMSAA(0),
       m_viewportRegionInvalidated(false),
       m_hasDepthClamp(false)
@@ -558,6 +896,9 @@ void BaseApplicationContext::initializeOpenGLContext(bool enableDebug)
 
 BaseApplicationContext::~BaseApplicationContext()
 {
+    detachSharedTextures();
+    internal::deleteObject(m_textureDecoderPtr);
+    m_textureProgressReporterRef = 0;
     m_configRef = 0;
     m_sceneRef = 0;
     m_encodingRef = 0;
@@ -582,10 +923,11 @@ void BaseApplicationContext::release()
     m_effectRef2Paths.clear();
     m_effectRef2ParameterUIs.clear();
     m_effectCaches.releaseAll();
+    detachSharedTextures();
     popAnnotationGroup(this);
 }
 
-ITexture *BaseApplicationContext::uploadTextureFromFile(const IString *path, bool flipVertically)
+ITexture *BaseApplicationContext::uploadTextureFromFile(const IString *path, bool flipVertically, int flags)
 {
     ITexture *texturePtr = 0;
     if (const String *s = static_cast<const String *>(path)) {
@@ -593,7 +935,7 @@ ITexture *BaseApplicationContext::uploadTextureFromFile(const IString *path, boo
         /* Loading major image format (BMP/JPG/PNG/TGA/DDS) texture with stb_image.c */
         MapBuffer buffer(this);
         if (mapFile(pathString, &buffer)) {
-            texturePtr = uploadTextureFromMemory(buffer.address, buffer.size, flipVertically);
+            texturePtr = uploadTextureFromMemory(buffer.address, buffer.size, flipVertically, flags);
             if (!texturePtr) {
                 VPVL2_LOG(WARNING, "Cannot load texture from " << pathString << ": " << stbi_failure_reason());
                 return 0;
@@ -610,7 +952,7 @@ ITexture *BaseApplicationContext::uploadEffectTexture(const IString *name, const
         if (extractFilePath(pathRef->toStdString(), dir, filename, baseName)) {
             const std::string &newName = static_cast<const String *>(name)->toStdString();
             IStringSmartPtr pathPtr(String::create(dir + "/" + newName));
-            return uploadTextureFromFile(pathPtr.get(), true);
+            return uploadTextureFromFile(pathPtr.get(), true, 0);
         }
     }
     return 0;
@@ -741,7 +1083,43 @@ BaseSurface::Format BaseApplicationContext::defaultTextureFormat() const
 
 void BaseApplicationContext::getMatrix(float32 value[], const IModel *model, int flags) const
 {
-    glm::mat4 m(1);
+    /* all cached matrices are dropped when the scene is updated (once per frame in usual) */
+    const int generation = m_sceneRef->updateGeneration();
+    if (m_matrixCacheSceneGeneration != generation) {
+        invalidateMatrixCache();
+        m_matrixCacheSceneGeneration = generation;
+    }
+    const bool dependsOnModel = model && internal::hasFlagBits(flags, IApplicationContext::kWorldMatrix);
+    const IModel *modelRef = dependsOnModel ? model : 0;
+    Transform worldTransform(Transform::getIdentity());
+    Vector3 lightDirection(kZeroV3);
+    Scalar scaleFactor(1);
+    if (dependsOnModel) {
+        /* the model may be moved without updating the scene (e.g. dragging by the handle) */
+        getModelWorldTransform(model, worldTransform);
+        lightDirection = m_sceneRef->lightRef()->direction();
+        scaleFactor = model->scaleFactor();
+    }
+    MatrixCacheValue &v = m_matrixCache[flags & (IApplicationContext::kMaxMatrixTypeFlags - 1)];
+    if (v.generation == m_matrixCacheGeneration && v.modelRef == modelRef && v.worldTransform == worldTransform
+            && v.lightDirection == lightDirection && v.scaleFactor == scaleFactor) {
+        m_matrixCacheStatistics.nhits++;
+    }
+    else {
+        m_matrixCacheStatistics.nmisses++;
+        computeMatrix(model, flags, v.value);
+        v.modelRef = modelRef;
+        v.worldTransform = worldTransform;
+        v.lightDirection = lightDirection;
+        v.scaleFactor = scaleFactor;
+        v.generation = m_matrixCacheGeneration;
+    }
+    std::memcpy(value, glm::value_ptr(v.value), sizeof(float) * 16);
+}
+
+void BaseApplicationContext::computeMatrix(const IModel *model, int flags, glm::mat4 &m) const
+{
+    m = glm::mat4(1);
     if (internal::hasFlagBits(flags, IApplicationContext::kShadowMatrix)) {
         if (internal::hasFlagBits(flags, IApplicationContext::kProjectionMatrix)) {
             m *= m_cameraProjectionMatrix;
@@ -809,7 +1187,22 @@ void BaseApplicationContext::getMatrix(float32 value[], const IModel *model, int
     if (internal::hasFlagBits(flags, IApplicationContext::kTransposeMatrix)) {
         m = glm::transpose(m);
     }
-    std::memcpy(value, glm::value_ptr(m), sizeof(float) * 16);
+}
+
+void BaseApplicationContext::getModelWorldTransform(const IModel *model, Transform &value)
+{
+    value.setRotation(model->worldOrientation());
+    value.setOrigin(model->worldTranslation());
+    if (const IBone *bone = model->parentBoneRef()) {
+        value = value * bone->worldTransform();
+    }
+}
+
+void BaseApplicationContext::invalidateMatrixCache() const
+{
+    /* entries stored with the older generation are treated as empty */
+    m_matrixCacheGeneration++;
+    m_matrixCacheStatistics.ninvalidations++;
 }
 
 IString *BaseApplicationContext::loadShaderSource(ShaderType type, const IModel *model, void *userData)
@@ -1030,6 +1423,10 @@ void BaseApplicationContext::addModelFilePath(IModel *model, const std::string &
             }
             m_basename2ModelRefs.insert(baseName.c_str(), model);
             m_modelRef2Basenames.insert(model, baseName);
+#if defined(VPVL2_ENABLE_NVIDIA_CG)
+            /* basename of the model is changed and it may match other rules */
+            invalidateAttachmentRules();
+#endif
         }
         else {
             if (!model->name(IEncoding::kDefaultLanguage)) {
@@ -1042,6 +1439,30 @@ void BaseApplicationContext::addModelFilePath(IModel *model, const std::string &
     }
 }
 
+void BaseApplicationContext::removeModelFilePath(const IModel *model)
+{
+    if (model) {
+        const std::string *basenameRef = m_modelRef2Basenames.find(model), *pathRef = m_modelRef2Paths.find(model);
+        const std::string &key = basenameRef ? *basenameRef : (pathRef ? *pathRef : std::string());
+        const HashString hashKey(key.c_str());
+        if (IModel *const *value = m_basename2ModelRefs.find(hashKey)) {
+            if (*value == model) {
+                m_basename2ModelRefs.remove(hashKey);
+            }
+        }
+        m_modelRef2Basenames.remove(model);
+        m_modelRef2Paths.remove(model);
+#if defined(VPVL2_ENABLE_NVIDIA_CG)
+        /* the address of the removed model may be reused by the model added later */
+        const int ntextures = m_offscreenTextures.count();
+        for (int i = 0; i < ntextures; i++) {
+            OffscreenTexture *textureRef = m_offscreenTextures[i];
+            textureRef->resolvedRuleRefs.remove(model);
+        }
+#endif
+    }
+}
+
 std::string BaseApplicationContext::findEffectOwnerName(const IEffect *effect) const
 {
     if (const std::string *value = m_effectRef2Owners.find(effect)) {
@@ -1211,7 +1632,7 @@ void BaseApplicationContext::parseOffscreenSemantic(IEffect *effectRef, const IS
                     /* self が指定されている場合は自身のエフェクトのファイル名を設定する */
                     if (key == "self") {
                         const IModel *model = effectOwner(effectRef);
-                        const UnicodeString &name = findModelBasename(model);
+                        const UnicodeString &name = UnicodeString::fromUTF8(findModelFileBasename(model));
                         regexp.reset(new RegexMatcher("\\A\\Q" + name + "\\E\\z", 0, status));
                     }
                     else {
@@ -1297,23 +1718,9 @@ void BaseApplicationContext::renderOffscreen()
     Array<IRenderEngine *> engines;
     m_sceneRef->getRenderEngineRefs(engines);
     const int nengines = engines.count();
-    /* オフスクリーンレンダリングを行う前に元のエフェクトを保存する */
-    Hash<HashPtr, IEffect *> effects;
-    for (int i = 0; i < nengines; i++) {
-        IRenderEngine *engine = engines[i];
-        if (IEffect *starndardEffect = engine->effectRef(IEffect::kStandard)) {
-            effects.insert(engine, starndardEffect);
-        }
-        else if (IEffect *postEffect = engine->effectRef(IEffect::kPostProcess)) {
-            effects.insert(engine, postEffect);
-        }
-        else if (IEffect *preEffect = engine->effectRef(IEffect::kPreProcess)) {
-            effects.insert(engine, preEffect);
-        }
-        else {
-            effects.insert(engine, 0);
-        }
-    }
+    /* オフスクリーン用のエフェクトに差し替えたレンダリングエンジンのみ元のエフェクトを保存して後で戻す */
+    Hash<HashPtr, IEffect *> effects, boundEffects;
+    Array<IRenderEngine *> overriddenEngines;
     /* オフスクリーンレンダーターゲット毎にエフェクトを実行する */
     const int ntextures = m_offscreenTextures.count();
     for (int i = 0; i < ntextures; i++) {
@@ -1346,34 +1753,49 @@ void BaseApplicationContext::renderOffscreen()
         clear(kGL_COLOR_BUFFER_BIT | kGL_DEPTH_BUFFER_BIT | kGL_STENCIL_BUFFER_BIT);
         for (int j = 0; j < nengines; j++) {
             IRenderEngine *engine = engines[j];
-            const IModel *model = engine->parentModelRef();
-            const UnicodeString &basename = findModelBasename(model);
-            EffectAttachmentRuleList::const_iterator it2 = rules.begin();
             bool hidden = false;
-            while (it2 != rules.end()) {
-                const EffectAttachmentRule &rule = *it2;
-                RegexMatcher *matcherRef = rule.first;
-                matcherRef->reset(basename);
-                if (matcherRef->find()) {
-                    const EffectAttachmentValue &v = rule.second;
-                    IEffect *effectRef = v.first;
-                    engine->setEffect(effectRef, IEffect::kStandardOffscreen, 0);
-                    hidden = v.second;
-                    break;
+            /* モデルに適用するルールは解決済みのものを引くだけで正規表現の評価は行わない */
+            if (const EffectAttachmentRule *ruleRef = resolveAttachmentRuleRef(offscreenTexture, engine->parentModelRef())) {
+                if (!effects.find(engine)) {
+                    if (IEffect *starndardEffect = engine->effectRef(IEffect::kStandard)) {
+                        effects.insert(engine, starndardEffect);
+                    }
+                    else if (IEffect *postEffect = engine->effectRef(IEffect::kPostProcess)) {
+                        effects.insert(engine, postEffect);
+                    }
+                    else if (IEffect *preEffect = engine->effectRef(IEffect::kPreProcess)) {
+                        effects.insert(engine, preEffect);
+                    }
+                    else {
+                        effects.insert(engine, 0);
+                    }
+                    overriddenEngines.append(engine);
+                }
+                const EffectAttachmentValue &v = ruleRef->second;
+                /*
+                 * 解決済みのエフェクトが既にエンジンに割り当てられている場合は切り替えを行わない。
+                 * オフスクリーン用のエフェクトエンジンは初回のみ生成され、以降は生成済みのものを選択するだけとなる
+                 */
+                IEffect *const *boundEffectRef = boundEffects.find(engine);
+                if (!boundEffectRef || *boundEffectRef != v.first) {
+                    engine->setEffect(v.first, IEffect::kStandardOffscreen, 0);
+                    boundEffects.insert(engine, v.first);
                 }
-                ++it2;
+                hidden = v.second;
             }
             if (!hidden) {
+                /* スキニング済みの頂点は Scene#update で計算済みのため、ここではエフェクトのパラメータのみ更新される */
                 engine->update();
-                engine->renderModel();
-                engine->renderEdge();
+                engine->renderModel(0);
+                engine->renderEdge(0);
             }
         }
         /* オフスクリーンレンダリングターゲットの割り当てを解除 */
         releaseOffscreenRenderTarget(offscreenTexture, enableAA);
     }
-    for (int i = 0; i < nengines; i++) {
-        IRenderEngine *engine = engines[i];
+    const int nOverriddenEngines = overriddenEngines.count();
+    for (int i = 0; i < nOverriddenEngines; i++) {
+        IRenderEngine *engine = overriddenEngines[i];
         IEffect *const *effect = effects.find(engine);
         engine->setEffect(*effect, IEffect::kAutoDetection, 0);
     }
@@ -1574,6 +1996,7 @@ void BaseApplicationContext::setCameraMatrices(const glm::mat4 &world, const glm
     m_cameraWorldMatrix = world;
     m_cameraViewMatrix = view;
     m_cameraProjectionMatrix = projection;
+    invalidateMatrixCache();
 }
 
 void BaseApplicationContext::getLightMatrices(glm::mat4 &world, glm::mat4 &view, glm::mat4 &projection) const
@@ -1588,6 +2011,7 @@ void BaseApplicationContext::setLightMatrices(const glm::mat4 &world, const glm:
     m_lightWorldMatrix = world;
     m_lightViewMatrix = view;
     m_lightProjectionMatrix = projection;
+    invalidateMatrixCache();
 }
 
 void BaseApplicationContext::updateCameraMatrices()
@@ -1619,6 +2043,8 @@ void BaseApplicationContext::setViewportRegion(const glm::ivec4 &viewport)
         m_viewportRegionInvalidated = true;
         m_viewportFBO->resize(Vector3(width, height, 1), 0);
         TwWindowSize(viewport.z, viewport.w);
+        /* projection matrices depend on the aspect ratio even if the scene is not updated */
+        invalidateMatrixCache();
         updateCameraMatrices();
     }
 }
@@ -1696,12 +2122,18 @@ ITexture *BaseApplicationContext::uploadTexture(const void *ptr, const BaseSurfa
     return texture;
 }
 
-ITexture *BaseApplicationContext::uploadTextureFromMemory(const uint8 *data, vsize size, bool flipVertically)
+ITexture *BaseApplicationContext::uploadTextureFromMemory(const uint8 *data, vsize size, bool flipVertically, int flags)
 {
     VPVL2_DCHECK(data && size > 0);
+    if (ITexture *textureRef = findSharedTexture(data, size, flipVertically, flags)) {
+        return textureRef;
+    }
+    else if (m_configRef && m_configRef->value("texture.decode.async", false)) {
+        return decodeTextureAsync(data, size, flipVertically, flags);
+    }
     Vector3 textureSize;
     ITexture *texturePtr = 0;
-    int x = 0, y = 0, ncomponents = 0;
+    int x = 0, y = 0;
 #ifdef VPVL2_LINK_FREEIMAGE
     FIMEMORY *memory = FreeImage_OpenMemory(const_cast<uint8_t *>(data), size);
     FREE_IMAGE_FORMAT format = FreeImage_GetFileTypeFromMemory(memory);
@@ -1729,25 +2161,228 @@ ITexture *BaseApplicationContext::uploadTextureFromMemory(const uint8 *data, vsi
     }
     FreeImage_CloseMemory(memory);
 #endif
-    /* Loading major image format (BMP/JPG/PNG/TGA/DDS) texture with stb_image.c */
-    const int rc = 4;
-    if (stbi_uc *ptr = stbi_load_from_memory(data, int(size), &x, &y, &ncomponents, rc)) {
+    if (stbi_uc *ptr = DecodeImage(data, size, flipVertically, x, y)) {
         textureSize.setValue(Scalar(x), Scalar(y), 1);
-        if (flipVertically) {
-            for (int j = 0, height = y >> 1; j < height; ++j) {
-                stbi_uc *p1 = ptr + j * x * rc;
-                stbi_uc *p2 = ptr + (y - 1 - j) * x * rc;
-                for (int i = 0, width = x * rc; i < width; ++i) {
-                    stbi_uc t = p1[i];
-                    p1[i] = p2[i];
-                    p2[i] = t;
-                }
-            }
-        }
         texturePtr = uploadTexture(ptr, defaultTextureFormat(), textureSize);
         stbi_image_free(ptr);
     }
-    return texturePtr;
+    return shareTexture(data, size, flipVertically, flags, texturePtr);
+}
+
+ITexture *BaseApplicationContext::findSharedTexture(const uint8 *data, vsize size, bool flipVertically, int flags)
+{
+    VPVL2_DCHECK(data && size > 0);
+    const SharedTextureKey key(data, size, flipVertically, flags);
+    if (SharedTexture *sharedTextureRef = findSharedTextureEntry(key, data)) {
+        m_textureCacheStatistics.nhits++;
+        m_textureCacheStatistics.savedBytes += sharedTextureRef->bytes;
+        VPVL2_VLOG(2, "Found the shared texture: hash=" << key.hash << " size=" << key.size << " flags=" << key.flags << " refs=" << sharedTextureRef->nrefs);
+        return new SharedTextureRef(sharedTextureRef);
+    }
+    m_textureCacheStatistics.nmisses++;
+    return 0;
+}
+
+ITexture *BaseApplicationContext::shareTexture(const uint8 *data, vsize size, bool flipVertically, int flags, ITexture *texturePtr)
+{
+    VPVL2_DCHECK(data && size > 0);
+    if (!texturePtr) {
+        return 0;
+    }
+    const SharedTextureKey key(data, size, flipVertically, flags);
+    if (SharedTexture *sharedTextureRef = findSharedTextureEntry(key, data)) {
+        /* the same content was uploaded while decoding this one, discard the duplicated texture */
+        internal::deleteObject(texturePtr);
+        return new SharedTextureRef(sharedTextureRef);
+    }
+    return new SharedTextureRef(registerSharedTexture(key, data, texturePtr));
+}
+
+BaseApplicationContext::SharedTexture *BaseApplicationContext::findSharedTextureEntry(const SharedTextureKey &key, const uint8 *data) const
+{
+    std::pair<SharedTextureMap::const_iterator, SharedTextureMap::const_iterator> range = m_sharedTextures.equal_range(key);
+    for (SharedTextureMap::const_iterator it = range.first; it != range.second; it++) {
+        SharedTexture *sharedTextureRef = it->second;
+        /* rejects the different content which has the same hash */
+        if (std::memcmp(sharedTextureRef->content.data(), data, key.size) == 0) {
+            return sharedTextureRef;
+        }
+    }
+    return 0;
+}
+
+BaseApplicationContext::SharedTexture *BaseApplicationContext::registerSharedTexture(const SharedTextureKey &key, const uint8 *data, ITexture *texturePtr)
+{
+    SharedTexture *sharedTexturePtr = new SharedTexture(this, key, data, texturePtr);
+    m_sharedTextures.insert(std::make_pair(key, sharedTexturePtr));
+    m_textureCacheStatistics.ntextures++;
+    m_textureCacheStatistics.residentBytes += sharedTexturePtr->bytes;
+    return sharedTexturePtr;
+}
+
+ITexture *BaseApplicationContext::decodeTextureAsync(const uint8 *data, vsize size, bool flipVertically, int flags)
+{
+    const SharedTextureKey key(data, size, flipVertically, flags);
+    TextureDecoder::Task *task = m_textureDecoderPtr->claim(SharedTextureKey(data, size, flipVertically, 0), data);
+    if (task && task->completed) {
+        /* the prefetched texture is already decoded, upload it right now */
+        ITexture *texturePtr = 0;
+        if (task->pixels) {
+            texturePtr = uploadTexture(task->pixels, defaultTextureFormat(), Vector3(Scalar(task->width), Scalar(task->height), 1));
+        }
+        internal::deleteObject(task);
+        m_textureDecoderPtr->markUploaded();
+        return texturePtr ? new SharedTextureRef(registerSharedTexture(key, data, texturePtr)) : 0;
+    }
+    /* white 1x1 texture is used until the decoded image is uploaded by uploadDecodedTextures */
+    static const uint8 kPlaceholderPixel[] = { 0xff, 0xff, 0xff, 0xff };
+    ITexture *placeholderPtr = uploadTexture(kPlaceholderPixel, defaultTextureFormat(), Vector3(1, 1, 1));
+    if (!placeholderPtr) {
+        if (task) {
+            task->discarded = true;
+        }
+        return 0;
+    }
+    SharedTexture *sharedTextureRef = registerSharedTexture(key, data, placeholderPtr);
+    /* the pending task holds a reference to keep the shared texture alive until uploaded */
+    sharedTextureRef->retain();
+    ITexture *textureRef = new SharedTextureRef(sharedTextureRef);
+    if (task) {
+        task->sharedTextureRef = sharedTextureRef;
+        VPVL2_VLOG(2, "Claimed the prefetched texture: hash=" << key.hash << " size=" << key.size << " flags=" << key.flags);
+    }
+    else {
+        m_textureDecoderPtr->schedule(new TextureDecoder::Task(sharedTextureRef, data, size, flipVertically));
+        VPVL2_VLOG(2, "Scheduled decoding the texture: hash=" << key.hash << " size=" << key.size << " flags=" << key.flags);
+    }
+    return textureRef;
+}
+
+void BaseApplicationContext::prefetchModelTextures(const IModel *model, ModelContext *context)
+{
+    VPVL2_DCHECK(model && context);
+    if (!m_configRef || !m_configRef->value("texture.decode.async", false)) {
+        return;
+    }
+    Array<const IString *> textures;
+    model->getTextureRefs(textures);
+    const int ntextures = textures.count();
+    const bool flipVertically = context->flipVertically();
+    for (int i = 0; i < ntextures; i++) {
+        std::string name = static_cast<const String *>(textures[i])->toStdString();
+        std::string::size_type pos(name.find('\\'));
+        while (pos != std::string::npos) {
+            name.replace(pos, 1, "/");
+            pos = name.find('\\', pos + 1);
+        }
+        if (name.empty()) {
+            continue;
+        }
+        if (Archive *archiveRef = context->archiveRef()) {
+            archiveRef->uncompressEntry(name);
+            if (const std::string *bytesRef = archiveRef->dataRef(name)) {
+                prefetchTexture(reinterpret_cast<const uint8 *>(bytesRef->data()), bytesRef->size(), flipVertically);
+            }
+        }
+        else if (const String *directoryRef = static_cast<const String *>(context->directoryRef())) {
+            MapBuffer buffer(this);
+            if (mapFile(directoryRef->toStdString() + "/" + name, &buffer)) {
+                prefetchTexture(buffer.address, buffer.size, flipVertically);
+            }
+        }
+    }
+}
+
+void BaseApplicationContext::prefetchTexture(const uint8 *data, vsize size, bool flipVertically)
+{
+    if (!data || size == 0) {
+        return;
+    }
+    /* the task is claimed by decodeTextureAsync when the render engine requests the texture */
+    const SharedTextureKey key(data, size, flipVertically, 0);
+    if (!m_textureDecoderPtr->findPrefetched(key, data)) {
+        m_textureDecoderPtr->prefetch(key, new TextureDecoder::Task(0, data, size, flipVertically));
+        VPVL2_VLOG(2, "Prefetching the texture: hash=" << key.hash << " size=" << key.size);
+    }
+}
+
+void BaseApplicationContext::uploadDecodedTextures()
+{
+    TextureDecoder::Task *task = 0;
+    while (m_textureDecoderPtr->tryPop(task)) {
+        SharedTexture *sharedTextureRef = task->sharedTextureRef;
+        if (task->discarded) {
+            internal::deleteObject(task);
+            m_textureDecoderPtr->markUploaded();
+            continue;
+        }
+        else if (!sharedTextureRef) {
+            /* the prefetched texture is not requested yet and uploaded when it is claimed */
+            task->completed = true;
+            continue;
+        }
+        if (task->pixels && sharedTextureRef->nrefs > 1) {
+            const Vector3 textureSize(Scalar(task->width), Scalar(task->height), 1);
+            if (ITexture *texturePtr = uploadTexture(task->pixels, defaultTextureFormat(), textureSize)) {
+                sharedTextureRef->replaceTexture(texturePtr);
+            }
+        }
+        else if (!task->pixels) {
+            VPVL2_LOG(WARNING, "Cannot decode the texture: hash=" << sharedTextureRef->key.hash << " size=" << sharedTextureRef->key.size);
+        }
+        sharedTextureRef->release();
+        internal::deleteObject(task);
+        m_textureDecoderPtr->markUploaded();
+        if (m_textureProgressReporterRef) {
+            m_textureProgressReporterRef->reportProgress(m_textureDecoderPtr->progress());
+        }
+    }
+}
+
+void BaseApplicationContext::waitForDecodingTextures()
+{
+    m_textureDecoderPtr->wait();
+    uploadDecodedTextures();
+}
+
+int BaseApplicationContext::countDecodingTextures() const
+{
+    return m_textureDecoderPtr->countPendingTasks();
+}
+
+IProgressReporter *BaseApplicationContext::textureProgressReporterRef() const
+{
+    return m_textureProgressReporterRef;
+}
+
+void BaseApplicationContext::setTextureProgressReporterRef(IProgressReporter *value)
+{
+    m_textureProgressReporterRef = value;
+}
+
+void BaseApplicationContext::getTextureCacheStatistics(TextureCacheStatistics &value) const
+{
+    value = m_textureCacheStatistics;
+}
+
+void BaseApplicationContext::getMatrixCacheStatistics(MatrixCacheStatistics &value) const
+{
+    value = m_matrixCacheStatistics;
+}
+
+void BaseApplicationContext::detachSharedTextures()
+{
+    /* decoded pixels are discarded as there may be no render engine to receive them */
+    m_textureDecoderPtr->discardAll();
+    /* textures still referenced by render engines are kept until the last reference is deleted */
+    for (SharedTextureMap::const_iterator it = m_sharedTextures.begin(); it != m_sharedTextures.end(); it++) {
+        it->second->parentRef = 0;
+    }
+    m_sharedTextures.clear();
+    VPVL2_VLOG(1, "Texture cache: hits=" << m_textureCacheStatistics.nhits
+               << " misses=" << m_textureCacheStatistics.nmisses
+               << " saved=" << m_textureCacheStatistics.savedBytes);
+    m_textureCacheStatistics = TextureCacheStatistics();
 }
 
 void BaseApplicationContext::optimizeTexture(ITexture *texture)
@@ -1785,6 +2420,36 @@ void BaseApplicationContext::releaseOffscreenRenderTarget(const OffscreenTexture
         buffer->unbind();
     }
 }
+
+const BaseApplicationContext::EffectAttachmentRule *BaseApplicationContext::resolveAttachmentRuleRef(OffscreenTexture *textureRef, const IModel *modelRef) const
+{
+    if (const EffectAttachmentRule *const *ruleRef = textureRef->resolvedRuleRefs.find(modelRef)) {
+        return *ruleRef;
+    }
+    const EffectAttachmentRule *resolvedRuleRef = 0;
+    const UnicodeString &basename = UnicodeString::fromUTF8(findModelFileBasename(modelRef));
+    const EffectAttachmentRuleList &rules = textureRef->attachmentRules;
+    for (EffectAttachmentRuleList::const_iterator it = rules.begin(); it != rules.end(); ++it) {
+        const EffectAttachmentRule &rule = *it;
+        RegexMatcher *matcherRef = rule.first;
+        matcherRef->reset(basename);
+        if (matcherRef->find()) {
+            resolvedRuleRef = &rule;
+            break;
+        }
+    }
+    textureRef->resolvedRuleRefs.insert(modelRef, resolvedRuleRef);
+    return resolvedRuleRef;
+}
+
+void BaseApplicationContext::invalidateAttachmentRules()
+{
+    const int ntextures = m_offscreenTextures.count();
+    for (int i = 0; i < ntextures; i++) {
+        OffscreenTexture *textureRef = m_offscreenTextures[i];
+        textureRef->resolvedRuleRefs.clear();
+    }
+}
 #endif
 
 std::string BaseApplicationContext::toonDirectory() const
@@ -100,7 +100,10 @@ const IString *Encoding::stringConstant(ConstantType value) const
 IString *Encoding::toString(const uint8 *value, vsize size, IString::Codec codec) const
 {
     IString *s = 0;
-    if (UConverter *converter = m_converter.converterFromCodec(codec)) {
+    if (value && size <= kMaxSymbolLength) {
+        s = m_symbolTable.newString(value, size, codec, &m_converter);
+    }
+    else if (UConverter *converter = m_converter.converterFromCodec(codec)) {
         const char *str = reinterpret_cast<const char *>(value);
         UErrorCode status = U_ZERO_ERROR;
         UnicodeString us(str, int(size), converter, status);
@@ -196,6 +199,11 @@ IString *Encoding::createString(const UnicodeString &value) const
     return new String(value, IString::kUTF8, &m_converter);
 }
 
+const String::SymbolTable *Encoding::symbolTable() const
+{
+    return &m_symbolTable;
+}
+
 } /* namespace icu4c */
 } /* namespace extensions */
 } /* namespace VPVL2_VERSION_NS */
@@ -38,6 +38,12 @@
 #include <vpvl2/extensions/icu4c/String.h>
 #include <vpvl2/internal/util.h>
 
+#include <map>
+#if defined(VPVL2_LINK_INTEL_TBB)
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
+#endif
+
 namespace vpvl2
 {
 namespace VPVL2_VERSION_NS
@@ -47,6 +53,236 @@ namespace extensions
 namespace icu4c
 {
 
+struct String::SymbolTable::PrivateContext {
+    struct Identifier {
+        Identifier(int value)
+            : value(value),
+              nrefs(0)
+        {
+        }
+        int value;
+        int nrefs;
+    };
+    typedef std::map<std::string, Symbol *> SymbolMap;
+    typedef std::map<std::string, Identifier> IdentifierMap;
+    PrivateContext()
+        : nextIdentifier(0)
+    {
+        converter.initialize();
+    }
+    ~PrivateContext();
+
+    void decode(Symbol *symbol);
+    void decodeUnlocked(Symbol *symbol);
+    Symbol *intern(const uint8 *value, vsize size, IString::Codec codec);
+    Symbol *internUnlocked(const uint8 *value, vsize size, IString::Codec codec);
+    void retain(Symbol *symbol);
+    void release(Symbol *symbol);
+    void releaseUnlocked(Symbol *symbol);
+
+    /* has own converters not to share them with IEncoding which is accessed without locking */
+    Converter converter;
+    SymbolMap symbols;
+    IdentifierMap identifiers;
+    int nextIdentifier;
+#if defined(VPVL2_LINK_INTEL_TBB)
+    tbb::spin_mutex mutex;
+#endif
+};
+
+/* a symbol is removed from the table when the last string referring it is deleted */
+struct String::Symbol {
+    Symbol(const std::string &key, IString::Codec codec, SymbolTable::PrivateContext *tableRef)
+        : key(key),
+          tableRef(tableRef),
+          utf8Ref(0),
+          codec(codec),
+          identifier(-1),
+          nrefs(0)
+    {
+        decoded = false;
+    }
+    ~Symbol() {
+        tableRef = 0;
+        utf8Ref = 0;
+    }
+
+    void resolve() {
+#if defined(VPVL2_LINK_INTEL_TBB)
+        /* decoded fields are written before the flag is released and never written after that */
+        if (decoded.load<tbb::acquire>()) {
+            return;
+        }
+#endif
+        /* the flag is checked again under the lock by decodeUnlocked */
+        tableRef->decode(this);
+    }
+
+    const std::string key;
+    SymbolTable::PrivateContext *tableRef;
+    UnicodeString value;
+    const std::string *utf8Ref;
+    const IString::Codec codec;
+    int identifier;
+    int nrefs;
+#if defined(VPVL2_LINK_INTEL_TBB)
+    tbb::atomic<bool> decoded;
+#else
+    bool decoded;
+#endif
+};
+
+String::SymbolTable::PrivateContext::~PrivateContext()
+{
+    for (SymbolMap::const_iterator it = symbols.begin(); it != symbols.end(); ++it) {
+        delete it->second;
+    }
+    symbols.clear();
+    identifiers.clear();
+}
+
+void String::SymbolTable::PrivateContext::decode(Symbol *symbol)
+{
+#if defined(VPVL2_LINK_INTEL_TBB)
+    tbb::spin_mutex::scoped_lock lock(mutex);
+    decodeUnlocked(symbol);
+#elif defined(VPVL2_ENABLE_OPENMP)
+#pragma omp critical (vpvl2_icu4c_string_symbol_table)
+    decodeUnlocked(symbol);
+#else
+    decodeUnlocked(symbol);
+#endif
+}
+
+void String::SymbolTable::PrivateContext::decodeUnlocked(Symbol *symbol)
+{
+    if (!symbol->decoded) {
+        UErrorCode status = U_ZERO_ERROR;
+        /* the first byte of the key is the codec */
+        UnicodeString us(symbol->key.data() + 1, int32_t(symbol->key.size() - 1), converter.converterFromCodec(symbol->codec), status);
+        /* remove head and trail spaces and 0x1a (appended by PMDEditor) */
+        symbol->value = us.trim().findAndReplace(UChar(0x1a), UChar());
+        const std::string &utf8 = toStdString(symbol->value);
+        IdentifierMap::iterator it = identifiers.find(utf8);
+        if (it == identifiers.end()) {
+            it = identifiers.insert(std::make_pair(utf8, Identifier(nextIdentifier++))).first;
+        }
+        it->second.nrefs++;
+        /* key of std::map is never moved so same names decoded from any codecs share the UTF-8 buffer */
+        symbol->utf8Ref = &it->first;
+        symbol->identifier = it->second.value;
+#if defined(VPVL2_LINK_INTEL_TBB)
+        symbol->decoded.store<tbb::release>(true);
+#else
+        symbol->decoded = true;
+#endif
+    }
+}
+
+String::Symbol *String::SymbolTable::PrivateContext::intern(const uint8 *value, vsize size, IString::Codec codec)
+{
+    Symbol *symbol = 0;
+#if defined(VPVL2_LINK_INTEL_TBB)
+    tbb::spin_mutex::scoped_lock lock(mutex);
+    symbol = internUnlocked(value, size, codec);
+#elif defined(VPVL2_ENABLE_OPENMP)
+#pragma omp critical (vpvl2_icu4c_string_symbol_table)
+    symbol = internUnlocked(value, size, codec);
+#else
+    symbol = internUnlocked(value, size, codec);
+#endif
+    return symbol;
+}
+
+String::Symbol *String::SymbolTable::PrivateContext::internUnlocked(const uint8 *value, vsize size, IString::Codec codec)
+{
+    /* same bytes may be decoded differently by each codecs, the codec is prepended as a part of the key */
+    std::string key(1, char(codec));
+    key.append(reinterpret_cast<const char *>(value), size);
+    SymbolMap::const_iterator it = symbols.find(key);
+    Symbol *symbol = 0;
+    if (it != symbols.end()) {
+        symbol = it->second;
+    }
+    else {
+        symbol = new Symbol(key, codec, this);
+        symbols.insert(std::make_pair(key, symbol));
+    }
+    /* retained here not to be released by the other thread before returning */
+    symbol->nrefs++;
+    return symbol;
+}
+
+void String::SymbolTable::PrivateContext::retain(Symbol *symbol)
+{
+#if defined(VPVL2_LINK_INTEL_TBB)
+    tbb::spin_mutex::scoped_lock lock(mutex);
+    symbol->nrefs++;
+#elif defined(VPVL2_ENABLE_OPENMP)
+#pragma omp critical (vpvl2_icu4c_string_symbol_table)
+    symbol->nrefs++;
+#else
+    symbol->nrefs++;
+#endif
+}
+
+void String::SymbolTable::PrivateContext::release(Symbol *symbol)
+{
+#if defined(VPVL2_LINK_INTEL_TBB)
+    tbb::spin_mutex::scoped_lock lock(mutex);
+    releaseUnlocked(symbol);
+#elif defined(VPVL2_ENABLE_OPENMP)
+#pragma omp critical (vpvl2_icu4c_string_symbol_table)
+    releaseUnlocked(symbol);
+#else
+    releaseUnlocked(symbol);
+#endif
+}
+
+void String::SymbolTable::PrivateContext::releaseUnlocked(Symbol *symbol)
+{
+    if (--symbol->nrefs > 0) {
+        return;
+    }
+    if (symbol->decoded) {
+        IdentifierMap::iterator it = identifiers.find(*symbol->utf8Ref);
+        if (it != identifiers.end() && --it->second.nrefs == 0) {
+            identifiers.erase(it);
+        }
+    }
+    symbols.erase(symbol->key);
+    delete symbol;
+}
+
+String::SymbolTable::SymbolTable()
+    : m_context(new PrivateContext())
+{
+}
+
+String::SymbolTable::~SymbolTable()
+{
+    internal::deleteObject(m_context);
+}
+
+String *String::SymbolTable::newString(const uint8 *value, vsize size, IString::Codec codec, const Converter *converterRef)
+{
+    if (m_context->converter.converterFromCodec(codec)) {
+        /* the string adopts the reference retained by intern */
+        return new String(m_context->intern(value, size, codec), codec, converterRef);
+    }
+    return 0;
+}
+
+int String::SymbolTable::countSymbols() const
+{
+    return int(m_context->symbols.size());
+}
+
+int String::SymbolTable::countIdentifiers() const
+{
+    return int(m_context->identifiers.size());
+}
+
 IString *String::create(const std::string &value)
 {
     return new String(UnicodeString::fromUTF8(value), IString::kUTF8, 0);
@@ -64,31 +300,43 @@ std::string String::toStdString(const UnicodeString &value)
 }
 
 String::String(const UnicodeString &value, Codec codec, const Converter *converterRef)
-    : m_converterRef(converterRef),
+    : m_symbolRef(0),
+      m_converterRef(converterRef),
       m_value(value),
       m_codec(codec),
       m_utf8(toStdString(value))
 {
 }
 
+String::String(Symbol *symbolRef, Codec codec, const Converter *converterRef)
+    : m_symbolRef(symbolRef),
+      m_converterRef(converterRef),
+      m_codec(codec)
+{
+}
+
 String::~String()
 {
+    if (m_symbolRef) {
+        m_symbolRef->tableRef->release(m_symbolRef);
+    }
+    m_symbolRef = 0;
     m_converterRef = 0;
 }
 
 bool String::startsWith(const IString *value) const
 {
-    return m_value.startsWith(static_cast<const String *>(value)->value()) == TRUE;
+    return unicode().startsWith(static_cast<const String *>(value)->value()) == TRUE;
 }
 
 bool String::contains(const IString *value) const
 {
-    return m_value.indexOf(static_cast<const String *>(value)->value()) != -1;
+    return unicode().indexOf(static_cast<const String *>(value)->value()) != -1;
 }
 
 bool String::endsWith(const IString *value) const
 {
-    return m_value.endsWith(static_cast<const String *>(value)->value()) == TRUE;
+    return unicode().endsWith(static_cast<const String *>(value)->value()) == TRUE;
 }
 
 void String::split(const IString *separator, int maxTokens, Array<IString *> &tokens) const
@@ -97,8 +345,8 @@ void String::split(const IString *separator, int maxTokens, Array<IString *> &to
     if (maxTokens > 0) {
         const UnicodeString &sep = static_cast<const String *>(separator)->value();
         int32 offset = 0, pos = 0, size = sep.length(), nwords = 0;
-        while ((pos = m_value.indexOf(sep, offset)) >= 0) {
-            tokens.append(new String(m_value.tempSubString(offset, pos - offset), m_codec, m_converterRef));
+        while ((pos = unicode().indexOf(sep, offset)) >= 0) {
+            tokens.append(new String(unicode().tempSubString(offset, pos - offset), m_codec, m_converterRef));
             offset = pos + size;
             nwords++;
             if (nwords >= maxTokens) {
@@ -110,21 +358,21 @@ void String::split(const IString *separator, int maxTokens, Array<IString *> &to
             IString *s = tokens[lastArrayOffset];
             const UnicodeString &s2 = static_cast<const String *>(s)->value();
             const UnicodeString &sp = static_cast<const String *>(separator)->value();
-            tokens[lastArrayOffset] = new String(s2 + sp + m_value.tempSubString(offset), m_codec, m_converterRef);
+            tokens[lastArrayOffset] = new String(s2 + sp + unicode().tempSubString(offset), m_codec, m_converterRef);
             internal::deleteObject(s);
         }
     }
     else if (maxTokens == 0) {
-        tokens.append(new String(m_value, m_codec, m_converterRef));
+        tokens.append(new String(unicode(), m_codec, m_converterRef));
     }
     else {
         const UnicodeString &sep = static_cast<const String *>(separator)->value();
         int32 offset = 0, pos = 0, size = sep.length();
-        while ((pos = m_value.indexOf(sep, offset)) >= 0) {
-            tokens.append(new String(m_value.tempSubString(offset, pos - offset), m_codec, m_converterRef));
+        while ((pos = unicode().indexOf(sep, offset)) >= 0) {
+            tokens.append(new String(unicode().tempSubString(offset, pos - offset), m_codec, m_converterRef));
             offset = pos + size;
         }
-        tokens.append(new String(m_value.tempSubString(offset), m_codec, m_converterRef));
+        tokens.append(new String(unicode().tempSubString(offset), m_codec, m_converterRef));
     }
 }
 
@@ -136,7 +384,7 @@ IString *String::join(const Array<IString *> &tokens) const
         const IString *token = tokens[i];
         s.append(static_cast<const String *>(token)->value());
         if (i != ntokens - 1) {
-            s.append(m_value);
+            s.append(unicode());
         }
     }
     return new String(s, m_codec, m_converterRef);
@@ -144,38 +392,75 @@ IString *String::join(const Array<IString *> &tokens) const
 
 IString *String::clone() const
 {
-    return new String(m_value, m_codec, m_converterRef);
+    if (m_symbolRef) {
+        m_symbolRef->tableRef->retain(m_symbolRef);
+        return new String(m_symbolRef, m_codec, m_converterRef);
+    }
+    return new String(unicode(), m_codec, m_converterRef);
 }
 
 const HashString String::toHashString() const
 {
     /* first argument of HashString's construct must be on memory after calling this (toHashString) */
-    return HashString(m_utf8.c_str());
+    return HashString(utf8().c_str());
 }
 
 bool String::equals(const IString *value) const
 {
-    return value && m_value.compare(static_cast<const String *>(value)->value()) == 0;
+    if (const String *s = static_cast<const String *>(value)) {
+        if (m_symbolRef && s->m_symbolRef && m_symbolRef->tableRef == s->m_symbolRef->tableRef) {
+            return symbolId() == s->symbolId();
+        }
+        return unicode().compare(s->unicode()) == 0;
+    }
+    return false;
 }
 
 UnicodeString String::value() const
 {
-    return m_value;
+    return unicode();
 }
 
 std::string String::toStdString() const
 {
-    return m_utf8;
+    return utf8();
 }
 
 const uint8 *String::toByteArray() const
 {
-    return reinterpret_cast<const uint8 *>(m_utf8.c_str());
+    return reinterpret_cast<const uint8 *>(utf8().c_str());
 }
 
 vsize String::size() const
 {
-    return m_value.length();
+    return unicode().length();
+}
+
+int String::symbolId() const
+{
+    if (m_symbolRef) {
+        m_symbolRef->resolve();
+        return m_symbolRef->identifier;
+    }
+    return -1;
+}
+
+const UnicodeString &String::unicode() const
+{
+    if (m_symbolRef) {
+        m_symbolRef->resolve();
+        return m_symbolRef->value;
+    }
+    return m_value;
+}
+
+const std::string &String::utf8() const
+{
+    if (m_symbolRef) {
+        m_symbolRef->resolve();
+        return *m_symbolRef->utf8Ref;
+    }
+    return m_utf8;
 }
 
 } /* namespace icu4c */
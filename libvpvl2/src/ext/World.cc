@@ -40,6 +40,7 @@
 #include <vpvl2/IModel.h>
 #include <vpvl2/Scene.h>
 #include <vpvl2/internal/util.h>
+#include <vpvl2/internal/BaseRigidBody.h>
 
 /* Bullet Physics */
 #ifdef __clang__
@@ -55,10 +56,225 @@
 #pragma clang diagnostic pop
 #endif
 
-/* std::numeric_limits */
-#include <limits>
-/* prevent errors on MSVC */
-#undef max
+#ifdef VPVL2_LINK_INTEL_TBB
+#include <tbb/tbb.h>
+#endif
+
+namespace {
+
+using namespace vpvl2::VPVL2_VERSION_NS;
+
+/*
+ * Island owns a dynamics world of the one model. Every island has its own collision
+ * configuration, dispatcher, broadphase and solver so islands can be stepped concurrently
+ * (Bullet itself must be built with BT_NO_PROFILE because the profiler is global).
+ */
+struct Island {
+    Island(IModel *model, btCollisionShape *groundShapeRef)
+        : modelRef(model),
+          dispatcher(0),
+          broadphase(0),
+          solver(0),
+          world(0),
+          groundBody(0)
+    {
+        dispatcher = new btCollisionDispatcher(&config);
+        broadphase = new btDbvtBroadphase();
+        solver = new btSequentialImpulseConstraintSolver();
+        world = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, &config);
+        world->getSolverInfo().m_solverMode &= ~SOLVER_RANDMIZE_ORDER;
+        btRigidBody::btRigidBodyConstructionInfo info(0, 0, groundShapeRef, kZeroV3);
+        groundBody = new btRigidBody(info);
+    }
+    ~Island() {
+        world->removeRigidBody(groundBody);
+        internal::deleteObject(groundBody);
+        internal::deleteObject(world);
+        internal::deleteObject(solver);
+        internal::deleteObject(broadphase);
+        internal::deleteObject(dispatcher);
+        modelRef = 0;
+    }
+
+    void setFloorEnabled(bool value) {
+        world->removeRigidBody(groundBody);
+        if (value) {
+            world->addRigidBody(groundBody, 0x10, 0);
+        }
+    }
+
+    IModel *modelRef;
+    btDefaultCollisionConfiguration config;
+    btCollisionDispatcher *dispatcher;
+    btDbvtBroadphase *broadphase;
+    btSequentialImpulseConstraintSolver *solver;
+    btDiscreteDynamicsWorld *world;
+    btRigidBody *groundBody;
+};
+
+struct Checkpoint {
+    struct Body {
+        Transform centerOfMassTransform;
+        Transform interpolationWorldTransform;
+        Transform motionStateTransform;
+        Vector3 linearVelocity;
+        Vector3 angularVelocity;
+        Vector3 interpolationLinearVelocity;
+        Vector3 interpolationAngularVelocity;
+    };
+    /*
+     * bodies of models are identified by the parent model and the index of the rigid body so
+     * a rebuilt body of the same model is restored too. other bodies have no parent model and
+     * are identified by the order in the worlds instead.
+     */
+    struct Key VPVL2_DECL_FINAL {
+        Key(const IModel *modelRef, int index)
+            : modelRef(modelRef),
+              index(index)
+        {
+        }
+        unsigned int getHash() const {
+            return HashPtr(modelRef).getHash() ^ (static_cast<unsigned int>(index) * 2654435761u);
+        }
+        bool equals(const Key &other) const {
+            return modelRef == other.modelRef && index == other.index;
+        }
+        const IModel *modelRef;
+        int index;
+    };
+    struct Predication VPVL2_DECL_FINAL {
+        bool operator()(const Checkpoint *left, const Checkpoint *right) const {
+            return left->timeIndex < right->timeIndex;
+        }
+    };
+
+    static Key createKey(const btRigidBody *body, int &nunownedBodies) {
+        /* models set their rigid body as the user pointer when they join the world */
+        if (const IRigidBody *rigidBodyRef = static_cast<const internal::BaseRigidBody *>(body->getUserPointer())) {
+            return Key(rigidBodyRef->parentModelRef(), rigidBodyRef->index());
+        }
+        return Key(0, nunownedBodies++);
+    }
+
+    Checkpoint(const Scalar &value)
+        : timeIndex(value),
+          nunownedBodies(0)
+    {
+    }
+    ~Checkpoint() {
+        timeIndex = 0;
+        nunownedBodies = 0;
+    }
+
+    void save(const btDiscreteDynamicsWorld *world) {
+        const btCollisionObjectArray &objects = world->getCollisionObjectArray();
+        const int nobjects = objects.size();
+        for (int i = 0; i < nobjects; i++) {
+            const btRigidBody *body = btRigidBody::upcast(objects[i]);
+            if (body && !body->isStaticOrKinematicObject()) {
+                Body value;
+                value.centerOfMassTransform = body->getCenterOfMassTransform();
+                value.interpolationWorldTransform = body->getInterpolationWorldTransform();
+                value.linearVelocity = body->getLinearVelocity();
+                value.angularVelocity = body->getAngularVelocity();
+                value.interpolationLinearVelocity = body->getInterpolationLinearVelocity();
+                value.interpolationAngularVelocity = body->getInterpolationAngularVelocity();
+                if (const btMotionState *state = body->getMotionState()) {
+                    state->getWorldTransform(value.motionStateTransform);
+                }
+                else {
+                    value.motionStateTransform = value.centerOfMassTransform;
+                }
+                key2indices.insert(createKey(body, nunownedBodies), bodies.count());
+                bodies.append(value);
+            }
+        }
+    }
+    void restore(btDiscreteDynamicsWorld *world, int &nunownedBodiesRestored) const {
+        btCollisionObjectArray &objects = world->getCollisionObjectArray();
+        btOverlappingPairCache *cache = world->getPairCache();
+        btDispatcher *dispatcher = world->getDispatcher();
+        const int nobjects = objects.size();
+        for (int i = 0; i < nobjects; i++) {
+            btRigidBody *body = btRigidBody::upcast(objects[i]);
+            if (body && !body->isStaticOrKinematicObject()) {
+                if (const int *index = key2indices.find(createKey(body, nunownedBodiesRestored))) {
+                    const Body &value = bodies[*index];
+                    body->setCenterOfMassTransform(value.centerOfMassTransform);
+                    body->setInterpolationWorldTransform(value.interpolationWorldTransform);
+                    body->setLinearVelocity(value.linearVelocity);
+                    body->setAngularVelocity(value.angularVelocity);
+                    body->setInterpolationLinearVelocity(value.interpolationLinearVelocity);
+                    body->setInterpolationAngularVelocity(value.interpolationAngularVelocity);
+                    body->clearForces();
+                    if (btMotionState *state = body->getMotionState()) {
+                        state->setWorldTransform(value.motionStateTransform);
+                    }
+                    if (cache) {
+                        cache->cleanProxyFromPairs(body->getBroadphaseHandle(), dispatcher);
+                    }
+                }
+            }
+        }
+    }
+    vsize size() const {
+        return sizeof(*this) + bodies.count() * (sizeof(Body) + sizeof(Key) + sizeof(int));
+    }
+
+    Scalar timeIndex;
+    Array<Body> bodies;
+    Hash<Key, int> key2indices;
+    int nunownedBodies;
+};
+
+class ParallelStepIslandProcessor VPVL2_DECL_FINAL {
+public:
+    ParallelStepIslandProcessor(const Array<Island *> *islandsRef, const Scalar &timeStep, int maxSubSteps, const Scalar &fixedTimeStep)
+        : m_islandsRef(islandsRef),
+          m_timeStep(timeStep),
+          m_fixedTimeStep(fixedTimeStep),
+          m_maxSubSteps(maxSubSteps)
+    {
+    }
+    ~ParallelStepIslandProcessor() {
+        m_islandsRef = 0;
+    }
+
+    inline void step(int index) const {
+        Island *island = m_islandsRef->at(index);
+        island->world->stepSimulation(m_timeStep, m_maxSubSteps, m_fixedTimeStep);
+    }
+#ifdef VPVL2_LINK_INTEL_TBB
+    void operator()(const tbb::blocked_range<int> &range) const {
+        for (int i = range.begin(), end = range.end(); i != end; ++i) {
+            step(i);
+        }
+    }
+#endif /* VPVL2_LINK_INTEL_TBB */
+
+    void execute() {
+        const int nislands = m_islandsRef->count();
+#if defined(VPVL2_LINK_INTEL_TBB)
+        /* an island is heavy enough to be a task by itself */
+        tbb::parallel_for(tbb::blocked_range<int>(0, nislands, 1), *this);
+#else
+#ifdef VPVL2_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < nislands; ++i) {
+            step(i);
+        }
+#endif
+    }
+
+private:
+    const Array<Island *> *m_islandsRef;
+    const Scalar m_timeStep;
+    const Scalar m_fixedTimeStep;
+    const int m_maxSubSteps;
+};
+
+} /* namespace anonymous */
 
 namespace vpvl2
 {
@@ -68,7 +284,6 @@ namespace extensions
 {
 
 struct World::PrivateContext {
-    static const int kMaxSubSteps;
     PrivateContext()
         : dispatcher(0),
           broadphase(0),
@@ -76,9 +291,13 @@ struct World::PrivateContext {
           world(0),
           ground(0),
           groundBody(0),
+          checkpointBytes(0),
+          checkpointMemoryBudget(kDefaultCheckpointMemoryBudget),
           baseFPS(60.0f),
           timeScale(1.0f),
-          enableFloor(true)
+          maxSubSteps(kDefaultMaxSubSteps),
+          enableFloor(true),
+          enableIsland(false)
     {
         dispatcher = new btCollisionDispatcher(&config);
         broadphase = new btDbvtBroadphase();
@@ -91,6 +310,10 @@ struct World::PrivateContext {
         world->addRigidBody(groundBody, 0x10, 0);
     }
     ~PrivateContext() {
+        /* rigid bodies of the models must leave islands before deleting their dynamics worlds */
+        removeAllModels();
+        checkpoints.releaseAll();
+        islands.releaseAll();
         world->removeRigidBody(groundBody);
         internal::deleteObject(groundBody);
         internal::deleteObject(ground);
@@ -98,9 +321,175 @@ struct World::PrivateContext {
         internal::deleteObject(broadphase);
         internal::deleteObject(solver);
         internal::deleteObject(world);
+        checkpointBytes = 0;
+        checkpointMemoryBudget = 0;
         baseFPS = 0;
         timeScale = 0;
+        maxSubSteps = 0;
         enableFloor = false;
+        enableIsland = false;
+    }
+
+    void addModel(IModel *model, bool sharedCollision) {
+        if (enableIsland && !sharedCollision) {
+            Island *island = islands.append(new Island(model, ground));
+            island->world->setGravity(world->getGravity());
+            island->solver->setRandSeed(solver->getRandSeed());
+            island->setFloorEnabled(enableFloor);
+            model->joinWorld(island->world);
+        }
+        else {
+            model->joinWorld(world);
+        }
+        if (sharedCollision) {
+            sharedCollisionModelRefs.append(model);
+        }
+        modelRefs.append(model);
+    }
+    static bool containsModel(const Array<IModel *> &models, const IModel *model) {
+        const int nmodels = models.count();
+        for (int i = 0; i < nmodels; i++) {
+            if (models[i] == model) {
+                return true;
+            }
+        }
+        return false;
+    }
+    Island *findIsland(const IModel *model, int &index) const {
+        const int nislands = islands.count();
+        for (int i = 0; i < nislands; i++) {
+            Island *island = islands[i];
+            if (island->modelRef == model) {
+                index = i;
+                return island;
+            }
+        }
+        index = -1;
+        return 0;
+    }
+    void leaveModel(IModel *model) {
+        int index;
+        if (Island *island = findIsland(model, index)) {
+            model->leaveWorld(island->world);
+            islands.removeAt(index);
+            delete island;
+        }
+        else {
+            model->leaveWorld(world);
+        }
+    }
+    bool removeModel(IModel *model) {
+        const int nmodels = modelRefs.count();
+        for (int i = 0; i < nmodels; i++) {
+            if (modelRefs[i] == model) {
+                leaveModel(model);
+                modelRefs.removeAt(i);
+                sharedCollisionModelRefs.remove(model);
+                return true;
+            }
+        }
+        return false;
+    }
+    void removeAllModels() {
+        const int nmodels = modelRefs.count();
+        for (int i = nmodels - 1; i >= 0; i--) {
+            leaveModel(modelRefs[i]);
+        }
+        modelRefs.clear();
+        sharedCollisionModelRefs.clear();
+    }
+    void resetMotionState() {
+        bool resetWorld = false;
+        const int nmodels = modelRefs.count();
+        for (int i = 0; i < nmodels; i++) {
+            IModel *model = modelRefs[i];
+            int index;
+            if (Island *island = findIsland(model, index)) {
+                model->resetMotionState(island->world);
+                island->broadphase->resetPool(island->dispatcher);
+                island->solver->reset();
+            }
+            else {
+                model->resetMotionState(world);
+                resetWorld = true;
+            }
+        }
+        if (resetWorld) {
+            broadphase->resetPool(dispatcher);
+            solver->reset();
+        }
+    }
+    void saveCheckpoint(const Scalar &timeIndex) {
+        const int ncheckpoints = checkpoints.count();
+        for (int i = 0; i < ncheckpoints; i++) {
+            Checkpoint *checkpoint = checkpoints[i];
+            if (checkpoint->timeIndex == timeIndex) {
+                checkpointBytes -= checkpoint->size();
+                checkpoints.removeAt(i);
+                delete checkpoint;
+                break;
+            }
+        }
+        Checkpoint *checkpoint = checkpoints.append(new Checkpoint(timeIndex));
+        checkpoint->save(world);
+        const int nislands = islands.count();
+        for (int i = 0; i < nislands; i++) {
+            checkpoint->save(islands[i]->world);
+        }
+        checkpoints.sort(Checkpoint::Predication());
+        checkpointBytes += checkpoint->size();
+        while (checkpointBytes > checkpointMemoryBudget && checkpoints.count() > 0) {
+            thinCheckpoints();
+        }
+    }
+    void thinCheckpoints() {
+        /* drop every other checkpoint so the remaining ones still cover the whole timeline */
+        int ncheckpoints = checkpoints.count();
+        if (ncheckpoints > 1) {
+            for (int i = ncheckpoints - 1; i >= 0; i--) {
+                if (i % 2 == 1) {
+                    Checkpoint *checkpoint = checkpoints[i];
+                    checkpointBytes -= checkpoint->size();
+                    checkpoints.removeAt(i);
+                    delete checkpoint;
+                }
+            }
+        }
+        else {
+            clearCheckpoints();
+        }
+    }
+    int findCheckpointIndex(const Scalar &timeIndex) const {
+        for (int i = checkpoints.count() - 1; i >= 0; i--) {
+            if (checkpoints[i]->timeIndex <= timeIndex) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    void restoreCheckpoint(const Checkpoint *checkpoint) {
+        int nunownedBodies = 0;
+        checkpoint->restore(world, nunownedBodies);
+        const int nislands = islands.count();
+        for (int i = 0; i < nislands; i++) {
+            checkpoint->restore(islands[i]->world, nunownedBodies);
+        }
+    }
+    void clearCheckpoints() {
+        checkpoints.releaseAll();
+        checkpointBytes = 0;
+    }
+    void rebuildIslands() {
+        /* rejoin all models to move their rigid bodies between the shared world and islands */
+        Array<IModel *> models, sharedCollisionModels;
+        models.copy(modelRefs);
+        sharedCollisionModels.copy(sharedCollisionModelRefs);
+        removeAllModels();
+        const int nmodels = models.count();
+        for (int i = 0; i < nmodels; i++) {
+            IModel *model = models[i];
+            addModel(model, containsModel(sharedCollisionModels, model));
+        }
     }
 
     btDefaultCollisionConfiguration config;
@@ -110,12 +499,21 @@ struct World::PrivateContext {
     btDiscreteDynamicsWorld *world;
     btStaticPlaneShape *ground;
     btRigidBody *groundBody;
+    PointerArray<Island> islands;
+    PointerArray<Checkpoint> checkpoints;
+    Array<IModel *> modelRefs;
+    Array<IModel *> sharedCollisionModelRefs;
+    vsize checkpointBytes;
+    vsize checkpointMemoryBudget;
     Scalar baseFPS;
     Scalar timeScale;
+    int maxSubSteps;
     bool enableFloor;
+    bool enableIsland;
 };
 
-const int World::PrivateContext::kMaxSubSteps = std::numeric_limits<int>::max();
+const int World::kDefaultMaxSubSteps = 240;
+const vsize World::kDefaultCheckpointMemoryBudget = 64 * 1024 * 1024;
 
 World::World()
     : m_context(new PrivateContext())
@@ -130,16 +528,19 @@ World::~World()
 
 void World::addRigidBody(btRigidBody *value)
 {
+    m_context->clearCheckpoints();
     m_context->world->addRigidBody(value);
 }
 
 void World::removeRigidBody(btRigidBody *value)
 {
+    m_context->clearCheckpoints();
     m_context->world->removeRigidBody(value);
 }
 
 void World::deleteAll()
 {
+    m_context->clearCheckpoints();
     btDiscreteDynamicsWorld *world = m_context->world;
     const int numCollidables = world->getNumCollisionObjects();
     for (int i = numCollidables - 1; i >= 0; i--) {
@@ -161,7 +562,113 @@ void World::deleteAll()
 void World::stepSimulation(const Scalar &deltaTimeIndex, const Scalar &motionFPS)
 {
     const Scalar &v = (deltaTimeIndex / motionFPS) * (m_context->baseFPS / motionFPS) * m_context->timeScale;
-    m_context->world->stepSimulation(v, PrivateContext::kMaxSubSteps, 1.0f / m_context->baseFPS);
+    const Scalar &fixedTimeStep = 1.0f / m_context->baseFPS;
+    m_context->world->stepSimulation(v, m_context->maxSubSteps, fixedTimeStep);
+    if (m_context->islands.count() > 0) {
+        ParallelStepIslandProcessor processor(&m_context->islands, v, m_context->maxSubSteps, fixedTimeStep);
+        processor.execute();
+    }
+}
+
+void World::addModel(IModel *value, bool sharedCollision)
+{
+    if (value && !PrivateContext::containsModel(m_context->modelRefs, value)) {
+        m_context->clearCheckpoints();
+        m_context->addModel(value, sharedCollision);
+    }
+}
+
+bool World::removeModel(IModel *value)
+{
+    if (value && m_context->removeModel(value)) {
+        m_context->clearCheckpoints();
+        return true;
+    }
+    return false;
+}
+
+void World::removeAllModels()
+{
+    m_context->clearCheckpoints();
+    m_context->removeAllModels();
+}
+
+void World::resetMotionState()
+{
+    m_context->clearCheckpoints();
+    m_context->resetMotionState();
+}
+
+bool World::isIslandEnabled() const
+{
+    return m_context->enableIsland;
+}
+
+void World::setIslandEnabled(bool value)
+{
+    if (m_context->enableIsland != value) {
+        m_context->enableIsland = value;
+        m_context->clearCheckpoints();
+        m_context->rebuildIslands();
+    }
+}
+
+void World::saveCheckpoint(const Scalar &timeIndex)
+{
+    m_context->saveCheckpoint(timeIndex);
+}
+
+bool World::findCheckpoint(const Scalar &timeIndex, Scalar &checkpointTimeIndex) const
+{
+    int index = m_context->findCheckpointIndex(timeIndex);
+    if (index >= 0) {
+        checkpointTimeIndex = m_context->checkpoints[index]->timeIndex;
+        return true;
+    }
+    return false;
+}
+
+bool World::restoreCheckpoint(const Scalar &timeIndex)
+{
+    int index = m_context->findCheckpointIndex(timeIndex);
+    if (index >= 0) {
+        m_context->restoreCheckpoint(m_context->checkpoints[index]);
+        return true;
+    }
+    return false;
+}
+
+void World::clearCheckpoints()
+{
+    m_context->clearCheckpoints();
+}
+
+int World::countCheckpoints() const
+{
+    return m_context->checkpoints.count();
+}
+
+vsize World::checkpointMemoryBudget() const
+{
+    return m_context->checkpointMemoryBudget;
+}
+
+void World::setCheckpointMemoryBudget(vsize value)
+{
+    m_context->checkpointMemoryBudget = value;
+    while (m_context->checkpointBytes > value && m_context->checkpoints.count() > 0) {
+        m_context->thinCheckpoints();
+    }
+}
+
+int World::maxSubSteps() const
+{
+    return m_context->maxSubSteps;
+}
+
+void World::setMaxSubSteps(int value)
+{
+    m_context->maxSubSteps = btMax(value, 1);
 }
 
 const Vector3 World::gravity() const
@@ -177,6 +684,10 @@ btDiscreteDynamicsWorld *World::dynamicWorldRef() const
 void World::setGravity(const Vector3 &value)
 {
     m_context->world->setGravity(value);
+    const int nislands = m_context->islands.count();
+    for (int i = 0; i < nislands; i++) {
+        m_context->islands[i]->world->setGravity(value);
+    }
 }
 
 Scalar World::baseFPS() const
@@ -207,6 +718,10 @@ unsigned long World::randSeed() const
 void World::setRandSeed(unsigned long value)
 {
     m_context->solver->setRandSeed(value);
+    const int nislands = m_context->islands.count();
+    for (int i = 0; i < nislands; i++) {
+        m_context->islands[i]->solver->setRandSeed(value);
+    }
 }
 
 bool World::isFloorEnabled() const
@@ -223,6 +738,10 @@ void World::setFloorEnabled(bool value)
     else {
         m_context->world->removeRigidBody(m_context->groundBody);
     }
+    const int nislands = m_context->islands.count();
+    for (int i = 0; i < nislands; i++) {
+        m_context->islands[i]->setFloorEnabled(value);
+    }
     m_context->enableFloor = value;
 }
 
@@ -36,6 +36,7 @@
 */
 
 #include "vpvl2/vpvl2.h"
+#include "vpvl2/internal/MappedFile.h"
 #include "vpvl2/internal/util.h"
 
 #include "vpvl2/extensions/XMLProject.h"
@@ -83,6 +84,78 @@ namespace VPVL2_VERSION_NS
 namespace extensions
 {
 
+#pragma pack(push, 1)
+
+struct BinaryHeaderUnit {
+    uint8 signature[4];
+    float32 version;
+    int32 nchunks;
+};
+
+struct BinaryChunkIndexUnit {
+    uint8 tag[4];
+    int32 offset;
+    int32 size;
+};
+
+struct BinaryBoneKeyframeUnit {
+    int32 nameIndex;
+    float32 timeIndex;
+    int32 layerIndex;
+    float32 position[3];
+    float32 rotation[4];
+    uint8 interpolation[16];
+    uint8 flags;
+};
+
+struct BinaryCameraKeyframeUnit {
+    float32 timeIndex;
+    int32 layerIndex;
+    float32 lookAt[3];
+    float32 angle[3];
+    float32 fov;
+    float32 distance;
+    uint8 interpolation[24];
+};
+
+struct BinaryEffectKeyframeUnit {
+    float32 timeIndex;
+    uint8 flags;
+    float32 scaleFactor;
+    float32 opacity;
+};
+
+struct BinaryLightKeyframeUnit {
+    float32 timeIndex;
+    float32 color[3];
+    float32 direction[3];
+};
+
+struct BinaryModelKeyframeUnit {
+    float32 timeIndex;
+    uint8 flags;
+    uint8 physicsStillMode;
+    float32 edgeWidth;
+    float32 edgeColor[4];
+};
+
+struct BinaryMorphKeyframeUnit {
+    int32 nameIndex;
+    float32 timeIndex;
+    float32 weight;
+};
+
+struct BinaryProjectKeyframeUnit {
+    float32 timeIndex;
+    float32 gravityFactor;
+    float32 gravityDirection[3];
+    int32 shadowMode;
+    float32 shadowDepth;
+    float32 shadowDistance;
+};
+
+#pragma pack(pop)
+
 struct XMLProject::PrivateContext {
     enum State {
         kInitial,
@@ -110,8 +183,12 @@ struct XMLProject::PrivateContext {
     };
     static const int kElementContentBufferSize = 128;
     static const std::string kEmpty;
+    static const uint8 kBinarySignature[];
     typedef std::map<XMLProject::UUID, IModel *> ModelMap;
     typedef std::map<XMLProject::UUID, IMotion *> MotionMap;
+    typedef std::vector<uint8> ByteArray;
+    typedef std::pair<vsize, vsize> ChunkRange;
+    typedef std::map<XMLProject::UUID, ChunkRange> PendingMotionMap;
 
     static inline const char *projectPrefix() {
         return "vpvm";
@@ -231,7 +308,8 @@ struct XMLProject::PrivateContext {
           currentMotionType(IMotion::kVMDFormat),
           state(kInitial),
           depth(0),
-          dirty(false)
+          dirty(false),
+          enableMotionLazyLoad(false)
     {
     }
     ~PrivateContext() {
@@ -239,11 +317,13 @@ struct XMLProject::PrivateContext {
         assetRefs.clear();
         modelRefs.clear();
         motionRefs.clear();
+        pendingMotions.clear();
         internal::deleteObject(currentString);
         internal::deleteObject(currentMotion);
         state = kInitial;
         depth = 0;
         dirty = false;
+        enableMotionLazyLoad = false;
         sceneRef = 0;
         delegateRef = 0;
         factoryRef = 0;
@@ -821,6 +901,657 @@ struct XMLProject::PrivateContext {
         return true;
     }
 
+    static void appendBytes(const void *value, vsize size, ByteArray &bytes) {
+        const uint8 *ptr = static_cast<const uint8 *>(value);
+        bytes.insert(bytes.end(), ptr, ptr + size);
+    }
+    template<typename T>
+    static void appendTyped(const T &value, ByteArray &bytes) {
+        appendBytes(&value, sizeof(value), bytes);
+    }
+    static void appendString(const std::string &value, ByteArray &bytes) {
+        appendTyped(int32(value.size()), bytes);
+        appendBytes(value.data(), value.size(), bytes);
+    }
+    static void appendStringMap(const StringMap &map, ByteArray &bytes) {
+        int32 nvalues = 0;
+        for (StringMap::const_iterator it = map.begin(); it != map.end(); it++) {
+            if (!it->first.empty() && !it->second.empty()) {
+                nvalues++;
+            }
+        }
+        appendTyped(nvalues, bytes);
+        for (StringMap::const_iterator it = map.begin(); it != map.end(); it++) {
+            if (!it->first.empty() && !it->second.empty()) {
+                appendString(it->first, bytes);
+                appendString(it->second, bytes);
+            }
+        }
+    }
+    static void appendNames(const std::vector<std::string> &names, ByteArray &bytes) {
+        appendTyped(int32(names.size()), bytes);
+        for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); it++) {
+            appendString(*it, bytes);
+        }
+    }
+    template<typename T>
+    static void appendUnits(const std::vector<T> &units, ByteArray &bytes) {
+        appendTyped(int32(units.size()), bytes);
+        if (!units.empty()) {
+            appendBytes(&units[0], sizeof(T) * units.size(), bytes);
+        }
+    }
+    static void getInterpolation(const QuadWord &value, uint8 *output) {
+        output[0] = uint8(value.x());
+        output[1] = uint8(value.y());
+        output[2] = uint8(value.z());
+        output[3] = uint8(value.w());
+    }
+    static void setInterpolation(const uint8 *input, QuadWord &value) {
+        value.setValue(input[0], input[1], input[2], input[3]);
+    }
+    static bool readString(uint8 *&ptr, vsize &rest, std::string &value) {
+        uint8 *text = 0;
+        int32 size = 0;
+        if (!internal::getText(ptr, rest, text, size) || size < 0) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char *>(text), size);
+        return true;
+    }
+    static bool readStringMap(uint8 *&ptr, vsize &rest, StringMap &map) {
+        std::string key, value;
+        int32 nvalues = 0;
+        if (!internal::getTyped(ptr, rest, nvalues)) {
+            return false;
+        }
+        for (int32 i = 0; i < nvalues; i++) {
+            if (!readString(ptr, rest, key) || !readString(ptr, rest, value)) {
+                return false;
+            }
+            map[key] = value;
+        }
+        return true;
+    }
+    template<typename T>
+    static bool readUnits(uint8 *&ptr, vsize &rest, const T *&units, int32 &nunits) {
+        if (!internal::getTyped(ptr, rest, nunits) || nunits < 0) {
+            return false;
+        }
+        units = reinterpret_cast<const T *>(ptr);
+        return internal::validateSize(ptr, sizeof(T), nunits, rest);
+    }
+    static bool equalsTag(const uint8 *tag, const char *const value) {
+        return std::memcmp(tag, value, sizeof(BinaryChunkIndexUnit().tag)) == 0;
+    }
+
+    int32 findNameIndex(const IString *value, std::map<std::string, int32> &name2indices, std::vector<std::string> &names) const {
+        const std::string &name = delegateRef->toStdFromString(value);
+        std::map<std::string, int32>::const_iterator it = name2indices.find(name);
+        if (it != name2indices.end()) {
+            return it->second;
+        }
+        int32 index = int32(names.size());
+        name2indices.insert(std::make_pair(name, index));
+        names.push_back(name);
+        return index;
+    }
+    void writeBinaryBoneKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        std::map<std::string, int32> name2indices;
+        std::vector<std::string> names;
+        QuadWord qw;
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kBoneKeyframe);
+        const bool isVMD = motion->type() == IMotion::kVMDFormat;
+        std::vector<BinaryBoneKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kBoneKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const IBoneKeyframe *keyframe = motion->findBoneKeyframeRefAt(i);
+            BinaryBoneKeyframeUnit &unit = units[i];
+            unit.nameIndex = findNameIndex(keyframe->name(), name2indices, names);
+            unit.timeIndex = float32(keyframe->timeIndex());
+            unit.layerIndex = keyframe->layerIndex();
+            internal::getPosition(keyframe->localTranslation(), unit.position);
+            internal::getRotation2(keyframe->localOrientation(), unit.rotation);
+            for (int j = 0; j < IBoneKeyframe::kMaxBoneInterpolationType; j++) {
+                keyframe->getInterpolationParameter(static_cast<IBoneKeyframe::InterpolationType>(j), qw);
+                getInterpolation(qw, &unit.interpolation[j * 4]);
+            }
+            unit.flags = (isVMD && static_cast<const vmd::BoneKeyframe *>(keyframe)->isIKEnabled()) ? 1 : 0;
+        }
+        appendNames(names, bytes);
+        appendUnits(units, bytes);
+    }
+    void writeBinaryCameraKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        QuadWord qw;
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kCameraKeyframe);
+        std::vector<BinaryCameraKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kCameraKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const ICameraKeyframe *keyframe = motion->findCameraKeyframeRefAt(i);
+            BinaryCameraKeyframeUnit &unit = units[i];
+            unit.timeIndex = float32(keyframe->timeIndex());
+            unit.layerIndex = keyframe->layerIndex();
+            internal::getPosition(keyframe->lookAt(), unit.lookAt);
+            internal::getPositionRaw(keyframe->angle(), unit.angle);
+            unit.fov = float32(keyframe->fov());
+            unit.distance = float32(keyframe->distance());
+            for (int j = 0; j < ICameraKeyframe::kCameraMaxInterpolationType; j++) {
+                keyframe->getInterpolationParameter(static_cast<ICameraKeyframe::InterpolationType>(j), qw);
+                getInterpolation(qw, &unit.interpolation[j * 4]);
+            }
+        }
+        appendUnits(units, bytes);
+    }
+    void writeBinaryEffectKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kEffectKeyframe);
+        std::vector<BinaryEffectKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kEffectKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const IEffectKeyframe *keyframe = motion->findEffectKeyframeRefAt(i);
+            BinaryEffectKeyframeUnit &unit = units[i];
+            unit.timeIndex = float32(keyframe->timeIndex());
+            unit.flags = (keyframe->isVisible() ? 0x1 : 0) | (keyframe->isAddBlendEnabled() ? 0x2 : 0) | (keyframe->isShadowEnabled() ? 0x4 : 0);
+            unit.scaleFactor = keyframe->scaleFactor();
+            unit.opacity = keyframe->opacity();
+        }
+        appendUnits(units, bytes);
+    }
+    void writeBinaryLightKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kLightKeyframe);
+        std::vector<BinaryLightKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kLightKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const ILightKeyframe *keyframe = motion->findLightKeyframeRefAt(i);
+            BinaryLightKeyframeUnit &unit = units[i];
+            unit.timeIndex = float32(keyframe->timeIndex());
+            internal::getPositionRaw(keyframe->color(), unit.color);
+            internal::getPosition(keyframe->direction(), unit.direction);
+        }
+        appendUnits(units, bytes);
+    }
+    void writeBinaryModelKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kModelKeyframe);
+        std::vector<BinaryModelKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kModelKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const IModelKeyframe *keyframe = motion->findModelKeyframeRefAt(i);
+            BinaryModelKeyframeUnit &unit = units[i];
+            unit.timeIndex = float32(keyframe->timeIndex());
+            unit.flags = (keyframe->isVisible() ? 0x1 : 0) | (keyframe->isAddBlendEnabled() ? 0x2 : 0)
+                    | (keyframe->isShadowEnabled() ? 0x4 : 0) | (keyframe->isPhysicsEnabled() ? 0x8 : 0);
+            unit.physicsStillMode = keyframe->physicsStillMode();
+            unit.edgeWidth = float32(keyframe->edgeWidth());
+            internal::getColor(keyframe->edgeColor(), unit.edgeColor);
+        }
+        appendUnits(units, bytes);
+    }
+    void writeBinaryMorphKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        std::map<std::string, int32> name2indices;
+        std::vector<std::string> names;
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kMorphKeyframe);
+        std::vector<BinaryMorphKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kMorphKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const IMorphKeyframe *keyframe = motion->findMorphKeyframeRefAt(i);
+            BinaryMorphKeyframeUnit &unit = units[i];
+            unit.nameIndex = findNameIndex(keyframe->name(), name2indices, names);
+            unit.timeIndex = float32(keyframe->timeIndex());
+            unit.weight = float32(keyframe->weight());
+        }
+        appendNames(names, bytes);
+        appendUnits(units, bytes);
+    }
+    void writeBinaryProjectKeyframes(const IMotion *motion, ByteArray &bytes) const {
+        const int nkeyframes = motion->countKeyframes(IKeyframe::kProjectKeyframe);
+        std::vector<BinaryProjectKeyframeUnit> units(nkeyframes);
+        appendTyped(uint8(IKeyframe::kProjectKeyframe), bytes);
+        for (int i = 0; i < nkeyframes; i++) {
+            const IProjectKeyframe *keyframe = motion->findProjectKeyframeRefAt(i);
+            BinaryProjectKeyframeUnit &unit = units[i];
+            unit.timeIndex = float32(keyframe->timeIndex());
+            unit.gravityFactor = keyframe->gravityFactor();
+            internal::getPositionRaw(keyframe->gravityDirection(), unit.gravityDirection);
+            unit.shadowMode = keyframe->shadowMode();
+            unit.shadowDepth = keyframe->shadowDepth();
+            unit.shadowDistance = keyframe->shadowDistance();
+        }
+        appendUnits(units, bytes);
+    }
+    void writeBinaryMotion(const XMLProject::UUID &motionUUID, const IMotion *motion, ByteArray &bytes) const {
+        appendString(motionUUID, bytes);
+        appendString(findModelUUID(motion->parentModelRef()), bytes);
+        appendTyped(uint8(motion->type()), bytes);
+        /* a section of each keyframe type except asset, bone and morph have a name table */
+        appendTyped(int32(IKeyframe::kMaxKeyframeType - 1), bytes);
+        writeBinaryBoneKeyframes(motion, bytes);
+        writeBinaryMorphKeyframes(motion, bytes);
+        writeBinaryCameraKeyframes(motion, bytes);
+        writeBinaryLightKeyframes(motion, bytes);
+        writeBinaryEffectKeyframes(motion, bytes);
+        writeBinaryModelKeyframes(motion, bytes);
+        writeBinaryProjectKeyframes(motion, bytes);
+    }
+    void writeBinaryModels(const char *const tag, const ModelMap &modelMap, const ModelSettings &settings,
+                           std::vector<std::string> &tags, std::vector<ByteArray> &chunks) const {
+        StringMap newModelSettings;
+        for (ModelMap::const_iterator it = modelMap.begin(); it != modelMap.end(); it++) {
+            const XMLProject::UUID &uuid = it->first;
+            ByteArray bytes;
+            appendString(uuid, bytes);
+            newModelSettings.clear();
+            ModelSettings::const_iterator it2 = settings.find(uuid);
+            if (it2 != settings.end()) {
+                getNewModelSettings(it->second, it2->second, newModelSettings);
+            }
+            appendStringMap(newModelSettings, bytes);
+            tags.push_back(tag);
+            chunks.push_back(bytes);
+        }
+    }
+    void writeBinary(ByteArray &bytes) const {
+        std::vector<std::string> tags;
+        std::vector<ByteArray> chunks;
+        ByteArray settingBytes;
+        appendStringMap(globalSettings, settingBytes);
+        tags.push_back("SETG");
+        chunks.push_back(settingBytes);
+        writeBinaryModels("MODL", modelRefs, localModelSettings, tags, chunks);
+        writeBinaryModels("ASST", assetRefs, localAssetSettings, tags, chunks);
+        for (MotionMap::const_iterator it = motionRefs.begin(); it != motionRefs.end(); it++) {
+            if (const IMotion *motion = it->second) {
+                ByteArray motionBytes;
+                writeBinaryMotion(it->first, motion, motionBytes);
+                tags.push_back("MOTN");
+                chunks.push_back(motionBytes);
+            }
+        }
+        /* motions not decoded yet are copied as is */
+        for (PendingMotionMap::const_iterator it = pendingMotions.begin(); it != pendingMotions.end(); it++) {
+            const ChunkRange &range = it->second;
+            const uint8 *ptr = &binaryData[range.first];
+            tags.push_back("MOTN");
+            chunks.push_back(ByteArray(ptr, ptr + range.second));
+        }
+        const int32 nchunks = int32(chunks.size());
+        BinaryHeaderUnit header;
+        internal::copyBytes(header.signature, kBinarySignature, sizeof(header.signature));
+        header.version = XMLProject::formatVersion();
+        header.nchunks = nchunks;
+        bytes.clear();
+        appendTyped(header, bytes);
+        int32 offset = int32(sizeof(header) + sizeof(BinaryChunkIndexUnit) * nchunks);
+        for (int32 i = 0; i < nchunks; i++) {
+            BinaryChunkIndexUnit index;
+            internal::copyBytes(index.tag, tags[i].c_str(), sizeof(index.tag));
+            index.offset = offset;
+            index.size = int32(chunks[i].size());
+            appendTyped(index, bytes);
+            offset += index.size;
+        }
+        for (int32 i = 0; i < nchunks; i++) {
+            bytes.insert(bytes.end(), chunks[i].begin(), chunks[i].end());
+        }
+    }
+
+    bool readBinaryBoneKeyframes(uint8 *&ptr, vsize &rest, const Array<IString *> &names, IMotion *motion) {
+        const BinaryBoneKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        const bool isVMD = motion->type() == IMotion::kVMDFormat;
+        const int nnames = names.count();
+        QuadWord qw;
+        Vector3 position;
+        Quaternion rotation;
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryBoneKeyframeUnit &unit = units[i];
+            if (!internal::checkBound(unit.nameIndex, 0, nnames)) {
+                VPVL2_LOG(WARNING, "Invalid name index of the keyframe: index=" << i << " name=" << unit.nameIndex);
+                return false;
+            }
+            if (IBoneKeyframe *keyframe = factoryRef->createBoneKeyframe(motion)) {
+                keyframe->setName(names[unit.nameIndex]);
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                keyframe->setLayerIndex(unit.layerIndex);
+                internal::setPosition(unit.position, position);
+                keyframe->setLocalTranslation(position);
+                internal::setRotation2(unit.rotation, rotation);
+                keyframe->setLocalOrientation(rotation);
+                for (int j = 0; j < IBoneKeyframe::kMaxBoneInterpolationType; j++) {
+                    setInterpolation(&unit.interpolation[j * 4], qw);
+                    keyframe->setInterpolationParameter(static_cast<IBoneKeyframe::InterpolationType>(j), qw);
+                }
+                if (isVMD) {
+                    static_cast<vmd::BoneKeyframe *>(keyframe)->setIKEnable((unit.flags & 0x1) != 0);
+                }
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryCameraKeyframes(uint8 *&ptr, vsize &rest, IMotion *motion) {
+        const BinaryCameraKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        QuadWord qw;
+        Vector3 value;
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryCameraKeyframeUnit &unit = units[i];
+            if (ICameraKeyframe *keyframe = factoryRef->createCameraKeyframe(motion)) {
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                keyframe->setLayerIndex(unit.layerIndex);
+                internal::setPosition(unit.lookAt, value);
+                keyframe->setLookAt(value);
+                internal::setPositionRaw(unit.angle, value);
+                keyframe->setAngle(value);
+                keyframe->setFov(unit.fov);
+                keyframe->setDistance(unit.distance);
+                for (int j = 0; j < ICameraKeyframe::kCameraMaxInterpolationType; j++) {
+                    setInterpolation(&unit.interpolation[j * 4], qw);
+                    keyframe->setInterpolationParameter(static_cast<ICameraKeyframe::InterpolationType>(j), qw);
+                }
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryEffectKeyframes(uint8 *&ptr, vsize &rest, IMotion *motion) {
+        const BinaryEffectKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryEffectKeyframeUnit &unit = units[i];
+            if (IEffectKeyframe *keyframe = factoryRef->createEffectKeyframe(motion)) {
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                keyframe->setVisible((unit.flags & 0x1) != 0);
+                keyframe->setAddBlendEnable((unit.flags & 0x2) != 0);
+                keyframe->setShadowEnable((unit.flags & 0x4) != 0);
+                keyframe->setScaleFactor(unit.scaleFactor);
+                keyframe->setOpacity(unit.opacity);
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryLightKeyframes(uint8 *&ptr, vsize &rest, IMotion *motion) {
+        const BinaryLightKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        Vector3 value;
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryLightKeyframeUnit &unit = units[i];
+            if (ILightKeyframe *keyframe = factoryRef->createLightKeyframe(motion)) {
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                internal::setPositionRaw(unit.color, value);
+                keyframe->setColor(value);
+                internal::setPosition(unit.direction, value);
+                keyframe->setDirection(value);
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryModelKeyframes(uint8 *&ptr, vsize &rest, IMotion *motion) {
+        const BinaryModelKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryModelKeyframeUnit &unit = units[i];
+            if (IModelKeyframe *keyframe = factoryRef->createModelKeyframe(motion)) {
+                const float32 *edgeColor = unit.edgeColor;
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                keyframe->setVisible((unit.flags & 0x1) != 0);
+                keyframe->setAddBlendEnable((unit.flags & 0x2) != 0);
+                keyframe->setShadowEnable((unit.flags & 0x4) != 0);
+                keyframe->setPhysicsEnable((unit.flags & 0x8) != 0);
+                keyframe->setPhysicsStillMode(unit.physicsStillMode);
+                keyframe->setEdgeWidth(IVertex::EdgeSizePrecision(unit.edgeWidth));
+                keyframe->setEdgeColor(Color(edgeColor[0], edgeColor[1], edgeColor[2], edgeColor[3]));
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryMorphKeyframes(uint8 *&ptr, vsize &rest, const Array<IString *> &names, IMotion *motion) {
+        const BinaryMorphKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        const int nnames = names.count();
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryMorphKeyframeUnit &unit = units[i];
+            if (!internal::checkBound(unit.nameIndex, 0, nnames)) {
+                VPVL2_LOG(WARNING, "Invalid name index of the keyframe: index=" << i << " name=" << unit.nameIndex);
+                return false;
+            }
+            if (IMorphKeyframe *keyframe = factoryRef->createMorphKeyframe(motion)) {
+                keyframe->setName(names[unit.nameIndex]);
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                keyframe->setWeight(IMorph::WeightPrecision(unit.weight));
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryProjectKeyframes(uint8 *&ptr, vsize &rest, IMotion *motion) {
+        const BinaryProjectKeyframeUnit *units = 0;
+        int32 nunits = 0;
+        if (!readUnits(ptr, rest, units, nunits)) {
+            return false;
+        }
+        Vector3 value;
+        for (int32 i = 0; i < nunits; i++) {
+            const BinaryProjectKeyframeUnit &unit = units[i];
+            if (IProjectKeyframe *keyframe = factoryRef->createProjectKeyframe(motion)) {
+                keyframe->setTimeIndex(IKeyframe::TimeIndex(unit.timeIndex));
+                keyframe->setGravityFactor(unit.gravityFactor);
+                internal::setPositionRaw(unit.gravityDirection, value);
+                keyframe->setGravityDirection(value);
+                keyframe->setShadowMode(unit.shadowMode);
+                keyframe->setShadowDepth(unit.shadowDepth);
+                keyframe->setShadowDistance(unit.shadowDistance);
+                motion->addKeyframe(keyframe);
+            }
+        }
+        return true;
+    }
+    bool readBinaryNames(uint8 *&ptr, vsize &rest, Array<IString *> &names) const {
+        std::string name;
+        int32 nnames = 0;
+        if (!internal::getTyped(ptr, rest, nnames)) {
+            return false;
+        }
+        for (int32 i = 0; i < nnames; i++) {
+            if (!readString(ptr, rest, name)) {
+                return false;
+            }
+            names.append(delegateRef->toStringFromStd(name));
+        }
+        return true;
+    }
+    bool readBinaryMotion(uint8 *ptr, vsize rest) {
+        XMLProject::UUID motionUUID, modelUUID;
+        uint8 type = 0;
+        int32 nsections = 0;
+        if (!readString(ptr, rest, motionUUID) || !readString(ptr, rest, modelUUID)
+                || !internal::getTyped(ptr, rest, type) || !internal::getTyped(ptr, rest, nsections)) {
+            return false;
+        }
+        IMotion *motion = factoryRef->newMotion(static_cast<IMotion::FormatType>(type), 0);
+        if (!motion) {
+            return false;
+        }
+        motion->setParentModelRef(findModel(modelUUID));
+        PointerArray<IString> names;
+        uint8 sectionType = 0;
+        bool ok = true;
+        for (int32 i = 0; i < nsections && ok; i++) {
+            ok = internal::getTyped(ptr, rest, sectionType);
+            if (!ok) {
+                break;
+            }
+            switch (static_cast<IKeyframe::Type>(sectionType)) {
+            case IKeyframe::kBoneKeyframe:
+                names.releaseAll();
+                ok = readBinaryNames(ptr, rest, names);
+                if (ok) {
+                    ok = readBinaryBoneKeyframes(ptr, rest, names, motion);
+                }
+                break;
+            case IKeyframe::kMorphKeyframe:
+                names.releaseAll();
+                ok = readBinaryNames(ptr, rest, names);
+                if (ok) {
+                    ok = readBinaryMorphKeyframes(ptr, rest, names, motion);
+                }
+                break;
+            case IKeyframe::kCameraKeyframe:
+                ok = readBinaryCameraKeyframes(ptr, rest, motion);
+                break;
+            case IKeyframe::kLightKeyframe:
+                ok = readBinaryLightKeyframes(ptr, rest, motion);
+                break;
+            case IKeyframe::kEffectKeyframe:
+                ok = readBinaryEffectKeyframes(ptr, rest, motion);
+                break;
+            case IKeyframe::kModelKeyframe:
+                ok = readBinaryModelKeyframes(ptr, rest, motion);
+                break;
+            case IKeyframe::kProjectKeyframe:
+                ok = readBinaryProjectKeyframes(ptr, rest, motion);
+                break;
+            case IKeyframe::kAssetKeyframe:
+            case IKeyframe::kMaxKeyframeType:
+            default:
+                ok = false;
+                break;
+            }
+        }
+        names.releaseAll();
+        if (!ok || motionUUID.empty() || motionUUID == XMLProject::kNullUUID) {
+            internal::deleteObject(motion);
+            return false;
+        }
+        MotionMap::iterator it = motionRefs.find(motionUUID);
+        if (it != motionRefs.end()) {
+            sceneRef->removeMotion(it->second);
+            internal::deleteObject(it->second);
+            motionRefs.erase(it);
+        }
+        motionRefs.insert(std::make_pair(motionUUID, motion));
+        motion->createFirstKeyframesUnlessFound();
+        sceneRef->addMotion(motion);
+        return true;
+    }
+    bool readBinaryModel(uint8 *ptr, vsize rest, IModel::Type type, ModelSettings &settings) {
+        XMLProject::UUID modelUUID;
+        if (!readString(ptr, rest, modelUUID) || !readStringMap(ptr, rest, settings[modelUUID])) {
+            return false;
+        }
+        if (type == IModel::kAssetModel) {
+            loadAsset(modelUUID);
+        }
+        else {
+            loadModel(modelUUID);
+        }
+        return true;
+    }
+    bool readBinary(const uint8 *data, vsize size) {
+        uint8 *ptr = const_cast<uint8 *>(data);
+        vsize rest = size;
+        BinaryHeaderUnit header;
+        if (!isBinaryFormat(data, size) || !internal::getTyped(ptr, rest, header) || header.nchunks < 0) {
+            return false;
+        }
+        const BinaryChunkIndexUnit *indices = reinterpret_cast<const BinaryChunkIndexUnit *>(ptr);
+        if (!internal::validateSize(ptr, sizeof(*indices), header.nchunks, rest)) {
+            return false;
+        }
+        char buffer[kElementContentBufferSize];
+        internal::snprintf(buffer, sizeof(buffer), "%.1f", header.version);
+        version.assign(buffer);
+        Array<const BinaryChunkIndexUnit *> motionIndices;
+        for (int32 i = 0; i < header.nchunks; i++) {
+            const BinaryChunkIndexUnit &index = indices[i];
+            if (index.offset < 0 || index.size < 0 || vsize(index.offset) + vsize(index.size) > size) {
+                return false;
+            }
+            uint8 *chunkPtr = const_cast<uint8 *>(data) + index.offset;
+            vsize chunkSize = index.size;
+            if (equalsTag(index.tag, "SETG")) {
+                if (!readStringMap(chunkPtr, chunkSize, globalSettings)) {
+                    return false;
+                }
+            }
+            else if (equalsTag(index.tag, "MODL")) {
+                if (!readBinaryModel(chunkPtr, chunkSize, IModel::kPMDModel, localModelSettings)) {
+                    return false;
+                }
+            }
+            else if (equalsTag(index.tag, "ASST")) {
+                if (!readBinaryModel(chunkPtr, chunkSize, IModel::kAssetModel, localAssetSettings)) {
+                    return false;
+                }
+            }
+            else if (equalsTag(index.tag, "MOTN")) {
+                /* motions refer models by UUID so they are read after all models are loaded */
+                motionIndices.append(&index);
+            }
+            /* unknown chunks are skipped for forward compatibility */
+        }
+        const int nmotions = motionIndices.count();
+        if (enableMotionLazyLoad && nmotions > 0) {
+            binaryData.assign(data, data + size);
+            XMLProject::UUID motionUUID;
+            for (int i = 0; i < nmotions; i++) {
+                const BinaryChunkIndexUnit *index = motionIndices[i];
+                uint8 *chunkPtr = &binaryData[index->offset];
+                vsize chunkSize = index->size;
+                if (!readString(chunkPtr, chunkSize, motionUUID)) {
+                    return false;
+                }
+                pendingMotions[motionUUID] = ChunkRange(index->offset, index->size);
+            }
+        }
+        else {
+            for (int i = 0; i < nmotions; i++) {
+                const BinaryChunkIndexUnit *index = motionIndices[i];
+                if (!readBinaryMotion(const_cast<uint8 *>(data) + index->offset, index->size)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    bool loadPendingMotion(const XMLProject::UUID &value) {
+        PendingMotionMap::iterator it = pendingMotions.find(value);
+        if (it != pendingMotions.end()) {
+            const ChunkRange range = it->second;
+            pendingMotions.erase(it);
+            bool ret = readBinaryMotion(&binaryData[range.first], range.second);
+            if (pendingMotions.empty()) {
+                ByteArray().swap(binaryData);
+            }
+            return ret;
+        }
+        return false;
+    }
+    void loadAllPendingMotions() {
+        while (!pendingMotions.empty()) {
+            loadPendingMotion(pendingMotions.begin()->first);
+        }
+    }
+
     bool visitReadEnter(const XMLElement &element, const XMLAttribute *firstAttribute) {
         if (depth == 0 && equalsToElement(element, "vpvm:project")) {
             readVersion(firstAttribute);
@@ -1562,29 +2293,35 @@ struct XMLProject::PrivateContext {
         }
     }
 
-    void addAsset() {
-        if (!uuid.empty() && uuid != XMLProject::kNullUUID && assetRefs.find(uuid) == assetRefs.end()) {
+    void loadAsset(const XMLProject::UUID &value) {
+        if (!value.empty() && value != XMLProject::kNullUUID && assetRefs.find(value) == assetRefs.end()) {
             IModel *assetPtr = 0;
             IRenderEngine *enginePtr = 0;
             int priority = 0;
-            if (delegateRef->loadModel(uuid, localAssetSettings[uuid], IModel::kAssetModel, assetPtr, enginePtr, priority)) {
-                assetRefs.insert(std::make_pair(uuid, assetPtr));
+            if (delegateRef->loadModel(value, localAssetSettings[value], IModel::kAssetModel, assetPtr, enginePtr, priority)) {
+                assetRefs.insert(std::make_pair(value, assetPtr));
                 sceneRef->addModel(assetPtr, enginePtr, priority);
             }
         }
-        popState(kAssets);
-        uuid.clear();
     }
-    void addModel() {
-        if (!uuid.empty() && uuid != XMLProject::kNullUUID && modelRefs.find(uuid) == modelRefs.end()) {
+    void loadModel(const XMLProject::UUID &value) {
+        if (!value.empty() && value != XMLProject::kNullUUID && modelRefs.find(value) == modelRefs.end()) {
             IModel *modelPtr = 0;
             IRenderEngine *enginePtr = 0;
             int priority = 0;
-            if (delegateRef->loadModel(uuid, localModelSettings[uuid], IModel::kPMDModel, modelPtr, enginePtr, priority)) {
-                modelRefs.insert(std::make_pair(uuid, modelPtr));
+            if (delegateRef->loadModel(value, localModelSettings[value], IModel::kPMDModel, modelPtr, enginePtr, priority)) {
+                modelRefs.insert(std::make_pair(value, modelPtr));
                 sceneRef->addModel(modelPtr, enginePtr, priority);
             }
         }
+    }
+    void addAsset() {
+        loadAsset(uuid);
+        popState(kAssets);
+        uuid.clear();
+    }
+    void addModel() {
+        loadModel(uuid);
         popState(kModels);
         uuid.clear();
     }
@@ -1617,7 +2354,7 @@ struct XMLProject::PrivateContext {
         popState(kMotions);
     }
 
-    bool save(XMLPrinter &printer) {
+    void saveSceneStates() {
         const ICamera *camera = sceneRef->cameraRef();
         globalSettings["state.camera.angle"] = XMLProject::toStringFromVector3(camera->angle());
         globalSettings["state.camera.distance"] = XMLProject::toStringFromFloat32(camera->distance());
@@ -1626,6 +2363,11 @@ struct XMLProject::PrivateContext {
         const ILight *light = sceneRef->lightRef();
         globalSettings["state.light.color"] = XMLProject::toStringFromVector3(light->color());
         globalSettings["state.light.direction"] = XMLProject::toStringFromVector3(light->direction());
+    }
+    bool save(XMLPrinter &printer) {
+        /* XML form has no index, so all motions must be decoded before writing */
+        loadAllPendingMotions();
+        saveSceneStates();
         bool ret = writeXml(printer);
         if (ret) {
             dirty = false;
@@ -1817,15 +2559,19 @@ struct XMLProject::PrivateContext {
     std::string settingKey;
     std::string parentModel;
     XMLProject::UUID uuid;
+    ByteArray binaryData;
+    PendingMotionMap pendingMotions;
     const IString *currentString;
     IMotion *currentMotion;
     IMotion::FormatType currentMotionType;
     State state;
     int depth;
     bool dirty;
+    bool enableMotionLazyLoad;
 };
 
 const std::string XMLProject::PrivateContext::kEmpty = "";
+const uint8 XMLProject::PrivateContext::kBinarySignature[] = { 'V', 'P', 'V', 'B' };
 const XMLProject::UUID XMLProject::kNullUUID = "{00000000-0000-0000-0000-000000000000}";
 const std::string XMLProject::kSettingNameKey = "name";
 const std::string XMLProject::kSettingURIKey = "uri";
@@ -1837,6 +2583,12 @@ float32 XMLProject::formatVersion()
     return 2.1f;
 }
 
+bool XMLProject::isBinaryFormat(const uint8 *data, vsize size)
+{
+    return data && size >= sizeof(BinaryHeaderUnit)
+            && std::memcmp(data, PrivateContext::kBinarySignature, sizeof(BinaryHeaderUnit().signature)) == 0;
+}
+
 bool XMLProject::isReservedSettingKey(const std::string &key)
 {
     return key.find(kSettingNameKey) == 0 || key.find(kSettingURIKey) == 0 || key.find(kSettingOrderKey) == 0;
@@ -1924,6 +2676,11 @@ XMLProject::~XMLProject()
 
 bool XMLProject::load(const char *path)
 {
+    internal::MappedFile file;
+    if (file.open(path) && isBinaryFormat(file.address(), file.size())) {
+        return load(file.address(), file.size());
+    }
+    file.close();
     tinyxml2::XMLDocument document;
     bool ret = false;
     if (document.LoadFile(path) == XML_NO_ERROR) {
@@ -1944,7 +2701,17 @@ bool XMLProject::load(const uint8 *data, vsize size)
 {
     tinyxml2::XMLDocument document;
     bool ret = false;
-    if (document.Parse(reinterpret_cast<const char *>(data), size) == XML_NO_ERROR) {
+    if (isBinaryFormat(data, size)) {
+        ret = m_context->readBinary(data, size) && m_context->checkDuplicateUUID();
+        if (ret) {
+            m_context->sort();
+            m_context->restoreStates();
+        }
+        else {
+            VPVL2_LOG(WARNING, "Cannot load binary project from memory: size=" << size);
+        }
+    }
+    else if (document.Parse(reinterpret_cast<const char *>(data), size) == XML_NO_ERROR) {
         PrivateContext::Reader reader(m_context);
         ret = m_context->validate(document.Accept(&reader));
         if (ret) {
@@ -1969,12 +2736,55 @@ bool XMLProject::save(const char *path)
     return false;
 }
 
+bool XMLProject::saveBinary(const char *path)
+{
+    if (FILE *fp = fopen(path, "wb")) {
+        PrivateContext::ByteArray bytes;
+        m_context->saveSceneStates();
+        m_context->writeBinary(bytes);
+        bool ret = fwrite(&bytes[0], 1, bytes.size(), fp) == bytes.size();
+        fclose(fp);
+        if (ret) {
+            m_context->dirty = false;
+        }
+        return ret;
+    }
+    return false;
+}
+
 void XMLProject::clear()
 {
     IDelegate *delegateRef = m_context->delegateRef;
     Factory *factoryRef = m_context->factoryRef;
+    bool enableMotionLazyLoad = m_context->enableMotionLazyLoad;
     internal::deleteObject(m_context);
     m_context = new PrivateContext(this, delegateRef, factoryRef);
+    m_context->enableMotionLazyLoad = enableMotionLazyLoad;
+}
+
+bool XMLProject::loadMotion(const UUID &uuid)
+{
+    return m_context->loadPendingMotion(uuid);
+}
+
+const XMLProject::UUIDList XMLProject::pendingMotionUUIDs() const
+{
+    const PrivateContext::PendingMotionMap &motions = m_context->pendingMotions;
+    XMLProject::UUIDList uuids;
+    for (PrivateContext::PendingMotionMap::const_iterator it = motions.begin(); it != motions.end(); it++) {
+        uuids.push_back(it->first);
+    }
+    return uuids;
+}
+
+bool XMLProject::isMotionLazyLoadEnabled() const
+{
+    return m_context->enableMotionLazyLoad;
+}
+
+void XMLProject::setMotionLazyLoadEnable(bool value)
+{
+    m_context->enableMotionLazyLoad = value;
 }
 
 std::string XMLProject::version() const
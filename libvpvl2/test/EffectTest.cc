@@ -537,6 +537,25 @@ TEST_F(EffectTest, FindTechniques)
     ASSERT_STREQ("MainTecBS0", engine.findTechnique("object_ss", 16, 42, false, false, false)->name());
 }
 
+TEST_F(EffectTest, FindTechniquesFromTable)
+{
+    MockIApplicationContext applicationContext;
+    Scene scene(true);
+    CGeffect effectPtr;
+    std::unique_ptr<cg::Effect> ptr(createEffect(":effects/techniques.cgfx", scene, applicationContext, effectPtr));
+    EXPECT_CALL(applicationContext, findProcedureAddress(_)).Times(AnyNumber()).WillRepeatedly(Return(static_cast<void *>(0)));
+    MockEffectEngine engine(&scene, ptr.data(), &applicationContext);
+    /* second lookups are resolved from the technique table and must return the same technique */
+    for (int i = 0; i < 2; i++) {
+        ASSERT_STREQ("MainTec7",   engine.findTechnique("object",     1, 42, true,  true,  true)->name());
+        ASSERT_STREQ("MainTec0",   engine.findTechnique("object",     8, 42, false, false, false)->name());
+        ASSERT_STREQ("MainTecBS7", engine.findTechnique("object_ss",  9, 42, true,  true,  true)->name());
+        ASSERT_STREQ("MainTec0",   engine.findTechnique("object",     1, 42, false, false, false)->name());
+    }
+    /* changing number of materials rebuilds the table */
+    ASSERT_STREQ("MainTec7", engine.findTechnique("object", 1, 43, true, true, true)->name());
+}
+
 class FindTechnique : public EffectTest, public WithParamInterface< tuple<int, int, bool, bool, bool> > {};
 
 TEST_P(FindTechnique, TestEdge)
@@ -133,6 +133,38 @@ TEST_P(ConvertTest, DetectCodec)
     ASSERT_EQ(codecEnum, encoding.detectCodec(bytes.constData(), bytes.length()));
 }
 
+TEST(EncodingTest, InternSymbols)
+{
+    Encoding encoding(0);
+    const QString source("センター");
+    const QByteArray &sjis = QTextCodec::codecForName("Shift-JIS")->fromUnicode(source), &utf8 = source.toUtf8();
+    const uint8 *sjisInBytes = reinterpret_cast<const uint8 *>(sjis.constData());
+    const uint8 *utf8InBytes = reinterpret_cast<const uint8 *>(utf8.constData());
+    std::unique_ptr<IString> s1(encoding.toString(sjisInBytes, sjis.length(), IString::kShiftJIS));
+    std::unique_ptr<IString> s2(encoding.toString(sjisInBytes, sjis.length(), IString::kShiftJIS));
+    std::unique_ptr<IString> s3(encoding.toString(utf8InBytes, utf8.length(), IString::kUTF8));
+    ASSERT_EQ(2, encoding.symbolTable()->countSymbols());
+    ASSERT_EQ(0, encoding.symbolTable()->countIdentifiers());
+    ASSERT_STREQ(utf8.constData(), s3->toHashString().m_string);
+    ASSERT_EQ(1, encoding.symbolTable()->countIdentifiers());
+    ASSERT_TRUE(s1->equals(s2.get()));
+    ASSERT_TRUE(s1->equals(s3.get()));
+    ASSERT_EQ(1, encoding.symbolTable()->countIdentifiers());
+    ASSERT_EQ(s1->toHashString().m_string, s3->toHashString().m_string);
+    ASSERT_EQ(TO_CSTRING(s1)->symbolId(), TO_CSTRING(s3)->symbolId());
+    /* symbols are removed with the last string referring them */
+    std::unique_ptr<IString> s4(s1->clone());
+    s1.reset();
+    s2.reset();
+    ASSERT_EQ(2, encoding.symbolTable()->countSymbols());
+    s4.reset();
+    ASSERT_EQ(1, encoding.symbolTable()->countSymbols());
+    ASSERT_EQ(1, encoding.symbolTable()->countIdentifiers());
+    s3.reset();
+    ASSERT_EQ(0, encoding.symbolTable()->countSymbols());
+    ASSERT_EQ(0, encoding.symbolTable()->countIdentifiers());
+}
+
 TEST(EncodingTest, StringConstant)
 {
     Encoding encoding(0);
@@ -47,6 +47,19 @@ TEST(FactoryTest, CreateEmptyModels)
     ASSERT_TRUE(dynamic_cast<asset::Model *>(asset.get()));
 }
 
+TEST(FactoryTest, PropagateParallelLoadToPMXModel)
+{
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    ASSERT_FALSE(factory.isParallelLoadEnabled());
+    std::unique_ptr<IModel> serial(factory.newModel(IModel::kPMXModel));
+    ASSERT_FALSE(static_cast<pmx::Model *>(serial.get())->isParallelLoadEnabled());
+    factory.setParallelLoadEnable(true);
+    ASSERT_TRUE(factory.isParallelLoadEnabled());
+    std::unique_ptr<IModel> parallel(factory.newModel(IModel::kPMXModel));
+    ASSERT_TRUE(static_cast<pmx::Model *>(parallel.get())->isParallelLoadEnabled());
+}
+
 TEST(FactoryTest, CreateEmptyMotions)
 {
     Encoding encoding(0);
@@ -114,6 +127,51 @@ TEST(FactoryTest, CreateEmptyMorphKeyframes)
     ASSERT_TRUE(dynamic_cast<mvd::MorphKeyframe *>(mmk.get()));
 }
 
+TEST(FactoryTest, CreateFromMappedFile)
+{
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    bool ok = true;
+    ASSERT_EQ(static_cast<IModel *>(0), factory.createModelFromFile("not_found.pmx", ok));
+    ASSERT_FALSE(ok);
+    ok = true;
+    ASSERT_EQ(static_cast<IMotion *>(0), factory.createMotionFromFile("not_found.vmd", 0, ok));
+    ASSERT_FALSE(ok);
+    /* builds a motion file with one bone keyframe so the mapped file path is always tested */
+    String name("bone");
+    pmx::Model model(&encoding);
+    IBone *bone = model.createBone();
+    bone->setName(&name, IEncoding::kDefaultLanguage);
+    model.addBone(bone);
+    vmd::BoneKeyframe keyframe(&encoding);
+    keyframe.setName(&name);
+    keyframe.setTimeIndex(42);
+    QByteArray keyframeBytes(int(vmd::BoneKeyframe::strideSize()), 0);
+    keyframe.write(reinterpret_cast<uint8 *>(keyframeBytes.data()));
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    QDataStream stream(&buffer);
+    buffer.open(QBuffer::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    const char header[vmd::Motion::kSignatureSize + vmd::Motion::kNameSize] = "Vocaloid Motion Data 0002";
+    stream.writeRawData(header, sizeof(header));
+    stream << qint32(1);
+    stream.writeRawData(keyframeBytes.constData(), keyframeBytes.size());
+    /* morph, camera and light keyframes */
+    stream << qint32(0) << qint32(0) << qint32(0);
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    ASSERT_EQ(qint64(bytes.size()), file.write(bytes));
+    ASSERT_TRUE(file.flush());
+    std::unique_ptr<IMotion> expected(factory.createMotion(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size(), &model, ok));
+    ASSERT_TRUE(ok);
+    std::unique_ptr<IMotion> actual(factory.createMotionFromFile(file.fileName().toUtf8().constData(), &model, ok));
+    ASSERT_TRUE(ok);
+    ASSERT_GT(expected->countKeyframes(IKeyframe::kBoneKeyframe), 0);
+    ASSERT_EQ(expected->countKeyframes(IKeyframe::kBoneKeyframe), actual->countKeyframes(IKeyframe::kBoneKeyframe));
+    ASSERT_EQ(expected->countKeyframes(IKeyframe::kMorphKeyframe), actual->countKeyframes(IKeyframe::kMorphKeyframe));
+}
+
 class FactoryModelTest : public TestWithParam<IModel::Type> {};
 
 TEST_P(FactoryModelTest, StopInfiniteParentModelLoop)
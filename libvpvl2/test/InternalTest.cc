@@ -1,8 +1,10 @@
 #include "Common.h"
 #include "vpvl2/extensions/icu4c/Encoding.h"
 #include "vpvl2/extensions/icu4c/String.h"
+#include "vpvl2/internal/Arena.h"
 #include "vpvl2/internal/MotionHelper.h"
 #include "vpvl2/internal/util.h"
+#include "vpvl2/vmd/BoneKeyframe.h"
 #include <limits>
 
 using namespace ::testing;
@@ -17,6 +19,87 @@ TEST(InternalTest, Lerp)
     ASSERT_EQ(3.0, vpvl2::internal::MotionHelper::lerp(4, 2, 0.5));
 }
 
+namespace {
+
+/* the linear search implementation of MotionHelper::findKeyframeIndices used as a reference */
+template<typename T>
+static void FindKeyframeIndicesLinear(const IKeyframe::TimeIndex &seekIndex,
+                                      int &lastIndex,
+                                      int &fromIndex,
+                                      int &toIndex,
+                                      const Array<T *> &keyframes)
+{
+    const int nframes = keyframes.count();
+    const IKeyframe::TimeIndex &currentKeyframe = btMin(seekIndex, keyframes[nframes - 1]->timeIndex());
+    fromIndex = toIndex = 0;
+    if (currentKeyframe >= keyframes[lastIndex]->timeIndex()) {
+        for (int i = lastIndex; i < nframes; i++) {
+            if (currentKeyframe <= keyframes[i]->timeIndex()) {
+                toIndex = i;
+                break;
+            }
+        }
+    }
+    else {
+        for (int i = 0; i <= lastIndex && i < nframes; i++) {
+            if (currentKeyframe <= keyframes[i]->timeIndex()) {
+                toIndex = i;
+                break;
+            }
+        }
+    }
+    fromIndex = toIndex <= 1 ? 0 : toIndex - 1;
+    lastIndex = fromIndex;
+}
+
+}
+
+TEST(InternalTest, FindKeyframeIndices)
+{
+    Encoding encoding(0);
+    PointerArray<vmd::BoneKeyframe> keyframes;
+    for (int i = 0; i < 1000; i++) {
+        vmd::BoneKeyframe *keyframe = keyframes.append(new vmd::BoneKeyframe(&encoding));
+        keyframe->setTimeIndex(i * 3 + (i % 2));
+    }
+    const int duration = int(keyframes[keyframes.count() - 1]->timeIndex());
+    IKeyframe::TimeIndex currentTimeIndex = 0;
+    int lastIndex = 0, expectedLastIndex = 0, fromIndex = 0, toIndex = 0, expectedFromIndex = 0, expectedToIndex = 0;
+    /* sequential playback including seeking beyond the last keyframe */
+    for (int i = 0; i < duration + 10; i++) {
+        const IKeyframe::TimeIndex timeIndex(i);
+        MotionHelper::findKeyframeIndices(timeIndex, currentTimeIndex, lastIndex, fromIndex, toIndex, keyframes);
+        FindKeyframeIndicesLinear(timeIndex, expectedLastIndex, expectedFromIndex, expectedToIndex, keyframes);
+        ASSERT_EQ(expectedFromIndex, fromIndex);
+        ASSERT_EQ(expectedToIndex, toIndex);
+        ASSERT_EQ(expectedLastIndex, lastIndex);
+        ASSERT_EQ(IKeyframe::TimeIndex(btMin(i, duration)), currentTimeIndex);
+    }
+    /* backward playback */
+    for (int i = duration; i >= 0; i--) {
+        const IKeyframe::TimeIndex timeIndex(i);
+        MotionHelper::findKeyframeIndices(timeIndex, currentTimeIndex, lastIndex, fromIndex, toIndex, keyframes);
+        FindKeyframeIndicesLinear(timeIndex, expectedLastIndex, expectedFromIndex, expectedToIndex, keyframes);
+        ASSERT_EQ(expectedFromIndex, fromIndex);
+        ASSERT_EQ(expectedToIndex, toIndex);
+    }
+    /* random seek */
+    uint32 seed = 42;
+    for (int i = 0; i < 10000; i++) {
+        seed = seed * 1103515245 + 12345;
+        const IKeyframe::TimeIndex timeIndex((seed >> 8) % uint32(duration + 10));
+        MotionHelper::findKeyframeIndices(timeIndex, currentTimeIndex, lastIndex, fromIndex, toIndex, keyframes);
+        FindKeyframeIndicesLinear(timeIndex, expectedLastIndex, expectedFromIndex, expectedToIndex, keyframes);
+        ASSERT_EQ(expectedFromIndex, fromIndex);
+        ASSERT_EQ(expectedToIndex, toIndex);
+    }
+    /* out of bound cursor (e.g. keyframes are removed) should be recovered */
+    lastIndex = keyframes.count() + 1;
+    MotionHelper::findKeyframeIndices(IKeyframe::TimeIndex(5), currentTimeIndex, lastIndex, fromIndex, toIndex, keyframes);
+    ASSERT_EQ(1, fromIndex);
+    ASSERT_EQ(2, toIndex);
+}
+
 TEST(InternalTest, Size32)
 {
     QByteArray bytes;
@@ -58,6 +141,74 @@ TEST(InternalTest, ClearAll)
     ASSERT_EQ(0, hash.count());
 }
 
+namespace {
+
+struct ArenaObject {
+    VPVL2_DECLARE_ARENA_ALLOCATABLE()
+    ArenaObject() : value(42) {}
+    Vector3 position;
+    int value;
+};
+
+}
+
+TEST(InternalTest, AllocateFromArena)
+{
+    Arena::Statistics statistics;
+    {
+        Arena arena;
+        Array<ArenaObject *> objects;
+        for (int i = 0; i < 16; i++) {
+            ArenaObject *object = new (&arena) ArenaObject();
+            /* SIMD types in the object must be aligned */
+            ASSERT_EQ(vsize(0), reinterpret_cast<vsize>(&object->position) % 16);
+            ASSERT_EQ(42, object->value);
+            objects.append(object);
+        }
+        arena.getStatistics(statistics);
+        ASSERT_EQ(1, statistics.nblocks);
+        ASSERT_EQ(16, statistics.nobjects);
+        ASSERT_EQ(16, statistics.nliveObjects);
+        ASSERT_GE(statistics.reservedBytes, statistics.usedBytes);
+        ASSERT_EQ(vsize(0), statistics.releasedBytes);
+        objects.releaseAll();
+        arena.getStatistics(statistics);
+        ASSERT_EQ(0, statistics.nliveObjects);
+        ASSERT_EQ(statistics.usedBytes, statistics.releasedBytes);
+    }
+    /* objects allocated without arena are allocated from the heap */
+    ArenaObject *object = new ArenaObject();
+    ASSERT_EQ(42, object->value);
+    delete object;
+    ArenaObject *nullArenaObject = new (static_cast<Arena *>(0)) ArenaObject();
+    ASSERT_EQ(42, nullArenaObject->value);
+    delete nullArenaObject;
+}
+
+TEST(InternalTest, ReleaseArenaObjectAfterArena)
+{
+    ArenaObject *object = 0;
+    {
+        Arena arena;
+        object = new (&arena) ArenaObject();
+        delete new (&arena) ArenaObject();
+        /* reset detaches blocks still used by the object */
+        arena.reset();
+        Arena::Statistics statistics;
+        arena.getStatistics(statistics);
+        ASSERT_EQ(0, statistics.nblocks);
+        ASSERT_EQ(0, statistics.nobjects);
+        ArenaObject *object2 = new (&arena) ArenaObject();
+        ASSERT_EQ(42, object2->value);
+        delete object2;
+    }
+    /* the object taken out of the arena is still valid after the arena is destroyed */
+    ASSERT_EQ(42, object->value);
+    object->value = 24;
+    ASSERT_EQ(24, object->value);
+    delete object;
+}
+
 TEST(InternalTest, Version)
 {
     ASSERT_TRUE(isLibraryVersionCorrect(VPVL2_VERSION));
@@ -457,6 +457,109 @@ TEST(ProjectTest, Save)
     TestMorphMotion(motion3);
 }
 
+TEST(ProjectTest, SaveBinary)
+{
+    Delegate delegate;
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    XMLProject project(&delegate, &factory, true);
+    ASSERT_TRUE(project.load("../../docs/project.xml"));
+    QTemporaryFile file;
+    file.open();
+    file.setAutoRemove(true);
+    project.setDirty(true);
+    ASSERT_TRUE(project.saveBinary(file.fileName().toUtf8()));
+    ASSERT_FALSE(project.isDirty());
+    QByteArray bytes = file.readAll();
+    ASSERT_TRUE(XMLProject::isBinaryFormat(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+    XMLProject project2(&delegate, &factory, true);
+    ASSERT_TRUE(project2.load(file.fileName().toUtf8()));
+    ASSERT_EQ(vsize(4), project2.modelUUIDs().size());
+    ASSERT_EQ(vsize(3), project2.motionUUIDs().size());
+    TestGlobalSettings(project2);
+    TestLocalSettings(project2);
+    /* VMD motion for model */
+    IMotion *motion = project2.findMotion(kMotion1UUID);
+    ASSERT_EQ(project2.findModel(kModel1UUID), motion->parentModelRef());
+    ASSERT_EQ(IMotion::kVMDFormat, motion->type());
+    TestBoneMotion(motion, false);
+    TestMorphMotion(motion);
+    TestCameraMotion(motion, false);
+    TestLightMotion(motion);
+    /* MVD motion */
+    IMotion *motion2 = project2.findMotion(kMotion2UUID);
+    ASSERT_EQ(IMotion::kMVDFormat, motion2->type());
+    ASSERT_EQ(project2.findModel(kModel2UUID), motion2->parentModelRef());
+    TestBoneMotion(motion2, true);
+    TestMorphMotion(motion2);
+    TestCameraMotion(motion2, true);
+    TestLightMotion(motion2);
+    TestEffectMotion(motion2);
+    TestModelMotion(motion2);
+    TestProjectMotion(motion2);
+    /* converting back to XML should keep the content */
+    QTemporaryFile file2;
+    file2.open();
+    file2.setAutoRemove(true);
+    ASSERT_TRUE(project2.save(file2.fileName().toUtf8()));
+    XMLProject project3(&delegate, &factory, true);
+    ASSERT_TRUE(project3.load(file2.fileName().toUtf8()));
+    ASSERT_EQ(vsize(3), project3.motionUUIDs().size());
+    TestBoneMotion(project3.findMotion(kMotion2UUID), true);
+}
+
+TEST(ProjectTest, SaveBinaryRoundTrip)
+{
+    Delegate delegate;
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    XMLProject project(&delegate, &factory, true);
+    ASSERT_TRUE(project.load("../../docs/project.xml"));
+    QTemporaryFile expected, binary, actual;
+    expected.open();
+    expected.setAutoRemove(true);
+    binary.open();
+    binary.setAutoRemove(true);
+    actual.open();
+    actual.setAutoRemove(true);
+    /* save -> load -> save should produce the same XML as the original output */
+    ASSERT_TRUE(project.save(expected.fileName().toUtf8()));
+    ASSERT_TRUE(project.saveBinary(binary.fileName().toUtf8()));
+    XMLProject project2(&delegate, &factory, true);
+    ASSERT_TRUE(project2.load(binary.fileName().toUtf8()));
+    ASSERT_TRUE(project2.save(actual.fileName().toUtf8()));
+    const QByteArray &expectedBytes = expected.readAll(), &actualBytes = actual.readAll();
+    ASSERT_FALSE(expectedBytes.isEmpty());
+    ASSERT_EQ(expectedBytes, actualBytes);
+}
+
+TEST(ProjectTest, LoadBinaryLazily)
+{
+    Delegate delegate;
+    Encoding encoding(0);
+    Factory factory(&encoding);
+    XMLProject project(&delegate, &factory, true);
+    ASSERT_TRUE(project.load("../../docs/project.xml"));
+    QTemporaryFile file;
+    file.open();
+    file.setAutoRemove(true);
+    ASSERT_TRUE(project.saveBinary(file.fileName().toUtf8()));
+    XMLProject project2(&delegate, &factory, true);
+    project2.setMotionLazyLoadEnable(true);
+    ASSERT_TRUE(project2.load(file.fileName().toUtf8()));
+    ASSERT_EQ(vsize(4), project2.modelUUIDs().size());
+    ASSERT_EQ(vsize(0), project2.motionUUIDs().size());
+    ASSERT_EQ(vsize(3), project2.pendingMotionUUIDs().size());
+    ASSERT_TRUE(project2.loadMotion(kMotion2UUID));
+    ASSERT_FALSE(project2.loadMotion(kMotion2UUID));
+    ASSERT_EQ(vsize(1), project2.motionUUIDs().size());
+    ASSERT_EQ(vsize(2), project2.pendingMotionUUIDs().size());
+    IMotion *motion2 = project2.findMotion(kMotion2UUID);
+    ASSERT_EQ(project2.findModel(kModel2UUID), motion2->parentModelRef());
+    TestBoneMotion(motion2, true);
+    TestMorphMotion(motion2);
+}
+
 TEST(ProjectTest, HandleAssets)
 {
     const QString &uuid = QUuid::createUuid().toString();
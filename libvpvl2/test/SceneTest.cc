@@ -4,6 +4,7 @@
 #include "vpvl2/IApplicationContext.h"
 #include "vpvl2/extensions/icu4c/Encoding.h"
 #include "mock/ApplicationContext.h"
+#include "mock/Bone.h"
 #include "mock/Model.h"
 #include "mock/Motion.h"
 #include "mock/RenderEngine.h"
@@ -19,8 +20,13 @@
 #include "vpvl2/fx/PMXRenderEngine.h"
 #include "vpvl2/gl2/AssetRenderEngine.h"
 #include "vpvl2/gl2/PMXRenderEngine.h"
+#include "vpvl2/gl/VertexBundle.h"
 #include "vpvl2/extensions/World.h"
 
+#include <BulletCollision/CollisionShapes/btSphereShape.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <LinearMath/btDefaultMotionState.h>
+
 using namespace ::testing;
 using namespace std::tr1;
 using namespace vpvl2;
@@ -32,6 +38,98 @@ struct MockResolver : IApplicationContext::FunctionResolver {
     int query(QueryType /* type */) const { return 0; }
 } g_resolver;
 
+struct UploadStatisticsResolver : IApplicationContext::FunctionResolver {
+    static gl::GLenum waitResult;
+    static int nmaps;
+    static int nwrites;
+    static vsize dynamicBufferSize;
+    static Array<uint8> mappedBytes;
+    static void GLAPIENTRY genBuffers(gl::GLsizei n, gl::GLuint *buffers) {
+        static gl::GLuint name = 0;
+        for (int i = 0; i < n; i++) {
+            buffers[i] = ++name;
+        }
+    }
+    static void GLAPIENTRY bindBuffer(gl::GLenum /* target */, gl::GLuint /* buffer */) {}
+    static void GLAPIENTRY bufferData(gl::GLenum /* target */, gl::GLsizeiptr size, const gl::GLvoid * /* data */, gl::GLenum usage) {
+        if (usage == gl::VertexBundle::kGL_STREAM_DRAW) {
+            dynamicBufferSize = size;
+        }
+    }
+    static void GLAPIENTRY bufferSubData(gl::GLenum /* target */, gl::GLintptr /* offset */, gl::GLsizeiptr /* size */, const gl::GLvoid * /* data */) {
+        nwrites++;
+    }
+    static void GLAPIENTRY deleteBuffers(gl::GLsizei /* n */, const gl::GLuint * /* buffers */) {}
+    static gl::GLvoid *GLAPIENTRY mapBufferRange(gl::GLenum /* target */, gl::GLintptr /* offset */, gl::GLsizeiptr length, gl::GLbitfield access) {
+        if (access & gl::VertexBundle::kGL_MAP_UNSYNCHRONIZED_BIT) {
+            nmaps++;
+        }
+        mappedBytes.resize(int(length));
+        return &mappedBytes[0];
+    }
+    static gl::GLboolean GLAPIENTRY unmapBuffer(gl::GLenum /* target */) { return 1; }
+    static gl::GLsync GLAPIENTRY fenceSync(gl::GLenum /* condition */, gl::GLbitfield /* flags */) {
+        static int fence = 0;
+        return reinterpret_cast<gl::GLsync>(++fence);
+    }
+    static gl::GLenum GLAPIENTRY clientWaitSync(gl::GLsync /* sync */, gl::GLbitfield flags, gl::GLuint64 /* timeout */) {
+        /* the first poll always expires to force waiting for the fence */
+        return flags ? waitResult : gl::VertexBundle::kGL_TIMEOUT_EXPIRED;
+    }
+    static void GLAPIENTRY deleteSync(gl::GLsync /* sync */) {}
+    static gl::GLuint GLAPIENTRY createObject() { return 1; }
+    static gl::GLuint GLAPIENTRY createShader(gl::GLenum /* type */) { return 1; }
+    static void GLAPIENTRY shaderSource(gl::GLuint /* shader */, gl::GLsizei /* count */, const gl::GLchar ** /* strings */, const gl::GLint * /* lengths */) {}
+    static void GLAPIENTRY handleObject(gl::GLuint /* object */) {}
+    static void GLAPIENTRY getObjectiv(gl::GLuint /* object */, gl::GLenum /* pname */, gl::GLint *param) { *param = 1; }
+    static void GLAPIENTRY attachShader(gl::GLuint /* program */, gl::GLuint /* shader */) {}
+    static void GLAPIENTRY bindAttribLocation(gl::GLuint /* program */, gl::GLuint /* index */, const gl::GLchar * /* name */) {}
+    static gl::GLint GLAPIENTRY getUniformLocation(gl::GLuint /* program */, const gl::GLchar * /* name */) { return -1; }
+
+    bool hasExtension(const char *name) const {
+        return strcmp(name, "ARB_map_buffer_range") == 0 || strcmp(name, "ARB_sync") == 0;
+    }
+    void *resolveSymbol(const char *name) const {
+        static const struct { const char *name; void *function; } kFunctions[] = {
+            { "glGenBuffers", reinterpret_cast<void *>(genBuffers) },
+            { "glBindBuffer", reinterpret_cast<void *>(bindBuffer) },
+            { "glBufferData", reinterpret_cast<void *>(bufferData) },
+            { "glBufferSubData", reinterpret_cast<void *>(bufferSubData) },
+            { "glDeleteBuffers", reinterpret_cast<void *>(deleteBuffers) },
+            { "glMapBufferRange", reinterpret_cast<void *>(mapBufferRange) },
+            { "glUnmapBuffer", reinterpret_cast<void *>(unmapBuffer) },
+            { "glFenceSync", reinterpret_cast<void *>(fenceSync) },
+            { "glClientWaitSync", reinterpret_cast<void *>(clientWaitSync) },
+            { "glDeleteSync", reinterpret_cast<void *>(deleteSync) },
+            { "glCreateProgram", reinterpret_cast<void *>(createObject) },
+            { "glCreateShader", reinterpret_cast<void *>(createShader) },
+            { "glShaderSource", reinterpret_cast<void *>(shaderSource) },
+            { "glCompileShader", reinterpret_cast<void *>(handleObject) },
+            { "glDeleteShader", reinterpret_cast<void *>(handleObject) },
+            { "glDeleteProgram", reinterpret_cast<void *>(handleObject) },
+            { "glLinkProgram", reinterpret_cast<void *>(handleObject) },
+            { "glUseProgram", reinterpret_cast<void *>(handleObject) },
+            { "glGetShaderiv", reinterpret_cast<void *>(getObjectiv) },
+            { "glGetProgramiv", reinterpret_cast<void *>(getObjectiv) },
+            { "glAttachShader", reinterpret_cast<void *>(attachShader) },
+            { "glBindAttribLocation", reinterpret_cast<void *>(bindAttribLocation) },
+            { "glGetUniformLocation", reinterpret_cast<void *>(getUniformLocation) }
+        };
+        for (vsize i = 0; i < sizeof(kFunctions) / sizeof(kFunctions[0]); i++) {
+            if (strcmp(kFunctions[i].name, name) == 0) {
+                return kFunctions[i].function;
+            }
+        }
+        return 0;
+    }
+    int query(QueryType /* type */) const { return 0; }
+} g_uploadStatisticsResolver;
+gl::GLenum UploadStatisticsResolver::waitResult = gl::VertexBundle::kGL_CONDITION_SATISFIED;
+int UploadStatisticsResolver::nmaps = 0;
+int UploadStatisticsResolver::nwrites = 0;
+vsize UploadStatisticsResolver::dynamicBufferSize = 0;
+Array<uint8> UploadStatisticsResolver::mappedBytes;
+
 TEST(SceneTest, AddModel)
 {
     Array<IModel *> models;
@@ -259,6 +357,94 @@ TEST(SceneTest, Update)
         scene.update(Scene::kUpdateLight);
         scene.update(Scene::kUpdateModels);
     }
+    {
+        std::unique_ptr<MockIRenderEngine> parentEngine(new MockIRenderEngine()), childEngine(new MockIRenderEngine());
+        EXPECT_CALL(*parentEngine, release()).WillOnce(Return());
+        EXPECT_CALL(*childEngine, release()).WillOnce(Return());
+        EXPECT_CALL(*parentEngine, update()).WillOnce(Return());
+        EXPECT_CALL(*childEngine, update()).WillOnce(Return());
+        std::unique_ptr<MockIModel> parentModel(new MockIModel()), childModel(new MockIModel());
+        /* ignore setting setParentSceneRef */
+        EXPECT_CALL(*parentModel, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*childModel, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*parentModel, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+        EXPECT_CALL(*parentModel, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+        EXPECT_CALL(*childModel, parentModelRef()).WillRepeatedly(Return(parentModel.get()));
+        EXPECT_CALL(*childModel, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+        /* the dependent model should be updated after the independent model */
+        {
+            InSequence sequence;
+            EXPECT_CALL(*parentModel, performUpdate()).Times(1);
+            EXPECT_CALL(*childModel, performUpdate()).Times(1);
+        }
+        EXPECT_CALL(*parentModel, joinWorld(0)).Times(1);
+        EXPECT_CALL(*childModel, joinWorld(0)).Times(1);
+        String s(UnicodeString::fromUTF8("This is a test model."));
+        EXPECT_CALL(*parentModel, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+        EXPECT_CALL(*childModel, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+        Scene scene(true);
+        /* add the dependent model first to check the update order is not the registration order */
+        scene.addModel(childModel.release(), childEngine.release(), 0);
+        scene.addModel(parentModel.release(), parentEngine.release(), 0);
+        scene.update(Scene::kUpdateAll | Scene::kParallelUpdateModels);
+    }
+    {
+        std::unique_ptr<MockIRenderEngine> rootEngine(new MockIRenderEngine()), childEngine(new MockIRenderEngine()), grandChildEngine(new MockIRenderEngine());
+        EXPECT_CALL(*rootEngine, release()).WillOnce(Return());
+        EXPECT_CALL(*childEngine, release()).WillOnce(Return());
+        EXPECT_CALL(*grandChildEngine, release()).WillOnce(Return());
+        EXPECT_CALL(*rootEngine, update()).WillOnce(Return());
+        EXPECT_CALL(*childEngine, update()).WillOnce(Return());
+        EXPECT_CALL(*grandChildEngine, update()).WillOnce(Return());
+        std::unique_ptr<MockIModel> rootModel(new MockIModel()), childModel(new MockIModel()), grandChildModel(new MockIModel());
+        MockIBone childBone;
+        EXPECT_CALL(*rootModel, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*childModel, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*grandChildModel, type()).WillRepeatedly(Return(IModel::kMaxModelType));
+        EXPECT_CALL(*rootModel, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+        EXPECT_CALL(*rootModel, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+        EXPECT_CALL(*childModel, parentModelRef()).WillRepeatedly(Return(rootModel.get()));
+        EXPECT_CALL(*childModel, parentBoneRef()).WillRepeatedly(Return(static_cast<IBone *>(0)));
+        /* the grand child model is attached to the bone of the dependent child model */
+        EXPECT_CALL(childBone, parentModelRef()).WillRepeatedly(Return(childModel.get()));
+        EXPECT_CALL(*grandChildModel, parentModelRef()).WillRepeatedly(Return(static_cast<IModel *>(0)));
+        EXPECT_CALL(*grandChildModel, parentBoneRef()).WillRepeatedly(Return(&childBone));
+        {
+            InSequence sequence;
+            EXPECT_CALL(*rootModel, performUpdate()).Times(1);
+            EXPECT_CALL(*childModel, performUpdate()).Times(1);
+            EXPECT_CALL(*grandChildModel, performUpdate()).Times(1);
+        }
+        EXPECT_CALL(*rootModel, joinWorld(0)).Times(1);
+        EXPECT_CALL(*childModel, joinWorld(0)).Times(1);
+        EXPECT_CALL(*grandChildModel, joinWorld(0)).Times(1);
+        String s(UnicodeString::fromUTF8("This is a test model."));
+        EXPECT_CALL(*rootModel, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+        EXPECT_CALL(*childModel, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+        EXPECT_CALL(*grandChildModel, name(IEncoding::kDefaultLanguage)).WillRepeatedly(Return(&s));
+        Scene scene(true);
+        /* the grand child model is registered before its parent to check dependent models are sorted */
+        scene.addModel(grandChildModel.release(), grandChildEngine.release(), 0);
+        scene.addModel(childModel.release(), childEngine.release(), 0);
+        scene.addModel(rootModel.release(), rootEngine.release(), 0);
+        scene.update(Scene::kUpdateAll | Scene::kParallelUpdateModels);
+    }
+}
+
+TEST(SceneTest, UpdateGeneration)
+{
+    Scene scene(true);
+    int generation = scene.updateGeneration();
+    scene.update(Scene::kUpdateCamera);
+    ASSERT_LT(generation, scene.updateGeneration());
+    generation = scene.updateGeneration();
+    scene.update(Scene::kUpdateAll);
+    ASSERT_LT(generation, scene.updateGeneration());
+    /* not changed until the next update */
+    generation = scene.updateGeneration();
+    ASSERT_EQ(generation, scene.updateGeneration());
+    scene.updateModel(0);
+    ASSERT_EQ(generation, scene.updateGeneration());
 }
 
 TEST(SceneTest, SeekMotions)
@@ -443,6 +629,65 @@ TEST(SceneTest, SetWorldRef)
     }
 }
 
+TEST(SceneTest, AddModelToWorldIsland)
+{
+    extensions::World world;
+    btDiscreteDynamicsWorld *worldRef = world.dynamicWorldRef();
+    MockIModel model, model2;
+    world.setIslandEnabled(true);
+    /* model gets its own island and model2 collides with other models in the shared world */
+    EXPECT_CALL(model, joinWorld(AllOf(NotNull(), Ne(worldRef)))).Times(1);
+    EXPECT_CALL(model, leaveWorld(AllOf(NotNull(), Ne(worldRef)))).Times(1);
+    EXPECT_CALL(model2, joinWorld(worldRef)).Times(1);
+    EXPECT_CALL(model2, leaveWorld(worldRef)).Times(1);
+    world.addModel(&model, false);
+    world.addModel(&model2, true);
+    /* adding same model twice should be ignored */
+    world.addModel(&model, false);
+    world.stepSimulation(1, Scene::defaultFPS());
+    ASSERT_TRUE(world.removeModel(&model));
+    ASSERT_TRUE(world.removeModel(&model2));
+    ASSERT_FALSE(world.removeModel(&model));
+}
+
+TEST(SceneTest, RestoreWorldCheckpoint)
+{
+    extensions::World world;
+    btSphereShape shape(1);
+    btDefaultMotionState state(Transform(Quaternion::getIdentity(), Vector3(0, 10, 0)));
+    btRigidBody body(btRigidBody::btRigidBodyConstructionInfo(1, &state, &shape));
+    body.setActivationState(DISABLE_DEACTIVATION);
+    world.setFloorEnabled(false);
+    world.addRigidBody(&body);
+    /* substeps are bounded by default so a long seek cannot stall */
+    ASSERT_EQ(240, world.maxSubSteps());
+    Scalar timeIndex = -1;
+    ASSERT_FALSE(world.findCheckpoint(0, timeIndex));
+    ASSERT_FALSE(world.restoreCheckpoint(0));
+    world.saveCheckpoint(0);
+    world.stepSimulation(30, Scene::defaultFPS());
+    const Vector3 &position = body.getCenterOfMassPosition();
+    ASSERT_LT(position.y(), 10);
+    world.saveCheckpoint(30);
+    /* saving same time index replaces the checkpoint */
+    world.saveCheckpoint(30);
+    ASSERT_EQ(2, world.countCheckpoints());
+    ASSERT_TRUE(world.findCheckpoint(45, timeIndex));
+    ASSERT_FLOAT_EQ(30, timeIndex);
+    ASSERT_TRUE(world.findCheckpoint(15, timeIndex));
+    ASSERT_FLOAT_EQ(0, timeIndex);
+    ASSERT_TRUE(world.restoreCheckpoint(15));
+    ASSERT_FLOAT_EQ(10, body.getCenterOfMassPosition().y());
+    ASSERT_TRUE(body.getLinearVelocity().isZero());
+    /* exceeding the memory budget thins out checkpoints */
+    world.setCheckpointMemoryBudget(0);
+    ASSERT_EQ(0, world.countCheckpoints());
+    world.setCheckpointMemoryBudget(extensions::World::kDefaultCheckpointMemoryBudget);
+    world.saveCheckpoint(0);
+    world.removeRigidBody(&body);
+    ASSERT_EQ(0, world.countCheckpoints());
+}
+
 TEST(SceneTest, CreateRenderEngine)
 {
     Scene scene(true);
@@ -484,6 +729,56 @@ TEST(SceneTest, CreateRenderEngine)
     ASSERT_EQ(static_cast<IRenderEngine *>(0), scene.createRenderEngine(&applicationContext, 0, 0));
 }
 
+TEST(SceneTest, UploadDynamicVertexBufferRing)
+{
+    Encoding encoding(0);
+    MockIApplicationContext applicationContext;
+    EXPECT_CALL(applicationContext, sharedFunctionResolverInstance()).Times(AnyNumber()).WillRepeatedly(Return(&g_uploadStatisticsResolver));
+    EXPECT_CALL(applicationContext, loadShaderSource(_, _, _)).Times(AnyNumber()).WillRepeatedly(Return(static_cast<IString *>(0)));
+    UploadStatisticsResolver::waitResult = gl::VertexBundle::kGL_CONDITION_SATISFIED;
+    UploadStatisticsResolver::nmaps = UploadStatisticsResolver::nwrites = 0;
+    Scene scene(true);
+    pmx::Model model(&encoding);
+    IBone *bone = model.createBone();
+    model.addBone(bone);
+    IVertex *vertex = model.createVertex();
+    vertex->setType(IVertex::kBdef1);
+    vertex->setBoneRef(0, bone);
+    model.addVertex(vertex);
+    Array<int> indices;
+    indices.append(0);
+    model.setIndices(indices);
+    IMaterial *material = model.createMaterial();
+    IMaterial::IndexRange range;
+    range.count = 1;
+    material->setIndexRange(range);
+    model.addMaterial(material);
+    gl2::PMXRenderEngine engine(&applicationContext, &scene, 0, &model);
+    gl2::PMXRenderEngine::UploadStatistics statistics;
+    ASSERT_TRUE(engine.upload(0));
+    engine.getUploadStatistics(statistics);
+    /* third update of upload waits the fence inserted by the first one */
+    ASSERT_EQ(1, statistics.nwaits);
+    ASSERT_EQ(UploadStatisticsResolver::dynamicBufferSize, statistics.nbytes);
+    ASSERT_GT(statistics.nbytes, vsize(0));
+    ASSERT_EQ(3, UploadStatisticsResolver::nmaps);
+    ASSERT_EQ(0, UploadStatisticsResolver::nwrites);
+    /* the ring index rotates back to the first buffer */
+    engine.update();
+    engine.getUploadStatistics(statistics);
+    ASSERT_EQ(1, statistics.nwaits);
+    ASSERT_EQ(4, UploadStatisticsResolver::nmaps);
+    ASSERT_EQ(0, UploadStatisticsResolver::nwrites);
+    /* should not map unsynchronized if waiting the fence is failed */
+    UploadStatisticsResolver::waitResult = gl::VertexBundle::kGL_WAIT_FAILED;
+    engine.update();
+    engine.getUploadStatistics(statistics);
+    ASSERT_EQ(0, statistics.nwaits);
+    ASSERT_EQ(4, UploadStatisticsResolver::nmaps);
+    ASSERT_EQ(1, UploadStatisticsResolver::nwrites);
+    ASSERT_EQ(UploadStatisticsResolver::dynamicBufferSize, statistics.nbytes);
+}
+
 TEST(SceneModel, HandleDefaultCamera)
 {
     Scene scene(true);
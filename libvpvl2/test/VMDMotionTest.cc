@@ -540,6 +540,51 @@ TEST(VMDMotionTest, CameraInterpolation)
     CompareCameraInterpolationMatrix(p, frame);
 }
 
+TEST(VMDMotionTest, ShareInterpolationCurveTables)
+{
+    Encoding encoding(0);
+    internal::InterpolationCurveRegistry::Statistics before, after;
+    internal::InterpolationCurveRegistry::getStatistics(before);
+    const QuadWord curve(31, 41, 59, 26), curve2(53, 58, 97, 93);
+    vmd::BoneKeyframe frame(&encoding);
+    std::unique_ptr<vmd::BoneKeyframe> frame2(new vmd::BoneKeyframe(&encoding));
+    frame.setDefaultInterpolationParameter();
+    frame2->setDefaultInterpolationParameter();
+    frame.setInterpolationParameter(vmd::BoneKeyframe::kBonePositionX, curve);
+    frame2->setInterpolationParameter(vmd::BoneKeyframe::kBonePositionY, curve);
+    frame2->setInterpolationParameter(vmd::BoneKeyframe::kBoneRotation, curve2);
+    /* keyframes with the same control points refer the same curve table */
+    const IKeyframe::SmoothPrecision *const *tables = frame.interpolationTable();
+    const IKeyframe::SmoothPrecision *const *tables2 = frame2->interpolationTable();
+    ASSERT_TRUE(tables[vmd::BoneKeyframe::kBonePositionX]);
+    ASSERT_EQ(tables[vmd::BoneKeyframe::kBonePositionX], tables2[vmd::BoneKeyframe::kBonePositionY]);
+    ASSERT_EQ(tables[vmd::BoneKeyframe::kBoneRotation], tables2[vmd::BoneKeyframe::kBonePositionX]);
+    ASSERT_NE(tables[vmd::BoneKeyframe::kBonePositionX], tables2[vmd::BoneKeyframe::kBoneRotation]);
+    /* the shared table must be the same as the one built from the control points */
+    IKeyframe::SmoothPrecision expected[vmd::BoneKeyframe::kTableSize + 1], *ptr = expected;
+    internal::InterpolationTable::build(curve.x() / 127.0f, curve.z() / 127.0f, curve.y() / 127.0f, curve.w() / 127.0f,
+                                        vmd::BoneKeyframe::kTableSize, ptr);
+    for (int i = 0; i <= vmd::BoneKeyframe::kTableSize; i++) {
+        ASSERT_FLOAT_EQ(expected[i], tables[vmd::BoneKeyframe::kBonePositionX][i]);
+    }
+    internal::InterpolationCurveRegistry::getStatistics(after);
+    ASSERT_LE(after.ncurves - before.ncurves, 2);
+    /* three curves are bound: position X of frame, position Y and rotation of frame2 */
+    ASSERT_EQ(3, after.nlookups - before.nlookups);
+    /* rebinding a curve should not change the count of bound tables */
+    frame.setInterpolationParameter(vmd::BoneKeyframe::kBonePositionX, curve2);
+    internal::InterpolationCurveRegistry::getStatistics(after);
+    ASSERT_EQ(3, after.nlookups - before.nlookups);
+    /* linear interpolation does not bind any table */
+    frame.setDefaultInterpolationParameter();
+    internal::InterpolationCurveRegistry::getStatistics(after);
+    ASSERT_EQ(2, after.nlookups - before.nlookups);
+    /* destroying the keyframe should release its tables */
+    frame2.reset();
+    internal::InterpolationCurveRegistry::getStatistics(after);
+    ASSERT_EQ(before.nlookups, after.nlookups);
+}
+
 TEST(VMDMotionTest, AddAndRemoveBoneKeyframes)
 {
     Encoding encoding(0);
@@ -598,6 +643,75 @@ TEST(VMDMotionTest, AddAndRemoveBoneKeyframes)
     }
 }
 
+TEST(VMDMotionTest, SeekCompiledBoneAnimation)
+{
+    Encoding encoding(0);
+    pmx::Model model(&encoding);
+    const char *names[] = { "bone0", "bone1", "bone2" };
+    for (int i = 0; i < 3; i++) {
+        String name(names[i]);
+        IBone *bone = model.createBone();
+        bone->setName(&name, IEncoding::kDefaultLanguage);
+        model.addBone(bone);
+    }
+    vmd::Motion expected(&model, &encoding), actual(&model, &encoding);
+    actual.mutableBoneAnimation()->setCompileEnable(true);
+    ASSERT_TRUE(actual.boneAnimation().isCompileEnabled());
+    vmd::Motion *motions[] = { &expected, &actual };
+    for (int i = 0; i < 2; i++) {
+        vmd::Motion *motion = motions[i];
+        for (int j = 0; j < 3; j++) {
+            String name(names[j]);
+            for (int k = 0; k < 8; k++) {
+                std::unique_ptr<IBoneKeyframe> keyframe(motion->createBoneKeyframe());
+                keyframe->setDefaultInterpolationParameter();
+                keyframe->setName(&name);
+                keyframe->setTimeIndex(k * (j + 3));
+                keyframe->setLocalTranslation(Vector3(k * 0.1f, j * 0.2f, (k + j) * 0.3f));
+                keyframe->setLocalOrientation(Quaternion(Vector3(0, 1, 0), btRadians(k * 15 + j * 5)));
+                if (k % 2 == 1) {
+                    keyframe->setInterpolationParameter(IBoneKeyframe::kBonePositionX, QuadWord(20, 30, 100, 110));
+                    keyframe->setInterpolationParameter(IBoneKeyframe::kBoneRotation, QuadWord(64, 0, 64, 127));
+                }
+                motion->addKeyframe(keyframe.release());
+            }
+        }
+        motion->update(IKeyframe::kBoneKeyframe);
+    }
+    Array<IBone *> bones;
+    model.getBoneRefs(bones);
+    /* forward, backward and beyond the duration */
+    const int timeIndices[] = { 0, 1, 2, 5, 9, 13, 20, 28, 35, 7, 3, 30, 0, 42 };
+    for (int i = 0; i < int(sizeof(timeIndices) / sizeof(timeIndices[0])); i++) {
+        expected.seekTimeIndex(timeIndices[i]);
+        Vector3 expectedTranslations[3];
+        Quaternion expectedOrientations[3];
+        for (int j = 0; j < 3; j++) {
+            expectedTranslations[j] = bones[j]->localTranslation();
+            expectedOrientations[j] = bones[j]->localOrientation();
+            bones[j]->setLocalTranslation(kZeroV3);
+            bones[j]->setLocalOrientation(Quaternion::getIdentity());
+        }
+        actual.seekTimeIndex(timeIndices[i]);
+        for (int j = 0; j < 3; j++) {
+            ASSERT_TRUE(CompareVector(expectedTranslations[j], bones[j]->localTranslation()));
+            ASSERT_TRUE(CompareVector(expectedOrientations[j], bones[j]->localOrientation()));
+        }
+    }
+    /* pose buffer slots are reassigned by adding a bone, then bones are written through IBone */
+    String name("bone3");
+    IBone *bone = model.createBone();
+    bone->setName(&name, IEncoding::kDefaultLanguage);
+    model.addBone(bone);
+    expected.seekTimeIndex(13);
+    for (int j = 0; j < 3; j++) {
+        const Vector3 expectedTranslation = bones[j]->localTranslation();
+        bones[j]->setLocalTranslation(kZeroV3);
+        actual.seekTimeIndex(13);
+        ASSERT_TRUE(CompareVector(expectedTranslation, bones[j]->localTranslation()));
+    }
+}
+
 TEST(VMDMotionTest, AddAndRemoveCameraKeyframes)
 {
     Encoding encoding(0);
@@ -0,0 +1,111 @@
+#include <vpvl2/vpvl2.h>
+#include <vpvl2/extensions/BaseApplicationContext.h> /* BaseApplicationContext::initializeOnce */
+#include <vpvl2/extensions/icu4c/Encoding.h>
+#include <vpvl2/extensions/icu4c/String.h>
+#include <vpvl2/vmd/BoneAnimation.h>
+#include <vpvl2/vmd/Motion.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sstream>
+
+#include <QtCore>
+
+using namespace vpvl2;
+using namespace vpvl2::extensions;
+using namespace vpvl2::extensions::icu4c;
+
+namespace {
+
+static IString *CreateBoneName(int index)
+{
+    std::ostringstream stream;
+    stream << "Bone" << index;
+    return String::create(stream.str());
+}
+
+static void CreateModel(IModel *model, int nbones)
+{
+    for (int i = 0; i < nbones; i++) {
+        IBone *bone = model->createBone();
+        std::auto_ptr<IString> name(CreateBoneName(i));
+        bone->setName(name.get(), IEncoding::kDefaultLanguage);
+        model->addBone(bone);
+    }
+}
+
+static void CreateMotion(IMotion *motion, int nbones, int nkeyframes)
+{
+    for (int i = 0; i < nbones; i++) {
+        std::auto_ptr<IString> name(CreateBoneName(i));
+        for (int j = 0; j < nkeyframes; j++) {
+            std::auto_ptr<IBoneKeyframe> keyframe(motion->createBoneKeyframe());
+            keyframe->setDefaultInterpolationParameter();
+            keyframe->setName(name.get());
+            keyframe->setTimeIndex(j * 2);
+            keyframe->setLocalTranslation(Vector3(j * 0.01, i * 0.01, 0));
+            keyframe->setLocalOrientation(Quaternion(Vector3(0, 1, 0), btRadians(j % 360)));
+            motion->addKeyframe(keyframe.release());
+        }
+    }
+    motion->update(IKeyframe::kBoneKeyframe);
+}
+
+static void Report(const char *mode, const char *label, int nseeks, qint64 elapsed)
+{
+    fprintf(stderr, "%-9s %-10s %8d seeks %10.3f ms %10.3f us/seek\n",
+            mode, label, nseeks, elapsed / 1000000.0, elapsed / 1000.0 / btMax(nseeks, 1));
+}
+
+static void RunSeeks(IMotion *motion, const char *mode, int nseeks)
+{
+    const int duration = btMax(int(motion->durationTimeIndex()), 1);
+    QElapsedTimer timer;
+    /* sequential playback */
+    motion->reset();
+    timer.start();
+    for (int i = 0; i < nseeks; i++) {
+        motion->seekTimeIndex(IKeyframe::TimeIndex(i % duration));
+    }
+    Report(mode, "forward", nseeks, timer.nsecsElapsed());
+    /* scrubbing backward */
+    timer.start();
+    for (int i = 0; i < nseeks; i++) {
+        motion->seekTimeIndex(IKeyframe::TimeIndex(duration - i % duration));
+    }
+    Report(mode, "backward", nseeks, timer.nsecsElapsed());
+    /* random seek across whole the motion */
+    uint32 seed = 42;
+    timer.start();
+    for (int i = 0; i < nseeks; i++) {
+        seed = seed * 1103515245 + 12345;
+        motion->seekTimeIndex(IKeyframe::TimeIndex((seed >> 8) % uint32(duration)));
+    }
+    Report(mode, "random", nseeks, timer.nsecsElapsed());
+}
+
+}
+
+/* usage: vpvl2_motion_benchmark [nbones=64] [nkeyframes=10000] [nseeks=10000] */
+int main(int argc, char *argv[])
+{
+    BaseApplicationContext::initializeOnce(argv[0], 0, 2);
+    const int nbones = argc > 1 ? btMax(atoi(argv[1]), 1) : 64;
+    const int nkeyframes = argc > 2 ? btMax(atoi(argv[2]), 2) : 10000;
+    const int nseeks = argc > 3 ? btMax(atoi(argv[3]), 1) : 10000;
+    Encoding::Dictionary dictionary;
+    Encoding encoding(&dictionary);
+    Factory factory(&encoding);
+    std::auto_ptr<IModel> model(factory.newModel(IModel::kPMXModel));
+    CreateModel(model.get(), nbones);
+    std::auto_ptr<IMotion> motion(factory.newMotion(IMotion::kVMDFormat, model.get()));
+    CreateMotion(motion.get(), nbones, nkeyframes);
+    const IKeyframe::TimeIndex &duration = motion->durationTimeIndex();
+    fprintf(stderr, "bones=%d keyframes/bone=%d duration=%d\n", nbones, nkeyframes, int(duration));
+    RunSeeks(motion.get(), "default", nseeks);
+    /* same motion evaluated from the compiled form of the bone animation */
+    vmd::Motion *vmdMotion = static_cast<vmd::Motion *>(motion.get());
+    vmdMotion->mutableBoneAnimation()->setCompileEnable(true);
+    RunSeeks(motion.get(), "compiled", nseeks);
+    return 0;
+}
@@ -156,3 +156,302 @@ TEST(PMXModelTest, RemoveBoneReferences)
     ASSERT_EQ(static_cast<IBone *>(0), childBone.destinationOriginBoneRef());
     ASSERT_EQ(static_cast<IBone *>(0), model.findBoneRef(&s));
 }
+
+TEST(PMXModelTest, BindBonesToPoseBuffer)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Bone bone(&model), apsBone(&model);
+    const Vector3 translation(1, 2, 3), origin(4, 5, 6);
+    bone.setLocalTranslation(translation);
+    bone.setOrigin(origin);
+    apsBone.setTransformAfterPhysicsEnable(true);
+    model.addBone(&apsBone);
+    model.addBone(&bone);
+    const Model::PoseBuffer &poseBuffer = model.poseBuffer();
+    ASSERT_EQ(2, poseBuffer.worldTransforms.size());
+    ASSERT_EQ(1, poseBuffer.numBonesBeforePhysics);
+    /* bones transformed before physics simulation come first */
+    ASSERT_EQ(0, bone.poseSlot());
+    ASSERT_EQ(1, apsBone.poseSlot());
+    ASSERT_EQ(1, poseBuffer.boneIndex2Slot[apsBone.index()]);
+    ASSERT_EQ(0, poseBuffer.boneIndex2Slot[bone.index()]);
+    ASSERT_TRUE(poseBuffer.localTranslations[0] == translation);
+    ASSERT_TRUE(poseBuffer.origins[0] == origin);
+    model.performUpdate();
+    Transform expected;
+    bone.getLocalTransform(expected);
+    ASSERT_TRUE(poseBuffer.skinningTransforms[0] == expected);
+    ASSERT_TRUE(bone.localTransform() == expected);
+    /* the removed bone keeps its pose */
+    model.removeBone(&bone);
+    ASSERT_EQ(-1, bone.poseSlot());
+    ASSERT_EQ(1, poseBuffer.worldTransforms.size());
+    ASSERT_EQ(0, apsBone.poseSlot());
+    ASSERT_TRUE(bone.localTranslation() == translation);
+    ASSERT_TRUE(bone.localTransform() == expected);
+    model.removeBone(&apsBone);
+    ASSERT_EQ(0, poseBuffer.worldTransforms.size());
+}
+
+TEST(PMXModelTest, TransformBonesFromPoseBuffer)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Bone root(&model), child(&model), inherent(&model);
+    model.addBone(&root);
+    model.addBone(&child);
+    model.addBone(&inherent);
+    child.setParentBoneRef(&root);
+    inherent.setParentInherentBoneRef(&root);
+    inherent.setInherentOrientationEnable(true);
+    inherent.setInherentTranslationEnable(true);
+    inherent.setInherentCoefficient(0.5);
+    const Model::PoseBuffer &poseBuffer = model.poseBuffer();
+    ASSERT_EQ(-1, poseBuffer.parentSlots[root.poseSlot()]);
+    ASSERT_EQ(root.poseSlot(), poseBuffer.parentSlots[child.poseSlot()]);
+    ASSERT_EQ(root.poseSlot(), poseBuffer.parentInherentSlots[inherent.poseSlot()]);
+    const Vector3 translation(1, 2, 3);
+    const Quaternion orientation(Vector3(0, 1, 0), 0.5);
+    root.setLocalTranslation(translation);
+    root.setLocalOrientation(orientation);
+    model.performUpdate();
+    ASSERT_TRUE(CompareVector(translation, root.worldTransform().getOrigin()));
+    ASSERT_TRUE(CompareVector(translation, child.worldTransform().getOrigin()));
+    ASSERT_TRUE(CompareVector(orientation, child.worldTransform().getRotation()));
+    ASSERT_TRUE(CompareVector(translation * 0.5, inherent.worldTransform().getOrigin()));
+    ASSERT_TRUE(CompareVector(Quaternion::getIdentity().slerp(orientation, 0.5), inherent.worldTransform().getRotation()));
+    /* the parent slot follows the bone after the buffer is rebuilt */
+    model.removeBone(&inherent);
+    model.removeBone(&root);
+    ASSERT_EQ(-1, poseBuffer.parentSlots[child.poseSlot()]);
+    model.removeBone(&child);
+}
+
+TEST(PMXModelTest, UpdateBonesIncrementally)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Bone root(&model), child(&model), sibling(&model);
+    child.setParentBoneRef(&root);
+    model.addBone(&root);
+    model.addBone(&child);
+    model.addBone(&sibling);
+    model.setIncrementalUpdateEnable(true);
+    model.performUpdate();
+    const Model::PoseBuffer &poseBuffer = model.poseBuffer();
+    ASSERT_TRUE(poseBuffer.changedFlags[root.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[child.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[sibling.poseSlot()]);
+    /* nothing is changed */
+    model.performUpdate();
+    ASSERT_FALSE(poseBuffer.changedFlags[root.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[child.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[sibling.poseSlot()]);
+    /* only the sibling is changed */
+    sibling.setLocalTranslation(Vector3(1, 2, 3));
+    model.performUpdate();
+    ASSERT_FALSE(poseBuffer.changedFlags[root.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[child.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[sibling.poseSlot()]);
+    /* the child is transformed with the root */
+    root.setLocalOrientation(Quaternion(Vector3(0, 1, 0), 0.5));
+    model.performUpdate();
+    ASSERT_TRUE(poseBuffer.changedFlags[root.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[child.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[sibling.poseSlot()]);
+    const Transform rootTransform = root.worldTransform(), childTransform = child.worldTransform(),
+            siblingTransform = sibling.worldTransform();
+    const Transform childSkinningTransform = child.localTransform();
+    /* the incremental update should be same as the full update */
+    model.requestFullUpdate();
+    model.performUpdate();
+    ASSERT_TRUE(root.worldTransform() == rootTransform);
+    ASSERT_TRUE(child.worldTransform() == childTransform);
+    ASSERT_TRUE(sibling.worldTransform() == siblingTransform);
+    ASSERT_TRUE(child.localTransform() == childSkinningTransform);
+    model.removeBone(&sibling);
+    model.removeBone(&child);
+    model.removeBone(&root);
+}
+
+struct BoneDataWriter {
+    template<typename T>
+    void write(const T &value) {
+        bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    void writeVector3(const Vector3 &value) {
+        write(float32(value.x()));
+        write(float32(value.y()));
+        write(float32(value.z()));
+    }
+    void writeBone(const Vector3 &origin, int32 parentBoneIndex, uint16 flags) {
+        /* empty Japanese and English names */
+        write(int32(0));
+        write(int32(0));
+        writeVector3(origin);
+        write(parentBoneIndex);
+        write(int32(0));
+        write(flags);
+        writeVector3(kZeroV3);
+    }
+    std::string bytes;
+};
+
+static void AssertIncrementalUpdateEqualsFullUpdate(Model &model, Bone *const *bones, int nbones)
+{
+    Array<Transform> worldTransforms, localTransforms;
+    for (int i = 0; i < nbones; i++) {
+        worldTransforms.append(bones[i]->worldTransform());
+        localTransforms.append(bones[i]->localTransform());
+    }
+    model.requestFullUpdate();
+    model.performUpdate();
+    for (int i = 0; i < nbones; i++) {
+        ASSERT_TRUE(bones[i]->worldTransform() == worldTransforms[i]);
+        ASSERT_TRUE(bones[i]->localTransform() == localTransforms[i]);
+    }
+}
+
+TEST(PMXModelTest, UpdateBonesIncrementallyWithInverseKinematics)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Model::DataInfo info;
+    std::memset(&info, 0, sizeof(info));
+    info.encoding = &encoding;
+    info.codec = IString::kUTF8;
+    info.boneIndexSize = 4;
+    /* rotatable, movable, visible and interactive */
+    static const uint16 kBoneFlags = 0x1e, kIKBoneFlags = kBoneFlags | 0x20;
+    BoneDataWriter writers[5];
+    writers[0].writeBone(Vector3(1, 10, 0), -1, kBoneFlags);
+    writers[1].writeBone(Vector3(1, 5, 0.3), 0, kBoneFlags);
+    writers[2].writeBone(Vector3(1, 0.5, 0), 1, kBoneFlags);
+    writers[3].writeBone(Vector3(1, 0.5, 0), -1, kIKBoneFlags);
+    writers[4].writeBone(Vector3(-1, 10, 0), -1, kBoneFlags);
+    /* the effector, iterations, angle limit and joints (the knee has an angle limit) */
+    writers[3].write(int32(2));
+    writers[3].write(int32(40));
+    writers[3].write(float32(2));
+    writers[3].write(int32(2));
+    writers[3].write(int32(1));
+    writers[3].write(uint8(1));
+    writers[3].writeVector3(Vector3(-btRadians(180), 0, 0));
+    writers[3].writeVector3(Vector3(-btRadians(0.5), 0, 0));
+    writers[3].write(int32(0));
+    writers[3].write(uint8(0));
+    Bone hip(&model), knee(&model), ankle(&model), ik(&model), unrelated(&model);
+    Bone *bones[] = { &hip, &knee, &ankle, &ik, &unrelated };
+    static const int kNumBones = sizeof(bones) / sizeof(bones[0]);
+    Array<Bone *> boneRefs;
+    for (int i = 0; i < kNumBones; i++) {
+        vsize size = 0;
+        bones[i]->read(reinterpret_cast<const uint8 *>(writers[i].bytes.data()), info, size);
+        ASSERT_EQ(writers[i].bytes.size(), size);
+        boneRefs.append(bones[i]);
+    }
+    Bone::loadBones(boneRefs);
+    for (int i = 0; i < kNumBones; i++) {
+        bones[i]->setIndex(-1);
+        model.addBone(bones[i]);
+    }
+    ASSERT_TRUE(ik.hasInverseKinematics());
+    model.setIncrementalUpdateEnable(true);
+    model.performUpdate();
+    model.performUpdate();
+    /* moving the IK bone solves the chain again and transforms the joint bones */
+    ik.setLocalTranslation(Vector3(0, 3, -1));
+    model.performUpdate();
+    const Model::PoseBuffer &poseBuffer = model.poseBuffer();
+    ASSERT_TRUE(poseBuffer.changedFlags[ik.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[hip.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[knee.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[ankle.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[unrelated.poseSlot()]);
+    AssertIncrementalUpdateEqualsFullUpdate(model, bones, kNumBones);
+    /* moving the root of the chain changes the effector */
+    hip.setLocalTranslation(Vector3(0, -1, 0));
+    model.performUpdate();
+    AssertIncrementalUpdateEqualsFullUpdate(model, bones, kNumBones);
+    for (int i = kNumBones - 1; i >= 0; i--) {
+        model.removeBone(bones[i]);
+    }
+}
+
+TEST(PMXModelTest, UpdateBonesIncrementallyWithInherentBone)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Bone source(&model), target(&model), child(&model), unrelated(&model);
+    Bone *bones[] = { &source, &target, &child, &unrelated };
+    static const int kNumBones = sizeof(bones) / sizeof(bones[0]);
+    target.setParentInherentBoneRef(&source);
+    target.setInherentCoefficient(0.5);
+    target.setInherentOrientationEnable(true);
+    target.setInherentTranslationEnable(true);
+    child.setParentBoneRef(&target);
+    child.setOrigin(Vector3(0, 1, 0));
+    for (int i = 0; i < kNumBones; i++) {
+        model.addBone(bones[i]);
+    }
+    model.setIncrementalUpdateEnable(true);
+    model.performUpdate();
+    model.performUpdate();
+    /* the inherence target and its child follow the source bone */
+    source.setLocalOrientation(Quaternion(Vector3(1, 0, 0), 0.5));
+    source.setLocalTranslation(Vector3(1, 2, 3));
+    model.performUpdate();
+    const Model::PoseBuffer &poseBuffer = model.poseBuffer();
+    ASSERT_TRUE(poseBuffer.changedFlags[source.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[target.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[child.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[unrelated.poseSlot()]);
+    AssertIncrementalUpdateEqualsFullUpdate(model, bones, kNumBones);
+    for (int i = kNumBones - 1; i >= 0; i--) {
+        model.removeBone(bones[i]);
+    }
+}
+
+TEST(PMXModelTest, UpdateBonesIncrementallyWithBoneMorph)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Bone root(&model), child(&model), unrelated(&model);
+    Bone *bones[] = { &root, &child, &unrelated };
+    static const int kNumBones = sizeof(bones) / sizeof(bones[0]);
+    child.setParentBoneRef(&root);
+    for (int i = 0; i < kNumBones; i++) {
+        model.addBone(bones[i]);
+    }
+    std::unique_ptr<IMorph> morph(model.createMorph());
+    std::unique_ptr<IMorph::Bone> boneMorph(new IMorph::Bone());
+    boneMorph->bone = &root;
+    boneMorph->position.setValue(1, 2, 3);
+    boneMorph->rotation.setRotation(Vector3(0, 0, 1), 0.5);
+    morph->setType(IMorph::kBoneMorph);
+    morph->addBoneMorph(boneMorph.release());
+    model.addMorph(morph.get());
+    model.setIncrementalUpdateEnable(true);
+    model.performUpdate();
+    model.performUpdate();
+    /* changing the weight of the morph moves the morphed bone and its descendants */
+    morph->setWeight(0.5);
+    model.performUpdate();
+    const Model::PoseBuffer &poseBuffer = model.poseBuffer();
+    ASSERT_TRUE(poseBuffer.changedFlags[root.poseSlot()]);
+    ASSERT_TRUE(poseBuffer.changedFlags[child.poseSlot()]);
+    ASSERT_FALSE(poseBuffer.changedFlags[unrelated.poseSlot()]);
+    /* the bone morph is applied only when dirty, so mark it as Scene::kForceUpdateAllMorphs does */
+    morph->markDirty();
+    AssertIncrementalUpdateEqualsFullUpdate(model, bones, kNumBones);
+    /* resetting the weight restores the bind pose */
+    morph->setWeight(0);
+    model.performUpdate();
+    ASSERT_TRUE(poseBuffer.changedFlags[root.poseSlot()]);
+    AssertIncrementalUpdateEqualsFullUpdate(model, bones, kNumBones);
+    model.removeMorph(morph.get());
+    for (int i = kNumBones - 1; i >= 0; i--) {
+        model.removeBone(bones[i]);
+    }
+}
@@ -91,6 +91,280 @@ TEST(PMXModelTest, ParseRealPMX)
     }
 }
 
+TEST(PMXModelTest, ParseRealPMXInParallel)
+{
+    QFile file("miku.pmx");
+    if (file.open(QFile::ReadOnly)) {
+        const QByteArray &bytes = file.readAll();
+        Encoding::Dictionary dict;
+        Encoding encoding(&dict);
+        pmx::Model model(&encoding), model2(&encoding);
+        model2.setParallelLoadEnable(true);
+        ASSERT_TRUE(model.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+        ASSERT_TRUE(model2.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+        EXPECT_EQ(IModel::kNoError, model2.error());
+        EXPECT_EQ(model.vertices().count(), model2.vertices().count());
+        EXPECT_EQ(model.morphs().count(), model2.morphs().count());
+        ASSERT_EQ(model.estimateSize(), model2.estimateSize());
+        QByteArray bytes2, bytes3;
+        vsize written;
+        bytes2.resize(model.estimateSize());
+        model.save(reinterpret_cast<uint8 *>(bytes2.data()), written);
+        bytes3.resize(model2.estimateSize());
+        model2.save(reinterpret_cast<uint8 *>(bytes3.data()), written);
+        EXPECT_EQ(bytes2, bytes3);
+    }
+    else {
+        // skip
+    }
+}
+
+TEST_P(PMXFragmentTest, ParseInParallel)
+{
+    /* the vertex count is chosen to make the vertex index size same as the parameter */
+    const vsize indexSize = GetParam();
+    const int nvertices = indexSize == 4 ? 40000 : int(indexSize) * 100, nbones = 3, nmaterials = 2, nmorphs = 64;
+    Encoding encoding(0);
+    Model source(&encoding);
+    String name("Japanese"), englishName("English");
+    source.setName(&name, IEncoding::kJapanese);
+    source.setName(&englishName, IEncoding::kEnglish);
+    source.setComment(&name, IEncoding::kJapanese);
+    source.setComment(&englishName, IEncoding::kEnglish);
+    char buffer[32];
+    for (int i = 0; i < nbones; i++) {
+        IBone *bone = source.createBone();
+        qsnprintf(buffer, sizeof(buffer), "bone%d", i);
+        String boneName(buffer);
+        bone->setName(&boneName, IEncoding::kJapanese);
+        bone->setName(&boneName, IEncoding::kEnglish);
+        bone->setOrigin(Vector3(0, i, 0));
+        bone->setParentBoneRef(source.findBoneRefAt(i - 1));
+        source.addBone(bone);
+    }
+    Array<int> indices;
+    for (int i = 0; i < nvertices; i++) {
+        IVertex *vertex = source.createVertex();
+        vertex->setOrigin(Vector3(i, i * 2, i * 3));
+        vertex->setNormal(Vector3(0, 1, 0));
+        vertex->setTextureCoord(Vector3(i * 0.01, i * 0.02, 0));
+        vertex->setType(IVertex::Type(i % 4));
+        vertex->setBoneRef(0, source.findBoneRefAt(i % nbones));
+        vertex->setBoneRef(1, source.findBoneRefAt((i + 1) % nbones));
+        vertex->setWeight(0, 0.25);
+        source.addVertex(vertex);
+        indices.append(i);
+    }
+    source.setIndices(indices);
+    for (int i = 0; i < nmaterials; i++) {
+        IMaterial *material = source.createMaterial();
+        qsnprintf(buffer, sizeof(buffer), "material%d", i);
+        String materialName(buffer);
+        material->setName(&materialName, IEncoding::kJapanese);
+        material->setName(&materialName, IEncoding::kEnglish);
+        IMaterial::IndexRange range;
+        range.count = nvertices / nmaterials;
+        material->setIndexRange(range);
+        source.addMaterial(material);
+    }
+    for (int i = 0; i < nmorphs; i++) {
+        IMorph *morph = source.createMorph();
+        qsnprintf(buffer, sizeof(buffer), "morph%d", i);
+        String morphName(buffer);
+        morph->setName(&morphName, IEncoding::kJapanese);
+        morph->setName(&morphName, IEncoding::kEnglish);
+        if (i % 2 == 0) {
+            morph->setType(IMorph::kVertexMorph);
+            for (int j = 0; j < i % 7 + 1; j++) {
+                IMorph::Vertex *v = new IMorph::Vertex();
+                v->index = (i * 7 + j) % nvertices;
+                v->vertex = source.findVertexRefAt(v->index);
+                v->position.setValue(i, j, 1);
+                morph->addVertexMorph(v);
+            }
+        }
+        else {
+            morph->setType(IMorph::kBoneMorph);
+            IMorph::Bone *b = new IMorph::Bone();
+            b->index = i % nbones;
+            b->bone = source.findBoneRefAt(b->index);
+            b->position.setValue(i, 0, 0);
+            b->rotation.setValue(0, 0, 0, 1);
+            morph->addBoneMorph(b);
+        }
+        source.addMorph(morph);
+    }
+    QByteArray bytes;
+    vsize written;
+    bytes.resize(source.estimateSize());
+    source.save(reinterpret_cast<uint8 *>(bytes.data()), written);
+    bytes.resize(written);
+    Model model(&encoding), model2(&encoding);
+    model2.setParallelLoadEnable(true);
+    ASSERT_TRUE(model.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+    ASSERT_TRUE(model2.load(reinterpret_cast<const uint8 *>(bytes.constData()), bytes.size()));
+    /* compare each elements parsed sequentially and concurrently */
+    const Array<Vertex *> &vertices = model.vertices(), &vertices2 = model2.vertices();
+    ASSERT_EQ(nvertices, vertices.count());
+    ASSERT_EQ(vertices.count(), vertices2.count());
+    for (int i = 0; i < nvertices; i++) {
+        const Vertex *vertex = vertices[i], *vertex2 = vertices2[i];
+        ASSERT_EQ(vertex->index(), vertex2->index());
+        ASSERT_EQ(vertex->type(), vertex2->type());
+        ASSERT_TRUE(CompareVector(vertex->origin(), vertex2->origin()));
+        ASSERT_TRUE(CompareVector(vertex->normal(), vertex2->normal()));
+        ASSERT_TRUE(CompareVector(vertex->textureCoord(), vertex2->textureCoord()));
+        ASSERT_EQ(vertex->boneRef(0)->index(), vertex2->boneRef(0)->index());
+        ASSERT_EQ(vertex->boneRef(1)->index(), vertex2->boneRef(1)->index());
+        ASSERT_FLOAT_EQ(vertex->weight(0), vertex2->weight(0));
+        ASSERT_EQ(vertex->materialRef()->index(), vertex2->materialRef()->index());
+    }
+    const Array<int> &indices1 = model.indices(), &indices2 = model2.indices();
+    ASSERT_EQ(indices1.count(), indices2.count());
+    for (int i = 0; i < indices1.count(); i++) {
+        ASSERT_EQ(indices1[i], indices2[i]);
+    }
+    const Array<Material *> &materials = model.materials(), &materials2 = model2.materials();
+    ASSERT_EQ(nmaterials, materials.count());
+    ASSERT_EQ(materials.count(), materials2.count());
+    for (int i = 0; i < nmaterials; i++) {
+        const Material *material = materials[i], *material2 = materials2[i];
+        ASSERT_TRUE(material->name(IEncoding::kJapanese)->equals(material2->name(IEncoding::kJapanese)));
+        ASSERT_TRUE(material->indexRange() == material2->indexRange());
+    }
+    const Array<Bone *> &bones = model.bones(), &bones2 = model2.bones();
+    ASSERT_EQ(nbones, bones.count());
+    ASSERT_EQ(bones.count(), bones2.count());
+    for (int i = 0; i < nbones; i++) {
+        const Bone *bone = bones[i], *bone2 = bones2[i];
+        ASSERT_TRUE(bone->name(IEncoding::kJapanese)->equals(bone2->name(IEncoding::kJapanese)));
+        ASSERT_TRUE(CompareVector(bone->origin(), bone2->origin()));
+        ASSERT_EQ(bone->parentBoneRef() ? bone->parentBoneRef()->index() : -1,
+                  bone2->parentBoneRef() ? bone2->parentBoneRef()->index() : -1);
+    }
+    const Array<Morph *> &morphs = model.morphs(), &morphs2 = model2.morphs();
+    ASSERT_EQ(nmorphs, morphs.count());
+    ASSERT_EQ(morphs.count(), morphs2.count());
+    for (int i = 0; i < nmorphs; i++) {
+        const Morph *morph = morphs[i], *morph2 = morphs2[i];
+        ASSERT_TRUE(morph->name(IEncoding::kJapanese)->equals(morph2->name(IEncoding::kJapanese)));
+        ASSERT_EQ(morph, model.findMorphRef(morph->name(IEncoding::kJapanese)));
+        ASSERT_EQ(morph2, model2.findMorphRef(morph2->name(IEncoding::kJapanese)));
+        ASSERT_EQ(morph->type(), morph2->type());
+        Array<IMorph::Vertex *> vertexMorphs, vertexMorphs2;
+        morph->getVertexMorphs(vertexMorphs);
+        morph2->getVertexMorphs(vertexMorphs2);
+        ASSERT_EQ(vertexMorphs.count(), vertexMorphs2.count());
+        for (int j = 0; j < vertexMorphs.count(); j++) {
+            ASSERT_EQ(vertexMorphs[j]->index, vertexMorphs2[j]->index);
+            ASSERT_EQ(vertexMorphs[j]->vertex->index(), vertexMorphs2[j]->vertex->index());
+            ASSERT_TRUE(CompareVector(vertexMorphs[j]->position, vertexMorphs2[j]->position));
+        }
+        Array<IMorph::Bone *> boneMorphs, boneMorphs2;
+        morph->getBoneMorphs(boneMorphs);
+        morph2->getBoneMorphs(boneMorphs2);
+        ASSERT_EQ(boneMorphs.count(), boneMorphs2.count());
+        for (int j = 0; j < boneMorphs.count(); j++) {
+            ASSERT_EQ(boneMorphs[j]->bone->index(), boneMorphs2[j]->bone->index());
+            ASSERT_TRUE(CompareVector(boneMorphs[j]->position, boneMorphs2[j]->position));
+            ASSERT_TRUE(CompareVector(boneMorphs[j]->rotation, boneMorphs2[j]->rotation));
+        }
+    }
+    ASSERT_EQ(model.estimateSize(), model2.estimateSize());
+    QByteArray bytes2, bytes3;
+    bytes2.resize(model.estimateSize());
+    model.save(reinterpret_cast<uint8 *>(bytes2.data()), written);
+    bytes3.resize(model2.estimateSize());
+    model2.save(reinterpret_cast<uint8 *>(bytes3.data()), written);
+    ASSERT_EQ(bytes2, bytes3);
+}
+
+static void WriteLegBone(QDataStream &stream, const char *name, const Vector3 &origin, int parentBoneIndex, uint16 flags)
+{
+    const int length = int(qstrlen(name));
+    stream << length;
+    stream.writeRawData(name, length);
+    stream << length;
+    stream.writeRawData(name, length);
+    stream << float(origin.x()) << float(origin.y()) << float(origin.z());
+    stream << parentBoneIndex << int(0) << flags;
+    stream << 0.0f << 0.0f << 0.0f;
+}
+
+static void CreateLegBones(Model &model, Encoding &encoding, Array<Bone *> &bones)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    QDataStream stream(&buffer);
+    buffer.open(QBuffer::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    /* rotateable, movable, visible and interactive, and IK for the last one */
+    WriteLegBone(stream, "hip", Vector3(0, 10, 0), -1, 0x1e);
+    WriteLegBone(stream, "knee", Vector3(0, 5, -0.3), 0, 0x1e);
+    WriteLegBone(stream, "ankle", Vector3(0, 0.5, 0), 1, 0x1e);
+    WriteLegBone(stream, "ik", Vector3(0, 0.5, 0), -1, 0x3e);
+    /* effector, iterations, angle limit and two joints; the knee rotates around X axis only */
+    stream << int(2) << int(40) << 2.0f << int(2);
+    stream << int(1) << quint8(1) << float(-SIMD_PI) << 0.0f << 0.0f << -0.008f << 0.0f << 0.0f;
+    stream << int(0) << quint8(0);
+    Model::DataInfo info;
+    info.encoding = &encoding;
+    info.codec = IString::kUTF8;
+    info.boneIndexSize = sizeof(int);
+    uint8 *ptr = reinterpret_cast<uint8 *>(bytes.data());
+    for (int i = 0; i < 4; i++) {
+        Bone *bone = new Bone(&model);
+        vsize size = 0;
+        bone->read(ptr, info, size);
+        ptr += size;
+        bones.append(bone);
+    }
+    Bone::loadBones(bones);
+    for (int i = 0; i < 4; i++) {
+        bones[i]->setIndex(-1);
+        model.addBone(bones[i]);
+    }
+}
+
+TEST(PMXModelTest, SolveInverseKinematicsFast)
+{
+    Encoding encoding(0);
+    Model model(&encoding), model2(&encoding);
+    model2.setFastInverseKinematicsEnable(true);
+    Array<Bone *> bones, bones2;
+    CreateLegBones(model, encoding, bones);
+    CreateLegBones(model2, encoding, bones2);
+    ASSERT_TRUE(bones[3]->hasInverseKinematics());
+    const Vector3 translations[] = {
+        Vector3(0, 1, 0), Vector3(0, 3, -1), Vector3(0.5, 2, 1), Vector3(-1, 4, 0.5), Vector3(1, 0.5, -2)
+    };
+    /* Y rotation of the knee keyed by motion must be kept by the fast path */
+    const Quaternion kneeOrientations[] = { Quaternion::getIdentity(), Quaternion(Vector3(0, 1, 0), 0.2) };
+    for (int i = 0; i < 2; i++) {
+        const Quaternion &kneeOrientation = kneeOrientations[i];
+        for (int j = 0; j < int(sizeof(translations) / sizeof(translations[0])); j++) {
+            for (int k = 0; k < 3; k++) {
+                bones[k]->setLocalOrientation(Quaternion::getIdentity());
+                bones2[k]->setLocalOrientation(Quaternion::getIdentity());
+            }
+            bones[1]->setLocalOrientation(kneeOrientation);
+            bones2[1]->setLocalOrientation(kneeOrientation);
+            bones[3]->setLocalTranslation(translations[j]);
+            bones2[3]->setLocalTranslation(translations[j]);
+            model.performUpdate();
+            model2.performUpdate();
+            const Vector3 &target = bones[3]->worldTransform().getOrigin();
+            const Scalar error = bones[2]->worldTransform().getOrigin().distance(target);
+            const Scalar error2 = bones2[2]->worldTransform().getOrigin().distance(target);
+            /* fast path must reach to the target at least as close as CCD */
+            ASSERT_LE(error2, error);
+            ASSERT_LT(error2, 1e-4);
+            ASSERT_NEAR(quatRotate(kneeOrientation, kUnitX).x(), quatRotate(bones2[1]->localOrientation(), kUnitX).x(), 1e-5);
+        }
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(PMXModelInstance, PMXFragmentTest, Values(1, 2, 4));
 INSTANTIATE_TEST_CASE_P(PMXModelInstance, PMXFragmentWithUVTest, Combine(Values(1, 2, 4),
                                                                          Values(pmx::Morph::kTexCoordMorph,
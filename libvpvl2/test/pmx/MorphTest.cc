@@ -381,3 +381,86 @@ TEST_P(PMXLanguageTest, RenameMorph)
     ASSERT_EQ(morph.get(), model.findMorphRef(&newName));
     morph.release();
 }
+
+TEST(PMXModelTest, UpdateOnlyMorphedVertices)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    for (int i = 0; i < 8; i++) {
+        model.addVertex(model.createVertex());
+    }
+    const Array<Vertex *> &vertices = model.vertices();
+    Morph *morph = static_cast<Morph *>(model.createMorph());
+    morph->setType(IMorph::kVertexMorph);
+    Morph::Vertex *vertex1 = new Morph::Vertex(), *vertex2 = new Morph::Vertex();
+    vertex1->vertex = vertices[2];
+    vertex1->index = 2;
+    vertex1->position.setValue(1, 2, 3);
+    morph->addVertexMorph(vertex1);
+    vertex2->vertex = vertices[5];
+    vertex2->index = 5;
+    vertex2->position.setValue(4, 5, 6);
+    morph->addVertexMorph(vertex2);
+    model.addMorph(morph);
+    std::unique_ptr<IModel::IndexBuffer> indexBuffer;
+    std::unique_ptr<IModel::DynamicVertexBuffer> dynamicBuffer;
+    {
+        IModel::IndexBuffer *indexBufferPtr = 0;
+        IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+        model.getIndexBuffer(indexBufferPtr);
+        model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+        indexBuffer.reset(indexBufferPtr);
+        dynamicBuffer.reset(dynamicBufferPtr);
+    }
+    int from = -1, to = -1, lastUpdateCount = -1, lastUpdateCount2 = -1;
+    /* all vertices are reset at the first update */
+    model.performUpdate();
+    model.getDirtyVertexRange(from, to);
+    ASSERT_EQ(0, from);
+    ASSERT_EQ(8, to);
+    dynamicBuffer->getDirtyVertexRange(lastUpdateCount, from, to);
+    ASSERT_EQ(0, from);
+    ASSERT_EQ(8, to);
+    /* zero weight morph touches no vertices */
+    model.performUpdate();
+    model.getDirtyVertexRange(from, to);
+    ASSERT_EQ(from, to);
+    dynamicBuffer->getDirtyVertexRange(lastUpdateCount, from, to);
+    ASSERT_EQ(from, to);
+    morph->setWeight(0.5);
+    model.performUpdate();
+    model.getDirtyVertexRange(from, to);
+    ASSERT_EQ(2, from);
+    ASSERT_EQ(6, to);
+    ASSERT_TRUE(CompareVector(Vector3(0.5, 1.0, 1.5), vertices[2]->delta()));
+    ASSERT_TRUE(CompareVector(Vector3(2.0, 2.5, 3.0), vertices[5]->delta()));
+    ASSERT_TRUE(CompareVector(kZeroV3, vertices[3]->delta()));
+    dynamicBuffer->getDirtyVertexRange(lastUpdateCount, from, to);
+    ASSERT_EQ(2, from);
+    ASSERT_EQ(6, to);
+    /* the other caller has own counter, its first call gets the whole range */
+    dynamicBuffer->getDirtyVertexRange(lastUpdateCount2, from, to);
+    ASSERT_EQ(0, from);
+    ASSERT_EQ(8, to);
+    /* morph is applied only once even if the weight is not changed */
+    model.performUpdate();
+    dynamicBuffer->getDirtyVertexRange(lastUpdateCount2, from, to);
+    ASSERT_EQ(2, from);
+    ASSERT_EQ(6, to);
+    ASSERT_TRUE(CompareVector(Vector3(0.5, 1.0, 1.5), vertices[2]->delta()));
+    /* morphed vertices at the previous update should be reset */
+    morph->setWeight(0);
+    model.performUpdate();
+    model.getDirtyVertexRange(from, to);
+    ASSERT_EQ(2, from);
+    ASSERT_EQ(6, to);
+    ASSERT_TRUE(CompareVector(kZeroV3, vertices[2]->delta()));
+    ASSERT_TRUE(CompareVector(kZeroV3, vertices[5]->delta()));
+    model.performUpdate();
+    model.getDirtyVertexRange(from, to);
+    ASSERT_EQ(from, to);
+    /* dynamic buffer cannot track changes of skipped update */
+    dynamicBuffer->getDirtyVertexRange(lastUpdateCount, from, to);
+    ASSERT_EQ(0, from);
+    ASSERT_EQ(8, to);
+}
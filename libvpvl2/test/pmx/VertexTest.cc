@@ -271,3 +271,145 @@ TEST(PMXModelTest, RemoveVertexReferences)
     uvMorphs.releaseAll();
     parentUVMorphs.releaseAll();
 }
+
+TEST(PMXModelTest, PerformSkinningWithSkinningEngine)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    Bone bone1(&model), bone2(&model), bone3(&model), bone4(&model);
+    Bone *bones[] = { &bone1, &bone2, &bone3, &bone4 };
+    for (int i = 0; i < 4; i++) {
+        bones[i]->setOrigin(Vector3(i, i * 2, -i));
+        bones[i]->setLocalTranslation(Vector3(0.1 * i, 0.2, 0.3));
+        bones[i]->setLocalOrientation(Quaternion(Vector3(0, 1, 0.2 * i), 0.3 + i));
+        model.addBone(bones[i]);
+    }
+    bone2.setParentBoneRef(&bone1);
+    bone3.setParentBoneRef(&bone2);
+    Material material(&model);
+    model.addMaterial(&material);
+    PointerArray<Vertex> vertices;
+    const Vertex::Type types[] = { Vertex::kBdef1, Vertex::kBdef2, Vertex::kBdef4, Vertex::kSdef };
+    /* odd number of vertices to test padded lanes */
+    for (int i = 0; i < 37; i++) {
+        Vertex *vertex = vertices.append(new Vertex(&model));
+        vertex->setOrigin(Vector3(i * 0.1, 1 - i * 0.05, 0.5));
+        vertex->setNormal(Vector3(0, 1, 0));
+        vertex->setMaterialRef(&material);
+        vertex->setType(types[i % 4]);
+        for (int j = 0; j < 4; j++) {
+            vertex->setBoneRef(j, bones[(i + j) % 4]);
+            vertex->setWeight(j, 0.1 + 0.2 * ((i + j) % 3));
+        }
+        model.addVertex(vertex);
+    }
+    model.performUpdate();
+    std::unique_ptr<IModel::IndexBuffer> indexBuffer;
+    std::unique_ptr<IModel::DynamicVertexBuffer> dynamicBuffer;
+    {
+        IModel::IndexBuffer *indexBufferPtr = 0;
+        IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+        model.getIndexBuffer(indexBufferPtr);
+        model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+        indexBuffer.reset(indexBufferPtr);
+        dynamicBuffer.reset(dynamicBufferPtr);
+    }
+    btAlignedObjectArray<Vector4> bytes;
+    bytes.resize(int(dynamicBuffer->size() / sizeof(Vector4)));
+    void *address = &bytes[0];
+    dynamicBuffer->setupBindPose(address);
+    dynamicBuffer->performTransform(address, kZeroV3);
+    const vsize positionOffset = dynamicBuffer->strideOffset(IModel::Buffer::kVertexStride);
+    const vsize normalOffset = dynamicBuffer->strideOffset(IModel::Buffer::kNormalStride);
+    for (int i = 0; i < vertices.count(); i++) {
+        const uint8 *ptr = static_cast<const uint8 *>(address) + i * dynamicBuffer->strideSize();
+        Vector3 position, normal;
+        vertices[i]->performSkinning(position, normal);
+        ASSERT_TRUE(CompareVector(position, *reinterpret_cast<const Vector3 *>(ptr + positionOffset)));
+        ASSERT_TRUE(CompareVector(normal, *reinterpret_cast<const Vector3 *>(ptr + normalOffset)));
+    }
+    for (int i = 0; i < vertices.count(); i++) {
+        model.removeVertex(vertices[i]);
+    }
+    model.removeMaterial(&material);
+    for (int i = 0; i < 4; i++) {
+        model.removeBone(bones[i]);
+    }
+    vertices.releaseAll();
+}
+
+TEST(PMXModelTest, RepackSkinningEngineOnEdit)
+{
+    Encoding encoding(0);
+    Model model(&encoding);
+    for (int i = 0; i < 3; i++) {
+        IBone *bone = model.createBone();
+        bone->setLocalTranslation(Vector3(0.1 * i, 0.2, 0.3));
+        bone->setLocalOrientation(Quaternion(Vector3(0, 1, 0.2 * i), 0.3 + i));
+        model.addBone(bone);
+    }
+    model.addMaterial(model.createMaterial());
+    for (int i = 0; i < 11; i++) {
+        IVertex *vertex = model.createVertex();
+        vertex->setOrigin(Vector3(i * 0.1, 1 - i * 0.05, 0.5));
+        vertex->setNormal(Vector3(0, 1, 0));
+        vertex->setMaterialRef(model.findMaterialRefAt(0));
+        vertex->setType(IVertex::kBdef1);
+        vertex->setBoneRef(0, model.findBoneRefAt(0));
+        model.addVertex(vertex);
+    }
+    const Array<Vertex *> &vertices = model.vertices();
+    Morph *morph = static_cast<Morph *>(model.createMorph());
+    morph->setType(IMorph::kVertexMorph);
+    Morph::Vertex *morphVertex = new Morph::Vertex();
+    morphVertex->vertex = vertices[7];
+    morphVertex->index = 7;
+    morphVertex->position.setValue(1, 2, 3);
+    morph->addVertexMorph(morphVertex);
+    model.addMorph(morph);
+    std::unique_ptr<IModel::IndexBuffer> indexBuffer;
+    std::unique_ptr<IModel::DynamicVertexBuffer> dynamicBuffer;
+    {
+        IModel::IndexBuffer *indexBufferPtr = 0;
+        IModel::DynamicVertexBuffer *dynamicBufferPtr = 0;
+        model.getIndexBuffer(indexBufferPtr);
+        model.getDynamicVertexBuffer(dynamicBufferPtr, indexBufferPtr);
+        indexBuffer.reset(indexBufferPtr);
+        dynamicBuffer.reset(dynamicBufferPtr);
+    }
+    btAlignedObjectArray<Vector4> bytes;
+    bytes.resize(int(dynamicBuffer->size() / sizeof(Vector4)));
+    void *address = &bytes[0];
+    const vsize positionOffset = dynamicBuffer->strideOffset(IModel::Buffer::kVertexStride);
+    const vsize normalOffset = dynamicBuffer->strideOffset(IModel::Buffer::kNormalStride);
+    model.performUpdate();
+    dynamicBuffer->setupBindPose(address);
+    dynamicBuffer->performTransform(address, kZeroV3);
+    for (int step = 0; step < 3; step++) {
+        if (step == 1) {
+            /* edits skinning parameters without invalidating the engine explicitly */
+            vertices[3]->setType(IVertex::kBdef2);
+            vertices[3]->setBoneRef(1, model.findBoneRefAt(2));
+            vertices[3]->setWeight(0, 0.25);
+            vertices[5]->setBoneRef(0, model.findBoneRefAt(1));
+            morph->setWeight(0.5);
+        }
+        else if (step == 2) {
+            vertices[5]->setType(IVertex::kBdef4);
+            for (int i = 0; i < 4; i++) {
+                vertices[5]->setBoneRef(i, model.findBoneRefAt(i % 3));
+                vertices[5]->setWeight(i, 0.1 + 0.2 * i);
+            }
+            morph->setWeight(1);
+        }
+        model.performUpdate();
+        dynamicBuffer->performTransform(address, kZeroV3);
+        for (int i = 0; i < vertices.count(); i++) {
+            const uint8 *ptr = static_cast<const uint8 *>(address) + i * dynamicBuffer->strideSize();
+            Vector3 position, normal;
+            vertices[i]->performSkinning(position, normal);
+            ASSERT_TRUE(CompareVector(position, *reinterpret_cast<const Vector3 *>(ptr + positionOffset)));
+            ASSERT_TRUE(CompareVector(normal, *reinterpret_cast<const Vector3 *>(ptr + normalOffset)));
+        }
+    }
+}
@@ -33,7 +33,9 @@ protected
       :build_demos => false,
       :build_extras => false,
       :install_libs => true,
-      :use_glut => false
+      :use_glut => false,
+      # the built-in profiler is global and breaks stepping worlds concurrently
+      :cmake_cxx_flags => "-DBT_NO_PROFILE "
     }
   end
 